@@ -0,0 +1,185 @@
+#include "arena.h"
+#include <stdint.h>
+
+#define DEFAULT_BLOCK_SIZE 262144
+
+/*******************************************************************************
+* A block of arena memory. The blocks in use are chained from the newest one,  *
+* which is the only one still being carved. Blocks emptied by a reset are      *
+* chained as spares.                                                           *
+*******************************************************************************/
+typedef struct arena_block {
+    struct arena_block* p_next;
+    size_t              size;
+    size_t              capacity;
+    unsigned char       data[];
+} arena_block;
+
+typedef struct arena_state {
+    arena_block* p_blocks;
+    arena_block* p_spare_blocks;
+    size_t       block_size;
+    size_t       bytes;
+    size_t       reserved_bytes;
+} arena_state;
+
+/*******************************************************************************
+* Returns the amount of bytes to skip from 'p_address' to reach the alignment. *
+*******************************************************************************/
+static size_t padding(const void* p_address)
+{
+    return (ARENA_ALIGNMENT - (uintptr_t) p_address % ARENA_ALIGNMENT) %
+           ARENA_ALIGNMENT;
+}
+
+arena* arena_alloc(size_t block_size)
+{
+    arena* p_arena;
+
+    if (!(p_arena = malloc(sizeof(*p_arena)))) return NULL;
+
+    if (!(p_arena->state = malloc(sizeof(*p_arena->state))))
+    {
+        free(p_arena);
+        return NULL;
+    }
+
+    p_arena->state->p_blocks = NULL;
+    p_arena->state->p_spare_blocks = NULL;
+    p_arena->state->block_size = block_size ? block_size : DEFAULT_BLOCK_SIZE;
+    p_arena->state->bytes = 0;
+    p_arena->state->reserved_bytes = 0;
+    return p_arena;
+}
+
+void* arena_allocate(arena* p_arena, size_t size)
+{
+    arena_state* p_state;
+    arena_block* p_block;
+    size_t       skip;
+    size_t       capacity;
+
+    if (!p_arena) return NULL;
+
+    p_state = p_arena->state;
+    p_block = p_state->p_blocks;
+
+    /* Even empty allocations get an address of their own. */
+    size = size ? size : 1;
+
+    if (p_block)
+    {
+        skip = padding(p_block->data + p_block->size);
+
+        if (p_block->capacity - p_block->size >= skip &&
+            p_block->capacity - p_block->size - skip >= size)
+        {
+            p_block->size += skip + size;
+            p_state->bytes += size;
+            return p_block->data + p_block->size - size;
+        }
+    }
+
+    /* A spare block fits everything but an oversized allocation. */
+    if (size <= p_state->block_size && (p_block = p_state->p_spare_blocks))
+    {
+        p_state->p_spare_blocks = p_block->p_next;
+        p_block->p_next = p_state->p_blocks;
+        p_state->p_blocks = p_block;
+
+        skip = padding(p_block->data);
+        p_block->size = skip + size;
+        p_state->bytes += size;
+        return p_block->data + skip;
+    }
+
+    if (size > SIZE_MAX - sizeof(arena_block) - ARENA_ALIGNMENT) return NULL;
+
+    capacity = size > p_state->block_size ? size : p_state->block_size;
+    capacity += ARENA_ALIGNMENT;
+
+    if (!(p_block = malloc(sizeof(arena_block) + capacity))) return NULL;
+
+    skip = padding(p_block->data);
+
+    p_block->size = skip + size;
+    p_block->capacity = capacity;
+
+    /* An oversized allocation is chained behind the newest block, which may
+       still have room for the allocations to come. */
+    if (size > p_state->block_size && p_state->p_blocks)
+    {
+        p_block->p_next = p_state->p_blocks->p_next;
+        p_state->p_blocks->p_next = p_block;
+    }
+    else
+    {
+        p_block->p_next = p_state->p_blocks;
+        p_state->p_blocks = p_block;
+    }
+
+    p_state->bytes += size;
+    p_state->reserved_bytes += sizeof(arena_block) + capacity;
+    return p_block->data + skip;
+}
+
+void arena_reset(arena* p_arena)
+{
+    arena_state* p_state;
+    arena_block* p_block;
+    arena_block* p_next;
+
+    if (!p_arena) return;
+
+    p_state = p_arena->state;
+
+    for (p_block = p_state->p_blocks; p_block; p_block = p_next)
+    {
+        p_next = p_block->p_next;
+
+        if (p_block->capacity > p_state->block_size + ARENA_ALIGNMENT)
+        {
+            /* Blocks of oversized allocations are not worth keeping. */
+            p_state->reserved_bytes -= sizeof(arena_block) + p_block->capacity;
+            free(p_block);
+        }
+        else
+        {
+            p_block->size = 0;
+            p_block->p_next = p_state->p_spare_blocks;
+            p_state->p_spare_blocks = p_block;
+        }
+    }
+
+    p_state->p_blocks = NULL;
+    p_state->bytes = 0;
+}
+
+size_t arena_bytes(arena* p_arena)
+{
+    return p_arena ? p_arena->state->bytes : 0;
+}
+
+size_t arena_reserved_bytes(arena* p_arena)
+{
+    return p_arena ? p_arena->state->reserved_bytes : 0;
+}
+
+void arena_free(arena* p_arena)
+{
+    arena_block* p_block;
+    arena_block* p_next;
+
+    if (!p_arena) return;
+
+    arena_reset(p_arena);
+
+    for (p_block = p_arena->state->p_spare_blocks; p_block; p_block = p_next)
+    {
+        p_next = p_block->p_next;
+        free(p_block);
+    }
+
+    free(p_arena->state);
+    free(p_arena);
+}
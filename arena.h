@@ -0,0 +1,64 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+
+/*******************************************************************************
+* The alignment of every allocation handed out by an arena.                    *
+*******************************************************************************/
+#define ARENA_ALIGNMENT 16
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * A region allocator. Allocations are carved one after another out of      *
+    * large blocks and are never freed one by one; deallocating the arena      *
+    * releases all of them at once, a block at a time.                         *
+    ***************************************************************************/
+    typedef struct arena {
+        struct arena_state* state;
+    } arena;
+
+    /***************************************************************************
+    * Allocates an empty arena whose blocks hold 'block_size' bytes, or a      *
+    * default amount if 'block_size' is zero. Larger allocations get a block   *
+    * of their own.                                                            *
+    ***************************************************************************/
+    arena* arena_alloc(size_t block_size);
+
+    /***************************************************************************
+    * Returns 'size' bytes of uninitialized memory aligned to                  *
+    * 'ARENA_ALIGNMENT', valid until the arena is deallocated. Returns NULL if *
+    * memory runs out.                                                         *
+    ***************************************************************************/
+    void* arena_allocate(arena* p_arena, size_t size);
+
+    /***************************************************************************
+    * Takes back everything allocated from the arena at once. The blocks are   *
+    * kept for the allocations to come, except those of oversized ones, so an  *
+    * arena reset after every query stops calling 'malloc' once warmed up.     *
+    ***************************************************************************/
+    void arena_reset(arena* p_arena);
+
+    /***************************************************************************
+    * Returns the amount of bytes handed out by the arena.                     *
+    ***************************************************************************/
+    size_t arena_bytes(arena* p_arena);
+
+    /***************************************************************************
+    * Returns the amount of bytes the arena has obtained from 'malloc'.        *
+    ***************************************************************************/
+    size_t arena_reserved_bytes(arena* p_arena);
+
+    /***************************************************************************
+    * Deallocates the arena along with everything allocated from it.           *
+    ***************************************************************************/
+    void arena_free(arena* p_arena);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* ARENA_H */
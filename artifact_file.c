@@ -0,0 +1,371 @@
+#include "artifact_file.h"
+#include "file_mapping.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FILE_MAGIC      "CGARTIFS"
+#define BYTE_ORDER_MARK 0x01020304U
+
+typedef struct file_header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint64_t section_count;
+    uint64_t graph_checksum;
+    uint64_t file_size;
+    uint64_t reserved[3];
+} file_header;
+
+typedef struct section_entry {
+    char     name[ARTIFACT_NAME_LENGTH + 1];
+    uint64_t offset;
+    uint64_t size;
+    uint64_t checksum;
+    uint64_t reserved;
+} section_entry;
+
+typedef struct artifact_file_state {
+    file_mapping*        p_mapping;
+    const section_entry* p_entries;
+    size_t               section_count;
+} artifact_file_state;
+
+/*******************************************************************************
+* A running checksum of a sequence of bytes, processed 8 bytes at a time.      *
+*******************************************************************************/
+typedef struct checksum {
+    uint64_t value;
+} checksum;
+
+static const uint64_t CHECKSUM_PRIME_1 = 0x9e3779b185ebca87ULL;
+static const uint64_t CHECKSUM_PRIME_2 = 0xc2b2ae3d27d4eb4fULL;
+
+static void checksum_add(checksum* p_checksum, uint64_t word)
+{
+    uint64_t value = p_checksum->value ^ (word * CHECKSUM_PRIME_2);
+
+    p_checksum->value = ((value << 31) | (value >> 33)) * CHECKSUM_PRIME_1;
+}
+
+static void checksum_add_bytes(checksum* p_checksum,
+                               const void* p_data,
+                               size_t size)
+{
+    const unsigned char* p_byte = p_data;
+    uint64_t             word;
+
+    for (; size >= sizeof(word); size -= sizeof(word), p_byte += sizeof(word))
+    {
+        memcpy(&word, p_byte, sizeof(word));
+        checksum_add(p_checksum, word);
+    }
+
+    if (size > 0)
+    {
+        word = 0;
+        memcpy(&word, p_byte, size);
+        checksum_add(p_checksum, word);
+    }
+}
+
+static uint64_t checksum_value(const checksum* p_checksum, uint64_t length)
+{
+    uint64_t value = p_checksum->value ^ length;
+
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    return value;
+}
+
+static uint64_t section_checksum(const void* p_data, size_t size)
+{
+    checksum sum = { 0 };
+
+    checksum_add_bytes(&sum, p_data, size);
+    return checksum_value(&sum, size);
+}
+
+uint64_t artifact_graph_checksum(compact_graph* p_graph)
+{
+    compact_arc_iterator arcs;
+    checksum             sum = { 0 };
+    uint32_t             node_count;
+    uint32_t             head;
+    uint32_t             id;
+    size_t               arc;
+    double               scale;
+
+    if (!p_graph) return 0;
+
+    node_count = compact_graph_node_count(p_graph);
+    scale = compact_graph_fixed_point_scale(p_graph);
+
+    checksum_add(&sum, node_count);
+    checksum_add(&sum, compact_graph_arc_count(p_graph));
+    checksum_add(&sum, (uint64_t) compact_graph_weight_format(p_graph));
+    checksum_add_bytes(&sum, &scale, sizeof(scale));
+
+    /* The heads are walked arc by arc so that compressed graphs have a
+       checksum as well. */
+    for (id = 0; id < node_count; ++id)
+    {
+        checksum_add(&sum, compact_graph_offset(p_graph, id));
+        compact_graph_arcs(p_graph, id, &arcs);
+
+        while (compact_arc_iterator_next(&arcs, &arc, &head))
+        {
+            checksum_add(&sum, head);
+        }
+    }
+
+    checksum_add_bytes(&sum,
+                       compact_graph_weights(p_graph),
+                       weight_format_size(compact_graph_weight_format(p_graph))
+                       * compact_graph_arc_count(p_graph));
+
+    return checksum_value(&sum, compact_graph_arc_count(p_graph));
+}
+
+static size_t align8(size_t position)
+{
+    return (position + 7) & ~(size_t) 7;
+}
+
+static bool names_valid(const artifact_section* p_sections,
+                        size_t section_count)
+{
+    size_t length;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < section_count; ++i)
+    {
+        if (!p_sections[i].p_name) return false;
+        if (!p_sections[i].p_data && p_sections[i].size > 0) return false;
+
+        length = strlen(p_sections[i].p_name);
+
+        if (length == 0 || length > ARTIFACT_NAME_LENGTH) return false;
+
+        for (j = 0; j < i; ++j)
+        {
+            if (strcmp(p_sections[i].p_name, p_sections[j].p_name) == 0)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool artifact_file_save(const char* p_file_name,
+                        compact_graph* p_graph,
+                        const artifact_section* p_sections,
+                        size_t section_count)
+{
+    static const char zeros[8] = { 0 };
+
+    file_header    header;
+    section_entry* p_entries;
+    FILE*          p_file;
+    size_t         position;
+    size_t         i;
+    bool           ok;
+
+    if (!p_file_name || !p_graph)                 return false;
+    if (!p_sections && section_count > 0)        return false;
+    if (!names_valid(p_sections, section_count)) return false;
+
+    if (!(p_entries = calloc(section_count + 1, sizeof(section_entry))))
+    {
+        return false;
+    }
+
+    position = sizeof(file_header) + sizeof(section_entry) * section_count;
+
+    for (i = 0; i < section_count; ++i)
+    {
+        strcpy(p_entries[i].name, p_sections[i].p_name);
+        p_entries[i].offset = position;
+        p_entries[i].size = p_sections[i].size;
+        p_entries[i].checksum = section_checksum(p_sections[i].p_data,
+                                                 p_sections[i].size);
+        position = align8(position + p_sections[i].size);
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = ARTIFACT_FILE_VERSION;
+    header.byte_order_mark = BYTE_ORDER_MARK;
+    header.section_count = section_count;
+    header.graph_checksum = artifact_graph_checksum(p_graph);
+    header.file_size = position;
+
+    if (!(p_file = fopen(p_file_name, "wb")))
+    {
+        free(p_entries);
+        return false;
+    }
+
+    ok = fwrite(&header, sizeof(header), 1, p_file) == 1 &&
+         fwrite(p_entries,
+                sizeof(section_entry),
+                section_count,
+                p_file) == section_count;
+
+    for (i = 0; ok && i < section_count; ++i)
+    {
+        if (p_sections[i].size > 0)
+        {
+            ok = fwrite(p_sections[i].p_data,
+                        1,
+                        p_sections[i].size,
+                        p_file) == p_sections[i].size;
+        }
+
+        ok = ok && fwrite(zeros,
+                          1,
+                          align8(p_sections[i].size) - p_sections[i].size,
+                          p_file) ==
+                   align8(p_sections[i].size) - p_sections[i].size;
+    }
+
+    free(p_entries);
+    return (fclose(p_file) == 0) && ok;
+}
+
+/*******************************************************************************
+* Checks the header and the section table of a mapped container.               *
+*******************************************************************************/
+static bool container_valid(const file_mapping* p_mapping,
+                            compact_graph* p_graph)
+{
+    const char*          p_base;
+    const file_header*   p_header;
+    const section_entry* p_entries;
+    size_t               i;
+
+    p_base = p_mapping->p_address;
+    p_header = (const file_header*) p_base;
+
+    if (p_mapping->size < sizeof(file_header)                             ||
+        memcmp(p_header->magic, FILE_MAGIC, sizeof(p_header->magic)) != 0 ||
+        p_header->version != ARTIFACT_FILE_VERSION                        ||
+        p_header->byte_order_mark != BYTE_ORDER_MARK                      ||
+        p_header->file_size != p_mapping->size                            ||
+        p_header->section_count > (p_mapping->size - sizeof(file_header)) /
+                                  sizeof(section_entry))
+    {
+        return false;
+    }
+
+    if (p_header->graph_checksum != artifact_graph_checksum(p_graph))
+    {
+        return false;
+    }
+
+    p_entries = (const section_entry*)(p_base + sizeof(file_header));
+
+    for (i = 0; i < p_header->section_count; ++i)
+    {
+        if (p_entries[i].name[ARTIFACT_NAME_LENGTH] != '\0' ||
+            p_entries[i].offset % 8 != 0                    ||
+            p_entries[i].offset > p_mapping->size           ||
+            p_entries[i].size > p_mapping->size - p_entries[i].offset)
+        {
+            return false;
+        }
+
+        if (section_checksum(p_base + p_entries[i].offset,
+                             (size_t) p_entries[i].size)
+            != p_entries[i].checksum)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+artifact_file* artifact_file_open(const char* p_file_name,
+                                  compact_graph* p_graph)
+{
+    artifact_file* p_file;
+    file_mapping*  p_mapping;
+
+    if (!p_file_name || !p_graph) return NULL;
+
+    if (!(p_mapping = file_mapping_open(p_file_name))) return NULL;
+
+    if (!container_valid(p_mapping, p_graph))
+    {
+        file_mapping_close(p_mapping);
+        return NULL;
+    }
+
+    if (!(p_file = malloc(sizeof(*p_file))))
+    {
+        file_mapping_close(p_mapping);
+        return NULL;
+    }
+
+    if (!(p_file->state = malloc(sizeof(*p_file->state))))
+    {
+        free(p_file);
+        file_mapping_close(p_mapping);
+        return NULL;
+    }
+
+    p_file->state->p_mapping = p_mapping;
+    p_file->state->p_entries =
+        (const section_entry*)((const char*) p_mapping->p_address +
+                               sizeof(file_header));
+    p_file->state->section_count =
+        (size_t)((const file_header*) p_mapping->p_address)->section_count;
+
+    return p_file;
+}
+
+const void* artifact_file_section(artifact_file* p_file,
+                                  const char* p_name,
+                                  size_t* p_size)
+{
+    const section_entry* p_entry;
+    size_t               i;
+
+    if (!p_file || !p_name) return NULL;
+
+    for (i = 0; i < p_file->state->section_count; ++i)
+    {
+        p_entry = &p_file->state->p_entries[i];
+
+        if (strcmp(p_entry->name, p_name) == 0)
+        {
+            if (p_size)
+            {
+                *p_size = (size_t) p_entry->size;
+            }
+
+            return (const char*) p_file->state->p_mapping->p_address +
+                   p_entry->offset;
+        }
+    }
+
+    return NULL;
+}
+
+size_t artifact_file_section_count(artifact_file* p_file)
+{
+    return p_file ? p_file->state->section_count : 0;
+}
+
+void artifact_file_close(artifact_file* p_file)
+{
+    if (!p_file) return;
+
+    file_mapping_close(p_file->state->p_mapping);
+    free(p_file->state);
+    free(p_file);
+}
@@ -0,0 +1,97 @@
+#ifndef ARTIFACT_FILE_H
+#define ARTIFACT_FILE_H
+
+#include "compact_graph.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+* The version of the container format written by 'artifact_file_save'.         *
+* A file starts with a 64-byte header holding a magic string, the version, a   *
+* byte order mark, the amount of sections and the checksum of the graph the    *
+* artifacts were computed on. The header is followed by a table of 64-byte     *
+* entries giving the name, position, size and checksum of each section, and    *
+* then by the sections, each starting at a multiple of 8 bytes.                *
+*******************************************************************************/
+#define ARTIFACT_FILE_VERSION 1
+
+/*******************************************************************************
+* The longest section name, not counting the terminating zero.                 *
+*******************************************************************************/
+#define ARTIFACT_NAME_LENGTH 31
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * A named block of preprocessed data, such as landmark distances, a        *
+    * contraction order with its shortcuts or distance labels.                 *
+    ***************************************************************************/
+    typedef struct artifact_section {
+        const char* p_name;
+        const void* p_data;
+        size_t      size;
+    } artifact_section;
+
+    /***************************************************************************
+    * A container file opened for reading. The sections are used in place.     *
+    ***************************************************************************/
+    typedef struct artifact_file {
+        struct artifact_file_state* state;
+    } artifact_file;
+
+    /***************************************************************************
+    * Returns a checksum of the structure and the weights of the graph: the    *
+    * counts, the weight format, the offsets, the heads in arc order and the   *
+    * stored weights. Any change to the arcs or weights, including reordering  *
+    * them by compressing the graph, changes the checksum.                     *
+    ***************************************************************************/
+    uint64_t artifact_graph_checksum(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Writes the 'section_count' sections in 'p_sections' to the file          *
+    * 'p_file_name', bound to the graph 'p_graph'. Returns false if a name is  *
+    * empty, longer than 'ARTIFACT_NAME_LENGTH' or not unique, or on an I/O    *
+    * error.                                                                   *
+    ***************************************************************************/
+    bool artifact_file_save(const char* p_file_name,
+                            compact_graph* p_graph,
+                            const artifact_section* p_sections,
+                            size_t section_count);
+
+    /***************************************************************************
+    * Maps the container 'p_file_name' into memory and checks it against the   *
+    * graph 'p_graph' and the checksums of its sections. Returns NULL if the   *
+    * file cannot be opened, is not a container of this version and byte       *
+    * order, is truncated, was written for another graph or weights, or a      *
+    * section is corrupt.                                                      *
+    ***************************************************************************/
+    artifact_file* artifact_file_open(const char* p_file_name,
+                                      compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the data of the section named 'p_name' and stores its size into  *
+    * '*p_size', or returns NULL if there is no such section. The data is      *
+    * aligned to 8 bytes and stays valid until the file is closed.             *
+    ***************************************************************************/
+    const void* artifact_file_section(artifact_file* p_file,
+                                      const char* p_name,
+                                      size_t* p_size);
+
+    /***************************************************************************
+    * Returns the amount of sections in the file.                              *
+    ***************************************************************************/
+    size_t artifact_file_section_count(artifact_file* p_file);
+
+    /***************************************************************************
+    * Unmaps the file. The section data may not be used afterwards.            *
+    ***************************************************************************/
+    void artifact_file_close(artifact_file* p_file);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* ARTIFACT_FILE_H */
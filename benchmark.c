@@ -0,0 +1,368 @@
+/* 'clock_gettime' and 'CLOCK_MONOTONIC' are POSIX rather than C99. */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "benchmark.h"
+#include "arena.h"
+#include "compact_dijkstra.h"
+#include "dijkstra.h"
+#include "path.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/*******************************************************************************
+* The generator of the query pairs. It is private to the benchmark so that the *
+* queries do not depend on what else has called 'rand' before.                 *
+*******************************************************************************/
+static uint64_t next_random(uint64_t* p_state)
+{
+    uint64_t z = (*p_state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static int compare_doubles(const void* p_a, const void* p_b)
+{
+    double a = *(const double*) p_a;
+    double b = *(const double*) p_b;
+
+    return (a > b) - (a < b);
+}
+
+/*******************************************************************************
+* Returns the 'percent' percentile of the 'count' sorted latencies by nearest  *
+* rank.                                                                        *
+*******************************************************************************/
+static double percentile(const double* p_sorted, size_t count, size_t percent)
+{
+    size_t rank = (count * percent + 99) / 100;
+
+    return p_sorted[rank ? rank - 1 : 0];
+}
+
+/*******************************************************************************
+* Answers one query, adding the size of the path found to '*p_path_nodes'.     *
+*******************************************************************************/
+static bool run_query(graph_data* p_data,
+                      compact_graph* p_compact,
+                      benchmark_algorithm algorithm,
+                      arena* p_scratch,
+                      size_t source,
+                      size_t target,
+                      size_t* p_path_nodes)
+{
+    path*         p_path;
+    compact_path* p_compact_path;
+
+    switch (algorithm)
+    {
+        case BENCHMARK_DIJKSTRA:
+            p_path = dijkstra(p_data->p_node_array[source],
+                              p_data->p_node_array[target],
+                              p_data->p_weight_function);
+            break;
+
+        case BENCHMARK_DIJKSTRA_WITH_ARENA:
+            p_path = dijkstra_with_arena(p_data->p_node_array[source],
+                                         p_data->p_node_array[target],
+                                         p_data->p_weight_function,
+                                         p_scratch);
+            break;
+
+        case BENCHMARK_COMPACT_DIJKSTRA:
+            p_compact_path = compact_dijkstra(p_compact,
+                                              (uint32_t) source,
+                                              (uint32_t) target);
+
+            if (!p_compact_path) return false;
+
+            *p_path_nodes += compact_path_size(p_compact_path);
+            compact_path_free(p_compact_path);
+            return true;
+
+        default:
+            return false;
+    }
+
+    if (!p_path) return false;
+
+    *p_path_nodes += path_size(p_path);
+    path_free(p_path);
+    return true;
+}
+
+double benchmark_now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + 1e-9 * (double) now.tv_nsec;
+#endif
+}
+
+const char* benchmark_algorithm_name(benchmark_algorithm algorithm)
+{
+    switch (algorithm)
+    {
+        case BENCHMARK_DIJKSTRA:            return "dijkstra";
+        case BENCHMARK_DIJKSTRA_WITH_ARENA: return "dijkstra_with_arena";
+        case BENCHMARK_COMPACT_DIJKSTRA:    return "compact_dijkstra";
+        default:                            return "unknown";
+    }
+}
+
+bool benchmark_summarize(double* p_latencies,
+                         size_t count,
+                         double total,
+                         benchmark_result* p_result)
+{
+    double sum;
+    size_t i;
+
+    if (count == 0) return false;
+
+    qsort(p_latencies, count, sizeof(double), compare_doubles);
+
+    sum = 0.0;
+
+    for (i = 0; i < count; ++i)
+    {
+        sum += p_latencies[i];
+    }
+
+    p_result->queries = count;
+    p_result->mean = sum / (double) count;
+    p_result->median = percentile(p_latencies, count, 50);
+    p_result->p90 = percentile(p_latencies, count, 90);
+    p_result->p99 = percentile(p_latencies, count, 99);
+    p_result->max = p_latencies[count - 1];
+    p_result->queries_per_second = total > 0.0 ? (double) count / total : 0.0;
+    return true;
+}
+
+bool benchmark_run(graph_data* p_data,
+                   compact_graph* p_compact,
+                   benchmark_algorithm algorithm,
+                   const benchmark_config* p_config,
+                   benchmark_result* p_result)
+{
+    double*  p_latencies;
+    arena*   p_scratch;
+    uint64_t random_state;
+    size_t   node_count;
+    size_t   source;
+    size_t   target;
+    size_t   path_nodes;
+    size_t   i;
+    double   start;
+    double   query_start;
+    bool     ok;
+
+    node_count = p_data->node_count;
+
+    if (node_count == 0)                  return false;
+    if (p_config->measured_queries == 0)  return false;
+
+    if (algorithm == BENCHMARK_COMPACT_DIJKSTRA && !p_compact) return false;
+
+    if (!(p_latencies = malloc(sizeof(double) *
+                               p_config->measured_queries)))
+    {
+        return false;
+    }
+
+    if (!(p_scratch = arena_alloc(0)))
+    {
+        free(p_latencies);
+        return false;
+    }
+
+    random_state = (uint64_t) p_config->seed;
+    path_nodes = 0;
+    ok = true;
+
+    /* The warm-up queries fault in the pages and fill the caches. */
+    for (i = 0; ok && i < p_config->warmup_queries; ++i)
+    {
+        source = (size_t)(next_random(&random_state) % node_count);
+        target = (size_t)(next_random(&random_state) % node_count);
+        ok = run_query(p_data,
+                       p_compact,
+                       algorithm,
+                       p_scratch,
+                       source,
+                       target,
+                       &path_nodes);
+    }
+
+    path_nodes = 0;
+    start = benchmark_now();
+
+    for (i = 0; ok && i < p_config->measured_queries; ++i)
+    {
+        source = (size_t)(next_random(&random_state) % node_count);
+        target = (size_t)(next_random(&random_state) % node_count);
+
+        query_start = benchmark_now();
+        ok = run_query(p_data,
+                       p_compact,
+                       algorithm,
+                       p_scratch,
+                       source,
+                       target,
+                       &path_nodes);
+        p_latencies[i] = benchmark_now() - query_start;
+    }
+
+    if (ok)
+    {
+        p_result->algorithm = algorithm;
+        p_result->path_nodes = path_nodes;
+        benchmark_summarize(p_latencies,
+                            p_config->measured_queries,
+                            benchmark_now() - start,
+                            p_result);
+    }
+
+    arena_free(p_scratch);
+    free(p_latencies);
+    return ok;
+}
+
+static void write_usage(FILE* p_file,
+                        const char* p_category,
+                        memory_usage usage,
+                        bool last)
+{
+    fprintf(p_file,
+            "      \"%s\": { \"allocated\": %lu, \"live\": %lu }%s\n",
+            p_category,
+            (unsigned long) usage.allocated,
+            (unsigned long) usage.live,
+            last ? "" : ",");
+}
+
+/*******************************************************************************
+* Writes 'p_string' as a JSON string, or 'null' if it is NULL.                 *
+*******************************************************************************/
+static void write_string(FILE* p_file, const char* p_string)
+{
+    if (!p_string)
+    {
+        fputs("null", p_file);
+        return;
+    }
+
+    fputc('"', p_file);
+
+    for (; *p_string; ++p_string)
+    {
+        if (*p_string == '"' || *p_string == '\\')
+        {
+            fprintf(p_file, "\\%c", *p_string);
+        }
+        else if ((unsigned char) *p_string < 0x20)
+        {
+            fprintf(p_file, "\\u%04x", (unsigned) *p_string);
+        }
+        else
+        {
+            fputc(*p_string, p_file);
+        }
+    }
+
+    fputc('"', p_file);
+}
+
+void benchmark_write_json(FILE* p_file,
+                          const benchmark_config* p_config,
+                          double build_seconds,
+                          const graph_memory_summary* p_memory,
+                          const benchmark_result* p_results,
+                          size_t result_count)
+{
+    size_t i;
+
+    fprintf(p_file, "{\n");
+    fprintf(p_file, "  \"seed\": %lu,\n", p_config->seed);
+    fprintf(p_file, "  \"graph\": {\n");
+    fprintf(p_file, "    \"file\": ");
+    write_string(p_file, p_config->p_graph_file_name);
+    fprintf(p_file, ",\n    \"coordinate_file\": ");
+    write_string(p_file, p_config->p_coordinate_file_name);
+    fprintf(p_file, ",\n");
+    fprintf(p_file,
+            "    \"nodes\": %lu,\n",
+            (unsigned long) p_config->node_count);
+    fprintf(p_file,
+            "    \"arcs\": %lu,\n",
+            (unsigned long) p_config->arc_count);
+    fprintf(p_file, "    \"build_seconds\": %.9f,\n", build_seconds);
+    fprintf(p_file, "    \"memory\": {\n");
+    write_usage(p_file, "adjacency", p_memory->adjacency, false);
+    write_usage(p_file, "weights", p_memory->weights, false);
+    write_usage(p_file, "names", p_memory->names, false);
+    write_usage(p_file, "coordinates", p_memory->coordinates, false);
+    write_usage(p_file, "search_scratch", p_memory->search_scratch, false);
+    write_usage(p_file, "total", graph_memory_summary_total(p_memory), true);
+    fprintf(p_file, "    }\n");
+    fprintf(p_file, "  },\n");
+    fprintf(p_file,
+            "  \"warmup_queries\": %lu,\n",
+            (unsigned long) p_config->warmup_queries);
+    fprintf(p_file,
+            "  \"measured_queries\": %lu,\n",
+            (unsigned long) p_config->measured_queries);
+    fprintf(p_file, "  \"results\": [\n");
+
+    for (i = 0; i < result_count; ++i)
+    {
+        fprintf(p_file, "    {\n");
+        fprintf(p_file,
+                "      \"algorithm\": \"%s\",\n",
+                benchmark_algorithm_name(p_results[i].algorithm));
+        fprintf(p_file,
+                "      \"queries\": %lu,\n",
+                (unsigned long) p_results[i].queries);
+        fprintf(p_file,
+                "      \"mean_seconds\": %.9f,\n",
+                p_results[i].mean);
+        fprintf(p_file,
+                "      \"median_seconds\": %.9f,\n",
+                p_results[i].median);
+        fprintf(p_file,
+                "      \"p90_seconds\": %.9f,\n",
+                p_results[i].p90);
+        fprintf(p_file,
+                "      \"p99_seconds\": %.9f,\n",
+                p_results[i].p99);
+        fprintf(p_file,
+                "      \"max_seconds\": %.9f,\n",
+                p_results[i].max);
+        fprintf(p_file,
+                "      \"queries_per_second\": %.3f,\n",
+                p_results[i].queries_per_second);
+        fprintf(p_file,
+                "      \"path_nodes\": %lu\n",
+                (unsigned long) p_results[i].path_nodes);
+        fprintf(p_file, "    }%s\n", i + 1 < result_count ? "," : "");
+    }
+
+    fprintf(p_file, "  ]\n");
+    fprintf(p_file, "}\n");
+}
@@ -0,0 +1,108 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "compact_graph.h"
+#include "memory_usage.h"
+#include "utils.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * The searches a benchmark can time.                                       *
+    ***************************************************************************/
+    typedef enum benchmark_algorithm {
+        BENCHMARK_DIJKSTRA,
+        BENCHMARK_DIJKSTRA_WITH_ARENA,
+        BENCHMARK_COMPACT_DIJKSTRA
+    } benchmark_algorithm;
+
+    /***************************************************************************
+    * What a benchmark ran on: the seed of the random graph and of the query   *
+    * pairs, the graph file or the size of the random graph, and the amount of *
+    * untimed warm-up queries and of timed queries per algorithm.              *
+    ***************************************************************************/
+    typedef struct benchmark_config {
+        unsigned long seed;
+        const char*   p_graph_file_name;
+        const char*   p_coordinate_file_name;
+        size_t        node_count;
+        size_t        arc_count;
+        size_t        warmup_queries;
+        size_t        measured_queries;
+    } benchmark_config;
+
+    /***************************************************************************
+    * The latencies of the timed queries of one algorithm, in seconds. The     *
+    * percentiles are by nearest rank. 'path_nodes' sums the sizes of the      *
+    * paths found, which must agree between the algorithms.                    *
+    ***************************************************************************/
+    typedef struct benchmark_result {
+        benchmark_algorithm algorithm;
+        size_t              queries;
+        double              mean;
+        double              median;
+        double              p90;
+        double              p99;
+        double              max;
+        double              queries_per_second;
+        size_t              path_nodes;
+    } benchmark_result;
+
+    /***************************************************************************
+    * Returns the time in seconds of a monotonic clock, which is unaffected by *
+    * changes of the wall-clock time.                                          *
+    ***************************************************************************/
+    double benchmark_now(void);
+
+    /***************************************************************************
+    * Returns the name of the algorithm as used in the report.                 *
+    ***************************************************************************/
+    const char* benchmark_algorithm_name(benchmark_algorithm algorithm);
+
+    /***************************************************************************
+    * Fills the statistics of '*p_result' from the 'count' latencies in        *
+    * 'p_latencies', which are sorted in place, taking 'total' seconds         *
+    * altogether. Returns false if 'count' is zero.                            *
+    ***************************************************************************/
+    bool benchmark_summarize(double* p_latencies,
+                             size_t count,
+                             double total,
+                             benchmark_result* p_result);
+
+    /***************************************************************************
+    * Runs 'p_config->warmup_queries' untimed and then                         *
+    * 'p_config->measured_queries' timed queries of 'algorithm' between node   *
+    * pairs drawn from a generator seeded by 'p_config->seed', so that every   *
+    * algorithm and every run with the same seed answers the same queries.     *
+    * 'p_compact' must be the compact graph of 'p_data' for                    *
+    * 'BENCHMARK_COMPACT_DIJKSTRA' and may be NULL otherwise. Returns false if *
+    * there are no nodes or no timed queries, or memory runs out.              *
+    ***************************************************************************/
+    bool benchmark_run(graph_data* p_data,
+                       compact_graph* p_compact,
+                       benchmark_algorithm algorithm,
+                       const benchmark_config* p_config,
+                       benchmark_result* p_result);
+
+    /***************************************************************************
+    * Writes the configuration, the time taken to build the graph, its memory  *
+    * and the 'result_count' results to 'p_file' as one JSON object.           *
+    ***************************************************************************/
+    void benchmark_write_json(FILE* p_file,
+                              const benchmark_config* p_config,
+                              double build_seconds,
+                              const graph_memory_summary* p_memory,
+                              const benchmark_result* p_results,
+                              size_t result_count);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* BENCHMARK_H */
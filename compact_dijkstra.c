@@ -0,0 +1,310 @@
+#include "compact_dijkstra.h"
+#include "typed_containers.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+* Builds the path by following the parent ids from the target.                 *
+*******************************************************************************/
+static compact_path* traceback_path(const uint32_t* p_parents,
+                                    uint32_t target,
+                                    double cost)
+{
+    compact_path* p_path;
+    uint32_t*     p_ids;
+    uint32_t      id;
+    size_t        size;
+
+    size = 1;
+
+    for (id = target;
+         p_parents[id] != COMPACT_GRAPH_NO_NODE;
+         id = p_parents[id])
+    {
+        ++size;
+    }
+
+    if (!(p_path = compact_path_alloc(size, cost))) return NULL;
+
+    p_ids = compact_path_ids(p_path);
+
+    for (id = target; id != COMPACT_GRAPH_NO_NODE; id = p_parents[id])
+    {
+        p_ids[--size] = id;
+    }
+
+    return p_path;
+}
+
+/*******************************************************************************
+* Generates the search kernel 'NAME'. The weight of the arc 'arc' is           *
+* 'ARC_WEIGHT(p_weights, arc)', where 'p_weights' is of type 'SOURCE_TYPE',    *
+* such as a plain weight array. The tentative costs are of type 'COST_TYPE',   *
+* start at 'MAX_COST' and are kept in the heap type 'HEAP'. The arcs are       *
+* walked by the inline arc iterator, which decodes compressed heads on the     *
+* fly; the inner loop has no calls besides what 'ARC_WEIGHT' expands to. The   *
+* cost of the path is divided by 'scale', the fixed-point scale of the         *
+* weights.                                                                     *
+*******************************************************************************/
+#define COMPACT_DIJKSTRA_KERNEL(NAME, SOURCE_TYPE, ARC_WEIGHT,                \
+                                COST_TYPE, MAX_COST, HEAP)                    \
+static compact_path* NAME(compact_graph* p_graph,                             \
+                          SOURCE_TYPE p_weights,                              \
+                          double scale,                                       \
+                          uint32_t source,                                    \
+                          uint32_t target)                                    \
+{                                                                             \
+    compact_arc_iterator arcs;                                                \
+    COST_TYPE*           p_costs;                                             \
+    uint32_t*            p_parents;                                           \
+    HEAP*                p_open_set;                                          \
+    compact_path*        p_path;                                              \
+    COST_TYPE            cost;                                                \
+    COST_TYPE            tmp_cost;                                            \
+    uint32_t             node_count;                                          \
+    uint32_t             current;                                             \
+    uint32_t             child;                                               \
+    size_t               arc;                                                 \
+    bool                 target_reached;                                      \
+                                                                              \
+    node_count = compact_graph_node_count(p_graph);                           \
+                                                                              \
+    p_costs    = (COST_TYPE*) malloc(sizeof(COST_TYPE) * node_count);         \
+    p_parents  = (uint32_t*) malloc(sizeof(uint32_t) * node_count);           \
+    p_open_set = HEAP##_alloc(node_count);                                    \
+                                                                              \
+    if (!p_costs || !p_parents || !p_open_set)                                \
+    {                                                                         \
+        free(p_costs);                                                        \
+        free(p_parents);                                                      \
+        HEAP##_free(p_open_set);                                              \
+        return NULL;                                                          \
+    }                                                                         \
+                                                                              \
+    for (current = 0; current < node_count; ++current)                        \
+    {                                                                         \
+        p_costs[current] = MAX_COST;                                          \
+        p_parents[current] = COMPACT_GRAPH_NO_NODE;                           \
+    }                                                                         \
+                                                                              \
+    p_costs[source] = 0;                                                      \
+    HEAP##_add(p_open_set, source, 0);                                        \
+                                                                              \
+    p_path = NULL;                                                            \
+    target_reached = false;                                                   \
+                                                                              \
+    while (HEAP##_size(p_open_set) > 0)                                       \
+    {                                                                         \
+        current = HEAP##_extract_min(p_open_set, &cost);                      \
+                                                                              \
+        if (current == target)                                                \
+        {                                                                     \
+            p_path = traceback_path(p_parents,                                \
+                                    target,                                   \
+                                    (double) cost / scale);                   \
+            target_reached = true;                                            \
+            break;                                                            \
+        }                                                                     \
+                                                                              \
+        compact_graph_arcs(p_graph, current, &arcs);                          \
+                                                                              \
+        while (compact_arc_iterator_next(&arcs, &arc, &child))                \
+        {                                                                     \
+            tmp_cost = cost + (COST_TYPE) ARC_WEIGHT(p_weights, arc);         \
+                                                                              \
+            /* A settled node never improves as the weights are not           \
+               negative, so there is no closed set. */                        \
+            if (tmp_cost < p_costs[child])                                    \
+            {                                                                 \
+                if (p_costs[child] == MAX_COST)                               \
+                {                                                             \
+                    HEAP##_add(p_open_set, child, tmp_cost);                  \
+                }                                                             \
+                else                                                          \
+                {                                                             \
+                    HEAP##_decrease_key(p_open_set, child, tmp_cost);         \
+                }                                                             \
+                                                                              \
+                p_costs[child] = tmp_cost;                                    \
+                p_parents[child] = current;                                   \
+            }                                                                 \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    if (!target_reached)                                                      \
+    {                                                                         \
+        p_path = compact_path_alloc(0, 0.0);                                  \
+    }                                                                         \
+                                                                              \
+    free(p_costs);                                                            \
+    free(p_parents);                                                          \
+    HEAP##_free(p_open_set);                                                  \
+    return p_path;                                                            \
+}
+
+/*******************************************************************************
+* A linear combination of the metric columns of a weight profile, restricted   *
+* to the metrics with a non-zero coefficient.                                  *
+*******************************************************************************/
+typedef struct metric_mix {
+    size_t         count;
+    const double** p_columns;
+    const double*  p_coefficients;
+} metric_mix;
+
+static double mixed_weight(const metric_mix* p_mix, size_t arc)
+{
+    double weight;
+    size_t i;
+
+    weight = 0.0;
+
+    for (i = 0; i < p_mix->count; ++i)
+    {
+        weight += p_mix->p_coefficients[i] * p_mix->p_columns[i][arc];
+    }
+
+    return weight;
+}
+
+#define ARRAY_WEIGHT(P_WEIGHTS, ARC) ((P_WEIGHTS)[ARC])
+#define MIXED_WEIGHT(P_MIX, ARC)     mixed_weight(P_MIX, ARC)
+
+COMPACT_DIJKSTRA_KERNEL(dijkstra_double,
+                        const double*,
+                        ARRAY_WEIGHT,
+                        double,
+                        HUGE_VAL,
+                        u32_double_heap)
+
+COMPACT_DIJKSTRA_KERNEL(dijkstra_float,
+                        const float*,
+                        ARRAY_WEIGHT,
+                        double,
+                        HUGE_VAL,
+                        u32_double_heap)
+
+COMPACT_DIJKSTRA_KERNEL(dijkstra_fixed_point,
+                        const uint32_t*,
+                        ARRAY_WEIGHT,
+                        uint64_t,
+                        UINT64_MAX,
+                        u32_u64_heap)
+
+COMPACT_DIJKSTRA_KERNEL(dijkstra_mixed,
+                        const metric_mix*,
+                        MIXED_WEIGHT,
+                        double,
+                        HUGE_VAL,
+                        u32_double_heap)
+
+compact_path* compact_dijkstra(compact_graph* p_graph,
+                               uint32_t source,
+                               uint32_t target)
+{
+    const void* p_weights;
+
+    if (!p_graph) return NULL;
+    if (source >= compact_graph_node_count(p_graph)) return NULL;
+    if (target >= compact_graph_node_count(p_graph)) return NULL;
+
+    p_weights = compact_graph_weights(p_graph);
+
+    switch (compact_graph_weight_format(p_graph))
+    {
+        case WEIGHT_FORMAT_FLOAT:
+            return dijkstra_float(p_graph,
+                                  (const float*) p_weights,
+                                  1.0,
+                                  source,
+                                  target);
+
+        case WEIGHT_FORMAT_FIXED_POINT:
+            return dijkstra_fixed_point(
+                       p_graph,
+                       (const uint32_t*) p_weights,
+                       compact_graph_fixed_point_scale(p_graph),
+                       source,
+                       target);
+
+        default:
+            return dijkstra_double(p_graph,
+                                   (const double*) p_weights,
+                                   1.0,
+                                   source,
+                                   target);
+    }
+}
+
+compact_path* compact_dijkstra_profile(compact_graph* p_graph,
+                                       weight_profile* p_profile,
+                                       const double* p_coefficients,
+                                       uint32_t source,
+                                       uint32_t target)
+{
+    compact_path*  p_path;
+    metric_mix     mix;
+    const double** p_columns;
+    double*        p_mix_coefficients;
+    size_t         metric_count;
+    size_t         i;
+
+    if (!p_graph)        return NULL;
+    if (!p_profile)      return NULL;
+    if (!p_coefficients) return NULL;
+    if (source >= compact_graph_node_count(p_graph)) return NULL;
+    if (target >= compact_graph_node_count(p_graph)) return NULL;
+
+    if (weight_profile_arc_count(p_profile) != compact_graph_arc_count(p_graph))
+    {
+        return NULL;
+    }
+
+    metric_count = weight_profile_metric_count(p_profile);
+
+    p_columns = (const double**) malloc(sizeof(double*) * metric_count);
+    p_mix_coefficients = (double*) malloc(sizeof(double) * metric_count);
+
+    if (!p_columns || !p_mix_coefficients)
+    {
+        free(p_columns);
+        free(p_mix_coefficients);
+        return NULL;
+    }
+
+    mix.count = 0;
+    mix.p_columns = p_columns;
+    mix.p_coefficients = p_mix_coefficients;
+
+    for (i = 0; i < metric_count; ++i)
+    {
+        if (p_coefficients[i] < 0.0)
+        {
+            free(p_columns);
+            free(p_mix_coefficients);
+            return NULL;
+        }
+
+        if (p_coefficients[i] != 0.0)
+        {
+            p_columns[mix.count] = weight_profile_column(p_profile, i);
+            p_mix_coefficients[mix.count] = p_coefficients[i];
+            mix.count++;
+        }
+    }
+
+    if (mix.count == 1 && p_mix_coefficients[0] == 1.0)
+    {
+        /* A single metric is searched directly on its column. */
+        p_path = dijkstra_double(p_graph, p_columns[0], 1.0, source, target);
+    }
+    else
+    {
+        p_path = dijkstra_mixed(p_graph, &mix, 1.0, source, target);
+    }
+
+    free(p_columns);
+    free(p_mix_coefficients);
+    return p_path;
+}
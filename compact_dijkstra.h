@@ -0,0 +1,43 @@
+#ifndef COMPACT_DIJKSTRA_H
+#define COMPACT_DIJKSTRA_H
+
+#include "compact_graph.h"
+#include "path.h"
+#include "weight_profile.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * Returns a shortest path from node 'source' to node 'target' of the       *
+    * compact graph, or an empty path if 'target' is not reachable. Each       *
+    * weight format has its own search kernel: the double and single-precision *
+    * kernels sum the costs in double, the fixed-point kernel sums them        *
+    * exactly in 64-bit integers. Returns NULL if an id is out of range or     *
+    * memory runs out. The caller owns the returned path.                      *
+    ***************************************************************************/
+    compact_path* compact_dijkstra(compact_graph* p_graph,
+                                   uint32_t source,
+                                   uint32_t target);
+
+    /***************************************************************************
+    * Returns a shortest path from node 'source' to node 'target' of the       *
+    * compact graph under the weights of 'p_profile' combined linearly: the    *
+    * weight of an arc is the sum over the metrics 'k' of 'p_coefficients[k]'  *
+    * times its weight under 'k'. The coefficients must not be negative. A     *
+    * single metric with coefficient 1 is searched on its column directly.     *
+    * Returns NULL if the profile does not match the graph, a coefficient is   *
+    * negative, an id is out of range or memory runs out.                      *
+    ***************************************************************************/
+    compact_path* compact_dijkstra_profile(compact_graph* p_graph,
+                                           weight_profile* p_profile,
+                                           const double* p_coefficients,
+                                           uint32_t source,
+                                           uint32_t target);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* COMPACT_DIJKSTRA_H */
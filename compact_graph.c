@@ -0,0 +1,1096 @@
+#include "compact_graph.h"
+#include "large_array.h"
+#include "unordered_map.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+* The amount of nodes sharing one byte offset in a compressed adjacency. The   *
+* heads of a node are found by skipping the varints of the preceding nodes of  *
+* its block.                                                                   *
+*******************************************************************************/
+#define COMPRESSED_BLOCK_SIZE 16
+
+/*******************************************************************************
+* The amount of arrays of a graph that 'compact_graph_place_arrays' moves.     *
+*******************************************************************************/
+#define PLACED_ARRAY_COUNT 8
+
+typedef struct compact_graph_state {
+    uint32_t              node_count;
+    size_t                arc_count;
+    void*                 p_offsets;
+    uint32_t*             p_heads;
+    uint8_t*              p_adjacency;
+    size_t*               p_block_offsets;
+    void*                 p_reverse_offsets;
+    uint32_t*             p_reverse_tails;
+    void*                 p_reverse_arcs;
+    void*                 p_weights;
+    weight_format         format;
+    double                fixed_point_scale;
+    directed_graph_node** p_nodes;
+    point_3d*             p_points;
+    const uint64_t*       p_name_offsets;
+    const char*           p_names;
+    void(*p_release)(void*);
+    void*                 p_release_arg;
+    bool                  owns_arrays;
+    bool                  wide_offsets;
+    bool                  placed_arrays;
+} compact_graph_state;
+
+static const float LOAD_FACTOR = 1.0f;
+
+/*******************************************************************************
+* Returns entry 'i' of an array of offsets or arc indices, whose entries are   *
+* 'size_t' if the graph has wide offsets and 'uint32_t' otherwise.             *
+*******************************************************************************/
+static size_t index_get(const compact_graph_state* p_state,
+                        const void* p_array,
+                        size_t i)
+{
+    return p_state->wide_offsets ? ((const size_t*) p_array)[i]
+                                 : ((const uint32_t*) p_array)[i];
+}
+
+static void index_set(const compact_graph_state* p_state,
+                      void* p_array,
+                      size_t i,
+                      size_t value)
+{
+    if (p_state->wide_offsets)
+    {
+        ((size_t*) p_array)[i] = value;
+    }
+    else
+    {
+        ((uint32_t*) p_array)[i] = (uint32_t) value;
+    }
+}
+
+static size_t offset(const compact_graph_state* p_state, uint32_t id)
+{
+    return index_get(p_state, p_state->p_offsets, id);
+}
+
+/*******************************************************************************
+* Narrows the 'count' entries of 'p_array' to 32 bits in place and returns the *
+* array shrunk to them. Entry 'i' is written over the bytes of entry 'i / 2'   *
+* at the latest, which has been read by then. The writes go through 'memcpy'   *
+* so that they are ordered with the reads of the wide entries.                 *
+*******************************************************************************/
+static uint32_t* narrow_in_place(size_t* p_array, size_t count)
+{
+    uint32_t* p_narrow;
+    uint32_t  value;
+    size_t    i;
+
+    for (i = 0; i < count; ++i)
+    {
+        value = (uint32_t) p_array[i];
+        memcpy((char*) p_array + sizeof(uint32_t) * i, &value, sizeof(value));
+    }
+
+    /* Shrinking may fail, in which case the array just keeps its size. */
+    if ((p_narrow = realloc(p_array, sizeof(uint32_t) * (count + 1))))
+    {
+        return p_narrow;
+    }
+
+    return (uint32_t*) p_array;
+}
+
+static size_t compressed_block_count(const compact_graph_state* p_state)
+{
+    return (p_state->node_count + COMPRESSED_BLOCK_SIZE - 1) /
+           COMPRESSED_BLOCK_SIZE;
+}
+
+/*******************************************************************************
+* Stores the arrays holding the arcs of the graph into 'p_arrays' and their    *
+* sizes in bytes into 'p_sizes'. Absent arrays are NULL.                       *
+*******************************************************************************/
+static void get_arrays(const compact_graph_state* p_state,
+                       void* p_arrays[PLACED_ARRAY_COUNT],
+                       size_t p_sizes[PLACED_ARRAY_COUNT])
+{
+    size_t index_size;
+
+    index_size = p_state->wide_offsets ? sizeof(size_t) : sizeof(uint32_t);
+
+    p_arrays[0] = p_state->p_offsets;
+    p_arrays[1] = p_state->p_heads;
+    p_arrays[2] = p_state->p_adjacency;
+    p_arrays[3] = p_state->p_block_offsets;
+    p_arrays[4] = p_state->p_reverse_offsets;
+    p_arrays[5] = p_state->p_reverse_tails;
+    p_arrays[6] = p_state->p_reverse_arcs;
+    p_arrays[7] = p_state->p_weights;
+
+    p_sizes[0] = index_size * ((size_t) p_state->node_count + 1);
+    p_sizes[1] = sizeof(uint32_t) * p_state->arc_count;
+    p_sizes[2] = p_state->p_adjacency
+               ? p_state->p_block_offsets[compressed_block_count(p_state)]
+               : 0;
+    p_sizes[3] = sizeof(size_t) * (compressed_block_count(p_state) + 1);
+    p_sizes[4] = index_size * ((size_t) p_state->node_count + 1);
+    p_sizes[5] = sizeof(uint32_t) * p_state->arc_count;
+    p_sizes[6] = index_size * p_state->arc_count;
+    p_sizes[7] = weight_format_size(p_state->format) * p_state->arc_count;
+}
+
+static void set_arrays(compact_graph_state* p_state,
+                       void* p_arrays[PLACED_ARRAY_COUNT])
+{
+    p_state->p_offsets = p_arrays[0];
+    p_state->p_heads = p_arrays[1];
+    p_state->p_adjacency = p_arrays[2];
+    p_state->p_block_offsets = p_arrays[3];
+    p_state->p_reverse_offsets = p_arrays[4];
+    p_state->p_reverse_tails = p_arrays[5];
+    p_state->p_reverse_arcs = p_arrays[6];
+    p_state->p_weights = p_arrays[7];
+}
+
+static void compact_graph_state_free(compact_graph_state* p_state)
+{
+    void*  p_arrays[PLACED_ARRAY_COUNT];
+    size_t sizes[PLACED_ARRAY_COUNT];
+    size_t i;
+
+    if (!p_state->owns_arrays)
+    {
+        /* The arrays belong to the creator of the wrapping graph. */
+        if (p_state->p_release)
+        {
+            p_state->p_release(p_state->p_release_arg);
+        }
+
+        free(p_state);
+        return;
+    }
+
+    get_arrays(p_state, p_arrays, sizes);
+
+    for (i = 0; i < PLACED_ARRAY_COUNT; ++i)
+    {
+        if (p_state->placed_arrays)
+        {
+            large_array_free(p_arrays[i], sizes[i]);
+        }
+        else
+        {
+            free(p_arrays[i]);
+        }
+    }
+
+    free(p_state->p_nodes);
+    free(p_state->p_points);
+    free(p_state);
+}
+
+/*******************************************************************************
+* Writes the heads and the weights of the arcs. 'p_id_map' maps each node to   *
+* its slot in the node array, so the id of a node is the index of its slot.    *
+*******************************************************************************/
+static bool fill_arcs(compact_graph_state* p_state,
+                      unordered_map* p_id_map,
+                      directed_graph_weight_function* p_weight_function)
+{
+    directed_graph_node*  p_tail;
+    directed_graph_node** p_children;
+    directed_graph_node** p_slot;
+    double                weight;
+    size_t                child_count;
+    size_t                arc;
+    uint32_t              id;
+    size_t                i;
+
+    arc = 0;
+
+    for (id = 0; id < p_state->node_count; ++id)
+    {
+        p_tail      = p_state->p_nodes[id];
+        p_children  = directed_graph_node_children(p_tail);
+        child_count = directed_graph_node_child_count(p_tail);
+
+        index_set(p_state, p_state->p_offsets, id, arc);
+
+        for (i = 0; i < child_count; ++i, ++arc)
+        {
+            if (!(p_slot = unordered_map_get(p_id_map, p_children[i])))
+            {
+                return false;
+            }
+
+            if (!directed_graph_weight_function_get_value(p_weight_function,
+                                                          p_tail,
+                                                          p_children[i],
+                                                          &weight))
+            {
+                return false;
+            }
+
+            p_state->p_heads[arc] = (uint32_t)(p_slot - p_state->p_nodes);
+
+            if (!weight_format_write(p_state->format,
+                                     p_state->fixed_point_scale,
+                                     p_state->p_weights,
+                                     arc,
+                                     weight))
+            {
+                return false;
+            }
+        }
+    }
+
+    index_set(p_state, p_state->p_offsets, p_state->node_count, arc);
+    return true;
+}
+
+compact_graph* compact_graph_alloc(directed_graph_node** p_node_array,
+                                   size_t node_count,
+                                   directed_graph_weight_function*
+                                       p_weight_function,
+                                   weight_format format,
+                                   double fixed_point_scale)
+{
+    compact_graph*       p_graph;
+    compact_graph_state* p_state;
+    unordered_map*       p_id_map;
+    size_t               arc_count;
+    size_t               i;
+    bool                 ok;
+
+    if (!p_node_array)      return NULL;
+    if (!p_weight_function) return NULL;
+
+    /* The largest id value is reserved for COMPACT_GRAPH_NO_NODE. */
+    if (node_count >= COMPACT_GRAPH_NO_NODE) return NULL;
+
+    if (format == WEIGHT_FORMAT_FIXED_POINT && !(fixed_point_scale > 0.0))
+    {
+        return NULL;
+    }
+
+    arc_count = 0;
+
+    for (i = 0; i < node_count; ++i)
+    {
+        arc_count += directed_graph_node_child_count(p_node_array[i]);
+    }
+
+    if (!(p_graph = malloc(sizeof(*p_graph)))) return NULL;
+
+    if (!(p_state = calloc(1, sizeof(*p_state))))
+    {
+        free(p_graph);
+        return NULL;
+    }
+
+    p_state->node_count = (uint32_t) node_count;
+    p_state->arc_count = arc_count;
+    p_state->owns_arrays = true;
+    p_state->format = format;
+    p_state->fixed_point_scale =
+        format == WEIGHT_FORMAT_FIXED_POINT ? fixed_point_scale : 1.0;
+    p_state->wide_offsets = arc_count > COMPACT_GRAPH_MAX_NARROW_ARC_COUNT;
+
+    p_state->p_offsets = malloc((p_state->wide_offsets ? sizeof(size_t)
+                                                       : sizeof(uint32_t)) *
+                                (node_count + 1));
+    p_state->p_heads   = malloc(sizeof(uint32_t) * (arc_count + 1));
+    p_state->p_weights = malloc(weight_format_size(format) * (arc_count + 1));
+    p_state->p_nodes   = malloc(sizeof(directed_graph_node*) *
+                                (node_count + 1));
+
+    p_id_map = unordered_map_alloc(node_count,
+                                   LOAD_FACTOR,
+                                   hash_function,
+                                   equals_function);
+
+    if (!p_state->p_offsets || !p_state->p_heads || !p_state->p_weights ||
+        !p_state->p_nodes   || !p_id_map)
+    {
+        unordered_map_free(p_id_map);
+        compact_graph_state_free(p_state);
+        free(p_graph);
+        return NULL;
+    }
+
+    for (i = 0; i < node_count; ++i)
+    {
+        p_state->p_nodes[i] = p_node_array[i];
+
+        /* A new key yields NULL whether it was added or memory ran out. */
+        if (!unordered_map_put(p_id_map,
+                               p_node_array[i],
+                               &p_state->p_nodes[i]) &&
+            !unordered_map_contains_key(p_id_map, p_node_array[i]))
+        {
+            unordered_map_free(p_id_map);
+            compact_graph_state_free(p_state);
+            free(p_graph);
+            return NULL;
+        }
+    }
+
+    ok = fill_arcs(p_state, p_id_map, p_weight_function);
+    unordered_map_free(p_id_map);
+
+    if (!ok)
+    {
+        compact_graph_state_free(p_state);
+        free(p_graph);
+        return NULL;
+    }
+
+    p_graph->state = p_state;
+    return p_graph;
+}
+
+compact_graph* compact_graph_wrap(uint32_t node_count,
+                                  size_t arc_count,
+                                  const void* p_offsets,
+                                  const uint32_t* p_heads,
+                                  const void* p_weights,
+                                  weight_format format,
+                                  double fixed_point_scale,
+                                  const point_3d* p_points,
+                                  const uint64_t* p_name_offsets,
+                                  const char* p_names,
+                                  void(*p_release)(void*),
+                                  void* p_release_arg)
+{
+    compact_graph*       p_graph;
+    compact_graph_state* p_state;
+
+    if (!p_offsets || !p_heads || !p_weights) return NULL;
+    if (node_count >= COMPACT_GRAPH_NO_NODE)   return NULL;
+    if (!p_name_offsets != !p_names)           return NULL;
+
+    if (format == WEIGHT_FORMAT_FIXED_POINT && !(fixed_point_scale > 0.0))
+    {
+        return NULL;
+    }
+
+    if (!(p_graph = malloc(sizeof(*p_graph)))) return NULL;
+
+    if (!(p_state = calloc(1, sizeof(*p_state))))
+    {
+        free(p_graph);
+        return NULL;
+    }
+
+    p_state->node_count = node_count;
+    p_state->arc_count = arc_count;
+    p_state->p_offsets = (void*) p_offsets;
+    p_state->p_heads = (uint32_t*) p_heads;
+    p_state->p_weights = (void*) p_weights;
+    p_state->format = format;
+    p_state->fixed_point_scale =
+        format == WEIGHT_FORMAT_FIXED_POINT ? fixed_point_scale : 1.0;
+    p_state->p_points = (point_3d*) p_points;
+    p_state->p_name_offsets = p_name_offsets;
+    p_state->p_names = p_names;
+    p_state->p_release = p_release;
+    p_state->p_release_arg = p_release_arg;
+    p_state->wide_offsets = arc_count > COMPACT_GRAPH_MAX_NARROW_ARC_COUNT;
+    p_graph->state = p_state;
+    return p_graph;
+}
+
+bool compact_graph_validate(uint32_t node_count,
+                            size_t arc_count,
+                            const void* p_offsets,
+                            const uint32_t* p_heads,
+                            const uint64_t* p_name_offsets,
+                            const char* p_names,
+                            size_t names_size)
+{
+    compact_graph_state state;
+    size_t              i;
+
+    if (!p_offsets || !p_heads)      return false;
+    if (!p_name_offsets != !p_names) return false;
+
+    /* Only the layout of the offsets is needed to read them. */
+    state.wide_offsets = arc_count > COMPACT_GRAPH_MAX_NARROW_ARC_COUNT;
+
+    if (index_get(&state, p_offsets, 0) != 0)                  return false;
+    if (index_get(&state, p_offsets, node_count) != arc_count) return false;
+
+    for (i = 0; i < node_count; ++i)
+    {
+        if (index_get(&state, p_offsets, i) >
+            index_get(&state, p_offsets, i + 1))
+        {
+            return false;
+        }
+    }
+
+    for (i = 0; i < arc_count; ++i)
+    {
+        if (p_heads[i] >= node_count) return false;
+    }
+
+    if (!p_name_offsets) return true;
+
+    if (p_name_offsets[node_count] > names_size) return false;
+
+    for (i = 0; i < node_count; ++i)
+    {
+        /* Each name takes at least its terminating zero. */
+        if (p_name_offsets[i] >= p_name_offsets[i + 1]) return false;
+        if (p_names[p_name_offsets[i + 1] - 1] != '\0') return false;
+    }
+
+    return true;
+}
+
+compact_graph* compact_graph_adopt(uint32_t node_count,
+                                   size_t arc_count,
+                                   size_t* p_offsets,
+                                   uint32_t* p_heads,
+                                   void* p_weights,
+                                   weight_format format,
+                                   double fixed_point_scale,
+                                   size_t* p_reverse_offsets,
+                                   uint32_t* p_reverse_tails,
+                                   size_t* p_reverse_arcs)
+{
+    compact_graph*       p_graph;
+    compact_graph_state* p_state;
+
+    if (!p_offsets || !p_heads || !p_weights) return NULL;
+    if (node_count >= COMPACT_GRAPH_NO_NODE)   return NULL;
+
+    if (!p_reverse_offsets != !p_reverse_tails ||
+        !p_reverse_offsets != !p_reverse_arcs)
+    {
+        return NULL;
+    }
+
+    if (format == WEIGHT_FORMAT_FIXED_POINT && !(fixed_point_scale > 0.0))
+    {
+        return NULL;
+    }
+
+    if (!(p_graph = malloc(sizeof(*p_graph)))) return NULL;
+
+    if (!(p_state = calloc(1, sizeof(*p_state))))
+    {
+        free(p_graph);
+        return NULL;
+    }
+
+    p_state->node_count = node_count;
+    p_state->arc_count = arc_count;
+    p_state->owns_arrays = true;
+    p_state->p_offsets = p_offsets;
+    p_state->p_heads = p_heads;
+    p_state->p_weights = p_weights;
+    p_state->format = format;
+    p_state->fixed_point_scale =
+        format == WEIGHT_FORMAT_FIXED_POINT ? fixed_point_scale : 1.0;
+    p_state->p_reverse_offsets = p_reverse_offsets;
+    p_state->p_reverse_tails = p_reverse_tails;
+    p_state->p_reverse_arcs = p_reverse_arcs;
+    p_state->wide_offsets = arc_count > COMPACT_GRAPH_MAX_NARROW_ARC_COUNT;
+
+    if (!p_state->wide_offsets)
+    {
+        p_state->p_offsets = narrow_in_place(p_offsets, node_count + 1);
+
+        if (p_reverse_offsets)
+        {
+            p_state->p_reverse_offsets =
+                narrow_in_place(p_reverse_offsets, node_count + 1);
+            p_state->p_reverse_arcs =
+                narrow_in_place(p_reverse_arcs, arc_count);
+        }
+    }
+
+    p_graph->state = p_state;
+    return p_graph;
+}
+
+bool compact_graph_adopt_node_data(compact_graph* p_graph,
+                                   directed_graph_node** p_nodes,
+                                   point_3d* p_points)
+{
+    if (!p_graph || !p_graph->state->owns_arrays) return false;
+
+    if (p_nodes)
+    {
+        free(p_graph->state->p_nodes);
+        p_graph->state->p_nodes = p_nodes;
+    }
+
+    if (p_points)
+    {
+        free(p_graph->state->p_points);
+        p_graph->state->p_points = p_points;
+    }
+
+    return true;
+}
+
+uint32_t compact_graph_node_count(compact_graph* p_graph)
+{
+    return p_graph ? p_graph->state->node_count : 0;
+}
+
+size_t compact_graph_arc_count(compact_graph* p_graph)
+{
+    return p_graph ? p_graph->state->arc_count : 0;
+}
+
+bool compact_graph_has_wide_offsets(compact_graph* p_graph)
+{
+    return p_graph && p_graph->state->wide_offsets;
+}
+
+const void* compact_graph_offsets(compact_graph* p_graph)
+{
+    return p_graph ? p_graph->state->p_offsets : NULL;
+}
+
+size_t compact_graph_offset(compact_graph* p_graph, uint32_t id)
+{
+    return offset(p_graph->state, id);
+}
+
+const uint32_t* compact_graph_heads(compact_graph* p_graph)
+{
+    return p_graph ? p_graph->state->p_heads : NULL;
+}
+
+const void* compact_graph_reverse_offsets(compact_graph* p_graph)
+{
+    return p_graph ? p_graph->state->p_reverse_offsets : NULL;
+}
+
+size_t compact_graph_reverse_offset(compact_graph* p_graph, uint32_t id)
+{
+    return index_get(p_graph->state, p_graph->state->p_reverse_offsets, id);
+}
+
+const uint32_t* compact_graph_reverse_tails(compact_graph* p_graph)
+{
+    return p_graph ? p_graph->state->p_reverse_tails : NULL;
+}
+
+const void* compact_graph_reverse_arcs(compact_graph* p_graph)
+{
+    return p_graph ? p_graph->state->p_reverse_arcs : NULL;
+}
+
+size_t compact_graph_reverse_arc(compact_graph* p_graph, size_t position)
+{
+    return index_get(p_graph->state, p_graph->state->p_reverse_arcs, position);
+}
+
+const void* compact_graph_weights(compact_graph* p_graph)
+{
+    return p_graph ? p_graph->state->p_weights : NULL;
+}
+
+weight_format compact_graph_weight_format(compact_graph* p_graph)
+{
+    return p_graph ? p_graph->state->format : WEIGHT_FORMAT_DOUBLE;
+}
+
+double compact_graph_fixed_point_scale(compact_graph* p_graph)
+{
+    return p_graph ? p_graph->state->fixed_point_scale : 1.0;
+}
+
+double compact_graph_arc_weight(compact_graph* p_graph, size_t arc)
+{
+    return weight_format_read(p_graph->state->format,
+                              p_graph->state->fixed_point_scale,
+                              p_graph->state->p_weights,
+                              arc);
+}
+
+/*******************************************************************************
+* An arc of the node being sorted: its head and its position before sorting.   *
+*******************************************************************************/
+typedef struct head_slot {
+    uint32_t head;
+    size_t   arc;
+} head_slot;
+
+static int head_slot_cmp(const void* pa, const void* pb)
+{
+    const head_slot* p_a = pa;
+    const head_slot* p_b = pb;
+
+    if (p_a->head != p_b->head)
+    {
+        return p_a->head < p_b->head ? -1 : 1;
+    }
+
+    return p_a->arc < p_b->arc ? -1 : (p_a->arc > p_b->arc);
+}
+
+/*******************************************************************************
+* Maps the difference 'head - previous' to an unsigned value growing with its  *
+* magnitude, so that small differences of either sign get short varints.       *
+*******************************************************************************/
+static uint32_t zigzag_delta(uint32_t previous, uint32_t head)
+{
+    uint32_t delta = head - previous;
+
+    return (delta << 1) ^ (0U - (delta >> 31));
+}
+
+static size_t varint_size(uint32_t value)
+{
+    size_t size = 1;
+
+    while (value >= 0x80U)
+    {
+        value >>= 7;
+        ++size;
+    }
+
+    return size;
+}
+
+static uint8_t* write_varint(uint8_t* p_byte, uint32_t value)
+{
+    while (value >= 0x80U)
+    {
+        *p_byte++ = (uint8_t)(value | 0x80U);
+        value >>= 7;
+    }
+
+    *p_byte++ = (uint8_t) value;
+    return p_byte;
+}
+
+/*******************************************************************************
+* Sorts the arcs of each node by head, moving the weights along, and returns   *
+* the amount of bytes the compressed heads will take. If 'p_arc_map' is not    *
+* NULL, the new index of each arc is stored at its old index.                  *
+*******************************************************************************/
+static size_t sort_arcs(compact_graph_state* p_state,
+                        head_slot* p_slots,
+                        char* p_weight_buffer,
+                        size_t* p_arc_map)
+{
+    char*    p_weights;
+    size_t   weight_size;
+    size_t   byte_count;
+    size_t   degree;
+    size_t   first;
+    size_t   i;
+    uint32_t previous;
+    uint32_t id;
+
+    p_weights = p_state->p_weights;
+    weight_size = weight_format_size(p_state->format);
+    byte_count = 0;
+
+    for (id = 0; id < p_state->node_count; ++id)
+    {
+        first = offset(p_state, id);
+        degree = offset(p_state, id + 1) - first;
+
+        for (i = 0; i < degree; ++i)
+        {
+            p_slots[i].head = p_state->p_heads[first + i];
+            p_slots[i].arc = first + i;
+        }
+
+        qsort(p_slots, degree, sizeof(head_slot), head_slot_cmp);
+
+        for (i = 0; i < degree; ++i)
+        {
+            memcpy(p_weight_buffer + i * weight_size,
+                   p_weights + p_slots[i].arc * weight_size,
+                   weight_size);
+        }
+
+        if (degree > 0)
+        {
+            memcpy(p_weights + first * weight_size,
+                   p_weight_buffer,
+                   degree * weight_size);
+        }
+
+        previous = id;
+
+        for (i = 0; i < degree; ++i)
+        {
+            p_state->p_heads[first + i] = p_slots[i].head;
+
+            if (p_arc_map)
+            {
+                p_arc_map[p_slots[i].arc] = first + i;
+            }
+
+            byte_count += varint_size(zigzag_delta(previous, p_slots[i].head));
+            previous = p_slots[i].head;
+        }
+    }
+
+    return byte_count;
+}
+
+bool compact_graph_compress(compact_graph* p_graph)
+{
+    compact_graph_state* p_state;
+    head_slot*           p_slots;
+    char*                p_weight_buffer;
+    size_t*              p_arc_map;
+    uint8_t*             p_byte;
+    size_t               block_count;
+    size_t               byte_count;
+    size_t               max_degree;
+    size_t               arc;
+    uint32_t             previous;
+    uint32_t             id;
+
+    if (!p_graph) return false;
+
+    p_state = p_graph->state;
+
+    if (p_state->p_adjacency)   return true;
+    if (!p_state->owns_arrays)   return false;
+    if (p_state->placed_arrays) return false;
+
+    max_degree = 0;
+
+    for (id = 0; id < p_state->node_count; ++id)
+    {
+        if (offset(p_state, id + 1) - offset(p_state, id) > max_degree)
+        {
+            max_degree = offset(p_state, id + 1) - offset(p_state, id);
+        }
+    }
+
+    block_count = compressed_block_count(p_state);
+
+    p_slots = malloc(sizeof(head_slot) * (max_degree + 1));
+    p_weight_buffer = malloc(weight_format_size(p_state->format) *
+                             (max_degree + 1));
+    p_state->p_block_offsets = malloc(sizeof(size_t) * (block_count + 1));
+
+    /* The reverse adjacency refers to the arcs by index. */
+    p_arc_map = p_state->p_reverse_arcs
+              ? malloc(sizeof(size_t) * (p_state->arc_count + 1))
+              : NULL;
+
+    if (!p_slots || !p_weight_buffer || !p_state->p_block_offsets ||
+        (p_state->p_reverse_arcs && !p_arc_map))
+    {
+        free(p_slots);
+        free(p_weight_buffer);
+        free(p_arc_map);
+        free(p_state->p_block_offsets);
+        p_state->p_block_offsets = NULL;
+        return false;
+    }
+
+    byte_count = sort_arcs(p_state, p_slots, p_weight_buffer, p_arc_map);
+    free(p_slots);
+    free(p_weight_buffer);
+
+    if (p_arc_map)
+    {
+        for (arc = 0; arc < p_state->arc_count; ++arc)
+        {
+            index_set(p_state,
+                      p_state->p_reverse_arcs,
+                      arc,
+                      p_arc_map[index_get(p_state,
+                                          p_state->p_reverse_arcs,
+                                          arc)]);
+        }
+
+        free(p_arc_map);
+    }
+
+    if (!(p_state->p_adjacency = malloc(byte_count + 1)))
+    {
+        free(p_state->p_block_offsets);
+        p_state->p_block_offsets = NULL;
+        return false;
+    }
+
+    p_byte = p_state->p_adjacency;
+
+    for (id = 0; id < p_state->node_count; ++id)
+    {
+        if (id % COMPRESSED_BLOCK_SIZE == 0)
+        {
+            p_state->p_block_offsets[id / COMPRESSED_BLOCK_SIZE] =
+                (size_t)(p_byte - p_state->p_adjacency);
+        }
+
+        previous = id;
+
+        for (arc = offset(p_state, id); arc < offset(p_state, id + 1); ++arc)
+        {
+            p_byte = write_varint(p_byte,
+                                  zigzag_delta(previous,
+                                               p_state->p_heads[arc]));
+            previous = p_state->p_heads[arc];
+        }
+    }
+
+    p_state->p_block_offsets[block_count] = byte_count;
+
+    free(p_state->p_heads);
+    p_state->p_heads = NULL;
+    return true;
+}
+
+bool compact_graph_is_compressed(compact_graph* p_graph)
+{
+    return p_graph && p_graph->state->p_adjacency;
+}
+
+size_t compact_graph_adjacency_size(compact_graph* p_graph)
+{
+    compact_graph_state* p_state;
+    size_t               block_count;
+
+    if (!p_graph) return 0;
+
+    p_state = p_graph->state;
+
+    if (!p_state->p_adjacency)
+    {
+        return sizeof(uint32_t) * p_state->arc_count;
+    }
+
+    block_count = compressed_block_count(p_state);
+
+    return p_state->p_block_offsets[block_count] +
+           sizeof(size_t) * (block_count + 1);
+}
+
+bool compact_graph_place_arrays(compact_graph* p_graph,
+                                large_array_placement placement)
+{
+    compact_graph_state* p_state;
+    void*                p_arrays[PLACED_ARRAY_COUNT];
+    void*                p_copies[PLACED_ARRAY_COUNT];
+    size_t               sizes[PLACED_ARRAY_COUNT];
+    size_t               i;
+
+    if (!p_graph) return false;
+
+    p_state = p_graph->state;
+
+    if (!p_state->owns_arrays)  return false;
+    if (p_state->placed_arrays) return true;
+
+    get_arrays(p_state, p_arrays, sizes);
+
+    /* All copies are made before any array is given up, so that running out
+       of memory leaves the graph as it was. */
+    for (i = 0; i < PLACED_ARRAY_COUNT; ++i)
+    {
+        p_copies[i] = NULL;
+
+        if (p_arrays[i] &&
+            !(p_copies[i] = large_array_alloc(sizes[i], placement)))
+        {
+            while (i-- > 0)
+            {
+                large_array_free(p_copies[i], sizes[i]);
+            }
+
+            return false;
+        }
+    }
+
+    for (i = 0; i < PLACED_ARRAY_COUNT; ++i)
+    {
+        if (p_arrays[i])
+        {
+            memcpy(p_copies[i], p_arrays[i], sizes[i]);
+            free(p_arrays[i]);
+        }
+    }
+
+    set_arrays(p_state, p_copies);
+    p_state->placed_arrays = true;
+    return true;
+}
+
+void compact_graph_arcs(compact_graph* p_graph,
+                        uint32_t tail,
+                        compact_arc_iterator* p_iterator)
+{
+    compact_graph_state* p_state;
+    const uint8_t*       p_byte;
+    uint32_t             block_first;
+    size_t               skipped;
+
+    p_state = p_graph->state;
+
+    p_iterator->p_heads = p_state->p_heads;
+    p_iterator->p_bytes = NULL;
+    p_iterator->arc = offset(p_state, tail);
+    p_iterator->arc_end = offset(p_state, tail + 1);
+    p_iterator->head = tail;
+
+    if (!p_state->p_adjacency) return;
+
+    block_first = tail - tail % COMPRESSED_BLOCK_SIZE;
+    p_byte = p_state->p_adjacency +
+             p_state->p_block_offsets[tail / COMPRESSED_BLOCK_SIZE];
+
+    /* Each varint ends with the only byte of it having the top bit clear. */
+    for (skipped = p_iterator->arc - offset(p_state, block_first);
+         skipped > 0;
+         ++p_byte)
+    {
+        if (!(*p_byte & 0x80U))
+        {
+            --skipped;
+        }
+    }
+
+    p_iterator->p_bytes = p_byte;
+}
+
+bool compact_graph_attach_points(compact_graph* p_graph,
+                                 unordered_map* p_point_map)
+{
+    compact_graph_state* p_state;
+    point_3d*            p_points;
+    point_3d*            p_point;
+    uint32_t             id;
+
+    if (!p_graph || !p_point_map) return false;
+
+    p_state = p_graph->state;
+
+    if (!p_state->owns_arrays || !p_state->p_nodes) return false;
+
+    if (!(p_points = malloc(sizeof(point_3d) * (p_state->node_count + 1))))
+    {
+        return false;
+    }
+
+    for (id = 0; id < p_state->node_count; ++id)
+    {
+        if (!(p_point = unordered_map_get(p_point_map, p_state->p_nodes[id])))
+        {
+            free(p_points);
+            return false;
+        }
+
+        p_points[id] = *p_point;
+    }
+
+    free(p_state->p_points);
+    p_state->p_points = p_points;
+    return true;
+}
+
+const point_3d* compact_graph_points(compact_graph* p_graph)
+{
+    return p_graph ? p_graph->state->p_points : NULL;
+}
+
+const char* compact_graph_name(compact_graph* p_graph, uint32_t id)
+{
+    if (!p_graph || id >= p_graph->state->node_count) return NULL;
+
+    if (p_graph->state->p_names)
+    {
+        return p_graph->state->p_names + p_graph->state->p_name_offsets[id];
+    }
+
+    if (p_graph->state->p_nodes)
+    {
+        return directed_graph_node_name(p_graph->state->p_nodes[id]);
+    }
+
+    return NULL;
+}
+
+directed_graph_node* compact_graph_node(compact_graph* p_graph, uint32_t id)
+{
+    if (!p_graph || !p_graph->state->p_nodes) return NULL;
+    if (id >= p_graph->state->node_count)     return NULL;
+
+    return p_graph->state->p_nodes[id];
+}
+
+graph_memory_summary compact_graph_memory_summary(compact_graph* p_graph)
+{
+    graph_memory_summary summary;
+    compact_graph_state* p_state;
+    void*                p_arrays[PLACED_ARRAY_COUNT];
+    size_t               sizes[PLACED_ARRAY_COUNT];
+    size_t               i;
+
+    memset(&summary, 0, sizeof(summary));
+
+    if (!p_graph) return summary;
+
+    p_state = p_graph->state;
+    get_arrays(p_state, p_arrays, sizes);
+
+    /* The arrays hold exactly the graph, so all of them are live. */
+    for (i = 0; i < PLACED_ARRAY_COUNT; ++i)
+    {
+        if (!p_arrays[i]) continue;
+
+        if (p_arrays[i] == p_state->p_weights)
+        {
+            summary.weights.allocated += sizes[i];
+        }
+        else
+        {
+            summary.adjacency.allocated += sizes[i];
+        }
+    }
+
+    summary.adjacency.allocated += sizeof(*p_graph) + sizeof(*p_state);
+
+    if (p_state->p_nodes)
+    {
+        summary.adjacency.allocated += sizeof(directed_graph_node*) *
+                                       p_state->node_count;
+    }
+
+    if (p_state->p_name_offsets)
+    {
+        summary.names.allocated =
+            sizeof(uint64_t) * ((size_t) p_state->node_count + 1) +
+            (size_t) p_state->p_name_offsets[p_state->node_count];
+    }
+
+    if (p_state->p_points)
+    {
+        summary.coordinates.allocated =
+            sizeof(point_3d) * p_state->node_count;
+    }
+
+    summary.adjacency.live = summary.adjacency.allocated;
+    summary.weights.live = summary.weights.allocated;
+    summary.names.live = summary.names.allocated;
+    summary.coordinates.live = summary.coordinates.allocated;
+    return summary;
+}
+
+void compact_graph_free(compact_graph* p_graph)
+{
+    if (!p_graph) return;
+
+    compact_graph_state_free(p_graph->state);
+    free(p_graph);
+}
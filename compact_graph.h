@@ -0,0 +1,358 @@
+#ifndef COMPACT_GRAPH_H
+#define COMPACT_GRAPH_H
+
+#include "directed_graph_node.h"
+#include "large_array.h"
+#include "memory_usage.h"
+#include "typed_common.h"
+#include "weight_function.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+* Denotes the absence of a node id.                                            *
+*******************************************************************************/
+#define COMPACT_GRAPH_NO_NODE UINT32_MAX
+
+/*******************************************************************************
+* The largest amount of arcs for which the offsets and the arc indices of a    *
+* compact graph are stored as 32-bit integers. A graph with more arcs stores   *
+* them as 'size_t'.                                                            *
+*******************************************************************************/
+#define COMPACT_GRAPH_MAX_NARROW_ARC_COUNT UINT32_MAX
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * A frozen snapshot of a weighted graph in compressed sparse row form. The *
+    * nodes are identified by the dense ids '0, 1, ..., node_count - 1'. The   *
+    * arcs leaving node 'i' are 'offsets[i]' to 'offsets[i + 1] - 1'; the head *
+    * of arc 'a' is 'heads[a]' and its weight is the a'th element of the       *
+    * weight array, stored in the weight format of the graph. The offsets are  *
+    * 32 bits wide unless there are too many arcs for that.                    *
+    ***************************************************************************/
+    typedef struct compact_graph {
+        struct compact_graph_state* state;
+    } compact_graph;
+
+    /***************************************************************************
+    * Walks the arcs leaving one node in order, whether the heads are stored   *
+    * plainly or compressed. Set up by 'compact_graph_arcs' and advanced by    *
+    * 'compact_arc_iterator_next'.                                             *
+    ***************************************************************************/
+    typedef struct compact_arc_iterator {
+        const uint32_t* p_heads;
+        const uint8_t*  p_bytes;
+        size_t          arc;
+        size_t          arc_end;
+        uint32_t        head;
+    } compact_arc_iterator;
+
+    /***************************************************************************
+    * Freezes the graph spanned by the 'node_count' nodes in 'p_node_array',   *
+    * the i'th node getting id i, with the weights of 'p_weight_function'      *
+    * converted to format 'format'. Returns NULL if an arc leads out of the    *
+    * node array, an arc has no weight, a weight is not representable in the   *
+    * format, or there are too many nodes for 32-bit ids.                      *
+    ***************************************************************************/
+    compact_graph* compact_graph_alloc(directed_graph_node** p_node_array,
+                                       size_t node_count,
+                                       directed_graph_weight_function*
+                                           p_weight_function,
+                                       weight_format format,
+                                       double fixed_point_scale);
+
+    /***************************************************************************
+    * Creates a compact graph over arrays owned by someone else, such as a     *
+    * mapped file: 'node_count + 1' offsets, 'arc_count' heads and weights,    *
+    * optionally 'node_count' points, and optionally a name table of           *
+    * 'node_count + 1' offsets into the characters 'p_names', the name of node *
+    * 'i' starting at 'p_names[p_name_offsets[i]]' and being terminated by a   *
+    * zero. The offsets are 32-bit integers unless 'arc_count' exceeds         *
+    * 'COMPACT_GRAPH_MAX_NARROW_ARC_COUNT', and 'size_t' otherwise. The arrays *
+    * are not copied, nor checked; see 'compact_graph_validate'. 'p_release',  *
+    * if not NULL, is called with 'p_release_arg' when the graph is            *
+    * deallocated.                                                             *
+    ***************************************************************************/
+    compact_graph* compact_graph_wrap(uint32_t node_count,
+                                      size_t arc_count,
+                                      const void* p_offsets,
+                                      const uint32_t* p_heads,
+                                      const void* p_weights,
+                                      weight_format format,
+                                      double fixed_point_scale,
+                                      const point_3d* p_points,
+                                      const uint64_t* p_name_offsets,
+                                      const char* p_names,
+                                      void(*p_release)(void*),
+                                      void* p_release_arg);
+
+    /***************************************************************************
+    * Checks arrays laid out as 'compact_graph_wrap' expects them in one pass: *
+    * the offsets start at zero, never decrease and end at 'arc_count', every  *
+    * head is a node, and, if 'p_name_offsets' is not NULL, the name offsets   *
+    * never decrease and every name ends with a zero within the 'names_size'   *
+    * characters of 'p_names'. Returns false if any of this does not hold.     *
+    ***************************************************************************/
+    bool compact_graph_validate(uint32_t node_count,
+                                size_t arc_count,
+                                const void* p_offsets,
+                                const uint32_t* p_heads,
+                                const uint64_t* p_name_offsets,
+                                const char* p_names,
+                                size_t names_size);
+
+    /***************************************************************************
+    * Creates a compact graph taking over the arrays allocated by the caller   *
+    * with 'malloc': 'node_count + 1' offsets, 'arc_count' heads and weights   *
+    * and optionally the reverse adjacency, which is 'node_count + 1' offsets  *
+    * into 'arc_count' tails and forward arc indices, the arcs entering node   *
+    * 'i' being 'p_reverse_offsets[i]' to 'p_reverse_offsets[i + 1] - 1'. The  *
+    * arrays are freed along with the graph, but not if NULL is returned.      *
+    * Unless 'arc_count' exceeds 'COMPACT_GRAPH_MAX_NARROW_ARC_COUNT', the     *
+    * offsets and the arc indices are narrowed to 32 bits in place.            *
+    ***************************************************************************/
+    compact_graph* compact_graph_adopt(uint32_t node_count,
+                                       size_t arc_count,
+                                       size_t* p_offsets,
+                                       uint32_t* p_heads,
+                                       void* p_weights,
+                                       weight_format format,
+                                       double fixed_point_scale,
+                                       size_t* p_reverse_offsets,
+                                       uint32_t* p_reverse_tails,
+                                       size_t* p_reverse_arcs);
+
+    /***************************************************************************
+    * Hands the node array 'p_nodes' and the coordinates 'p_points' of the     *
+    * nodes, both allocated with 'malloc' and either of them possibly NULL,    *
+    * over to a graph created by 'compact_graph_adopt'. Node 'i' of the graph  *
+    * is 'p_nodes[i]' at 'p_points[i]'. Returns false, taking over nothing, if *
+    * the graph wraps arrays it does not own.                                  *
+    ***************************************************************************/
+    bool compact_graph_adopt_node_data(compact_graph* p_graph,
+                                       directed_graph_node** p_nodes,
+                                       point_3d* p_points);
+
+    /***************************************************************************
+    * Returns the amount of nodes in the graph.                                *
+    ***************************************************************************/
+    uint32_t compact_graph_node_count(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the amount of arcs in the graph.                                 *
+    ***************************************************************************/
+    size_t compact_graph_arc_count(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns true if the offsets and the arc indices of the graph are stored  *
+    * as 'size_t', and false if they are 32-bit integers.                      *
+    ***************************************************************************/
+    bool compact_graph_has_wide_offsets(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the offset array of 'node_count + 1' entries, whose type is      *
+    * 'size_t' if the graph has wide offsets and 'uint32_t' otherwise.         *
+    ***************************************************************************/
+    const void* compact_graph_offsets(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the index of the first arc leaving node 'id', or the amount of   *
+    * arcs if 'id' is 'node_count'.                                            *
+    ***************************************************************************/
+    size_t compact_graph_offset(compact_graph* p_graph, uint32_t id);
+
+    /***************************************************************************
+    * Returns the head array of 'arc_count' entries, or NULL if the heads are  *
+    * compressed.                                                              *
+    ***************************************************************************/
+    const uint32_t* compact_graph_heads(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the offsets of the reverse adjacency, of the same type as the    *
+    * forward ones, or NULL if the graph has none.                             *
+    ***************************************************************************/
+    const void* compact_graph_reverse_offsets(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the position of the first arc entering node 'id' in the reverse  *
+    * adjacency, or the amount of arcs if 'id' is 'node_count'. The graph must *
+    * have a reverse adjacency.                                                *
+    ***************************************************************************/
+    size_t compact_graph_reverse_offset(compact_graph* p_graph, uint32_t id);
+
+    /***************************************************************************
+    * Returns the tails of the arcs in the order of the reverse adjacency, or  *
+    * NULL if the graph has none.                                              *
+    ***************************************************************************/
+    const uint32_t* compact_graph_reverse_tails(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the indices of the arcs in the order of the reverse adjacency,   *
+    * by which their weights are found, of the same type as the offsets, or    *
+    * NULL if the graph has none.                                              *
+    ***************************************************************************/
+    const void* compact_graph_reverse_arcs(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the index of the arc at position 'position' of the reverse       *
+    * adjacency. The graph must have a reverse adjacency.                      *
+    ***************************************************************************/
+    size_t compact_graph_reverse_arc(compact_graph* p_graph, size_t position);
+
+    /***************************************************************************
+    * Replaces the head array by a byte stream: the heads of each node are     *
+    * sorted, and each is stored as its difference to the previous head, the   *
+    * first head as its difference to the tail, in a zigzag varint of 1 to 5   *
+    * bytes. The weights are reordered along with the heads, so weight         *
+    * profiles are to be loaded after compressing; the reverse adjacency is    *
+    * updated. Returns false if the graph wraps arrays it does not own, its    *
+    * arrays have been placed, or memory runs out, in which case the heads     *
+    * stay plain.                                                              *
+    ***************************************************************************/
+    bool compact_graph_compress(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns true if the heads of the graph are compressed.                   *
+    ***************************************************************************/
+    bool compact_graph_is_compressed(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the amount of bytes taken by the heads, compressed or not.       *
+    ***************************************************************************/
+    size_t compact_graph_adjacency_size(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Moves the offsets, the heads, the weights and the reverse adjacency of   *
+    * the graph into large arrays placed by 'placement', cutting down on TLB   *
+    * misses for graphs of many megabytes. Meant for a graph in its final      *
+    * form: compressing fails afterwards. Returns false if the graph wraps     *
+    * arrays it does not own or memory runs out, in which case the arrays stay *
+    * where they were.                                                         *
+    ***************************************************************************/
+    bool compact_graph_place_arrays(compact_graph* p_graph,
+                                    large_array_placement placement);
+
+    /***************************************************************************
+    * Sets up 'p_iterator' to walk the arcs leaving node 'tail'.               *
+    ***************************************************************************/
+    void compact_graph_arcs(compact_graph* p_graph,
+                            uint32_t tail,
+                            compact_arc_iterator* p_iterator);
+
+    /***************************************************************************
+    * Reads a varint of at most 5 bytes and moves '*pp_bytes' past it.         *
+    ***************************************************************************/
+    TYPED_INLINE uint32_t compact_graph_read_varint(const uint8_t** pp_bytes)
+    {
+        const uint8_t* p_byte = *pp_bytes;
+        uint32_t       value  = *p_byte & 0x7fU;
+        unsigned       shift  = 7;
+
+        while (*p_byte++ & 0x80U)
+        {
+            value |= (uint32_t)(*p_byte & 0x7fU) << shift;
+            shift += 7;
+        }
+
+        *pp_bytes = p_byte;
+        return value;
+    }
+
+    /***************************************************************************
+    * Moves to the next arc, storing its index into '*p_arc' and its head into *
+    * '*p_head'. Returns false if there are no more arcs.                      *
+    ***************************************************************************/
+    TYPED_INLINE bool compact_arc_iterator_next(
+                          compact_arc_iterator* p_iterator,
+                          size_t* p_arc,
+                          uint32_t* p_head)
+    {
+        uint32_t delta;
+
+        if (p_iterator->arc == p_iterator->arc_end) return false;
+
+        if (p_iterator->p_heads)
+        {
+            p_iterator->head = p_iterator->p_heads[p_iterator->arc];
+        }
+        else
+        {
+            delta = compact_graph_read_varint(&p_iterator->p_bytes);
+            p_iterator->head += (delta >> 1) ^ (0U - (delta & 1U));
+        }
+
+        *p_arc = p_iterator->arc++;
+        *p_head = p_iterator->head;
+        return true;
+    }
+
+    /***************************************************************************
+    * Returns the weight array of 'arc_count' entries.                         *
+    ***************************************************************************/
+    const void* compact_graph_weights(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the storage format of the weights.                               *
+    ***************************************************************************/
+    weight_format compact_graph_weight_format(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the amount of fixed-point units per unit of weight, or 1 for the *
+    * other formats.                                                           *
+    ***************************************************************************/
+    double compact_graph_fixed_point_scale(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the weight of the arc 'arc' widened to double.                   *
+    ***************************************************************************/
+    double compact_graph_arc_weight(compact_graph* p_graph, size_t arc);
+
+    /***************************************************************************
+    * Copies the coordinates of the nodes from 'p_point_map' into the graph.   *
+    * Returns false if a node has no point, or the graph wraps arrays it does  *
+    * not own.                                                                 *
+    ***************************************************************************/
+    bool compact_graph_attach_points(compact_graph* p_graph,
+                                     unordered_map* p_point_map);
+
+    /***************************************************************************
+    * Returns the array of the 'node_count' node coordinates, or NULL if the   *
+    * graph has none.                                                          *
+    ***************************************************************************/
+    const point_3d* compact_graph_points(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the name of node 'id', or NULL if the id is out of range or the  *
+    * graph has no names.                                                      *
+    ***************************************************************************/
+    const char* compact_graph_name(compact_graph* p_graph, uint32_t id);
+
+    /***************************************************************************
+    * Returns the node the graph was frozen from having id 'id', or NULL if    *
+    * the id is out of range or the graph was not frozen from nodes.           *
+    ***************************************************************************/
+    directed_graph_node* compact_graph_node(compact_graph* p_graph,
+                                            uint32_t id);
+
+    /***************************************************************************
+    * Returns the memory taken by the arrays of the graph, all of which is     *
+    * live. The heads, the offsets, the reverse adjacency and the node array   *
+    * count as adjacency. The arrays of a graph mapped from a file are counted *
+    * as well. The graph keeps no search scratch.                              *
+    ***************************************************************************/
+    graph_memory_summary compact_graph_memory_summary(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Deallocates the compact graph. The original nodes are not touched.       *
+    ***************************************************************************/
+    void compact_graph_free(compact_graph* p_graph);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* COMPACT_GRAPH_H */
@@ -0,0 +1,347 @@
+#include "compact_graph_file.h"
+#include "file_mapping.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FILE_MAGIC      "CMPGRAPH"
+#define BYTE_ORDER_MARK 0x01020304U
+#define HAS_POINTS      1U
+#define HAS_NAMES       2U
+
+typedef struct file_header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint32_t node_count;
+    uint32_t weight_format;
+    uint64_t arc_count;
+    double   fixed_point_scale;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t names_size;
+    uint64_t file_size;
+} file_header;
+
+/*******************************************************************************
+* The byte positions of the sections of a file.                                *
+*******************************************************************************/
+typedef struct file_layout {
+    size_t offsets;
+    size_t heads;
+    size_t weights;
+    size_t points;
+    size_t name_offsets;
+    size_t names;
+    size_t end;
+} file_layout;
+
+static size_t align8(size_t position)
+{
+    return (position + 7) & ~(size_t) 7;
+}
+
+/*******************************************************************************
+* Returns the size of an offset in a file of 'arc_count' arcs, which matches   *
+* the offsets of a compact graph of as many arcs.                              *
+*******************************************************************************/
+static size_t offset_size(uint64_t arc_count)
+{
+    return arc_count > COMPACT_GRAPH_MAX_NARROW_ARC_COUNT ? sizeof(uint64_t)
+                                                          : sizeof(uint32_t);
+}
+
+/*******************************************************************************
+* Advances '*p_position' past 'count' entries of 'size' bytes. Returns false   *
+* if the position would overflow.                                              *
+*******************************************************************************/
+static bool skip_entries(size_t* p_position, uint64_t count, size_t size)
+{
+    if (count > (SIZE_MAX - *p_position) / size) return false;
+
+    *p_position += (size_t) count * size;
+    return true;
+}
+
+/*******************************************************************************
+* Places the sections described by the header. Returns false if a section      *
+* would end beyond what 'size_t' can address, which no file can be opened      *
+* with.                                                                        *
+*******************************************************************************/
+static bool compute_layout(const file_header* p_header, file_layout* p_layout)
+{
+    size_t position;
+
+    position = sizeof(file_header);
+
+    p_layout->offsets = position;
+
+    if (!skip_entries(&position,
+                      (uint64_t) p_header->node_count + 1,
+                      offset_size(p_header->arc_count)))
+    {
+        return false;
+    }
+
+    p_layout->heads = position = align8(position);
+
+    if (!skip_entries(&position, p_header->arc_count, sizeof(uint32_t)))
+    {
+        return false;
+    }
+
+    p_layout->weights = position = align8(position);
+
+    if (!skip_entries(&position,
+                      p_header->arc_count,
+                      weight_format_size(p_header->weight_format)))
+    {
+        return false;
+    }
+
+    p_layout->points = position = align8(position);
+
+    if ((p_header->flags & HAS_POINTS) &&
+        !skip_entries(&position, p_header->node_count, sizeof(point_3d)))
+    {
+        return false;
+    }
+
+    p_layout->name_offsets = position;
+
+    if ((p_header->flags & HAS_NAMES) &&
+        !skip_entries(&position,
+                      (uint64_t) p_header->node_count + 1,
+                      sizeof(uint64_t)))
+    {
+        return false;
+    }
+
+    p_layout->names = position;
+
+    if ((p_header->flags & HAS_NAMES) &&
+        !skip_entries(&position, p_header->names_size, 1))
+    {
+        return false;
+    }
+
+    /* 'align8' cannot overflow once the position is below 'SIZE_MAX - 7'. */
+    if (position > SIZE_MAX - 7) return false;
+
+    p_layout->end = align8(position);
+    return true;
+}
+
+/*******************************************************************************
+* Pads a section of 'size' bytes with zeros up to the next multiple of 8.      *
+*******************************************************************************/
+static bool write_padding(FILE* p_file, size_t size)
+{
+    static const char zeros[8] = { 0 };
+
+    size = align8(size) - size;
+
+    return fwrite(zeros, 1, size, p_file) == size;
+}
+
+static bool write_section(FILE* p_file, const void* p_data, size_t size)
+{
+    if (size && fwrite(p_data, 1, size, p_file) != size) return false;
+
+    return write_padding(p_file, size);
+}
+
+/*******************************************************************************
+* Writes the name table: the offsets of the names followed by the names, each  *
+* terminated by a zero.                                                        *
+*******************************************************************************/
+static bool write_names(FILE* p_file,
+                        compact_graph* p_graph,
+                        uint64_t names_size)
+{
+    uint64_t offset;
+    uint32_t id;
+    size_t   length;
+
+    offset = 0;
+
+    for (id = 0; id < compact_graph_node_count(p_graph); ++id)
+    {
+        if (fwrite(&offset, sizeof(offset), 1, p_file) != 1) return false;
+
+        offset += strlen(compact_graph_name(p_graph, id)) + 1;
+    }
+
+    if (fwrite(&offset, sizeof(offset), 1, p_file) != 1) return false;
+
+    for (id = 0; id < compact_graph_node_count(p_graph); ++id)
+    {
+        length = strlen(compact_graph_name(p_graph, id)) + 1;
+
+        if (fwrite(compact_graph_name(p_graph, id), 1, length, p_file)
+            != length)
+        {
+            return false;
+        }
+    }
+
+    return write_padding(p_file, (size_t) names_size);
+}
+
+bool compact_graph_save(compact_graph* p_graph, const char* p_file_name)
+{
+    file_header header;
+    file_layout layout;
+    FILE*       p_file;
+    uint32_t    id;
+    bool        ok;
+
+    if (!p_graph || !p_file_name) return false;
+
+    /* The format stores the heads plainly. */
+    if (compact_graph_is_compressed(p_graph)) return false;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = COMPACT_GRAPH_FILE_VERSION;
+    header.byte_order_mark = BYTE_ORDER_MARK;
+    header.node_count = compact_graph_node_count(p_graph);
+    header.weight_format = compact_graph_weight_format(p_graph);
+    header.arc_count = compact_graph_arc_count(p_graph);
+    header.fixed_point_scale = compact_graph_fixed_point_scale(p_graph);
+
+    if (compact_graph_points(p_graph))
+    {
+        header.flags |= HAS_POINTS;
+    }
+
+    header.flags |= HAS_NAMES;
+
+    for (id = 0; id < header.node_count; ++id)
+    {
+        if (!compact_graph_name(p_graph, id))
+        {
+            header.flags &= ~HAS_NAMES;
+            header.names_size = 0;
+            break;
+        }
+
+        header.names_size += strlen(compact_graph_name(p_graph, id)) + 1;
+    }
+
+    if (!compute_layout(&header, &layout)) return false;
+
+    header.file_size = layout.end;
+
+    if (!(p_file = fopen(p_file_name, "wb"))) return false;
+
+    ok = fwrite(&header, sizeof(header), 1, p_file) == 1 &&
+         write_section(p_file,
+                       compact_graph_offsets(p_graph),
+                       offset_size(header.arc_count) *
+                       ((size_t) header.node_count + 1)) &&
+         write_section(p_file,
+                       compact_graph_heads(p_graph),
+                       sizeof(uint32_t) * header.arc_count) &&
+         write_section(p_file,
+                       compact_graph_weights(p_graph),
+                       weight_format_size(header.weight_format) *
+                       header.arc_count);
+
+    if (ok && (header.flags & HAS_POINTS))
+    {
+        ok = write_section(p_file,
+                           compact_graph_points(p_graph),
+                           sizeof(point_3d) * header.node_count);
+    }
+
+    if (ok && (header.flags & HAS_NAMES))
+    {
+        ok = write_names(p_file, p_graph, header.names_size);
+    }
+
+    return (fclose(p_file) == 0) && ok;
+}
+
+compact_graph* compact_graph_open(const char* p_file_name)
+{
+    file_mapping*      p_mapping;
+    const file_header* p_header;
+    const char*        p_base;
+    const void*        p_offsets;
+    file_layout        layout;
+    compact_graph*     p_graph;
+
+    if (!p_file_name) return NULL;
+
+    if (!(p_mapping = file_mapping_open(p_file_name))) return NULL;
+
+    p_base = p_mapping->p_address;
+    p_header = (const file_header*) p_base;
+
+    if (p_mapping->size < sizeof(file_header)                             ||
+        memcmp(p_header->magic, FILE_MAGIC, sizeof(p_header->magic)) != 0 ||
+        p_header->version != COMPACT_GRAPH_FILE_VERSION                   ||
+        p_header->byte_order_mark != BYTE_ORDER_MARK                      ||
+        p_header->weight_format > WEIGHT_FORMAT_FIXED_POINT               ||
+        p_header->node_count >= COMPACT_GRAPH_NO_NODE                     ||
+        p_header->arc_count > SIZE_MAX)
+    {
+        file_mapping_close(p_mapping);
+        return NULL;
+    }
+
+    if (!compute_layout(p_header, &layout))
+    {
+        file_mapping_close(p_mapping);
+        return NULL;
+    }
+
+    p_offsets = p_base + layout.offsets;
+
+    /* The sections are only read once they are known to lie in the file. */
+    if (layout.end != p_header->file_size ||
+        layout.end > p_mapping->size      ||
+        !compact_graph_validate(
+             p_header->node_count,
+             (size_t) p_header->arc_count,
+             p_offsets,
+             (const uint32_t*)(p_base + layout.heads),
+             (p_header->flags & HAS_NAMES)
+                 ? (const uint64_t*)(p_base + layout.name_offsets)
+                 : NULL,
+             (p_header->flags & HAS_NAMES) ? p_base + layout.names : NULL,
+             (size_t) p_header->names_size))
+    {
+        file_mapping_close(p_mapping);
+        return NULL;
+    }
+
+    p_graph = compact_graph_wrap(
+                  p_header->node_count,
+                  (size_t) p_header->arc_count,
+                  p_offsets,
+                  (const uint32_t*)(p_base + layout.heads),
+                  p_base + layout.weights,
+                  (weight_format) p_header->weight_format,
+                  p_header->fixed_point_scale,
+                  (p_header->flags & HAS_POINTS)
+                      ? (const point_3d*)(p_base + layout.points)
+                      : NULL,
+                  (p_header->flags & HAS_NAMES)
+                      ? (const uint64_t*)(p_base + layout.name_offsets)
+                      : NULL,
+                  (p_header->flags & HAS_NAMES)
+                      ? p_base + layout.names
+                      : NULL,
+                  file_mapping_close,
+                  p_mapping);
+
+    if (!p_graph)
+    {
+        file_mapping_close(p_mapping);
+    }
+
+    return p_graph;
+}
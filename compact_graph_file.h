@@ -0,0 +1,46 @@
+#ifndef COMPACT_GRAPH_FILE_H
+#define COMPACT_GRAPH_FILE_H
+
+#include "compact_graph.h"
+#include <stdbool.h>
+
+/*******************************************************************************
+* The version of the binary compact graph format written by                    *
+* 'compact_graph_save'. A file starts with a 64-byte header holding a magic    *
+* string, the version, a byte order mark, the counts, the weight format and    *
+* the section flags. The header is followed by the sections, each starting at  *
+* a multiple of 8 bytes: the offsets, which are 32-bit integers unless there   *
+* are more than 'COMPACT_GRAPH_MAX_NARROW_ARC_COUNT' arcs and 64-bit integers  *
+* otherwise, the 32-bit heads, the weights, then optionally the points and the *
+* name table.                                                                  *
+*******************************************************************************/
+#define COMPACT_GRAPH_FILE_VERSION 2
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * Writes the graph to the file 'p_file_name', including the points and the *
+    * names of the nodes if the graph has them. Returns false on an I/O error  *
+    * or if the heads of the graph are compressed.                             *
+    ***************************************************************************/
+    bool compact_graph_save(compact_graph* p_graph, const char* p_file_name);
+
+    /***************************************************************************
+    * Opens a graph written by 'compact_graph_save'. The file is mapped into   *
+    * memory and the graph uses the arrays in place, so opening copies nothing *
+    * and allocates no memory proportional to the size of the graph. The       *
+    * mapping is released when the graph is deallocated. Where mapping is not  *
+    * available, the file is read into memory instead. The arrays are checked  *
+    * in one pass by 'compact_graph_validate'. Returns NULL if the file cannot *
+    * be opened, is not a compact graph file of this version and byte order,   *
+    * is truncated, or its arrays do not describe a graph.                     *
+    ***************************************************************************/
+    compact_graph* compact_graph_open(const char* p_file_name);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* COMPACT_GRAPH_FILE_H */
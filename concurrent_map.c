@@ -0,0 +1,568 @@
+#include "concurrent_map.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+* The amount of writer locks. Bucket 'i' is guarded by the lock                *
+* 'i & (LOCK_STRIPES - 1)' at every table capacity, since the capacity never   *
+* drops below the amount of stripes.                                           *
+*******************************************************************************/
+#define LOCK_STRIPES 64
+
+typedef struct concurrent_map_entry {
+    void*                                 key;
+    size_t                                hash;
+    _Atomic(void*)                        value;
+    _Atomic(struct concurrent_map_entry*) chain_next;
+} concurrent_map_entry;
+
+typedef struct concurrent_map_table {
+    size_t                         capacity;
+    size_t                         mask;
+    _Atomic(concurrent_map_entry*) buckets[];
+} concurrent_map_table;
+
+typedef struct concurrent_map_state {
+    _Atomic(concurrent_map_table*) table;
+    pthread_mutex_t                locks[LOCK_STRIPES];
+    pthread_mutex_t                retire_lock;
+    void**                         retired;
+    size_t                         retired_count;
+    size_t                         retired_capacity;
+    size_t(*hash_function)(void*);
+    bool(*equals_function)(void*, void*);
+    atomic_size_t                  size;
+    float                          load_factor;
+} concurrent_map_state;
+
+static const float MINIMUM_LOAD_FACTOR = 0.2f;
+
+/*******************************************************************************
+* Makes sure that the initial capacity is no less than the amount of lock      *
+* stripes and is a power of two.                                               *
+*******************************************************************************/
+static size_t fix_initial_capacity(size_t initial_capacity)
+{
+    size_t ret = LOCK_STRIPES;
+
+    while (ret < initial_capacity)
+    {
+        ret <<= 1;
+    }
+
+    return ret;
+}
+
+static concurrent_map_table* concurrent_map_table_alloc(size_t capacity)
+{
+    concurrent_map_table* p_table;
+    size_t                i;
+
+    p_table = malloc(sizeof(*p_table) +
+                     sizeof(_Atomic(concurrent_map_entry*)) * capacity);
+
+    if (!p_table)
+    {
+        return NULL;
+    }
+
+    p_table->capacity = capacity;
+    p_table->mask = capacity - 1;
+
+    for (i = 0; i < capacity; ++i)
+    {
+        atomic_init(&p_table->buckets[i], NULL);
+    }
+
+    return p_table;
+}
+
+concurrent_map* concurrent_map_alloc(size_t initial_capacity,
+    float load_factor,
+    size_t(*hash_function)(void*),
+    bool(*equals_function)(void*, void*))
+{
+    concurrent_map*       map;
+    concurrent_map_table* p_table;
+    size_t                i;
+
+    if (!hash_function || !equals_function)
+    {
+        return NULL;
+    }
+
+    if (!(map = malloc(sizeof(*map))))
+    {
+        return NULL;
+    }
+
+    if (!(map->state = malloc(sizeof(*map->state))))
+    {
+        free(map);
+        return NULL;
+    }
+
+    if (!(p_table = concurrent_map_table_alloc(
+                        fix_initial_capacity(initial_capacity))))
+    {
+        free(map->state);
+        free(map);
+        return NULL;
+    }
+
+    for (i = 0; i < LOCK_STRIPES; ++i)
+    {
+        pthread_mutex_init(&map->state->locks[i], NULL);
+    }
+
+    pthread_mutex_init(&map->state->retire_lock, NULL);
+    atomic_init(&map->state->table, p_table);
+    atomic_init(&map->state->size, 0);
+
+    map->state->retired          = NULL;
+    map->state->retired_count    = 0;
+    map->state->retired_capacity = 0;
+    map->state->hash_function    = hash_function;
+    map->state->equals_function  = equals_function;
+    map->state->load_factor      = load_factor < MINIMUM_LOAD_FACTOR ?
+                                   MINIMUM_LOAD_FACTOR : load_factor;
+    return map;
+}
+
+void concurrent_map_retire(concurrent_map* map, void* p_memory)
+{
+    void** p_new_retired;
+    size_t new_capacity;
+
+    if (!map || !p_memory)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&map->state->retire_lock);
+
+    if (map->state->retired_count == map->state->retired_capacity)
+    {
+        new_capacity = map->state->retired_capacity ?
+                       2 * map->state->retired_capacity : 16;
+        p_new_retired = realloc(map->state->retired,
+                                sizeof(void*) * new_capacity);
+
+        if (!p_new_retired)
+        {
+            /* Leaking is the only safe option left. */
+            pthread_mutex_unlock(&map->state->retire_lock);
+            return;
+        }
+
+        map->state->retired = p_new_retired;
+        map->state->retired_capacity = new_capacity;
+    }
+
+    map->state->retired[map->state->retired_count++] = p_memory;
+    pthread_mutex_unlock(&map->state->retire_lock);
+}
+
+static concurrent_map_entry* find_entry(concurrent_map_table* p_table,
+                                        concurrent_map* map,
+                                        void* key,
+                                        size_t hash)
+{
+    concurrent_map_entry* p_entry;
+
+    for (p_entry = atomic_load_explicit(&p_table->buckets[hash & p_table->mask],
+                                        memory_order_acquire);
+         p_entry;
+         p_entry = atomic_load_explicit(&p_entry->chain_next,
+                                        memory_order_acquire))
+    {
+        if (p_entry->hash == hash && map->state->equals_function(p_entry->key,
+                                                                 key))
+        {
+            return p_entry;
+        }
+    }
+
+    return NULL;
+}
+
+static void free_table_entries(concurrent_map_table* p_table)
+{
+    concurrent_map_entry* p_entry;
+    concurrent_map_entry* p_next;
+    size_t                i;
+
+    for (i = 0; i < p_table->capacity; ++i)
+    {
+        for (p_entry = atomic_load(&p_table->buckets[i]);
+             p_entry;
+             p_entry = p_next)
+        {
+            p_next = atomic_load(&p_entry->chain_next);
+            free(p_entry);
+        }
+    }
+}
+
+static void unlock_all(concurrent_map* map)
+{
+    size_t i;
+
+    for (i = 0; i < LOCK_STRIPES; ++i)
+    {
+        pthread_mutex_unlock(&map->state->locks[i]);
+    }
+}
+
+/*******************************************************************************
+* Doubles the table once the load factor is exceeded. Readers keep using the   *
+* old table and its entries until they are reclaimed, so the entries are       *
+* copied rather than relinked.                                                 *
+*******************************************************************************/
+static void ensure_capacity(concurrent_map* map)
+{
+    concurrent_map_table* p_old_table;
+    concurrent_map_table* p_new_table;
+    concurrent_map_entry* p_entry;
+    concurrent_map_entry* p_copy;
+    size_t                index;
+    size_t                i;
+
+    p_old_table = atomic_load_explicit(&map->state->table,
+                                       memory_order_acquire);
+
+    if (atomic_load(&map->state->size) <=
+        (size_t)(p_old_table->capacity * map->state->load_factor))
+    {
+        return;
+    }
+
+    for (i = 0; i < LOCK_STRIPES; ++i)
+    {
+        pthread_mutex_lock(&map->state->locks[i]);
+    }
+
+    /* Some other writer might have resized the table in the meantime. */
+    if (p_old_table != atomic_load(&map->state->table) ||
+        !(p_new_table = concurrent_map_table_alloc(2 * p_old_table->capacity)))
+    {
+        unlock_all(map);
+        return;
+    }
+
+    for (i = 0; i < p_old_table->capacity; ++i)
+    {
+        for (p_entry = atomic_load(&p_old_table->buckets[i]);
+             p_entry;
+             p_entry = atomic_load(&p_entry->chain_next))
+        {
+            if (!(p_copy = malloc(sizeof(*p_copy))))
+            {
+                /* Give up resizing; the map just gets a bit slower. */
+                free_table_entries(p_new_table);
+                free(p_new_table);
+                unlock_all(map);
+                return;
+            }
+
+            p_copy->key = p_entry->key;
+            p_copy->hash = p_entry->hash;
+            atomic_init(&p_copy->value, atomic_load(&p_entry->value));
+
+            index = p_copy->hash & p_new_table->mask;
+            atomic_init(&p_copy->chain_next,
+                        atomic_load(&p_new_table->buckets[index]));
+            atomic_init(&p_new_table->buckets[index], p_copy);
+        }
+    }
+
+    atomic_store_explicit(&map->state->table,
+                          p_new_table,
+                          memory_order_release);
+
+    for (i = 0; i < p_old_table->capacity; ++i)
+    {
+        for (p_entry = atomic_load(&p_old_table->buckets[i]);
+             p_entry;
+             p_entry = atomic_load(&p_entry->chain_next))
+        {
+            concurrent_map_retire(map, p_entry);
+        }
+    }
+
+    concurrent_map_retire(map, p_old_table);
+    unlock_all(map);
+}
+
+/*******************************************************************************
+* Implements the put operations. If 'overwrite' is false, an existing value is *
+* left untouched. Stores in '*p_result' the old value of 'key' or NULL if      *
+* 'overwrite' is true, and the value 'key' is mapped to after the call         *
+* otherwise. Returns false if memory runs out.                                 *
+*******************************************************************************/
+static bool put_impl(concurrent_map* map,
+                     void* key,
+                     void* value,
+                     bool overwrite,
+                     void** p_result)
+{
+    concurrent_map_table* p_table;
+    concurrent_map_entry* p_entry;
+    pthread_mutex_t*      p_lock;
+    size_t                hash;
+    size_t                index;
+
+    hash = map->state->hash_function(key);
+    p_lock = &map->state->locks[hash & (LOCK_STRIPES - 1)];
+    pthread_mutex_lock(p_lock);
+
+    /* Resizing holds all the locks, so the table is stable here. */
+    p_table = atomic_load_explicit(&map->state->table, memory_order_acquire);
+
+    if ((p_entry = find_entry(p_table, map, key, hash)))
+    {
+        *p_result = overwrite ?
+                    atomic_exchange_explicit(&p_entry->value,
+                                             value,
+                                             memory_order_acq_rel) :
+                    atomic_load_explicit(&p_entry->value,
+                                         memory_order_acquire);
+
+        pthread_mutex_unlock(p_lock);
+        return true;
+    }
+
+    if (!(p_entry = malloc(sizeof(*p_entry))))
+    {
+        pthread_mutex_unlock(p_lock);
+        return false;
+    }
+
+    index = hash & p_table->mask;
+    p_entry->key = key;
+    p_entry->hash = hash;
+    atomic_init(&p_entry->value, value);
+    atomic_init(&p_entry->chain_next,
+                atomic_load_explicit(&p_table->buckets[index],
+                                     memory_order_relaxed));
+
+    /* Publish the fully initialized entry to the readers. */
+    atomic_store_explicit(&p_table->buckets[index],
+                          p_entry,
+                          memory_order_release);
+    atomic_fetch_add(&map->state->size, 1);
+    pthread_mutex_unlock(p_lock);
+
+    ensure_capacity(map);
+    *p_result = overwrite ? NULL : value;
+    return true;
+}
+
+void* concurrent_map_put(concurrent_map* map, void* key, void* value)
+{
+    void* p_old_value;
+
+    if (!map || !put_impl(map, key, value, true, &p_old_value))
+    {
+        return NULL;
+    }
+
+    return p_old_value;
+}
+
+bool concurrent_map_try_put(concurrent_map* map,
+                            void* key,
+                            void* value,
+                            void** p_old_value)
+{
+    return map && put_impl(map, key, value, true, p_old_value);
+}
+
+void* concurrent_map_put_if_absent(concurrent_map* map, void* key, void* value)
+{
+    void* p_value;
+
+    if (!map || !put_impl(map, key, value, false, &p_value))
+    {
+        return NULL;
+    }
+
+    return p_value;
+}
+
+void* concurrent_map_get(concurrent_map* map, void* key)
+{
+    concurrent_map_table* p_table;
+    concurrent_map_entry* p_entry;
+
+    if (!map)
+    {
+        return NULL;
+    }
+
+    p_table = atomic_load_explicit(&map->state->table, memory_order_acquire);
+    p_entry = find_entry(p_table, map, key, map->state->hash_function(key));
+
+    return p_entry ? atomic_load_explicit(&p_entry->value,
+                                          memory_order_acquire) : NULL;
+}
+
+bool concurrent_map_contains_key(concurrent_map* map, void* key)
+{
+    concurrent_map_table* p_table;
+
+    if (!map)
+    {
+        return false;
+    }
+
+    p_table = atomic_load_explicit(&map->state->table, memory_order_acquire);
+    return find_entry(p_table,
+                      map,
+                      key,
+                      map->state->hash_function(key)) != NULL;
+}
+
+void* concurrent_map_remove(concurrent_map* map, void* key)
+{
+    concurrent_map_table*           p_table;
+    concurrent_map_entry*           p_entry;
+    _Atomic(concurrent_map_entry*)* p_link;
+    pthread_mutex_t*                p_lock;
+    size_t                          hash;
+    void*                           value;
+
+    if (!map)
+    {
+        return NULL;
+    }
+
+    hash = map->state->hash_function(key);
+    p_lock = &map->state->locks[hash & (LOCK_STRIPES - 1)];
+    pthread_mutex_lock(p_lock);
+
+    p_table = atomic_load_explicit(&map->state->table, memory_order_acquire);
+    p_link = &p_table->buckets[hash & p_table->mask];
+
+    for (p_entry = atomic_load(p_link);
+         p_entry;
+         p_entry = atomic_load(p_link))
+    {
+        if (p_entry->hash == hash && map->state->equals_function(p_entry->key,
+                                                                 key))
+        {
+            /* Readers standing on the entry can still follow its link. */
+            atomic_store_explicit(p_link,
+                                  atomic_load(&p_entry->chain_next),
+                                  memory_order_release);
+            atomic_fetch_sub(&map->state->size, 1);
+            value = atomic_load(&p_entry->value);
+            pthread_mutex_unlock(p_lock);
+            concurrent_map_retire(map, p_entry);
+            return value;
+        }
+
+        p_link = &p_entry->chain_next;
+    }
+
+    pthread_mutex_unlock(p_lock);
+    return NULL;
+}
+
+size_t concurrent_map_size(concurrent_map* map)
+{
+    return map ? atomic_load(&map->state->size) : 0;
+}
+
+memory_usage concurrent_map_memory_usage(concurrent_map* map)
+{
+    memory_usage          usage = { 0, 0 };
+    concurrent_map_table* p_table;
+
+    if (!map) return usage;
+
+    p_table = atomic_load(&map->state->table);
+
+    usage.live = sizeof(concurrent_map_entry) * atomic_load(&map->state->size);
+    usage.allocated = sizeof(*map) + sizeof(*map->state) +
+                      sizeof(*p_table) +
+                      sizeof(_Atomic(concurrent_map_entry*)) *
+                      p_table->capacity +
+                      sizeof(void*) * map->state->retired_capacity +
+                      usage.live;
+    return usage;
+}
+
+void concurrent_map_for_each(concurrent_map* map,
+    void(*action)(void* key, void* value, void* arg),
+    void* arg)
+{
+    concurrent_map_table* p_table;
+    concurrent_map_entry* p_entry;
+    size_t                i;
+
+    if (!map || !action)
+    {
+        return;
+    }
+
+    p_table = atomic_load(&map->state->table);
+
+    for (i = 0; i < p_table->capacity; ++i)
+    {
+        for (p_entry = atomic_load(&p_table->buckets[i]);
+             p_entry;
+             p_entry = atomic_load(&p_entry->chain_next))
+        {
+            action(p_entry->key, atomic_load(&p_entry->value), arg);
+        }
+    }
+}
+
+void concurrent_map_reclaim(concurrent_map* map)
+{
+    size_t i;
+
+    if (!map)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&map->state->retire_lock);
+
+    for (i = 0; i < map->state->retired_count; ++i)
+    {
+        free(map->state->retired[i]);
+    }
+
+    map->state->retired_count = 0;
+    pthread_mutex_unlock(&map->state->retire_lock);
+}
+
+void concurrent_map_free(concurrent_map* map)
+{
+    concurrent_map_table* p_table;
+    size_t                i;
+
+    if (!map)
+    {
+        return;
+    }
+
+    concurrent_map_reclaim(map);
+    p_table = atomic_load(&map->state->table);
+    free_table_entries(p_table);
+
+    for (i = 0; i < LOCK_STRIPES; ++i)
+    {
+        pthread_mutex_destroy(&map->state->locks[i]);
+    }
+
+    pthread_mutex_destroy(&map->state->retire_lock);
+    free(p_table);
+    free(map->state->retired);
+    free(map->state);
+    free(map);
+}
@@ -0,0 +1,122 @@
+#ifndef CONCURRENT_MAP_H
+#define CONCURRENT_MAP_H
+
+#include "memory_usage.h"
+#include <stdlib.h>
+#include <stdbool.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * A hash map for read-mostly data shared between threads. Readers never    *
+    * lock and never wait for writers. Writers serialize on one of a fixed     *
+    * number of lock stripes, so writers of different keys rarely contend.     *
+    *                                                                          *
+    * Memory that readers may still be looking at (removed entries, old        *
+    * tables after a resize and anything passed to 'concurrent_map_retire') is *
+    * not deallocated right away but at the next call to                       *
+    * 'concurrent_map_reclaim', which the client must only make while no       *
+    * thread is reading the map.                                               *
+    ***************************************************************************/
+    typedef struct concurrent_map {
+        struct concurrent_map_state* state;
+    } concurrent_map;
+
+    /***************************************************************************
+    * Allocates a new, empty map with given hash function and given equality   *
+    * testing function.                                                        *
+    ***************************************************************************/
+    concurrent_map* concurrent_map_alloc(size_t initial_capacity,
+                                         float  load_factor,
+                                         size_t(*hash_function)(void*),
+                                         bool(*equals_function)(void*, void*));
+
+    /***************************************************************************
+    * Maps 'key' to 'value'. Returns the old value of 'key' or NULL if 'key'   *
+    * was not mapped. Readers may still see the old value until the next       *
+    * reclamation, so it should be released via 'concurrent_map_retire'.       *
+    ***************************************************************************/
+    void* concurrent_map_put(concurrent_map* map, void* key, void* value);
+
+    /***************************************************************************
+    * Works like 'concurrent_map_put', but stores the old value of 'key' or    *
+    * NULL in '*p_old_value' and returns false, leaving the map unchanged, if  *
+    * memory runs out, which 'concurrent_map_put' cannot tell apart from a     *
+    * new mapping.                                                             *
+    ***************************************************************************/
+    bool concurrent_map_try_put(concurrent_map* map,
+                                void* key,
+                                void* value,
+                                void** p_old_value);
+
+    /***************************************************************************
+    * Maps 'key' to 'value' only if 'key' is not mapped yet. Returns the value *
+    * 'key' is mapped to after the call, or NULL if memory runs out.           *
+    ***************************************************************************/
+    void* concurrent_map_put_if_absent(concurrent_map* map,
+                                       void* key,
+                                       void* value);
+
+    /***************************************************************************
+    * Returns the value of 'key' or NULL if not mapped. Never blocks.          *
+    ***************************************************************************/
+    void* concurrent_map_get(concurrent_map* map, void* key);
+
+    /***************************************************************************
+    * Returns true if 'key' is mapped in the map. Never blocks.                *
+    ***************************************************************************/
+    bool concurrent_map_contains_key(concurrent_map* map, void* key);
+
+    /***************************************************************************
+    * Removes the mapping of 'key' and returns its value, or NULL if 'key' was *
+    * not mapped.                                                              *
+    ***************************************************************************/
+    void* concurrent_map_remove(concurrent_map* map, void* key);
+
+    /***************************************************************************
+    * Returns the amount of mappings in the map.                               *
+    ***************************************************************************/
+    size_t concurrent_map_size(concurrent_map* map);
+
+    /***************************************************************************
+    * Returns the memory taken by the current table and the entries of the     *
+    * map, but not by the keys and the values they refer to, nor by the        *
+    * retired memory waiting to be reclaimed. Not to be called while the map   *
+    * is being written.                                                        *
+    ***************************************************************************/
+    memory_usage concurrent_map_memory_usage(concurrent_map* map);
+
+    /***************************************************************************
+    * Calls 'action' for every mapping in the map. Must not run concurrently   *
+    * with writers.                                                            *
+    ***************************************************************************/
+    void concurrent_map_for_each(concurrent_map* map,
+                                 void(*action)(void* key,
+                                               void* value,
+                                               void* arg),
+                                 void* arg);
+
+    /***************************************************************************
+    * Schedules 'p_memory' for deallocation at the next reclamation.           *
+    ***************************************************************************/
+    void concurrent_map_retire(concurrent_map* map, void* p_memory);
+
+    /***************************************************************************
+    * Deallocates all the retired memory. The client must make sure that no    *
+    * thread is reading the map during this call.                              *
+    ***************************************************************************/
+    void concurrent_map_reclaim(concurrent_map* map);
+
+    /***************************************************************************
+    * Deallocates the entire map including the retired memory. The user is     *
+    * responsible for deallocating the actual data stored in the map.          *
+    ***************************************************************************/
+    void concurrent_map_free(concurrent_map* map);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* CONCURRENT_MAP_H */
@@ -1,5 +1,6 @@
 #include "dijkstra.h"
-#include "list.h"
+#include "arena.h"
+#include "path.h"
 #include "directed_graph_node.h"
 #include "weight_function.h"
 #include "unordered_map.h"
@@ -7,17 +8,25 @@
 #include "heap.h"
 #include "utils.h"
 
-typedef struct weight {
-    double weight;
-} weight;
+/*******************************************************************************
+* The search state of a node. Each record points to the record of the node's   *
+* parent, so the shortest path can be traced back without any lookups. The     *
+* record doubles as the heap priority, 'cost' being its first member.          *
+*******************************************************************************/
+typedef struct search_info {
+    double               cost;
+    directed_graph_node* p_node;
+    struct search_info*  p_parent;
+    size_t               hops;
+} search_info;
 
 static int priority_cmp(void* pa, void* pb)
 {
     double da;
     double db;
 
-    da = ((weight*)pa)->weight;
-    db = ((weight*)pb)->weight;
+    da = ((search_info*)pa)->cost;
+    db = ((search_info*)pb)->cost;
 
     if (da < db)
     {
@@ -34,168 +43,227 @@ static int priority_cmp(void* pa, void* pb)
 static const size_t INITIAL_CAPACITY = 16;
 static const float  LOAD_FACTOR = 1.0f;
 
-list* dijkstra(directed_graph_node* p_source,
-               directed_graph_node* p_target,
-               directed_graph_weight_function* p_weight_function)
+/*******************************************************************************
+* The block size of the arena 'dijkstra' creates for a single query.           *
+*******************************************************************************/
+static const size_t SCRATCH_BLOCK_SIZE = 65536;
+
+static search_info* search_info_alloc(directed_graph_node* p_node,
+                                      search_info* p_parent,
+                                      double cost,
+                                      arena* p_scratch)
 {
-    list*                   p_list;
-    heap*                   p_open_set;
-    unordered_set*          p_closed_set;
-    unordered_map*          p_parent_map;
-    unordered_map*          p_cost_map;
-    directed_graph_node*    p_current;
-    directed_graph_node*    p_child;
-    unordered_set_iterator* p_child_iterator;
-    weight*                 p_weight;
-    list*                   p_weight_list;
-    size_t                  i;
+    search_info* p_info = arena_allocate(p_scratch, sizeof(*p_info));
 
-    if (!p_source)          return NULL;
-    if (!p_target)          return NULL;
-    if (!p_weight_function) return NULL;
+    if (!p_info) return NULL;
 
-    p_open_set = heap_alloc(4,
-                            INITIAL_CAPACITY,
-                            LOAD_FACTOR,
-                            hash_function,
-                            equals_function,
-                            priority_cmp);
+    p_info->cost = cost;
+    p_info->p_node = p_node;
+    p_info->p_parent = p_parent;
+    p_info->hops = p_parent ? p_parent->hops + 1 : 0;
+    return p_info;
+}
 
-    if (!p_open_set)
-    {
-        return NULL;
-    }
+/*******************************************************************************
+* Records the search info of a node seen for the first time.                   *
+* 'unordered_map_put' returns NULL both when it adds the node and when it runs *
+* out of memory, so the two are told apart by looking the node up.             *
+*******************************************************************************/
+static bool put_info(unordered_map* p_info_map,
+                     directed_graph_node* p_node,
+                     search_info* p_info)
+{
+    return unordered_map_put(p_info_map, p_node, p_info) ||
+           unordered_map_contains_key(p_info_map, p_node);
+}
 
-    p_closed_set = unordered_set_alloc(INITIAL_CAPACITY,
-                                       LOAD_FACTOR,
-                                       hash_function,
-                                       equals_function);
+/*******************************************************************************
+* Builds the path by following the parent records from the target, filling     *
+* the node array from the back. The path is allocated with 'malloc', so it     *
+* outlives the records.                                                        *
+*******************************************************************************/
+static path* traceback_path(search_info* p_target_info)
+{
+    path*                 p_path;
+    directed_graph_node** p_nodes;
+    search_info*          p_info;
+    size_t                index;
 
-    if (!p_closed_set)
-    {
-        heap_free(p_open_set);
-        return NULL;
-    }
+    index = p_target_info->hops + 1;
+
+    if (!(p_path = path_alloc(index, p_target_info->cost))) return NULL;
 
-    p_parent_map = unordered_map_alloc(INITIAL_CAPACITY,
-                                       LOAD_FACTOR,
-                                       hash_function,
-                                       equals_function);
+    p_nodes = path_nodes(p_path);
 
-    if (!p_parent_map)
+    for (p_info = p_target_info; p_info; p_info = p_info->p_parent)
     {
-        heap_free(p_open_set);
-        unordered_set_free(p_closed_set);
-        return NULL;
+        p_nodes[--index] = p_info->p_node;
     }
 
-    p_cost_map = unordered_map_alloc(INITIAL_CAPACITY,
-        LOAD_FACTOR,
-        hash_function,
-        equals_function);
+    return p_path;
+}
 
-    if (!p_cost_map)
+/*******************************************************************************
+* Runs the search with all of its state in 'p_scratch'. Returns NULL if memory *
+* runs out.                                                                    *
+*******************************************************************************/
+static path* search(directed_graph_node* p_source,
+                    directed_graph_node* p_target,
+                    directed_graph_weight_function* p_weight_function,
+                    arena* p_scratch)
+{
+    heap*                   p_open_set;
+    unordered_set*          p_closed_set;
+    unordered_map*          p_info_map;
+    directed_graph_node*    p_current;
+    directed_graph_node*    p_child;
+    directed_graph_node**   p_children;
+    size_t                  child_count;
+    search_info*            p_current_info;
+    search_info*            p_child_info;
+    double                  weight;
+    double                  tmp_cost;
+    size_t                  j;
+
+    p_open_set = heap_alloc_in_arena(p_scratch,
+                                     4,
+                                     INITIAL_CAPACITY,
+                                     LOAD_FACTOR,
+                                     hash_function,
+                                     equals_function,
+                                     priority_cmp);
+
+    p_closed_set = unordered_set_alloc_in_arena(p_scratch,
+                                                INITIAL_CAPACITY,
+                                                LOAD_FACTOR,
+                                                hash_function,
+                                                equals_function);
+
+    p_info_map = unordered_map_alloc_in_arena(p_scratch,
+                                              INITIAL_CAPACITY,
+                                              LOAD_FACTOR,
+                                              hash_function,
+                                              equals_function);
+
+    p_current_info = search_info_alloc(p_source, NULL, 0.0, p_scratch);
+
+    if (!p_open_set || !p_closed_set || !p_info_map || !p_current_info)
     {
-        heap_free(p_open_set);
-        unordered_set_free(p_closed_set);
-        unordered_map_free(p_parent_map);
         return NULL;
     }
 
-    p_weight_list = list_alloc(INITIAL_CAPACITY);
-
-    if (!p_weight_list)
+    if (!heap_add(p_open_set, p_source, p_current_info) ||
+        !put_info(p_info_map, p_source, p_current_info))
     {
-        heap_free(p_open_set);
-        unordered_set_free(p_closed_set);
-        unordered_map_free(p_parent_map);
-        unordered_map_free(p_cost_map);
         return NULL;
     }
 
-    p_weight = malloc(sizeof(*p_weight));
-    p_weight->weight = 0.0;
-
-    heap_add(p_open_set, p_source, p_weight);
-    unordered_map_put(p_parent_map, p_source, NULL);
-    unordered_map_put(p_cost_map, p_source, p_weight);
-    list_push_back(p_weight_list, p_weight);
-
     while (heap_size(p_open_set) > 0)
     {
         p_current = heap_extract_min(p_open_set);
+        p_current_info = unordered_map_get(p_info_map, p_current);
 
         if (equals_function(p_current, p_target))
         {
-            p_list = traceback_path(p_target, p_parent_map);
-            heap_free(p_open_set);
-            unordered_set_free(p_closed_set);
-            unordered_map_free(p_parent_map);
-            unordered_map_free(p_cost_map);
-            return p_list;
+            return traceback_path(p_current_info);
         }
 
-        unordered_set_add(p_closed_set, p_current);
+        /* Each node is extracted once, so adding fails only without memory. */
+        if (!unordered_set_add(p_closed_set, p_current)) return NULL;
 
-        p_child_iterator =
-            unordered_set_iterator_alloc(
-                directed_graph_node_children_set(p_current));
+        p_children  = directed_graph_node_children(p_current);
+        child_count = directed_graph_node_child_count(p_current);
 
-        while (unordered_set_iterator_has_next(p_child_iterator))
+        for (j = 0; j < child_count; ++j)
         {
-            unordered_set_iterator_next(p_child_iterator, &p_child);
+            p_child = p_children[j];
 
             if (unordered_set_contains(p_closed_set, p_child)) {
                 continue;
             }
 
-            double tmp_cost =
-                ((weight*)unordered_map_get(p_cost_map,
-                    p_current))->weight;
+            /* An arc without a weight cannot be traversed. */
+            if (!directed_graph_weight_function_get_value(p_weight_function,
+                                                          p_current,
+                                                          p_child,
+                                                          &weight))
+            {
+                continue;
+            }
 
-            tmp_cost += *directed_graph_weight_function_get(
-                p_weight_function,
-                p_current,
-                p_child);
+            tmp_cost = p_current_info->cost + weight;
 
-            if (!unordered_map_contains_key(p_parent_map, p_child))
-            {
-                p_weight = malloc(sizeof(*p_weight));
-                p_weight->weight = tmp_cost;
+            p_child_info = unordered_map_get(p_info_map, p_child);
 
-                heap_add(p_open_set, p_child, p_weight);
-                unordered_map_put(p_parent_map, p_child, p_current);
-                unordered_map_put(p_cost_map, p_child, p_weight);
+            if (!p_child_info)
+            {
+                if (!(p_child_info = search_info_alloc(p_child,
+                                                       p_current_info,
+                                                       tmp_cost,
+                                                       p_scratch)))
+                {
+                    return NULL;
+                }
+
+                if (!heap_add(p_open_set, p_child, p_child_info) ||
+                    !put_info(p_info_map, p_child, p_child_info))
+                {
+                    return NULL;
+                }
             }
-            else if (tmp_cost <
-                ((weight*)unordered_map_get(p_cost_map,
-                    p_child))->weight)
+            else if (tmp_cost < p_child_info->cost)
             {
-                p_weight = malloc(sizeof(*p_weight));
-                p_weight->weight = tmp_cost;
-
-                heap_decrease_key(p_open_set, p_child, p_weight);
-                unordered_map_put(p_parent_map, p_child, p_current);
-                unordered_map_put(p_cost_map, p_child, p_weight);
+                if (!(p_child_info = search_info_alloc(p_child,
+                                                       p_current_info,
+                                                       tmp_cost,
+                                                       p_scratch)))
+                {
+                    return NULL;
+                }
+
+                heap_decrease_key(p_open_set, p_child, p_child_info);
+                unordered_map_put(p_info_map, p_child, p_child_info);
             }
         }
-
-        unordered_set_iterator_free(p_child_iterator);
     }
 
-    /* Once here, return a empty path in order to denote the fact that the
-       target node is not reachable from source node. */
-    heap_free(p_open_set);
-    unordered_set_free(p_closed_set);
-    unordered_map_free(p_parent_map);
-    unordered_map_free(p_cost_map);
-    p_list = list_alloc(10);
+    /* Denote the fact that the target node is not reachable from the source
+       node by an empty path. */
+    return path_alloc(0, 0.0);
+}
 
-    /* Deallocate the weights. */
-    for (i = 0; i < list_size(p_weight_list); ++i)
-    {
-        free(list_get(p_weight_list, i));
-    }
+path* dijkstra_with_arena(directed_graph_node* p_source,
+                          directed_graph_node* p_target,
+                          directed_graph_weight_function* p_weight_function,
+                          arena* p_scratch)
+{
+    path* p_path;
 
-    return p_list;
-}
\ No newline at end of file
+    if (!p_source)          return NULL;
+    if (!p_target)          return NULL;
+    if (!p_weight_function) return NULL;
+    if (!p_scratch)         return NULL;
+
+    p_path = search(p_source, p_target, p_weight_function, p_scratch);
+
+    /* The path is copied out by now, so the search state may go. */
+    arena_reset(p_scratch);
+    return p_path;
+}
+
+path* dijkstra(directed_graph_node* p_source,
+               directed_graph_node* p_target,
+               directed_graph_weight_function* p_weight_function)
+{
+    arena* p_scratch;
+    path*  p_path;
+
+    if (!(p_scratch = arena_alloc(SCRATCH_BLOCK_SIZE))) return NULL;
+
+    p_path = dijkstra_with_arena(p_source,
+                                 p_target,
+                                 p_weight_function,
+                                 p_scratch);
+    arena_free(p_scratch);
+    return p_path;
+}
@@ -1,18 +1,37 @@
 #ifndef DIJKSTRA_H
 #define DIJKSTRA_H
 
+#include "arena.h"
 #include "directed_graph_node.h"
 #include "weight_function.h"
-#include "list.h"
+#include "path.h"
 
 #ifdef  __cplusplus
 extern "C" {
 #endif
 
-    list* dijkstra(directed_graph_node* p_source,
+    /***************************************************************************
+    * Returns a shortest path from 'p_source' to 'p_target', or an empty path  *
+    * if 'p_target' is not reachable. Arcs without a weight are not followed.  *
+    * The caller owns the returned path. Returns NULL if memory runs out.      *
+    ***************************************************************************/
+    path* dijkstra(directed_graph_node* p_source,
                    directed_graph_node* p_target,
                    directed_graph_weight_function* p_weight_function);
 
+    /***************************************************************************
+    * Works like 'dijkstra', but takes the memory for the search state from    *
+    * 'p_scratch' and resets the arena before returning, taking back anything  *
+    * else allocated from it as well. A server reusing one arena per thread    *
+    * calls 'malloc' only for the returned path. Returns NULL if memory runs   *
+    * out.                                                                     *
+    ***************************************************************************/
+    path* dijkstra_with_arena(directed_graph_node* p_source,
+                              directed_graph_node* p_target,
+                              directed_graph_weight_function*
+                                  p_weight_function,
+                              arena* p_scratch);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -0,0 +1,456 @@
+#include "dimacs.h"
+#include "directed_graph_node.h"
+#include "typed_common.h"
+#include "unordered_map.h"
+#include "weight_function.h"
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define READ_BUFFER_SIZE 65536
+
+/*******************************************************************************
+* A buffered reader that hands out the characters of a file one by one         *
+* without any allocation per line or per token.                                *
+*******************************************************************************/
+typedef struct dimacs_reader {
+    FILE*  p_file;
+    size_t position;
+    size_t length;
+    char   buffer[READ_BUFFER_SIZE];
+} dimacs_reader;
+
+static const float LOAD_FACTOR = 1.0f;
+
+/*******************************************************************************
+* The nodes of a DIMACS graph have unique names, so the maps of the loader key *
+* them by identity, which is cheaper to hash and to compare than the names.    *
+*******************************************************************************/
+static size_t node_identity_hash(void* p_node)
+{
+    return typed_hash_u64((uint64_t)(uintptr_t) p_node);
+}
+
+static bool node_identity_equals(void* p_a, void* p_b)
+{
+    return p_a == p_b;
+}
+
+static int reader_peek(dimacs_reader* p_reader)
+{
+    if (p_reader->position == p_reader->length)
+    {
+        p_reader->position = 0;
+        p_reader->length = fread(p_reader->buffer,
+                                 1,
+                                 READ_BUFFER_SIZE,
+                                 p_reader->p_file);
+
+        if (p_reader->length == 0) return EOF;
+    }
+
+    return (unsigned char) p_reader->buffer[p_reader->position];
+}
+
+static int reader_next(dimacs_reader* p_reader)
+{
+    int c = reader_peek(p_reader);
+
+    if (c != EOF)
+    {
+        p_reader->position++;
+    }
+
+    return c;
+}
+
+static void skip_blanks(dimacs_reader* p_reader)
+{
+    int c;
+
+    while ((c = reader_peek(p_reader)) == ' ' || c == '\t' || c == '\r')
+    {
+        reader_next(p_reader);
+    }
+}
+
+static void skip_line(dimacs_reader* p_reader)
+{
+    int c;
+
+    while ((c = reader_next(p_reader)) != EOF && c != '\n')
+    {
+    }
+}
+
+/*******************************************************************************
+* Reads an optionally signed decimal integer preceded by blanks. Returns false *
+* if there is no integer or it does not fit in a 'long long'.                  *
+*******************************************************************************/
+static bool read_integer(dimacs_reader* p_reader, long long* p_value)
+{
+    long long value;
+    bool      negative;
+    bool      has_digits;
+    int       c;
+
+    skip_blanks(p_reader);
+
+    negative = false;
+    has_digits = false;
+    value = 0;
+
+    if ((c = reader_peek(p_reader)) == '-' || c == '+')
+    {
+        negative = c == '-';
+        reader_next(p_reader);
+    }
+
+    while ((c = reader_peek(p_reader)) >= '0' && c <= '9')
+    {
+        if (value > (LLONG_MAX - (c - '0')) / 10) return false;
+
+        value = 10 * value + (c - '0');
+        has_digits = true;
+        reader_next(p_reader);
+    }
+
+    if (!has_digits) return false;
+
+    *p_value = negative ? -value : value;
+    return true;
+}
+
+/*******************************************************************************
+* Reads the word 'p_word' preceded by blanks.                                  *
+*******************************************************************************/
+static bool read_word(dimacs_reader* p_reader, const char* p_word)
+{
+    skip_blanks(p_reader);
+
+    for (; *p_word; ++p_word)
+    {
+        if (reader_next(p_reader) != *p_word) return false;
+    }
+
+    return true;
+}
+
+static dimacs_reader* reader_alloc(const char* p_file_name)
+{
+    dimacs_reader* p_reader;
+
+    if (!(p_reader = malloc(sizeof(*p_reader)))) return NULL;
+
+    if (!(p_reader->p_file = fopen(p_file_name, "rb")))
+    {
+        free(p_reader);
+        return NULL;
+    }
+
+    p_reader->position = 0;
+    p_reader->length = 0;
+    return p_reader;
+}
+
+static void reader_free(dimacs_reader* p_reader)
+{
+    fclose(p_reader->p_file);
+    free(p_reader);
+}
+
+/*******************************************************************************
+* Allocates the 'node_count' nodes named by their DIMACS ids from the arena of *
+* the graph. The names are interned into the name pool of the graph.           *
+*******************************************************************************/
+static bool create_nodes(graph_data* p_data, size_t node_count)
+{
+    char   name[24];
+    char*  p_name;
+    size_t i;
+
+    if (!(p_data->p_node_array =
+              malloc(sizeof(directed_graph_node*) * node_count)))
+    {
+        return false;
+    }
+
+    for (i = 0; i < node_count; ++i)
+    {
+        sprintf(name, "%lu", (unsigned long)(i + 1));
+
+        if (!(p_name = string_pool_intern(p_data->p_name_pool, name)) ||
+            !(p_data->p_node_array[i] =
+                  directed_graph_node_alloc_in_arena(p_data->p_arena,
+                                                     p_name)))
+        {
+            free(p_data->p_node_array);
+            p_data->p_node_array = NULL;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+* Reads the problem line 'p sp n m' and the arc lines 'a u v w' of a '.gr'     *
+* file. The nodes are created once the problem line is read.                   *
+*******************************************************************************/
+static bool load_arcs(dimacs_reader* p_reader,
+                      graph_data* p_data,
+                      size_t* p_node_count)
+{
+    directed_graph_node* p_tail;
+    directed_graph_node* p_head;
+    long long            node_count;
+    long long            arc_count;
+    long long            tail;
+    long long            head;
+    long long            weight;
+    double               existing_weight;
+    int                  c;
+
+    node_count = -1;
+
+    while ((c = reader_next(p_reader)) != EOF)
+    {
+        switch (c)
+        {
+            case '\n':
+            case '\r':
+                break;
+
+            case 'c':
+                skip_line(p_reader);
+                break;
+
+            case 'p':
+                if (node_count >= 0)                      return false;
+                if (!read_word(p_reader, "sp"))           return false;
+                if (!read_integer(p_reader, &node_count)) return false;
+                if (!read_integer(p_reader, &arc_count))  return false;
+                if (node_count <= 0 || arc_count < 0)     return false;
+
+                if ((unsigned long long) node_count >=
+                    SIZE_MAX / sizeof(directed_graph_node*))
+                {
+                    return false;
+                }
+
+                if (!create_nodes(p_data, (size_t) node_count))
+                {
+                    return false;
+                }
+
+                *p_node_count = (size_t) node_count;
+                p_data->node_count = (size_t) node_count;
+
+                directed_graph_weight_function_reserve(
+                    p_data->p_weight_function,
+                    (size_t) node_count);
+
+                skip_line(p_reader);
+                break;
+
+            case 'a':
+                if (node_count < 0)                   return false;
+                if (!read_integer(p_reader, &tail))   return false;
+                if (!read_integer(p_reader, &head))   return false;
+                if (!read_integer(p_reader, &weight)) return false;
+                if (tail < 1 || tail > node_count)    return false;
+                if (head < 1 || head > node_count)    return false;
+
+                p_tail = p_data->p_node_array[tail - 1];
+                p_head = p_data->p_node_array[head - 1];
+
+                /* Of parallel arcs, only the cheapest one matters. */
+                if (!directed_graph_node_add_arc(p_tail, p_head))
+                {
+                    if (!directed_graph_node_has_child(p_tail, p_head))
+                    {
+                        return false;
+                    }
+
+                    if (directed_graph_weight_function_get_value(
+                            p_data->p_weight_function,
+                            p_tail,
+                            p_head,
+                            &existing_weight) &&
+                        existing_weight <= (double) weight)
+                    {
+                        skip_line(p_reader);
+                        break;
+                    }
+                }
+
+                /* Fails for weights outside the 32-bit fixed-point range. */
+                if (!directed_graph_weight_function_put(
+                         p_data->p_weight_function,
+                         p_tail,
+                         p_head,
+                         (double) weight))
+                {
+                    return false;
+                }
+
+                skip_line(p_reader);
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    return node_count > 0;
+}
+
+/*******************************************************************************
+* Reads the problem line 'p aux sp co n' and the coordinate lines 'v i x y'    *
+* of a '.co' file into one array of points.                                    *
+*******************************************************************************/
+static bool load_coordinates(dimacs_reader* p_reader,
+                             graph_data* p_data,
+                             size_t node_count)
+{
+    point_3d* p_points;
+    long long count;
+    long long id;
+    long long x;
+    long long y;
+    int       c;
+
+    p_points = NULL;
+
+    while ((c = reader_next(p_reader)) != EOF)
+    {
+        switch (c)
+        {
+            case '\n':
+            case '\r':
+                break;
+
+            case 'c':
+                skip_line(p_reader);
+                break;
+
+            case 'p':
+                if (p_points)                        return false;
+                if (!read_word(p_reader, "aux"))     return false;
+                if (!read_word(p_reader, "sp"))      return false;
+                if (!read_word(p_reader, "co"))      return false;
+                if (!read_integer(p_reader, &count)) return false;
+                if (count != (long long) node_count) return false;
+
+                if (!(p_points = malloc(sizeof(point_3d) * node_count)))
+                {
+                    return false;
+                }
+
+                p_data->p_points = p_points;
+
+                if (!unordered_map_reserve(p_data->p_point_map, node_count))
+                {
+                    return false;
+                }
+
+                skip_line(p_reader);
+                break;
+
+            case 'v':
+                if (!p_points)                             return false;
+                if (!read_integer(p_reader, &id))          return false;
+                if (!read_integer(p_reader, &x))           return false;
+                if (!read_integer(p_reader, &y))           return false;
+                if (id < 1 || id > (long long) node_count) return false;
+
+                p_points[id - 1].x = (double) x;
+                p_points[id - 1].y = (double) y;
+                p_points[id - 1].z = 0.0;
+
+                /* A repeated id moves the point, which is already mapped. */
+                if (!unordered_map_put(p_data->p_point_map,
+                                       p_data->p_node_array[id - 1],
+                                       &p_points[id - 1]) &&
+                    !unordered_map_contains_key(p_data->p_point_map,
+                                                p_data->p_node_array[id - 1]))
+                {
+                    return false;
+                }
+
+                skip_line(p_reader);
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    return p_points != NULL;
+}
+
+graph_data* dimacs_load(const char* p_graph_file_name,
+                        const char* p_coordinate_file_name)
+{
+    graph_data*    p_data;
+    dimacs_reader* p_reader;
+    size_t         node_count;
+    bool           ok;
+
+    if (!p_graph_file_name) return NULL;
+
+    if (!(p_data = calloc(1, sizeof(*p_data)))) return NULL;
+
+    p_data->p_weight_function =
+        directed_graph_weight_function_alloc_flat_format(
+            node_identity_hash,
+            node_identity_equals,
+            WEIGHT_FORMAT_FIXED_POINT,
+            1.0);
+
+    p_data->p_point_map = unordered_map_alloc(16,
+                                              LOAD_FACTOR,
+                                              node_identity_hash,
+                                              node_identity_equals);
+
+    p_data->p_name_pool = string_pool_alloc(0);
+    p_data->p_arena = arena_alloc(0);
+
+    if (!p_data->p_weight_function || !p_data->p_point_map ||
+        !p_data->p_name_pool       || !p_data->p_arena)
+    {
+        graph_data_free(p_data);
+        return NULL;
+    }
+
+    node_count = 0;
+
+    if ((p_reader = reader_alloc(p_graph_file_name)))
+    {
+        ok = load_arcs(p_reader, p_data, &node_count);
+        reader_free(p_reader);
+    }
+    else
+    {
+        ok = false;
+    }
+
+    if (ok && p_coordinate_file_name)
+    {
+        if ((p_reader = reader_alloc(p_coordinate_file_name)))
+        {
+            ok = load_coordinates(p_reader, p_data, node_count);
+            reader_free(p_reader);
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    if (ok) return p_data;
+
+    graph_data_free(p_data);
+    return NULL;
+}
@@ -0,0 +1,32 @@
+#ifndef DIMACS_H
+#define DIMACS_H
+
+#include "utils.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * Loads a graph in the format of the 9th DIMACS implementation challenge.  *
+    * 'p_graph_file_name' names a '.gr' file with the problem line 'p sp n m'  *
+    * and the arc lines 'a u v w'. The node with DIMACS id 'i' becomes the     *
+    * entry 'i - 1' of the node array, and the integer weights are kept        *
+    * exactly in a flat fixed-point weight function. Of parallel arcs, the     *
+    * one with the least weight is kept. If                                    *
+    * 'p_coordinate_file_name' is not NULL, it names a '.co' file whose lines  *
+    * 'v i x y' give the coordinates put in the point map, z being zero;       *
+    * otherwise the point map is empty. Each file is read in a single pass.    *
+    * Returns NULL if a file cannot be read or is malformed, or memory runs    *
+    * out. The weight function and the point map key the nodes by identity,    *
+    * so they are looked up with the nodes of the node array. The graph is     *
+    * deallocated with 'graph_data_free'.                                      *
+    ***************************************************************************/
+    graph_data* dimacs_load(const char* p_graph_file_name,
+                            const char* p_coordinate_file_name);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* DIMACS_H */
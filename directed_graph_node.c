@@ -1,19 +1,51 @@
 #include "directed_graph_node.h"
+#include "string_pool.h"
 #include "unordered_set.h"
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 
+/*******************************************************************************
+* The amount of neighbors stored directly in the node state. Most nodes of     *
+* sparse graphs never need more room than this.                                *
+*******************************************************************************/
+#define ADJACENCY_INLINE_CAPACITY 4
+
+/*******************************************************************************
+* The degree above which an adjacency gets a hash set index for fast           *
+* membership queries. Below it, a linear scan is cheaper than hashing.         *
+*******************************************************************************/
+#define ADJACENCY_INDEX_THRESHOLD 16
+
+typedef struct adjacency {
+    directed_graph_node** p_storage;
+    unordered_set*        p_index;
+    size_t                size;
+    size_t                capacity;
+    directed_graph_node*  inline_storage[ADJACENCY_INLINE_CAPACITY];
+} adjacency;
+
+/*******************************************************************************
+* The parent adjacency comes last, so that forward-only nodes are allocated    *
+* without it.                                                                  *
+*******************************************************************************/
 typedef struct directed_graph_node_state {
-    char* p_name;
-    char* p_text;
-    struct unordered_set* p_parent_node_set;
-    struct unordered_set* p_child_node_set;
+    char*                    p_name;
+    char*                    p_text;
+    arena*                   p_arena;
+    directed_graph_node_mode mode;
+    adjacency                child_adjacency;
+    adjacency                parent_adjacency;
 } directed_graph_node_state;
 
-static const int INITIAL_CAPACITY = 16;
-static const int MAXIMUM_NAME_STRING_LEN = 80;
 static const float LOAD_FACTOR = 1.0f;
+static const char* TEXT_FORMAT = "[directed_graph_node_t: id = %s]";
+
+static bool has_parents(directed_graph_node* p_node)
+{
+    return p_node->state->mode == DIRECTED_GRAPH_NODE_BIDIRECTIONAL;
+}
 
 bool equals_function(void* a, void* b)
 {
@@ -23,114 +55,325 @@ bool equals_function(void* a, void* b)
                   ((directed_graph_node*)b)->state->p_name) == 0;
 }
 
-/* TODO: Come up with a better hash function. */
 size_t hash_function(void* v)
 {
-    size_t ret;
+    if (!v) return 0;
+
+    /* Short decimal names only differ in a few bits of a sum of their
+       characters, so they are hashed byte by byte instead. */
+    return (size_t) string_hash(((directed_graph_node*)v)->state->p_name, 0);
+}
+
+static void adjacency_init(adjacency* p_adjacency)
+{
+    p_adjacency->p_storage = p_adjacency->inline_storage;
+    p_adjacency->p_index   = NULL;
+    p_adjacency->size      = 0;
+    p_adjacency->capacity  = ADJACENCY_INLINE_CAPACITY;
+}
+
+/*******************************************************************************
+* Returns the position of 'p_node' in the adjacency, or -1 if not present.     *
+*******************************************************************************/
+static size_t adjacency_index_of(adjacency* p_adjacency,
+                                 directed_graph_node* p_node)
+{
     size_t i;
-    char* pc;
 
-    if (!v) return 0;
+    for (i = 0; i < p_adjacency->size; ++i)
+    {
+        if (p_adjacency->p_storage[i] == p_node)
+        {
+            return i;
+        }
+    }
 
-    ret = 0;
-    i = 1;
-    pc = ((directed_graph_node*)v)->state->p_name;
+    for (i = 0; i < p_adjacency->size; ++i)
+    {
+        if (equals_function(p_adjacency->p_storage[i], p_node))
+        {
+            return i;
+        }
+    }
+
+    return (size_t)-1;
+}
 
-    while (*pc)
+static bool adjacency_contains(adjacency* p_adjacency,
+                               directed_graph_node* p_node)
+{
+    if (p_adjacency->p_index)
     {
-        ret += *pc * i;
-        ++i;
-        ++pc;
+        return unordered_set_contains(p_adjacency->p_index, p_node);
     }
 
-    return ret;
+    return adjacency_index_of(p_adjacency, p_node) != (size_t)-1;
 }
 
-static const size_t MAXIMUM_NAME_LENGTH = 80;
+/*******************************************************************************
+* Makes sure there is room for one more neighbor, moving the neighbors out of  *
+* the inline storage if needed. The storage of a node in an arena moves to a   *
+* new piece of the arena, the old piece being left behind.                     *
+*******************************************************************************/
+static bool adjacency_ensure_capacity(adjacency* p_adjacency, arena* p_arena)
+{
+    directed_graph_node** p_new_storage;
+    size_t                new_capacity;
 
-directed_graph_node* directed_graph_node_alloc(char* name)
+    if (p_adjacency->size < p_adjacency->capacity)
+    {
+        return true;
+    }
+
+    new_capacity = 2 * p_adjacency->capacity;
+
+    if (p_arena || p_adjacency->p_storage == p_adjacency->inline_storage)
+    {
+        p_new_storage = p_arena
+            ? arena_allocate(p_arena,
+                             sizeof(directed_graph_node*) * new_capacity)
+            : malloc(sizeof(directed_graph_node*) * new_capacity);
+
+        if (!p_new_storage) return false;
+
+        memcpy(p_new_storage,
+               p_adjacency->p_storage,
+               sizeof(directed_graph_node*) * p_adjacency->size);
+    }
+    else
+    {
+        p_new_storage = realloc(p_adjacency->p_storage,
+                                sizeof(directed_graph_node*) * new_capacity);
+
+        if (!p_new_storage) return false;
+    }
+
+    p_adjacency->p_storage = p_new_storage;
+    p_adjacency->capacity  = new_capacity;
+    return true;
+}
+
+/*******************************************************************************
+* Builds the hash set index once the degree grows beyond the threshold.        *
+*******************************************************************************/
+static bool adjacency_build_index(adjacency* p_adjacency, arena* p_arena)
 {
-    directed_graph_node* p_node = malloc(sizeof(*p_node));
-    char* p_text; 
-    
-    p_node->state = malloc(sizeof(*p_node->state));
+    size_t i;
 
-    if (!p_node) return NULL;
+    p_adjacency->p_index = p_arena
+        ? unordered_set_alloc_in_arena(p_arena,
+                                       2 * p_adjacency->size,
+                                       LOAD_FACTOR,
+                                       hash_function,
+                                       equals_function)
+        : unordered_set_alloc(2 * p_adjacency->size,
+                              LOAD_FACTOR,
+                              hash_function,
+                              equals_function);
 
-    p_node->state->p_name = name;
-    p_text = malloc(sizeof(char) * MAXIMUM_NAME_STRING_LEN);
+    if (!p_adjacency->p_index) return false;
 
-    if (!p_text)
+    for (i = 0; i < p_adjacency->size; ++i)
     {
-        free(p_node->state);
-        free(p_node);
-        return NULL;
+        unordered_set_add(p_adjacency->p_index, p_adjacency->p_storage[i]);
     }
 
-    p_node->state->p_child_node_set = unordered_set_alloc(INITIAL_CAPACITY,
-                                                          LOAD_FACTOR,
-                                                          hash_function,
-                                                          equals_function);
+    return true;
+}
 
-    if (!p_node->state->p_child_node_set)
+static bool adjacency_add(adjacency* p_adjacency,
+                          directed_graph_node* p_node,
+                          arena* p_arena)
+{
+    if (adjacency_contains(p_adjacency, p_node))
     {
-        free(p_text);
-        free(p_node->state);
-        free(p_node);
-        return NULL;
+        return false;
+    }
+
+    if (!adjacency_ensure_capacity(p_adjacency, p_arena))
+    {
+        return false;
+    }
+
+    if (p_adjacency->p_index && !unordered_set_add(p_adjacency->p_index,
+                                                   p_node))
+    {
+        return false;
+    }
+
+    p_adjacency->p_storage[p_adjacency->size++] = p_node;
+
+    if (!p_adjacency->p_index && p_adjacency->size > ADJACENCY_INDEX_THRESHOLD)
+    {
+        /* Failing to build the index only costs speed, not correctness. */
+        adjacency_build_index(p_adjacency, p_arena);
+    }
+
+    return true;
+}
+
+static bool adjacency_remove(adjacency* p_adjacency,
+                             directed_graph_node* p_node)
+{
+    size_t index;
+
+    if (p_adjacency->p_index && !unordered_set_contains(p_adjacency->p_index,
+                                                        p_node))
+    {
+        return false;
     }
 
-    p_node->state->p_parent_node_set = 
-        unordered_set_alloc(INITIAL_CAPACITY,
-                            LOAD_FACTOR,
-                            hash_function,
-                            equals_function);
+    if ((index = adjacency_index_of(p_adjacency, p_node)) == (size_t)-1)
+    {
+        return false;
+    }
 
-    if (!p_node->state->p_parent_node_set)
+    if (p_adjacency->p_index)
+    {
+        unordered_set_remove(p_adjacency->p_index, p_node);
+    }
+
+    /* Fill the hole with the last neighbor. */
+    p_adjacency->p_storage[index] =
+        p_adjacency->p_storage[--p_adjacency->size];
+
+    return true;
+}
+
+static void adjacency_clear(adjacency* p_adjacency)
+{
+    if (p_adjacency->p_index)
+    {
+        unordered_set_clear(p_adjacency->p_index);
+    }
+
+    p_adjacency->size = 0;
+}
+
+static void adjacency_destroy(adjacency* p_adjacency)
+{
+    if (p_adjacency->p_storage != p_adjacency->inline_storage)
+    {
+        free(p_adjacency->p_storage);
+    }
+
+    unordered_set_free(p_adjacency->p_index);
+    adjacency_init(p_adjacency);
+}
+
+/*******************************************************************************
+* Adds the memory taken by the adjacency beyond its node to '*p_usage'.        *
+*******************************************************************************/
+static void adjacency_memory_usage(adjacency* p_adjacency,
+                                   memory_usage* p_usage)
+{
+    p_usage->live += sizeof(directed_graph_node*) * p_adjacency->size;
+
+    if (p_adjacency->p_storage != p_adjacency->inline_storage)
+    {
+        p_usage->allocated +=
+            sizeof(directed_graph_node*) * p_adjacency->capacity;
+    }
+
+    if (p_adjacency->p_index)
+    {
+        p_usage->allocated +=
+            unordered_set_memory_usage(p_adjacency->p_index).allocated;
+    }
+}
+
+directed_graph_node* directed_graph_node_alloc_with_mode(
+                         char* name,
+                         directed_graph_node_mode mode,
+                         arena* p_arena)
+{
+    directed_graph_node* p_node;
+    size_t               size;
+
+    if (mode != DIRECTED_GRAPH_NODE_BIDIRECTIONAL &&
+        mode != DIRECTED_GRAPH_NODE_FORWARD_ONLY)
     {
-        unordered_set_free(p_node->state->p_child_node_set);
-        free(p_text);
-        free(p_node);
         return NULL;
     }
 
-    snprintf(p_text,
-        MAXIMUM_NAME_STRING_LEN,
-        "[directed_graph_node_t: id = %s]",
-        name);
+    /* The state directly follows the node in the same allocation. */
+    size = sizeof(*p_node) +
+           (mode == DIRECTED_GRAPH_NODE_FORWARD_ONLY
+               ? offsetof(directed_graph_node_state, parent_adjacency)
+               : sizeof(directed_graph_node_state));
+
+    p_node = p_arena ? arena_allocate(p_arena, size) : malloc(size);
+
+    if (!p_node) return NULL;
+
+    p_node->state = (directed_graph_node_state*)(p_node + 1);
+
+    adjacency_init(&p_node->state->child_adjacency);
+
+    if (mode == DIRECTED_GRAPH_NODE_BIDIRECTIONAL)
+    {
+        adjacency_init(&p_node->state->parent_adjacency);
+    }
 
+    /* The text is formatted on first request. */
     p_node->state->p_name = name;
-    p_node->state->p_text = p_text;
+    p_node->state->p_text = NULL;
+    p_node->state->p_arena = p_arena;
+    p_node->state->mode = mode;
     return p_node;
 }
 
+directed_graph_node* directed_graph_node_alloc(char* name)
+{
+    return directed_graph_node_alloc_with_mode(
+               name,
+               DIRECTED_GRAPH_NODE_BIDIRECTIONAL,
+               NULL);
+}
+
+directed_graph_node* directed_graph_node_alloc_in_arena(arena* p_arena,
+                                                        char* name)
+{
+    if (!p_arena) return NULL;
+
+    return directed_graph_node_alloc_with_mode(
+               name,
+               DIRECTED_GRAPH_NODE_BIDIRECTIONAL,
+               p_arena);
+}
+
 bool
 directed_graph_node_add_arc(directed_graph_node* p_tail,
                             directed_graph_node* p_head)
 {
     if (!p_tail || !p_head) return false;
 
-    if (!unordered_set_add(p_tail->state->p_child_node_set, p_head))
+    if (!adjacency_add(&p_tail->state->child_adjacency,
+                       p_head,
+                       p_tail->state->p_arena))
     {
         return false;
     }
 
-    if (!unordered_set_add(p_head->state->p_parent_node_set, p_tail))
+    if (has_parents(p_head) &&
+        !adjacency_add(&p_head->state->parent_adjacency,
+                       p_tail,
+                       p_head->state->p_arena))
     {
-        unordered_set_remove(p_tail->state->p_child_node_set, p_head);
+        adjacency_remove(&p_tail->state->child_adjacency, p_head);
         return false;
     }
 
     return true;
 }
 
-bool directed_graph_node_has_child(directed_graph_node* p_node, 
+bool directed_graph_node_has_child(directed_graph_node* p_node,
                                    directed_graph_node* p_child_candidate)
 {
     if (!p_node || !p_child_candidate) return false;
 
-    return unordered_set_contains(p_node->state->p_child_node_set,
-        p_child_candidate);
+    return adjacency_contains(&p_node->state->child_adjacency,
+                              p_child_candidate);
 }
 
 bool directed_graph_node_remove_arc(directed_graph_node* p_tail,
@@ -138,75 +381,161 @@ bool directed_graph_node_remove_arc(directed_graph_node* p_tail,
 {
     if (!p_tail || !p_head) return false;
 
-    unordered_set_remove(p_tail->state->p_child_node_set, p_head);
-    unordered_set_remove(p_head->state->p_parent_node_set, p_tail);
+    adjacency_remove(&p_tail->state->child_adjacency, p_head);
+
+    if (has_parents(p_head))
+    {
+        adjacency_remove(&p_head->state->parent_adjacency, p_tail);
+    }
+
     return true;
 }
 
 char* directed_graph_node_to_string(directed_graph_node* p_node)
 {
+    char*  p_text;
+    size_t size;
+
     if (!p_node) return "NULL node";
 
+    if (!p_node->state->p_text)
+    {
+        size = (size_t) snprintf(NULL, 0, TEXT_FORMAT, p_node->state->p_name);
+
+        p_text = p_node->state->p_arena
+                 ? arena_allocate(p_node->state->p_arena, size + 1)
+                 : malloc(size + 1);
+
+        if (!p_text) return p_node->state->p_name;
+
+        snprintf(p_text, size + 1, TEXT_FORMAT, p_node->state->p_name);
+        p_node->state->p_text = p_text;
+    }
+
     return p_node->state->p_text;
 }
 
-struct unordered_set*
-directed_graph_node_children_set(directed_graph_node* p_node)
+char* directed_graph_node_name(directed_graph_node* p_node)
+{
+    return p_node ? p_node->state->p_name : NULL;
+}
+
+size_t directed_graph_node_child_count(directed_graph_node* p_node)
 {
-    return p_node ? p_node->state->p_child_node_set : NULL;
+    return p_node ? p_node->state->child_adjacency.size : 0;
 }
 
-struct unordered_set*
-directed_graph_node_parent_set(directed_graph_node* p_node)
+directed_graph_node**
+directed_graph_node_children(directed_graph_node* p_node)
 {
-    return p_node ? p_node->state->p_parent_node_set : NULL;
+    return p_node ? p_node->state->child_adjacency.p_storage : NULL;
+}
+
+size_t directed_graph_node_parent_count(directed_graph_node* p_node)
+{
+    if (!p_node || !has_parents(p_node)) return 0;
+
+    return p_node->state->parent_adjacency.size;
+}
+
+directed_graph_node**
+directed_graph_node_parents(directed_graph_node* p_node)
+{
+    if (!p_node || !has_parents(p_node)) return NULL;
+
+    return p_node->state->parent_adjacency.p_storage;
+}
+
+directed_graph_node_mode directed_graph_node_get_mode(
+                             directed_graph_node* p_node)
+{
+    return p_node ? p_node->state->mode : DIRECTED_GRAPH_NODE_BIDIRECTIONAL;
+}
+
+memory_usage directed_graph_node_memory_usage(directed_graph_node* p_node)
+{
+    memory_usage usage = { 0, 0 };
+
+    if (!p_node) return usage;
+
+    usage.allocated = sizeof(*p_node) +
+                      (has_parents(p_node)
+                          ? sizeof(directed_graph_node_state)
+                          : offsetof(directed_graph_node_state,
+                                     parent_adjacency));
+
+    adjacency_memory_usage(&p_node->state->child_adjacency, &usage);
+
+    if (has_parents(p_node))
+    {
+        adjacency_memory_usage(&p_node->state->parent_adjacency, &usage);
+    }
+
+    if (p_node->state->p_text)
+    {
+        usage.allocated += strlen(p_node->state->p_text) + 1;
+    }
+
+    return usage;
 }
 
 void directed_graph_node_clear(directed_graph_node* p_node)
 {
-    unordered_set_iterator* p_iterator;
-    directed_graph_node*    p_tmp_node;
+    adjacency*           p_adjacency;
+    directed_graph_node* p_tmp_node;
+    size_t               i;
 
     if (!p_node) return;
 
-    p_iterator = unordered_set_iterator_alloc(p_node->state->p_child_node_set);
+    p_adjacency = &p_node->state->child_adjacency;
 
-    while (unordered_set_iterator_has_next(p_iterator))
+    for (i = 0; i < p_adjacency->size; ++i)
     {
-        unordered_set_iterator_next(p_iterator, &p_tmp_node);
+        p_tmp_node = p_adjacency->p_storage[i];
 
-        if (strcmp(p_node->state->p_name, p_tmp_node->state->p_name) != 0)
+        if (strcmp(p_node->state->p_name, p_tmp_node->state->p_name) != 0 &&
+            has_parents(p_tmp_node))
         {
-            unordered_set_remove(p_tmp_node->state->p_parent_node_set, p_node);
+            adjacency_remove(&p_tmp_node->state->parent_adjacency, p_node);
         }
     }
 
-    p_iterator = unordered_set_iterator_alloc(p_node->state->p_parent_node_set);
+    adjacency_clear(&p_node->state->child_adjacency);
 
-    while (unordered_set_iterator_has_next(p_iterator))
+    /* The arcs entering a forward-only node are not known to it. */
+    if (!has_parents(p_node)) return;
+
+    p_adjacency = &p_node->state->parent_adjacency;
+
+    for (i = 0; i < p_adjacency->size; ++i)
     {
-        unordered_set_iterator_next(p_iterator, &p_tmp_node);
+        p_tmp_node = p_adjacency->p_storage[i];
 
         if (strcmp(p_node->state->p_name, p_tmp_node->state->p_name) != 0)
         {
-            unordered_set_remove(p_tmp_node->state->p_child_node_set, p_node);
+            adjacency_remove(&p_tmp_node->state->child_adjacency, p_node);
         }
     }
 
-    unordered_set_clear(p_node->state->p_parent_node_set);
-    unordered_set_clear(p_node->state->p_child_node_set);
+    adjacency_clear(&p_node->state->parent_adjacency);
 }
 
 void directed_graph_node_free(directed_graph_node* p_node)
 {
-    unordered_set_iterator* p_iterator;
-    directed_graph_node* p_tmp_node;
-
     if (!p_node) return;
 
     directed_graph_node_clear(p_node);
-    unordered_set_free(p_node->state->p_child_node_set);
-    unordered_set_free(p_node->state->p_parent_node_set);
-    free(p_node->state);
+
+    /* The memory of a node in an arena is released with the arena. */
+    if (p_node->state->p_arena) return;
+
+    adjacency_destroy(&p_node->state->child_adjacency);
+
+    if (has_parents(p_node))
+    {
+        adjacency_destroy(&p_node->state->parent_adjacency);
+    }
+
+    free(p_node->state->p_text);
     free(p_node);
 }
@@ -13,13 +13,25 @@ extern "C" {
         struct directed_graph_node_state* state;
     } directed_graph_node;
 
+    /***************************************************************************
+    * Which arcs a node keeps track of. A forward-only node stores no parents, *
+    * which saves the parent adjacency and half of the work of adding arcs     *
+    * into it. Backward searches over forward-only nodes use a reverse index   *
+    * built when first needed.                                                 *
+    ***************************************************************************/
+    typedef enum directed_graph_node_mode {
+        DIRECTED_GRAPH_NODE_BIDIRECTIONAL,
+        DIRECTED_GRAPH_NODE_FORWARD_ONLY
+    } directed_graph_node_mode;
+
     /***************************************************************************
     * The function for testing node equality.                                  *
     ***************************************************************************/
     bool equals_function(void* a, void* b);
 
     /***************************************************************************
-    * The function for computing the hash values for nodes.                    *
+    * The function for computing the hash values for nodes, which hashes the   *
+    * name of the node with 'string_hash'.                                     *
     ***************************************************************************/
     size_t hash_function(void* v);
 
@@ -28,6 +40,25 @@ extern "C" {
     ***************************************************************************/
     directed_graph_node* directed_graph_node_alloc(char* name);
 
+    /***************************************************************************
+    * Allocates a new directed graph node with given name from 'p_arena'. Its  *
+    * neighbor arrays, neighbor index and text are allocated from the arena as *
+    * well. Freeing the node only removes its arcs; the whole graph is         *
+    * released at once by deallocating the arena, without freeing the nodes.   *
+    ***************************************************************************/
+    directed_graph_node* directed_graph_node_alloc_in_arena(arena* p_arena,
+                                                            char* name);
+
+    /***************************************************************************
+    * Allocates a new directed graph node with given name and mode, from       *
+    * 'p_arena' if it is not NULL. Returns NULL if the mode is unknown or      *
+    * memory runs out.                                                         *
+    ***************************************************************************/
+    directed_graph_node* directed_graph_node_alloc_with_mode(
+                             char* name,
+                             directed_graph_node_mode mode,
+                             arena* p_arena);
+
     /***************************************************************************
     * Creates an arc (p_tail, p_head) and returns true if the arc is actually  *
     * created. 'p_tail' is called a "parent" of 'p_head', and 'p_head' is      *
@@ -49,24 +80,62 @@ extern "C" {
                                         directed_graph_node* p_head);
 
     /***************************************************************************
-    * Returns the textual representation of the node.                          *
+    * Returns the textual representation of the node. The text is formatted on *
+    * the first call and kept until the node is deallocated; the first call is *
+    * not safe to race with another one on the same node.                      *
     ***************************************************************************/
     char* directed_graph_node_to_string(directed_graph_node* p_node);
 
     /***************************************************************************
-    * Returns the set containing all the child nodes of the given node.        *
+    * Returns the name the node was allocated with.                            *
+    ***************************************************************************/
+    char* directed_graph_node_name(directed_graph_node* p_node);
+
+    /***************************************************************************
+    * Returns the number of child nodes of the given node.                     *
+    ***************************************************************************/
+    size_t directed_graph_node_child_count(directed_graph_node* p_node);
+
+    /***************************************************************************
+    * Returns the contiguous array of the child nodes of the given node. The   *
+    * array holds 'directed_graph_node_child_count' nodes and stays valid      *
+    * until the next modification of the node's arcs.                          *
+    ***************************************************************************/
+    directed_graph_node**
+        directed_graph_node_children(directed_graph_node* p_node);
+
+    /***************************************************************************
+    * Returns the number of parent nodes of the given node, which is zero for  *
+    * a forward-only node.                                                     *
+    ***************************************************************************/
+    size_t directed_graph_node_parent_count(directed_graph_node* p_node);
+
+    /***************************************************************************
+    * Returns the contiguous array of the parent nodes of the given node. The  *
+    * array holds 'directed_graph_node_parent_count' nodes and stays valid     *
+    * until the next modification of the node's arcs. Returns NULL for a       *
+    * forward-only node.                                                       *
+    ***************************************************************************/
+    directed_graph_node**
+        directed_graph_node_parents(directed_graph_node* p_node);
+
+    /***************************************************************************
+    * Returns the mode the node was allocated with.                            *
     ***************************************************************************/
-    unordered_set*
-        directed_graph_node_children_set(directed_graph_node* p_node);
+    directed_graph_node_mode directed_graph_node_get_mode(
+                                 directed_graph_node* p_node);
 
     /***************************************************************************
-    * Returns the set containing all the parent nodes of the given node.       *
+    * Returns the memory taken by the node, its arc lists, their indices and   *
+    * its formatted text, but not by its name. The arcs are live. For a node   *
+    * in an arena the bytes are part of those of the arena.                    *
     ***************************************************************************/
-    unordered_set*
-        directed_graph_node_parent_set(directed_graph_node* p_node);
+    memory_usage directed_graph_node_memory_usage(directed_graph_node* p_node);
 
     /***************************************************************************
-    * Removes all the arcs involving the input node.                           *
+    * Removes all the arcs involving the input node. Of a forward-only node,   *
+    * only the arcs leaving it are removed; the arcs entering it have to be    *
+    * removed through their tails.                                             *
     ***************************************************************************/
     void directed_graph_node_clear(directed_graph_node* p_node);
 
@@ -0,0 +1,709 @@
+#include "edge_list.h"
+#include <float.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RADIX_BITS 11
+#define RADIX_SIZE (1U << RADIX_BITS)
+
+/*******************************************************************************
+* The least amount of work worth a thread of its own: bytes of text when       *
+* parsing, arcs when building.                                                 *
+*******************************************************************************/
+#define MIN_BYTES_PER_THREAD 65536
+#define MIN_ARCS_PER_THREAD  16384
+
+/*******************************************************************************
+* An arc being sorted: its sort key and its index before sorting.              *
+*******************************************************************************/
+typedef struct sort_item {
+    uint32_t key;
+    size_t   index;
+} sort_item;
+
+/*******************************************************************************
+* One radix sort pass over the items 'begin' to 'end - 1' of 'p_source'.       *
+* 'counts' first holds the amount of items per digit, then the position in     *
+* 'p_target' of the next item per digit.                                       *
+*******************************************************************************/
+typedef struct sort_task {
+    const sort_item* p_source;
+    sort_item*       p_target;
+    size_t           begin;
+    size_t           end;
+    unsigned         shift;
+    size_t           counts[RADIX_SIZE];
+} sort_task;
+
+typedef struct parse_task {
+    const char*    p_begin;
+    const char*    p_end;
+    weighted_edge* p_edges;
+    size_t         edge_count;
+    uint32_t       node_count;
+    bool           ok;
+} parse_task;
+
+/*******************************************************************************
+* The arrays shared by the threads building a graph.                           *
+*******************************************************************************/
+typedef struct build_context {
+    const weighted_edge* p_edges;
+    uint32_t             node_count;
+    weight_format        format;
+    double               fixed_point_scale;
+    sort_item*           p_items;
+    size_t*              p_offsets;
+    uint32_t*            p_heads;
+    void*                p_weights;
+    uint32_t*            p_arc_tails;
+    size_t*              p_reverse_offsets;
+    uint32_t*            p_reverse_tails;
+    size_t*              p_reverse_arcs;
+} build_context;
+
+typedef struct build_task {
+    build_context* p_context;
+    size_t         begin;
+    size_t         end;
+    bool           ok;
+} build_task;
+
+typedef struct task_call {
+    void(*p_function)(void*);
+    void* p_task;
+} task_call;
+
+static void* call_task(void* p_arg)
+{
+    task_call* p_call = p_arg;
+
+    p_call->p_function(p_call->p_task);
+    return NULL;
+}
+
+/*******************************************************************************
+* Calls 'p_function' on each of the 'task_count' tasks of size 'task_size' in  *
+* 'p_tasks', each on a thread of its own but the first, which runs on the      *
+* calling thread. A task whose thread cannot be started runs on the calling    *
+* thread as well.                                                              *
+*******************************************************************************/
+static void run_parallel(void(*p_function)(void*),
+                         void* p_tasks,
+                         size_t task_size,
+                         size_t task_count)
+{
+    pthread_t* p_threads;
+    task_call* p_calls;
+    bool*      p_started;
+    size_t     i;
+
+    p_threads = malloc(sizeof(pthread_t) * task_count);
+    p_calls   = malloc(sizeof(task_call) * task_count);
+    p_started = calloc(task_count, sizeof(bool));
+
+    for (i = 1; i < task_count; ++i)
+    {
+        if (!p_threads || !p_calls || !p_started) break;
+
+        p_calls[i].p_function = p_function;
+        p_calls[i].p_task = (char*) p_tasks + i * task_size;
+        p_started[i] = pthread_create(&p_threads[i],
+                                      NULL,
+                                      call_task,
+                                      &p_calls[i]) == 0;
+    }
+
+    for (i = 0; i < task_count; ++i)
+    {
+        if (!p_started || !p_started[i])
+        {
+            p_function((char*) p_tasks + i * task_size);
+        }
+    }
+
+    for (i = 1; i < task_count; ++i)
+    {
+        if (p_started && p_started[i])
+        {
+            pthread_join(p_threads[i], NULL);
+        }
+    }
+
+    free(p_threads);
+    free(p_calls);
+    free(p_started);
+}
+
+static size_t fix_task_count(size_t thread_count, size_t work, size_t minimum)
+{
+    size_t task_count = work / minimum;
+
+    if (task_count > thread_count) task_count = thread_count;
+
+    return task_count > 0 ? task_count : 1;
+}
+
+static const char* skip_blanks(const char* p_char)
+{
+    while (*p_char == ' ' || *p_char == '\t' || *p_char == '\r')
+    {
+        ++p_char;
+    }
+
+    return p_char;
+}
+
+static const char* skip_line(const char* p_char, const char* p_end)
+{
+    while (p_char < p_end && *p_char++ != '\n')
+    {
+    }
+
+    return p_char;
+}
+
+/*******************************************************************************
+* Reads an unsigned id preceded by blanks. Returns NULL if there is no id or   *
+* it is reserved for 'COMPACT_GRAPH_NO_NODE'.                                  *
+*******************************************************************************/
+static const char* read_id(const char* p_char, uint32_t* p_id)
+{
+    uint64_t id;
+
+    p_char = skip_blanks(p_char);
+
+    if (*p_char < '0' || *p_char > '9') return NULL;
+
+    for (id = 0; *p_char >= '0' && *p_char <= '9'; ++p_char)
+    {
+        id = 10 * id + (uint64_t)(*p_char - '0');
+
+        if (id >= COMPACT_GRAPH_NO_NODE) return NULL;
+    }
+
+    *p_id = (uint32_t) id;
+    return p_char;
+}
+
+static const char* read_weight(const char* p_char, double* p_weight)
+{
+    char* p_weight_end;
+
+    p_char = skip_blanks(p_char);
+
+    /* Keeps 'strtod' from skipping to the next line. */
+    if (*p_char == '\n' || *p_char == '\0') return NULL;
+
+    *p_weight = strtod(p_char, &p_weight_end);
+
+    if (p_weight_end == p_char)                     return NULL;
+    if (!(*p_weight >= 0.0 && *p_weight <= DBL_MAX)) return NULL;
+
+    return p_weight_end;
+}
+
+static void parse_part(void* p_arg)
+{
+    parse_task*    p_task = p_arg;
+    const char*    p_char;
+    weighted_edge* p_edge;
+    size_t         capacity;
+
+    p_task->edge_count = 0;
+    p_task->node_count = 0;
+    p_task->ok = false;
+    capacity = 1;
+
+    for (p_char = p_task->p_begin; p_char < p_task->p_end; ++p_char)
+    {
+        if (*p_char == '\n') ++capacity;
+    }
+
+    if (!(p_task->p_edges = malloc(sizeof(weighted_edge) * capacity))) return;
+
+    for (p_char = p_task->p_begin; p_char < p_task->p_end;)
+    {
+        p_char = skip_blanks(p_char);
+
+        if (p_char >= p_task->p_end) break;
+
+        if (*p_char == '\n' || *p_char == '#')
+        {
+            p_char = skip_line(p_char, p_task->p_end);
+            continue;
+        }
+
+        p_edge = &p_task->p_edges[p_task->edge_count];
+
+        if (!(p_char = read_id(p_char, &p_edge->tail)))       return;
+        if (!(p_char = read_id(p_char, &p_edge->head)))       return;
+        if (!(p_char = read_weight(p_char, &p_edge->weight))) return;
+
+        p_char = skip_blanks(p_char);
+
+        if (p_char < p_task->p_end && *p_char != '\n') return;
+
+        if (p_edge->tail >= p_task->node_count)
+        {
+            p_task->node_count = p_edge->tail + 1;
+        }
+
+        if (p_edge->head >= p_task->node_count)
+        {
+            p_task->node_count = p_edge->head + 1;
+        }
+
+        p_task->edge_count++;
+        p_char = skip_line(p_char, p_task->p_end);
+    }
+
+    p_task->ok = true;
+}
+
+bool edge_list_parse(const char* p_text,
+                     size_t thread_count,
+                     weighted_edge** pp_edges,
+                     size_t* p_edge_count,
+                     uint32_t* p_node_count)
+{
+    parse_task*    p_tasks;
+    weighted_edge* p_edges;
+    const char*    p_end;
+    size_t         task_count;
+    size_t         edge_count;
+    size_t         length;
+    uint32_t       node_count;
+    bool           ok;
+    size_t         i;
+
+    if (!p_text || !pp_edges || !p_edge_count || !p_node_count) return false;
+
+    length = strlen(p_text);
+    p_end = p_text + length;
+    task_count = fix_task_count(thread_count, length, MIN_BYTES_PER_THREAD);
+
+    if (!(p_tasks = calloc(task_count, sizeof(parse_task)))) return false;
+
+    /* Each part but the first starts right after a line break. */
+    for (i = 0; i < task_count; ++i)
+    {
+        p_tasks[i].p_begin = i == 0 ? p_text : p_tasks[i - 1].p_end;
+        p_tasks[i].p_end = i == task_count - 1
+                         ? p_end
+                         : skip_line(p_text + length / task_count * (i + 1),
+                                     p_end);
+
+        if (p_tasks[i].p_end < p_tasks[i].p_begin)
+        {
+            p_tasks[i].p_end = p_tasks[i].p_begin;
+        }
+    }
+
+    run_parallel(parse_part, p_tasks, sizeof(parse_task), task_count);
+
+    ok = true;
+    edge_count = 0;
+    node_count = 0;
+
+    for (i = 0; i < task_count; ++i)
+    {
+        ok = ok && p_tasks[i].ok;
+        edge_count += p_tasks[i].edge_count;
+
+        if (p_tasks[i].node_count > node_count)
+        {
+            node_count = p_tasks[i].node_count;
+        }
+    }
+
+    p_edges = ok ? malloc(sizeof(weighted_edge) * (edge_count + 1)) : NULL;
+    edge_count = 0;
+
+    for (i = 0; i < task_count; ++i)
+    {
+        if (p_edges)
+        {
+            memcpy(p_edges + edge_count,
+                   p_tasks[i].p_edges,
+                   sizeof(weighted_edge) * p_tasks[i].edge_count);
+
+            edge_count += p_tasks[i].edge_count;
+        }
+
+        free(p_tasks[i].p_edges);
+    }
+
+    free(p_tasks);
+
+    if (!p_edges) return false;
+
+    *pp_edges = p_edges;
+    *p_edge_count = edge_count;
+    *p_node_count = node_count;
+    return true;
+}
+
+static void count_digits(void* p_arg)
+{
+    sort_task* p_task = p_arg;
+    size_t     i;
+
+    memset(p_task->counts, 0, sizeof(p_task->counts));
+
+    for (i = p_task->begin; i < p_task->end; ++i)
+    {
+        p_task->counts[(p_task->p_source[i].key >> p_task->shift) &
+                       (RADIX_SIZE - 1)]++;
+    }
+}
+
+static void scatter_digits(void* p_arg)
+{
+    sort_task* p_task = p_arg;
+    unsigned   digit;
+    size_t     i;
+
+    for (i = p_task->begin; i < p_task->end; ++i)
+    {
+        digit = (p_task->p_source[i].key >> p_task->shift) & (RADIX_SIZE - 1);
+        p_task->p_target[p_task->counts[digit]++] = p_task->p_source[i];
+    }
+}
+
+/*******************************************************************************
+* Sorts the 'count' items stably by key, no key exceeding 'max_key', using     *
+* 'p_buffer' as the second array of the passes. Returns the one of the two     *
+* arrays holding the sorted items.                                             *
+*******************************************************************************/
+static sort_item* radix_sort(sort_item* p_items,
+                             sort_item* p_buffer,
+                             size_t count,
+                             uint32_t max_key,
+                             sort_task* p_tasks,
+                             size_t task_count)
+{
+    sort_item* p_swap;
+    size_t     position;
+    size_t     digit_count;
+    unsigned   shift;
+    unsigned   digit;
+    size_t     i;
+
+    for (shift = 0;
+         shift < 32 && ((uint64_t) max_key >> shift) != 0;
+         shift += RADIX_BITS)
+    {
+        for (i = 0; i < task_count; ++i)
+        {
+            p_tasks[i].p_source = p_items;
+            p_tasks[i].p_target = p_buffer;
+            p_tasks[i].begin = count / task_count * i;
+            p_tasks[i].end = i == task_count - 1
+                           ? count
+                           : count / task_count * (i + 1);
+            p_tasks[i].shift = shift;
+        }
+
+        run_parallel(count_digits, p_tasks, sizeof(sort_task), task_count);
+
+        /* The items of a digit go in the order of the tasks. */
+        position = 0;
+
+        for (digit = 0; digit < RADIX_SIZE; ++digit)
+        {
+            for (i = 0; i < task_count; ++i)
+            {
+                digit_count = p_tasks[i].counts[digit];
+                p_tasks[i].counts[digit] = position;
+                position += digit_count;
+            }
+        }
+
+        run_parallel(scatter_digits, p_tasks, sizeof(sort_task), task_count);
+
+        p_swap = p_items;
+        p_items = p_buffer;
+        p_buffer = p_swap;
+    }
+
+    return p_items;
+}
+
+/*******************************************************************************
+* Sets the offset of every node up to and including the key of each sorted     *
+* item 'begin' to 'end - 1' whose predecessor has a smaller key: the offset of *
+* a node is the position of the first item with a key no less than the node.   *
+*******************************************************************************/
+static void fill_offsets(const sort_item* p_items,
+                         size_t* p_offsets,
+                         size_t begin,
+                         size_t end)
+{
+    uint32_t id;
+    size_t   i;
+
+    for (i = begin; i < end; ++i)
+    {
+        for (id = i == 0 ? 0 : p_items[i - 1].key + 1;
+             id <= p_items[i].key;
+             ++id)
+        {
+            p_offsets[id] = i;
+        }
+    }
+}
+
+static void fill_last_offsets(const sort_item* p_items,
+                              size_t* p_offsets,
+                              size_t count,
+                              uint32_t node_count)
+{
+    uint32_t id;
+
+    for (id = count == 0 ? 0 : p_items[count - 1].key + 1;
+         id <= node_count;
+         ++id)
+    {
+        p_offsets[id] = count;
+    }
+}
+
+static void key_by_tail(void* p_arg)
+{
+    build_task*    p_task = p_arg;
+    build_context* p_context = p_task->p_context;
+    size_t         i;
+
+    p_task->ok = true;
+
+    for (i = p_task->begin; i < p_task->end; ++i)
+    {
+        if (p_context->p_edges[i].tail >= p_context->node_count ||
+            p_context->p_edges[i].head >= p_context->node_count)
+        {
+            p_task->ok = false;
+            return;
+        }
+
+        p_context->p_items[i].key = p_context->p_edges[i].tail;
+        p_context->p_items[i].index = i;
+    }
+}
+
+/*******************************************************************************
+* Writes the forward arrays for the arcs sorted by tail, and keys the arcs by  *
+* head for sorting the reverse adjacency.                                      *
+*******************************************************************************/
+static void emit_forward(void* p_arg)
+{
+    build_task*          p_task = p_arg;
+    build_context*       p_context = p_task->p_context;
+    const weighted_edge* p_edge;
+    size_t               arc;
+
+    p_task->ok = true;
+
+    fill_offsets(p_context->p_items,
+                 p_context->p_offsets,
+                 p_task->begin,
+                 p_task->end);
+
+    for (arc = p_task->begin; arc < p_task->end; ++arc)
+    {
+        p_edge = &p_context->p_edges[p_context->p_items[arc].index];
+
+        p_context->p_heads[arc] = p_edge->head;
+        p_context->p_arc_tails[arc] = p_edge->tail;
+
+        if (!weight_format_write(p_context->format,
+                                 p_context->fixed_point_scale,
+                                 p_context->p_weights,
+                                 arc,
+                                 p_edge->weight))
+        {
+            p_task->ok = false;
+        }
+    }
+}
+
+static void key_by_head(void* p_arg)
+{
+    build_task*    p_task = p_arg;
+    build_context* p_context = p_task->p_context;
+    size_t         arc;
+
+    for (arc = p_task->begin; arc < p_task->end; ++arc)
+    {
+        p_context->p_items[arc].key = p_context->p_heads[arc];
+        p_context->p_items[arc].index = arc;
+    }
+}
+
+static void emit_reverse(void* p_arg)
+{
+    build_task*    p_task = p_arg;
+    build_context* p_context = p_task->p_context;
+    size_t         i;
+
+    fill_offsets(p_context->p_items,
+                 p_context->p_reverse_offsets,
+                 p_task->begin,
+                 p_task->end);
+
+    for (i = p_task->begin; i < p_task->end; ++i)
+    {
+        p_context->p_reverse_arcs[i] = p_context->p_items[i].index;
+        p_context->p_reverse_tails[i] =
+            p_context->p_arc_tails[p_context->p_items[i].index];
+    }
+}
+
+static bool tasks_ok(const build_task* p_tasks, size_t task_count)
+{
+    size_t i;
+
+    for (i = 0; i < task_count; ++i)
+    {
+        if (!p_tasks[i].ok) return false;
+    }
+
+    return true;
+}
+
+compact_graph* edge_list_build(const weighted_edge* p_edges,
+                               size_t edge_count,
+                               uint32_t node_count,
+                               weight_format format,
+                               double fixed_point_scale,
+                               size_t thread_count)
+{
+    compact_graph* p_graph;
+    build_context  context;
+    build_task*    p_tasks;
+    sort_task*     p_sort_tasks;
+    sort_item*     p_items;
+    sort_item*     p_buffer;
+    size_t         task_count;
+    size_t         i;
+    bool           ok;
+
+    if (!p_edges && edge_count > 0)          return NULL;
+    if (node_count >= COMPACT_GRAPH_NO_NODE) return NULL;
+
+    if (format == WEIGHT_FORMAT_FIXED_POINT && !(fixed_point_scale > 0.0))
+    {
+        return NULL;
+    }
+
+    task_count = fix_task_count(thread_count, edge_count, MIN_ARCS_PER_THREAD);
+
+    context.p_edges           = p_edges;
+    context.node_count        = node_count;
+    context.format            = format;
+    context.fixed_point_scale = fixed_point_scale;
+    context.p_offsets         = malloc(sizeof(size_t) * (node_count + 1));
+    context.p_heads           = malloc(sizeof(uint32_t) * (edge_count + 1));
+    context.p_weights         = malloc(weight_format_size(format) *
+                                       (edge_count + 1));
+    context.p_arc_tails       = malloc(sizeof(uint32_t) * (edge_count + 1));
+    context.p_reverse_offsets = malloc(sizeof(size_t) * (node_count + 1));
+    context.p_reverse_tails   = malloc(sizeof(uint32_t) * (edge_count + 1));
+    context.p_reverse_arcs    = malloc(sizeof(size_t) * (edge_count + 1));
+
+    p_items      = malloc(sizeof(sort_item) * (edge_count + 1));
+    p_buffer     = malloc(sizeof(sort_item) * (edge_count + 1));
+    p_tasks      = malloc(sizeof(build_task) * task_count);
+    p_sort_tasks = malloc(sizeof(sort_task) * task_count);
+
+    ok = context.p_offsets         && context.p_heads         &&
+         context.p_weights         && context.p_arc_tails     &&
+         context.p_reverse_offsets && context.p_reverse_tails &&
+         context.p_reverse_arcs    && p_items && p_buffer     &&
+         p_tasks                   && p_sort_tasks;
+
+    if (ok)
+    {
+        for (i = 0; i < task_count; ++i)
+        {
+            p_tasks[i].p_context = &context;
+            p_tasks[i].begin = edge_count / task_count * i;
+            p_tasks[i].end = i == task_count - 1
+                           ? edge_count
+                           : edge_count / task_count * (i + 1);
+            p_tasks[i].ok = true;
+        }
+
+        context.p_items = p_items;
+        run_parallel(key_by_tail, p_tasks, sizeof(build_task), task_count);
+        ok = tasks_ok(p_tasks, task_count);
+    }
+
+    if (ok)
+    {
+        context.p_items = radix_sort(p_items,
+                                     p_buffer,
+                                     edge_count,
+                                     node_count > 0 ? node_count - 1 : 0,
+                                     p_sort_tasks,
+                                     task_count);
+
+        run_parallel(emit_forward, p_tasks, sizeof(build_task), task_count);
+        fill_last_offsets(context.p_items,
+                          context.p_offsets,
+                          edge_count,
+                          node_count);
+        ok = tasks_ok(p_tasks, task_count);
+    }
+
+    if (ok)
+    {
+        run_parallel(key_by_head, p_tasks, sizeof(build_task), task_count);
+
+        context.p_items = radix_sort(context.p_items,
+                                     context.p_items == p_items
+                                         ? p_buffer
+                                         : p_items,
+                                     edge_count,
+                                     node_count > 0 ? node_count - 1 : 0,
+                                     p_sort_tasks,
+                                     task_count);
+
+        run_parallel(emit_reverse, p_tasks, sizeof(build_task), task_count);
+        fill_last_offsets(context.p_items,
+                          context.p_reverse_offsets,
+                          edge_count,
+                          node_count);
+    }
+
+    free(p_items);
+    free(p_buffer);
+    free(p_tasks);
+    free(p_sort_tasks);
+    free(context.p_arc_tails);
+
+    p_graph = ok ? compact_graph_adopt(node_count,
+                                       edge_count,
+                                       context.p_offsets,
+                                       context.p_heads,
+                                       context.p_weights,
+                                       format,
+                                       fixed_point_scale,
+                                       context.p_reverse_offsets,
+                                       context.p_reverse_tails,
+                                       context.p_reverse_arcs)
+                 : NULL;
+
+    if (!p_graph)
+    {
+        free(context.p_offsets);
+        free(context.p_heads);
+        free(context.p_weights);
+        free(context.p_reverse_offsets);
+        free(context.p_reverse_tails);
+        free(context.p_reverse_arcs);
+    }
+
+    return p_graph;
+}
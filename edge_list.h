@@ -0,0 +1,59 @@
+#ifndef EDGE_LIST_H
+#define EDGE_LIST_H
+
+#include "compact_graph.h"
+#include "weight_function.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * An arc given by the ids of its tail and head, and its weight.            *
+    ***************************************************************************/
+    typedef struct weighted_edge {
+        uint32_t tail;
+        uint32_t head;
+        double   weight;
+    } weighted_edge;
+
+    /***************************************************************************
+    * Parses the zero-terminated text 'p_text' holding one arc per line as     *
+    * 'tail head weight', the ids counting from zero. Blank lines and lines    *
+    * starting with '#' are skipped. The text is split at line boundaries into *
+    * up to 'thread_count' parts parsed in parallel. On success stores the     *
+    * arcs in file order into a new array at '*pp_edges', their amount into    *
+    * '*p_edge_count' and the largest id plus one into '*p_node_count'.        *
+    * Returns false if a line is malformed, a weight is negative or memory     *
+    * runs out.                                                                *
+    ***************************************************************************/
+    bool edge_list_parse(const char* p_text,
+                         size_t thread_count,
+                         weighted_edge** pp_edges,
+                         size_t* p_edge_count,
+                         uint32_t* p_node_count);
+
+    /***************************************************************************
+    * Builds a compact graph of 'node_count' nodes from the 'edge_count' arcs  *
+    * in 'p_edges', using up to 'thread_count' threads. The arcs are radix     *
+    * sorted by tail, which keeps the arcs of a tail in input order, and the   *
+    * heads, the weights in format 'format' and the reverse adjacency are      *
+    * written in one pass over the sorted arcs. Returns NULL if an id is not   *
+    * less than 'node_count', a weight is not representable in the format, or  *
+    * memory runs out.                                                         *
+    ***************************************************************************/
+    compact_graph* edge_list_build(const weighted_edge* p_edges,
+                                   size_t edge_count,
+                                   uint32_t node_count,
+                                   weight_format format,
+                                   double fixed_point_scale,
+                                   size_t thread_count);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* EDGE_LIST_H */
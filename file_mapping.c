@@ -0,0 +1,109 @@
+#include "file_mapping.h"
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+file_mapping* file_mapping_open(const char* p_file_name)
+{
+    file_mapping* p_mapping;
+
+    if (!p_file_name) return NULL;
+
+    if (!(p_mapping = malloc(sizeof(*p_mapping)))) return NULL;
+
+#ifdef _WIN32
+    {
+        FILE* p_file;
+        void* p_address;
+        long  size;
+
+        if (!(p_file = fopen(p_file_name, "rb")))
+        {
+            free(p_mapping);
+            return NULL;
+        }
+
+        if (fseek(p_file, 0, SEEK_END) != 0 || (size = ftell(p_file)) <= 0 ||
+            fseek(p_file, 0, SEEK_SET) != 0)
+        {
+            fclose(p_file);
+            free(p_mapping);
+            return NULL;
+        }
+
+        p_mapping->size = (size_t) size;
+
+        if (!(p_address = malloc(p_mapping->size)) ||
+            fread(p_address, 1, p_mapping->size, p_file) != p_mapping->size)
+        {
+            free(p_address);
+            fclose(p_file);
+            free(p_mapping);
+            return NULL;
+        }
+
+        fclose(p_file);
+        p_mapping->p_address = p_address;
+    }
+#else
+    {
+        struct stat status;
+        void*       p_address;
+        int         descriptor;
+
+        if ((descriptor = open(p_file_name, O_RDONLY)) < 0)
+        {
+            free(p_mapping);
+            return NULL;
+        }
+
+        if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+        {
+            close(descriptor);
+            free(p_mapping);
+            return NULL;
+        }
+
+        p_mapping->size = (size_t) status.st_size;
+        p_address = mmap(NULL,
+                         p_mapping->size,
+                         PROT_READ,
+                         MAP_PRIVATE,
+                         descriptor,
+                         0);
+
+        /* The mapping stays valid after the descriptor is closed. */
+        close(descriptor);
+
+        if (p_address == MAP_FAILED)
+        {
+            free(p_mapping);
+            return NULL;
+        }
+
+        p_mapping->p_address = p_address;
+    }
+#endif
+
+    return p_mapping;
+}
+
+void file_mapping_close(void* p_arg)
+{
+    file_mapping* p_mapping = p_arg;
+
+    if (!p_mapping) return;
+
+#ifdef _WIN32
+    free((void*) p_mapping->p_address);
+#else
+    munmap((void*) p_mapping->p_address, p_mapping->size);
+#endif
+
+    free(p_mapping);
+}
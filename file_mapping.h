@@ -0,0 +1,34 @@
+#ifndef FILE_MAPPING_H
+#define FILE_MAPPING_H
+
+#include <stdlib.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * The contents of a file made available in memory for reading: mapped      *
+    * where possible, read into a buffer otherwise.                            *
+    ***************************************************************************/
+    typedef struct file_mapping {
+        const void* p_address;
+        size_t      size;
+    } file_mapping;
+
+    /***************************************************************************
+    * Maps the file 'p_file_name' read-only. Returns NULL if the file cannot   *
+    * be opened, is empty or memory runs out.                                  *
+    ***************************************************************************/
+    file_mapping* file_mapping_open(const char* p_file_name);
+
+    /***************************************************************************
+    * Releases the mapping. Its type suits release callbacks taking a 'void*'. *
+    ***************************************************************************/
+    void file_mapping_close(void* p_mapping);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* FILE_MAPPING_H */
@@ -18,15 +18,32 @@ typedef struct heap_state {
     size_t         capacity;
     size_t         degree;
     size_t*        indices;
+    arena*         p_arena;
+    heap_node*     free_nodes;
 } heap_state;
 /*
 typedef struct heap {
     struct heap_state* state;
 } heap;*/
 
-static heap_node* heap_node_alloc(void* element, void* priority)
+static heap_node* heap_node_alloc(heap* my_heap, void* element, void* priority)
 {
-    heap_node* p_ret = malloc(sizeof(*p_ret));
+    heap_node* p_ret;
+
+    if (!my_heap->state->p_arena)
+    {
+        p_ret = malloc(sizeof(*p_ret));
+    }
+    else if ((p_ret = my_heap->state->free_nodes))
+    {
+        /* Nodes of arena heaps are recycled instead of freed; a free node
+           links to the next one through its element. */
+        my_heap->state->free_nodes = p_ret->element;
+    }
+    else
+    {
+        p_ret = arena_allocate(my_heap->state->p_arena, sizeof(*p_ret));
+    }
 
     if (!p_ret)
     {
@@ -39,6 +56,34 @@ static heap_node* heap_node_alloc(void* element, void* priority)
     return p_ret;
 }
 
+static void heap_node_free(heap* my_heap, heap_node* node)
+{
+    if (!my_heap->state->p_arena)
+    {
+        free(node);
+        return;
+    }
+
+    node->element = my_heap->state->free_nodes;
+    my_heap->state->free_nodes = node;
+}
+
+/*******************************************************************************
+* Allocates 'size' bytes from the arena of the heap if it has one.             *
+*******************************************************************************/
+static void* heap_memory_alloc(arena* p_arena, size_t size)
+{
+    return p_arena ? arena_allocate(p_arena, size) : malloc(size);
+}
+
+static void heap_memory_free(arena* p_arena, void* p_memory)
+{
+    if (!p_arena)
+    {
+        free(p_memory);
+    }
+}
+
 static const size_t MINIMUM_CAPACITY = 16;
 
 static size_t fix_degree(size_t degree)
@@ -52,12 +97,13 @@ static size_t fix_initial_capacity(size_t initial_capacity)
         initial_capacity;
 }
 
-heap* heap_alloc(size_t   degree,
-    size_t   initial_capacity,
-    float    load_factor,
-    size_t(*hash_function)(void*),
-    bool(*equals_function)(void*, void*),
-    int(*priority_compare_function)(void*, void*))
+static heap* alloc_heap(arena* p_arena,
+                        size_t degree,
+                        size_t initial_capacity,
+                        float load_factor,
+                        size_t(*hash_function)(void*),
+                        bool(*equals_function)(void*, void*),
+                        int(*priority_compare_function)(void*, void*))
 {
     heap* my_heap;
     unordered_map* p_map;
@@ -67,51 +113,55 @@ heap* heap_alloc(size_t   degree,
         return NULL;
     }
 
-    my_heap = malloc(sizeof(*my_heap));
+    /* The state shares the allocation of the heap. */
+    my_heap = heap_memory_alloc(p_arena,
+                                sizeof(*my_heap) + sizeof(*my_heap->state));
 
     if (!my_heap)
     {
         return NULL;
     }
 
-    my_heap->state = malloc(sizeof(*my_heap->state));
-
-    if (!my_heap)
-    {
-        free(my_heap);
-        return NULL;
-    }
+    my_heap->state = (heap_state*)(my_heap + 1);
 
-    p_map = unordered_map_alloc(initial_capacity,
-        load_factor,
-        hash_function,
-        equals_function);
+    p_map = p_arena ? unordered_map_alloc_in_arena(p_arena,
+                                                   initial_capacity,
+                                                   load_factor,
+                                                   hash_function,
+                                                   equals_function)
+                    : unordered_map_alloc(initial_capacity,
+                                          load_factor,
+                                          hash_function,
+                                          equals_function);
 
     if (!p_map)
     {
-        free(my_heap);
+        heap_memory_free(p_arena, my_heap);
         return NULL;
     }
 
     degree = fix_degree(degree);
     initial_capacity = fix_initial_capacity(initial_capacity);
 
-    my_heap->state->table = malloc(sizeof(heap_node*) * initial_capacity);
+    my_heap->state->table = heap_memory_alloc(p_arena,
+                                              sizeof(heap_node*) *
+                                              initial_capacity);
 
     if (!my_heap->state->table)
     {
         unordered_map_free(p_map);
-        free(my_heap);
+        heap_memory_free(p_arena, my_heap);
         return NULL;
     }
 
-    my_heap->state->indices = malloc(sizeof(size_t) * degree);
+    my_heap->state->indices = heap_memory_alloc(p_arena,
+                                                sizeof(size_t) * degree);
 
     if (!my_heap->state->indices)
     {
         unordered_map_free(p_map);
-        free(my_heap->state->table);
-        free(my_heap);
+        heap_memory_free(p_arena, my_heap->state->table);
+        heap_memory_free(p_arena, my_heap);
         return NULL;
     }
 
@@ -122,10 +172,50 @@ heap* heap_alloc(size_t   degree,
     my_heap->state->hash_function        = hash_function;
     my_heap->state->equals_function      = equals_function;
     my_heap->state->key_compare_function = priority_compare_function;
+    my_heap->state->p_arena              = p_arena;
+    my_heap->state->free_nodes           = NULL;
 
     return my_heap;
 }
 
+heap* heap_alloc(size_t   degree,
+    size_t   initial_capacity,
+    float    load_factor,
+    size_t(*hash_function)(void*),
+    bool(*equals_function)(void*, void*),
+    int(*priority_compare_function)(void*, void*))
+{
+    return alloc_heap(NULL,
+                      degree,
+                      initial_capacity,
+                      load_factor,
+                      hash_function,
+                      equals_function,
+                      priority_compare_function);
+}
+
+heap* heap_alloc_in_arena(arena* p_arena,
+    size_t   degree,
+    size_t   initial_capacity,
+    float    load_factor,
+    size_t(*hash_function)(void*),
+    bool(*equals_function)(void*, void*),
+    int(*priority_compare_function)(void*, void*))
+{
+    if (!p_arena)
+    {
+        return NULL;
+    }
+
+    return alloc_heap(p_arena,
+                      degree,
+                      initial_capacity,
+                      load_factor,
+                      hash_function,
+                      equals_function,
+                      priority_compare_function);
+}
+
 static size_t get_parent_index(heap* my_heap, size_t child_index)
 {
     return (child_index - 1) / my_heap->state->degree;
@@ -305,7 +395,8 @@ static bool ensure_capacity_before_add(heap* my_heap)
     }
 
     new_capacity = 3 * my_heap->state->capacity / 2;
-    new_table = malloc(sizeof(heap_node*) * new_capacity);
+    new_table = heap_memory_alloc(my_heap->state->p_arena,
+                                  sizeof(heap_node*) * new_capacity);
 
     if (!new_table) return false;
 
@@ -314,7 +405,7 @@ static bool ensure_capacity_before_add(heap* my_heap)
         new_table[i] = my_heap->state->table[i];
     }
 
-    free(my_heap->state->table);
+    heap_memory_free(my_heap->state->p_arena, my_heap->state->table);
     my_heap->state->table = new_table;
     my_heap->state->capacity = new_capacity;
     return true;
@@ -340,7 +431,7 @@ bool heap_add(heap* my_heap, void* element, void* priority)
         return false;
     }
 
-    node = heap_node_alloc(element, priority);
+    node = heap_node_alloc(my_heap, element, priority);
 
     if (!node)
     {
@@ -406,7 +497,7 @@ void* heap_extract_min(heap* my_heap)
     my_heap->state->table[0] = my_heap->state->table[my_heap->state->size];
     unordered_map_remove(my_heap->state->node_map, ret);
     sift_down_root(my_heap);
-    free(node);
+    heap_node_free(my_heap, node);
     return ret;
 }
 
@@ -425,6 +516,30 @@ int heap_size(heap* my_heap)
     return my_heap ? my_heap->state->size : -1;
 }
 
+memory_usage heap_memory_usage(heap* my_heap)
+{
+    memory_usage usage = { 0, 0 };
+    heap_node*   node;
+
+    if (!my_heap) return usage;
+
+    usage = unordered_map_memory_usage(my_heap->state->node_map);
+    usage.live += (sizeof(heap_node) + sizeof(heap_node*)) *
+                  my_heap->state->size;
+    usage.allocated += sizeof(*my_heap) + sizeof(*my_heap->state) +
+                       sizeof(heap_node*) * my_heap->state->capacity +
+                       sizeof(size_t) * my_heap->state->degree +
+                       sizeof(heap_node) * my_heap->state->size;
+
+    /* The free nodes are linked through their element. */
+    for (node = my_heap->state->free_nodes; node; node = node->element)
+    {
+        usage.allocated += sizeof(*node);
+    }
+
+    return usage;
+}
+
 void heap_clear(heap* my_heap)
 {
     size_t i;
@@ -438,7 +553,7 @@ void heap_clear(heap* my_heap)
 
     for (i = 0; i < my_heap->state->size; ++i)
     {
-        free(my_heap->state->table[i]);
+        heap_node_free(my_heap, my_heap->state->table[i]);
     }
 
     my_heap->state->size = 0;
@@ -451,8 +566,15 @@ void heap_free(heap* my_heap)
         return;
     }
 
+    /* An arena heap goes away with its arena. */
+    if (my_heap->state->p_arena)
+    {
+        return;
+    }
+
     heap_clear(my_heap);
     unordered_map_free(my_heap->state->node_map);
     free(my_heap->state->indices);
     free(my_heap->state->table);
+    free(my_heap);
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef HEAP_H
 #define	HEAP_H
 
+#include "arena.h"
+#include "memory_usage.h"
 #include <stdbool.h>
 #include <stdlib.h>
 
@@ -22,6 +24,20 @@ extern "C" {
                      bool(*equals_function)(void*, void*),
                      int(*priority_compare_function)(void*, void*));
 
+    /***************************************************************************
+    * Allocates a new, empty heap with given degree whose table, node map and  *
+    * nodes are allocated from 'p_arena'. Extracted nodes are reused by later  *
+    * additions. Freeing the heap does nothing; the memory is released along   *
+    * with the arena.                                                          *
+    ***************************************************************************/
+    heap* heap_alloc_in_arena(arena* p_arena,
+                              size_t   degree,
+                              size_t   initial_capacity,
+                              float    load_factor,
+                              size_t(*hash_function)(void*),
+                              bool(*equals_function)(void*, void*),
+                              int(*priority_compare_function)(void*, void*));
+
     /***************************************************************************
     * Adds a new element and its priority to the heap only if it is not        *
     * already present.                                                         *
@@ -54,6 +70,12 @@ extern "C" {
     ***************************************************************************/
     int heap_size(heap* heap);
 
+    /***************************************************************************
+    * Returns the memory taken by the heap: its table, its nodes and the map   *
+    * from the elements to the nodes, but not the elements and priorities.     *
+    ***************************************************************************/
+    memory_usage heap_memory_usage(heap* heap);
+
     /***************************************************************************
     * Drops all the contents of the heap. Only internal structures are         *
     * deallocated; the user is responsible for memory-managing the contents.   *
@@ -0,0 +1,166 @@
+/* 'MAP_ANONYMOUS' is not POSIX, and strict C99 modes hide it. */
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include "large_array.h"
+#include <stdint.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+/*******************************************************************************
+* Returns 'size' rounded up to whole huge pages, or zero on overflow.          *
+*******************************************************************************/
+static size_t mapped_size(size_t size)
+{
+    if (size > SIZE_MAX - (LARGE_ARRAY_PAGE_SIZE - 1)) return 0;
+
+    return (size + LARGE_ARRAY_PAGE_SIZE - 1) & ~(LARGE_ARRAY_PAGE_SIZE - 1);
+}
+
+#ifdef __linux__
+
+/*******************************************************************************
+* Maps 'size' bytes in explicit huge pages of 'LARGE_ARRAY_PAGE_SIZE' bytes.   *
+* Fails right away unless the system has reserved enough of them.              *
+*******************************************************************************/
+static void* map_explicit_huge_pages(size_t size)
+{
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    void* p_address = mmap(NULL,
+                           size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                           (21 << MAP_HUGE_SHIFT),
+                           -1,
+                           0);
+
+    return p_address == MAP_FAILED ? NULL : p_address;
+#else
+    (void) size;
+    return NULL;
+#endif
+}
+
+/*******************************************************************************
+* Maps 'size' bytes in ordinary pages, starting at a huge page boundary so     *
+* that the kernel can back all of it with transparent huge pages. A huge page  *
+* more than needed is mapped and the ends beyond the boundaries are unmapped.  *
+*******************************************************************************/
+static void* map_transparent_huge_pages(size_t size)
+{
+    char*     p_address;
+    char*     p_aligned;
+    uintptr_t misalignment;
+
+    p_address = mmap(NULL,
+                     size + LARGE_ARRAY_PAGE_SIZE,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS,
+                     -1,
+                     0);
+
+    if (p_address == MAP_FAILED) return NULL;
+
+    misalignment = (uintptr_t) p_address & (LARGE_ARRAY_PAGE_SIZE - 1);
+    p_aligned = misalignment ? p_address + LARGE_ARRAY_PAGE_SIZE - misalignment
+                             : p_address;
+
+    if (p_aligned > p_address)
+    {
+        munmap(p_address, (size_t)(p_aligned - p_address));
+    }
+
+    munmap(p_aligned + size,
+           LARGE_ARRAY_PAGE_SIZE - (size_t)(p_aligned - p_address));
+
+#ifdef MADV_HUGEPAGE
+    /* Only advice; the kernel may not have transparent huge pages enabled. */
+    madvise(p_aligned, size, MADV_HUGEPAGE);
+#endif
+
+    return p_aligned;
+}
+
+#endif  /* __linux__ */
+
+/*******************************************************************************
+* Sets the NUMA policy of the 'size' bytes at 'p_array' before any of its      *
+* pages are touched.                                                           *
+*******************************************************************************/
+static void place(void* p_array, size_t size, large_array_placement placement)
+{
+#ifdef HAVE_LIBNUMA
+    if (placement == LARGE_ARRAY_INTERLEAVED &&
+        large_array_numa_node_count() > 1)
+    {
+        numa_interleave_memory(p_array, size, numa_all_nodes_ptr);
+    }
+#else
+    (void) p_array;
+    (void) size;
+    (void) placement;
+#endif
+}
+
+void* large_array_alloc(size_t size, large_array_placement placement)
+{
+    void*  p_array;
+    size_t mapped;
+
+    if (size < LARGE_ARRAY_PAGE_SIZE) return malloc(size ? size : 1);
+
+    if (!(mapped = mapped_size(size))) return NULL;
+
+#ifdef __linux__
+    if (!(p_array = map_explicit_huge_pages(mapped)) &&
+        !(p_array = map_transparent_huge_pages(mapped)))
+    {
+        return NULL;
+    }
+#else
+    if (!(p_array = malloc(size))) return NULL;
+#endif
+
+    place(p_array, mapped, placement);
+    return p_array;
+}
+
+void large_array_free(void* p_array, size_t size)
+{
+    if (!p_array) return;
+
+    if (size < LARGE_ARRAY_PAGE_SIZE)
+    {
+        free(p_array);
+        return;
+    }
+
+#ifdef __linux__
+    munmap(p_array, mapped_size(size));
+#else
+    free(p_array);
+#endif
+}
+
+size_t large_array_numa_node_count(void)
+{
+#ifdef HAVE_LIBNUMA
+    int node_count;
+
+    /* Without kernel support for NUMA policies the machine counts as one
+       node. */
+    if (numa_available() < 0) return 1;
+
+    node_count = numa_num_configured_nodes();
+    return node_count > 1 ? (size_t) node_count : 1;
+#else
+    return 1;
+#endif
+}
@@ -0,0 +1,58 @@
+#ifndef LARGE_ARRAY_H
+#define LARGE_ARRAY_H
+
+#include <stdlib.h>
+
+/*******************************************************************************
+* The size of a huge page. Arrays of at least this many bytes are mapped in    *
+* whole huge pages; smaller ones come from 'malloc'.                           *
+*******************************************************************************/
+#define LARGE_ARRAY_PAGE_SIZE ((size_t) 2 * 1024 * 1024)
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * Where the pages of a large array are put on a machine with several NUMA  *
+    * nodes.                                                                   *
+    ***************************************************************************/
+    typedef enum large_array_placement {
+        /* On the node of the thread touching the page first, which suits
+           arrays used by one thread only. */
+        LARGE_ARRAY_LOCAL,
+
+        /* Spread round-robin over all nodes, which suits arrays read by the
+           threads of all nodes alike, such as a frozen graph. */
+        LARGE_ARRAY_INTERLEAVED
+    } large_array_placement;
+
+    /***************************************************************************
+    * Allocates an array of 'size' bytes of uninitialized memory for the       *
+    * lifetime of a graph or a search. On Linux, arrays of at least            *
+    * 'LARGE_ARRAY_PAGE_SIZE' bytes are mapped in explicit huge pages if the   *
+    * system has reserved enough of them, and otherwise in ordinary pages      *
+    * aligned for transparent huge pages and advised to use them. With         *
+    * 'HAVE_LIBNUMA' defined the pages follow 'placement'; without it, or on   *
+    * a machine with one node, the placement is left to the system. Returns    *
+    * NULL if memory runs out.                                                 *
+    ***************************************************************************/
+    void* large_array_alloc(size_t size, large_array_placement placement);
+
+    /***************************************************************************
+    * Deallocates an array allocated by 'large_array_alloc' with the same      *
+    * 'size'.                                                                  *
+    ***************************************************************************/
+    void large_array_free(void* p_array, size_t size);
+
+    /***************************************************************************
+    * Returns the amount of NUMA nodes the pages can be spread over, which is  *
+    * 1 without 'HAVE_LIBNUMA'.                                                *
+    ***************************************************************************/
+    size_t large_array_numa_node_count(void);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* LARGE_ARRAY_H */
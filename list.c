@@ -5,26 +5,26 @@
 
 typedef struct list_state {
     void** storage;
-    int size; /* TODO: change to size_t? */
-    int capacity;
-    int head;
-    int mask;
+    size_t size;
+    size_t capacity;
+    size_t head;
+    size_t mask;
 } list_state;
 /*
 typedef struct list {
     list_state* state;
 } list;*/
 
-static const int MINIMUM_CAPACITY = 16;
-/*
+static const size_t MINIMUM_CAPACITY = 16;
+
 static size_t max(size_t a, size_t b)
 {
     return a < b ? b : a;
-}*/
+}
 
-static int fix_initial_capacity(int initial_capacity)
+static size_t fix_initial_capacity(size_t initial_capacity)
 {
-    int ret = 1;
+    size_t ret = 1;
 
     initial_capacity = max(initial_capacity, MINIMUM_CAPACITY);
 
@@ -61,6 +61,7 @@ list* list_alloc(size_t initial_capacity)
 
     if (!my_list->state->storage)
     {
+        free(my_list_state);
         free(my_list);
         return NULL;
     }
@@ -213,6 +214,18 @@ size_t list_size(list* my_list)
     return my_list ? my_list->state->size : 0;
 }
 
+memory_usage list_memory_usage(list* my_list)
+{
+    memory_usage usage = { 0, 0 };
+
+    if (!my_list) return usage;
+
+    usage.live = sizeof(void*) * my_list->state->size;
+    usage.allocated = sizeof(*my_list) + sizeof(*my_list->state) +
+                      sizeof(void*) * my_list->state->capacity;
+    return usage;
+}
+
 void* list_get(list* my_list, size_t index)
 {
     if (!my_list)
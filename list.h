@@ -1,6 +1,7 @@
 #ifndef LIST_H
 #define	LIST_H
 
+#include "memory_usage.h"
 #include <stdbool.h>
 #include <stdlib.h>
 
@@ -40,6 +41,12 @@ extern "C" {
     ***************************************************************************/
     size_t list_size(list* my_list);
 
+    /***************************************************************************
+    * Returns the memory taken by the list and its storage, but not by the     *
+    * elements.                                                                *
+    ***************************************************************************/
+    memory_usage list_memory_usage(list* my_list);
+
     /***************************************************************************
     * Returns the index'th element of the list. Returns NULL if the index is   *
     * out of range.                                                            *
@@ -74,7 +81,7 @@ extern "C" {
     * Returns true if the list contains the specified element using the        *
     * equality function. Returns false otherwise.                              *
     ***************************************************************************/
-    bool list_contains(list my_list,
+    bool list_contains(list* my_list,
         void* element,
         bool(*equals_function)(void*, void*));
 
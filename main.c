@@ -1,7 +1,23 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
+#include "benchmark.h"
 #include "dijkstra.h"
+#include "compact_dijkstra.h"
+#include "artifact_file.h"
+#include "compact_graph_file.h"
+#include "dimacs.h"
+#include "edge_list.h"
+#include "large_array.h"
+#include "list.h"
+#include "name_index.h"
+#include "node_order.h"
+#include "reverse_index.h"
+#include "typed_containers.h"
 #include "directed_graph_node.h"
 #include "weight_function.h"
 #include "utils.h"
@@ -97,25 +113,457 @@ static void test_directed_graph_node_correctness()
     ASSERT(directed_graph_node_has_child(p_node_b, p_node_d));
 }
 
+static void test_directed_graph_node_high_degree_correctness()
+{
+    directed_graph_node* p_hub;
+    directed_graph_node* p_leaves[40];
+    char                 names[40][8];
+    size_t               i;
+
+    p_hub = directed_graph_node_alloc("Hub");
+
+    for (i = 0; i < 40; ++i)
+    {
+        sprintf(names[i], "%d", (int) i);
+        p_leaves[i] = directed_graph_node_alloc(names[i]);
+        ASSERT(directed_graph_node_add_arc(p_hub, p_leaves[i]));
+        ASSERT(directed_graph_node_add_arc(p_hub, p_leaves[i]) == false);
+    }
+
+    ASSERT(directed_graph_node_child_count(p_hub) == 40);
+    ASSERT(directed_graph_node_parent_count(p_leaves[7]) == 1);
+    ASSERT(directed_graph_node_parents(p_leaves[7])[0] == p_hub);
+
+    for (i = 0; i < 40; i += 2)
+    {
+        directed_graph_node_remove_arc(p_hub, p_leaves[i]);
+    }
+
+    ASSERT(directed_graph_node_child_count(p_hub) == 20);
+
+    for (i = 0; i < 40; ++i)
+    {
+        ASSERT(directed_graph_node_has_child(p_hub, p_leaves[i]) == (i & 1));
+    }
+
+    directed_graph_node_clear(p_hub);
+    ASSERT(directed_graph_node_child_count(p_hub) == 0);
+    ASSERT(directed_graph_node_parent_count(p_leaves[7]) == 0);
+
+    for (i = 0; i < 40; ++i)
+    {
+        directed_graph_node_free(p_leaves[i]);
+    }
+
+    directed_graph_node_free(p_hub);
+}
+
+static void test_hash_container_bulk_correctness()
+{
+    directed_graph_node* p_nodes[100];
+    void*                keys[100];
+    void*                values[100];
+    char                 names[100][8];
+    unordered_map*       p_map;
+    unordered_set*       p_set;
+    size_t               i;
+
+    for (i = 0; i < 100; ++i)
+    {
+        sprintf(names[i], "%d", (int) i);
+        p_nodes[i] = directed_graph_node_alloc(names[i]);
+        keys[i] = p_nodes[i];
+    }
+
+    for (i = 0; i < 100; ++i)
+    {
+        values[i] = p_nodes[99 - i];
+    }
+
+    p_map = unordered_map_alloc(16, 1.0f, hash_function, equals_function);
+    p_set = unordered_set_alloc(16, 1.0f, hash_function, equals_function);
+
+    ASSERT(unordered_map_reserve(p_map, 100));
+    ASSERT(unordered_map_put_all(p_map, keys, values, 60) == 60);
+    ASSERT(unordered_map_size(p_map) == 60);
+
+    /* The first 60 keys are overwritten with themselves, 40 are new. */
+    ASSERT(unordered_map_put_all(p_map, keys, keys, 100) == 40);
+    ASSERT(unordered_map_size(p_map) == 100);
+
+    for (i = 0; i < 100; ++i)
+    {
+        ASSERT(unordered_map_get(p_map, p_nodes[i]) == p_nodes[i]);
+    }
+
+    /* A capacity past the address space is refused, not wrapped to 0. */
+    ASSERT(!unordered_map_reserve(p_map, SIZE_MAX));
+    ASSERT(!unordered_map_reserve(NULL, 1));
+    ASSERT(unordered_map_size(p_map) == 100);
+    ASSERT(unordered_map_get(p_map, p_nodes[42]) == p_nodes[42]);
+
+    ASSERT(unordered_set_reserve(p_set, 50));
+    ASSERT(unordered_set_add_all(p_set, keys, 50) == 50);
+
+    /* Elements already in the set and repeated ones count once. */
+    ASSERT(unordered_set_add_all(p_set, values, 100) == 50);
+    ASSERT(unordered_set_add_all(p_set, keys, 0) == 0);
+    ASSERT(unordered_set_size(p_set) == 100);
+    ASSERT(!unordered_set_reserve(p_set, SIZE_MAX));
+    ASSERT(unordered_set_size(p_set) == 100);
+
+    for (i = 0; i < 100; ++i)
+    {
+        ASSERT(unordered_set_contains(p_set, p_nodes[i]));
+    }
+
+    unordered_map_free(p_map);
+    unordered_set_free(p_set);
+
+    for (i = 0; i < 100; ++i)
+    {
+        directed_graph_node_free(p_nodes[i]);
+    }
+}
+
+static void test_batched_lookup_correctness()
+{
+    directed_graph_node* p_nodes[40];
+    void*                keys[37];
+    void*                values[37];
+    bool                 results[37];
+    char                 names[40][8];
+    unordered_map*       p_map;
+    unordered_set*       p_set;
+    size_t               found;
+    size_t               i;
+
+    for (i = 0; i < 40; ++i)
+    {
+        sprintf(names[i], "%d", (int) i);
+        p_nodes[i] = directed_graph_node_alloc(names[i]);
+    }
+
+    p_map = unordered_map_alloc(16, 1.0f, hash_function, equals_function);
+    p_set = unordered_set_alloc(16, 1.0f, hash_function, equals_function);
+
+    /* Only the even nodes are stored. */
+    for (i = 0; i < 40; i += 2)
+    {
+        unordered_map_put(p_map, p_nodes[i], p_nodes[i + 1]);
+        unordered_set_add(p_set, p_nodes[i]);
+    }
+
+    /* 37 keys span two full batches and a partial one; every third key
+       repeats an earlier one. */
+    for (i = 0; i < 37; ++i)
+    {
+        keys[i] = i % 3 == 2 ? keys[i / 2] : p_nodes[i];
+        values[i] = p_nodes[0];
+    }
+
+    unordered_map_get_many(p_map, keys, values, 37);
+    found = unordered_set_contains_many(p_set, keys, results, 37);
+
+    for (i = 0; i < 37; ++i)
+    {
+        ASSERT(values[i] == unordered_map_get(p_map, keys[i]));
+        ASSERT(results[i] == unordered_set_contains(p_set, keys[i]));
+        ASSERT((values[i] != NULL) == results[i]);
+        found -= results[i];
+    }
+
+    ASSERT(found == 0);
+
+    ASSERT(values[1] == NULL && !results[1]);
+    ASSERT(values[4] == p_nodes[5] && results[4]);
+
+    /* Exactly one batch, and an empty one that touches nothing. */
+    values[16] = p_nodes[0];
+    unordered_map_get_many(p_map, keys, values, 16);
+    ASSERT(values[16] == p_nodes[0]);
+    ASSERT(unordered_set_contains_many(p_set, keys, results, 0) == 0);
+
+    unordered_map_clear(p_map);
+    unordered_map_get_many(p_map, keys, values, 37);
+
+    for (i = 0; i < 37; ++i)
+    {
+        ASSERT(values[i] == NULL);
+    }
+
+    unordered_map_free(p_map);
+    unordered_set_free(p_set);
+
+    for (i = 0; i < 40; ++i)
+    {
+        directed_graph_node_free(p_nodes[i]);
+    }
+}
+
+static bool pointer_equals(void* p_a, void* p_b)
+{
+    return p_a == p_b;
+}
+
+static void test_list_correctness()
+{
+    list*  p_list;
+    char   elements[40];
+    size_t i;
+
+    ASSERT((p_list = list_alloc(0)));
+
+    /* Pushing to the front wraps the head around the ring buffer, and the
+       growth beyond the minimum capacity unwraps it. */
+    for (i = 0; i < 20; ++i)
+    {
+        ASSERT(list_push_front(p_list, &elements[19 - i]));
+        ASSERT(list_push_back(p_list, &elements[20 + i]));
+    }
+
+    ASSERT(list_size(p_list) == 40);
+
+    for (i = 0; i < 40; ++i)
+    {
+        ASSERT(list_get(p_list, i) == &elements[i]);
+    }
+
+    ASSERT(list_get(p_list, 40) == NULL);
+    ASSERT(list_remove_at(p_list, 1) == &elements[1]);
+    ASSERT(list_remove_at(p_list, 37) == &elements[38]);
+    ASSERT(list_insert(p_list, 1, &elements[1]));
+    ASSERT(list_insert(p_list, 38, &elements[38]));
+    ASSERT(!list_insert(p_list, 41, &elements[0]));
+
+    for (i = 0; i < 40; ++i)
+    {
+        ASSERT(list_get(p_list, i) == &elements[i]);
+    }
+
+    ASSERT(list_contains(p_list, &elements[39], pointer_equals));
+    ASSERT(list_pop_front(p_list) == &elements[0]);
+    ASSERT(list_pop_back(p_list) == &elements[39]);
+    ASSERT(!list_contains(p_list, &elements[39], pointer_equals));
+    ASSERT(list_size(p_list) == 38);
+
+    list_clear(p_list);
+    ASSERT(list_pop_front(p_list) == NULL);
+    list_free(p_list);
+}
+
+/*******************************************************************************
+* Puts all keys into a few clusters to exercise probing and removal.           *
+*******************************************************************************/
+#define CLUSTERED_HASH(KEY) ((size_t)(KEY) % 4)
+
+TYPED_MAP_DEFINE(test_clustered_map,
+                 uint32_t,
+                 double,
+                 CLUSTERED_HASH,
+                 TYPED_EQUALS)
+
+static void test_typed_containers_correctness()
+{
+    u32_u32_map*        p_map;
+    u32_double_map*     p_double_map;
+    test_clustered_map* p_clustered_map;
+    u32_set*            p_u32_set;
+    u64_set*            p_set;
+    u32_list*           p_list;
+    u32_double_heap*    p_heap;
+    uint32_t            value;
+    double              priority;
+    double              previous;
+    size_t              i;
+
+    /* Maps, across several resizes and with removals in between. */
+    ASSERT((p_map = u32_u32_map_alloc(0)));
+    ASSERT((p_clustered_map = test_clustered_map_alloc(4)));
+
+    for (i = 0; i < 1000; ++i)
+    {
+        ASSERT(u32_u32_map_put(p_map, (uint32_t) i, (uint32_t)(2 * i)));
+        ASSERT(test_clustered_map_put(p_clustered_map,
+                                      (uint32_t) i,
+                                      (double) i / 2));
+    }
+
+    ASSERT(u32_u32_map_size(p_map) == 1000);
+    ASSERT(u32_u32_map_put(p_map, 7, 70));
+    ASSERT(u32_u32_map_size(p_map) == 1000);
+
+    value = 12345;
+    ASSERT(!u32_u32_map_get(p_map, 1000, &value) && value == 12345);
+    ASSERT(u32_u32_map_get(p_map, 7, &value) && value == 70);
+    ASSERT(u32_u32_map_get(p_map, 0, &value) && value == 0);
+
+    for (i = 0; i < 1000; i += 3)
+    {
+        ASSERT(u32_u32_map_remove(p_map, (uint32_t) i));
+        ASSERT(test_clustered_map_remove(p_clustered_map, (uint32_t) i));
+    }
+
+    ASSERT(!u32_u32_map_remove(p_map, 0));
+    ASSERT(u32_u32_map_size(p_map) == 666);
+    ASSERT(test_clustered_map_size(p_clustered_map) == 666);
+
+    /* The keys probed past the removed ones must still be found. */
+    priority = 0.0;
+
+    for (i = 0; i < 1000; ++i)
+    {
+        ASSERT(u32_u32_map_contains_key(p_map, (uint32_t) i) == (i % 3 != 0));
+        ASSERT(test_clustered_map_get(p_clustered_map,
+                                      (uint32_t) i,
+                                      &priority) == (i % 3 != 0));
+
+        if (i % 3 != 0)
+        {
+            ASSERT(priority == (double) i / 2);
+        }
+    }
+
+    ASSERT(u32_u32_map_reserve(p_map, 5000));
+    ASSERT(!u32_u32_map_reserve(p_map, SIZE_MAX));
+    ASSERT(u32_u32_map_get(p_map, 1, &value) && value == 2);
+    u32_u32_map_clear(p_map);
+    ASSERT(u32_u32_map_size(p_map) == 0);
+    ASSERT(!u32_u32_map_contains_key(p_map, 1));
+    u32_u32_map_free(p_map);
+    test_clustered_map_free(p_clustered_map);
+
+    /* The tentative distances and the settled ids of a search. */
+    ASSERT((p_double_map = u32_double_map_alloc(0)));
+    ASSERT((p_u32_set = u32_set_alloc(0)));
+
+    for (i = 0; i < 300; ++i)
+    {
+        ASSERT(u32_double_map_put(p_double_map, (uint32_t) i, 0.5 * i));
+
+        if (i % 2 == 0)
+        {
+            ASSERT(u32_set_add(p_u32_set, (uint32_t) i));
+        }
+    }
+
+    ASSERT(u32_double_map_put(p_double_map, 10, -1.0));
+    ASSERT(u32_double_map_get(p_double_map, 10, &priority));
+    ASSERT(priority == -1.0);
+    ASSERT(u32_double_map_get(p_double_map, 299, &priority));
+    ASSERT(priority == 149.5);
+    ASSERT(!u32_double_map_get(p_double_map, 300, &priority));
+    ASSERT(u32_double_map_size(p_double_map) == 300);
+    ASSERT(u32_set_size(p_u32_set) == 150);
+    ASSERT(u32_set_contains(p_u32_set, 298));
+    ASSERT(!u32_set_contains(p_u32_set, 299));
+    ASSERT(!u32_set_add(p_u32_set, 0));
+    ASSERT(u32_set_remove(p_u32_set, 0));
+    ASSERT(!u32_set_contains(p_u32_set, 0));
+    u32_double_map_free(p_double_map);
+    u32_set_free(p_u32_set);
+
+    /* Sets of 64-bit keys beyond the 32-bit range. */
+    ASSERT((p_set = u64_set_alloc(16)));
+
+    for (i = 0; i < 500; ++i)
+    {
+        ASSERT(u64_set_add(p_set, ((uint64_t) i << 32) | i));
+    }
+
+    ASSERT(!u64_set_add(p_set, (uint64_t) 3 << 32 | 3));
+    ASSERT(!u64_set_contains(p_set, 3));
+    ASSERT(u64_set_remove(p_set, (uint64_t) 3 << 32 | 3));
+    ASSERT(!u64_set_remove(p_set, (uint64_t) 3 << 32 | 3));
+    ASSERT(u64_set_size(p_set) == 499);
+
+    for (i = 0; i < 500; ++i)
+    {
+        ASSERT(u64_set_contains(p_set, ((uint64_t) i << 32) | i) ==
+               (i != 3));
+    }
+
+    u64_set_clear(p_set);
+    ASSERT(u64_set_size(p_set) == 0);
+    ASSERT(u64_set_add(p_set, 3));
+    ASSERT(!u64_set_reserve(p_set, SIZE_MAX));
+    ASSERT(u64_set_contains(p_set, 3));
+    u64_set_free(p_set);
+
+    /* Lists. */
+    ASSERT((p_list = u32_list_alloc(1)));
+
+    for (i = 0; i < 100; ++i)
+    {
+        ASSERT(u32_list_push_back(p_list, (uint32_t) i));
+    }
+
+    u32_list_set(p_list, 50, 500);
+    ASSERT(u32_list_get(p_list, 50) == 500);
+    ASSERT(u32_list_pop_back(p_list) == 99);
+    ASSERT(u32_list_size(p_list) == 99);
+    ASSERT(u32_list_reserve(p_list, 1000));
+    ASSERT(p_list->capacity >= 1000);
+    ASSERT(!u32_list_reserve(p_list, SIZE_MAX));
+    ASSERT(u32_list_get(p_list, 98) == 98);
+    u32_list_clear(p_list);
+    ASSERT(u32_list_size(p_list) == 0);
+    u32_list_free(p_list);
+
+    /* Heaps come out sorted, with decreased keys moved up. */
+    ASSERT((p_heap = u32_double_heap_alloc(100)));
+
+    for (i = 0; i < 100; ++i)
+    {
+        ASSERT(u32_double_heap_add(p_heap,
+                                   (uint32_t) i,
+                                   (double)((i * 37) % 100)));
+    }
+
+    ASSERT(!u32_double_heap_add(p_heap, 5, 1.0));
+    ASSERT(!u32_double_heap_add(p_heap, 100, 1.0));
+    ASSERT(u32_double_heap_decrease_key(p_heap, 42, -1.0));
+    ASSERT(!u32_double_heap_decrease_key(p_heap, 42, 0.0));
+    ASSERT(u32_double_heap_min(p_heap) == 42);
+    ASSERT(u32_double_heap_extract_min(p_heap, &priority) == 42);
+    ASSERT(priority == -1.0 && !u32_double_heap_contains(p_heap, 42));
+
+    previous = -1.0;
+
+    while (u32_double_heap_size(p_heap) > 50)
+    {
+        u32_double_heap_extract_min(p_heap, &priority);
+        ASSERT(priority >= previous);
+        previous = priority;
+    }
+
+    u32_double_heap_clear(p_heap);
+    ASSERT(u32_double_heap_size(p_heap) == 0);
+
+    for (i = 0; i < 100; ++i)
+    {
+        ASSERT(!u32_double_heap_contains(p_heap, (uint32_t) i));
+    }
+
+    ASSERT(u32_double_heap_add(p_heap, 42, 0.0));
+    u32_double_heap_free(p_heap);
+}
+
 static void test_weight_function_correctness()
 {
     directed_graph_weight_function* p_weight_function;
 
     directed_graph_node* p_node_a;
-    directed_graph_node* p_node_b;
     directed_graph_node* p_node_c;
-    directed_graph_node* p_node_d;
 
     double weight;
 
     p_node_a = directed_graph_node_alloc("Node A");
-    p_node_b = directed_graph_node_alloc("Node B");
     p_node_c = directed_graph_node_alloc("Node C");
-    p_node_d = directed_graph_node_alloc("Node D");
 
-    ASSERT(p_weight_function =
+    ASSERT((p_weight_function =
         directed_graph_weight_function_alloc(hash_function,
-            equals_function));
+            equals_function)));
 
     ASSERT(directed_graph_weight_function_get(p_weight_function,
         p_node_a,
@@ -158,217 +606,2585 @@ static void test_weight_function_correctness()
         p_node_c) == NULL);
 
     directed_graph_weight_function_free(p_weight_function);
+    directed_graph_node_free(p_node_a);
+    directed_graph_node_free(p_node_c);
 }
 
-static void test_dijkstra_correctness()
+static void test_concurrent_weight_function_correctness()
 {
-    directed_graph_node* p_node_a;
-    directed_graph_node* p_node_b;
-    directed_graph_node* p_node_c;
-    directed_graph_node* p_node_d;
-    directed_graph_node* p_node_e;
-    directed_graph_node* p_node_s;
-    directed_graph_node* p_node_t;
-
     directed_graph_weight_function* p_weight_function;
-    list* p_path;
+    directed_graph_node*            p_node_a;
+    directed_graph_node*            p_node_b;
+    double*                         p_old_weight;
 
-    p_node_a = directed_graph_node_alloc("A");
-    p_node_b = directed_graph_node_alloc("B");
-    p_node_c = directed_graph_node_alloc("C");
-    p_node_d = directed_graph_node_alloc("D");
-    p_node_e = directed_graph_node_alloc("E");
-    p_node_s = directed_graph_node_alloc("Source");
-    p_node_t = directed_graph_node_alloc("Target");
+    p_node_a = directed_graph_node_alloc("Node A");
+    p_node_b = directed_graph_node_alloc("Node B");
 
-    p_weight_function = directed_graph_weight_function_alloc(hash_function,
-        equals_function);
+    ASSERT((p_weight_function =
+        directed_graph_weight_function_alloc_concurrent(hash_function,
+            equals_function)));
 
-    directed_graph_node_add_arc(p_node_s, p_node_a);
-    directed_graph_weight_function_put(p_weight_function,
-        p_node_s,
+    ASSERT(directed_graph_weight_function_get(p_weight_function,
         p_node_a,
-        1.0);
+        p_node_b) == NULL);
 
-    directed_graph_node_add_arc(p_node_a, p_node_b);
-    directed_graph_weight_function_put(p_weight_function,
+    ASSERT(directed_graph_weight_function_put(p_weight_function,
         p_node_a,
         p_node_b,
-        2.0);
+        3.0));
 
-    directed_graph_node_add_arc(p_node_b, p_node_c);
-    directed_graph_weight_function_put(p_weight_function,
-        p_node_b,
-        p_node_c,
-        3.0);
+    p_old_weight = directed_graph_weight_function_get(p_weight_function,
+        p_node_a,
+        p_node_b);
 
-    directed_graph_node_add_arc(p_node_c, p_node_t);
-    directed_graph_weight_function_put(p_weight_function,
-        p_node_c,
-        p_node_t,
-        16.0);
+    ASSERT(*p_old_weight == 3.0);
 
-    directed_graph_node_add_arc(p_node_s, p_node_d);
-    directed_graph_weight_function_put(p_weight_function,
-        p_node_s,
-        p_node_d,
-        11.0);
+    ASSERT(directed_graph_weight_function_put(p_weight_function,
+        p_node_a,
+        p_node_b,
+        5.0));
 
-    directed_graph_node_add_arc(p_node_d, p_node_e);
-    directed_graph_weight_function_put(p_weight_function,
-        p_node_d,
-        p_node_e,
-        5.0);
+    /* The replaced weight stays readable until reclaimed. */
+    ASSERT(*p_old_weight == 3.0);
+    ASSERT(*directed_graph_weight_function_get(p_weight_function,
+        p_node_a,
+        p_node_b) == 5.0);
 
-    directed_graph_node_add_arc(p_node_e, p_node_t);
-    directed_graph_weight_function_put(p_weight_function,
-        p_node_e,
-        p_node_t,
-        6.0);
+    directed_graph_weight_function_reclaim(p_weight_function);
+    directed_graph_weight_function_free(p_weight_function);
+    directed_graph_node_free(p_node_a);
+    directed_graph_node_free(p_node_b);
+}
 
-    directed_graph_node_add_arc(p_node_c, p_node_d);
-    directed_graph_weight_function_put(p_weight_function,
-        p_node_c,
-        p_node_d,
-        4.0);
+#define CONCURRENT_TEST_HEADS   64
+#define CONCURRENT_TEST_ROUNDS  200
+#define CONCURRENT_TEST_READERS 4
+
+/*******************************************************************************
+* The state shared by the threads of the concurrent weight function test. The  *
+* writer rewrites the weights of the arcs from 'p_tail' and adds the arcs from *
+* 'p_growing_tail' one by one, which makes the inner map resize under the      *
+* readers.                                                                     *
+*******************************************************************************/
+typedef struct concurrent_test_context {
+    directed_graph_weight_function* p_weight_function;
+    directed_graph_node*            p_tail;
+    directed_graph_node*            p_growing_tail;
+    directed_graph_node*            p_heads[CONCURRENT_TEST_HEADS];
+    atomic_bool                     done;
+    bool                            write_failed;
+} concurrent_test_context;
+
+typedef struct concurrent_test_reader {
+    concurrent_test_context* p_context;
+    size_t                   reads;
+    bool                     failed;
+} concurrent_test_reader;
+
+static void* concurrent_test_write(void* p_arg)
+{
+    concurrent_test_context* p_context = p_arg;
+    size_t                   round;
+    size_t                   i;
 
-    p_path = dijkstra(p_node_s, p_node_t, p_weight_function);
+    for (round = 1; round <= CONCURRENT_TEST_ROUNDS; ++round)
+    {
+        for (i = 0; i < CONCURRENT_TEST_HEADS; ++i)
+        {
+            if (!directed_graph_weight_function_put(
+                     p_context->p_weight_function,
+                     p_context->p_tail,
+                     p_context->p_heads[i],
+                     (double) round))
+            {
+                p_context->write_failed = true;
+            }
+        }
+
+        if (round <= CONCURRENT_TEST_HEADS &&
+            !directed_graph_weight_function_put(
+                p_context->p_weight_function,
+                p_context->p_growing_tail,
+                p_context->p_heads[round - 1],
+                (double) round))
+        {
+            p_context->write_failed = true;
+        }
+    }
 
-    ASSERT(list_size(p_path) == 7);
-    ASSERT(list_get(p_path, 0) == p_node_s);
-    ASSERT(list_get(p_path, 1) == p_node_a);
-    ASSERT(list_get(p_path, 2) == p_node_b);
-    ASSERT(list_get(p_path, 3) == p_node_c);
-    ASSERT(list_get(p_path, 4) == p_node_d);
-    ASSERT(list_get(p_path, 5) == p_node_e);
-    ASSERT(list_get(p_path, 6) == p_node_t);
+    atomic_store(&p_context->done, true);
+    return NULL;
 }
 
-static const size_t NODES = 20000;
-static const size_t EDGES = 20000 * 9;
-static const double MAXX = 10000.0;
-static const double MAXY = 10000.0;
-static const double MAXZ = 200.0;
-static const double MAX_DISTANCE = 800.0;
+static void* concurrent_test_read(void* p_arg)
+{
+    concurrent_test_reader*  p_reader = p_arg;
+    concurrent_test_context* p_context = p_reader->p_context;
+    double*                  p_weight;
+    size_t                   i;
+
+    /* A reader sees some complete weight of every round, never a torn or
+       missing one, and the arcs added once never change. */
+    do
+    {
+        for (i = 0; i < CONCURRENT_TEST_HEADS; ++i)
+        {
+            p_weight = directed_graph_weight_function_get(
+                           p_context->p_weight_function,
+                           p_context->p_tail,
+                           p_context->p_heads[i]);
+
+            if (!p_weight || *p_weight < 0.0 ||
+                *p_weight > CONCURRENT_TEST_ROUNDS ||
+                *p_weight != (double)(size_t) *p_weight)
+            {
+                p_reader->failed = true;
+            }
+
+            p_weight = directed_graph_weight_function_get(
+                           p_context->p_weight_function,
+                           p_context->p_growing_tail,
+                           p_context->p_heads[i]);
+
+            if (p_weight && *p_weight != (double)(i + 1))
+            {
+                p_reader->failed = true;
+            }
+
+            ++p_reader->reads;
+        }
+    }
+    while (!atomic_load(&p_context->done));
 
-int main(int argc, char** argv) {
-    graph_data* p_data;
-    clock_t       c;
-    int           seed = time(NULL);
-    double        duration;
-    list*       p_path;
-    size_t        i;
+    return NULL;
+}
+
+static void test_concurrent_weight_function_threads_correctness()
+{
+    concurrent_test_context context;
+    concurrent_test_reader  readers[CONCURRENT_TEST_READERS];
+    pthread_t               reader_threads[CONCURRENT_TEST_READERS];
+    pthread_t               writer_thread;
+    char                    names[CONCURRENT_TEST_HEADS][8];
+    size_t                  i;
+
+    ASSERT((context.p_weight_function =
+               directed_graph_weight_function_alloc_concurrent(
+                   hash_function,
+                   equals_function)));
+
+    context.p_tail = directed_graph_node_alloc("Tail");
+    context.p_growing_tail = directed_graph_node_alloc("Growing tail");
+    context.write_failed = false;
+    atomic_init(&context.done, false);
+
+    for (i = 0; i < CONCURRENT_TEST_HEADS; ++i)
+    {
+        sprintf(names[i], "%d", (int) i);
+        context.p_heads[i] = directed_graph_node_alloc(names[i]);
+        ASSERT(directed_graph_weight_function_put(context.p_weight_function,
+                                                  context.p_tail,
+                                                  context.p_heads[i],
+                                                  0.0));
+    }
 
-    directed_graph_node* p_source;
-    directed_graph_node* p_target;
+    for (i = 0; i < CONCURRENT_TEST_READERS; ++i)
+    {
+        readers[i].p_context = &context;
+        readers[i].reads = 0;
+        readers[i].failed = false;
+        ASSERT(pthread_create(&reader_threads[i],
+                              NULL,
+                              concurrent_test_read,
+                              &readers[i]) == 0);
+    }
 
-    printf("Seed: %d\n", seed);
-    srand(seed);
+    ASSERT(pthread_create(&writer_thread,
+                          NULL,
+                          concurrent_test_write,
+                          &context) == 0);
+    pthread_join(writer_thread, NULL);
 
-    test_directed_graph_node_correctness();
-    test_weight_function_correctness();
-    test_dijkstra_correctness();
-    //test_bidirectional_dijkstra_correctness();
+    for (i = 0; i < CONCURRENT_TEST_READERS; ++i)
+    {
+        pthread_join(reader_threads[i], NULL);
+        ASSERT(!readers[i].failed);
+        ASSERT(readers[i].reads > 0);
+    }
 
-    c = clock();
-    p_data = create_random_graph(NODES, EDGES, MAXX, MAXY, MAXZ, MAX_DISTANCE);
+    ASSERT(!context.write_failed);
 
-    duration = ((double)clock() - c);
-    printf("Built the graph in %f seconds.\n", duration / CLOCKS_PER_SEC);
+    for (i = 0; i < CONCURRENT_TEST_HEADS; ++i)
+    {
+        ASSERT(*directed_graph_weight_function_get(context.p_weight_function,
+                                                   context.p_tail,
+                                                   context.p_heads[i]) ==
+               CONCURRENT_TEST_ROUNDS);
+        ASSERT(*directed_graph_weight_function_get(context.p_weight_function,
+                                                   context.p_growing_tail,
+                                                   context.p_heads[i]) ==
+               (double)(i + 1));
+    }
 
-    p_source = choose(p_data->p_node_array, NODES);
-    p_target = choose(p_data->p_node_array, NODES);
+    /* No thread reads any more, so the replaced weights can go. */
+    directed_graph_weight_function_reclaim(context.p_weight_function);
+    directed_graph_weight_function_free(context.p_weight_function);
 
-    printf("Source: %s\n", directed_graph_node_to_string(p_source));
-    printf("Target: %s\n", directed_graph_node_to_string(p_target));
+    for (i = 0; i < CONCURRENT_TEST_HEADS; ++i)
+    {
+        directed_graph_node_free(context.p_heads[i]);
+    }
 
-    /**** DIJKSTRA'S ALGORITHM ****/
-    c = clock();
+    directed_graph_node_free(context.p_tail);
+    directed_graph_node_free(context.p_growing_tail);
+}
 
-    p_path = dijkstra(p_source, p_target, p_data->p_weight_function);
+static void test_flat_weight_function_correctness()
+{
+    directed_graph_weight_function* p_weight_function;
+    directed_graph_node*            p_tail;
+    directed_graph_node*            p_heads[30];
+    directed_graph_node*            p_alias;
+    char                            names[30][8];
+    size_t                          i;
 
-    duration = ((double)clock() - c);
+    p_tail = directed_graph_node_alloc("Tail");
 
-    printf("Dijkstra's algorithm in %f seconds.\n", duration / CLOCKS_PER_SEC);
-    printf("Path:\n");
+    ASSERT((p_weight_function =
+        directed_graph_weight_function_alloc_flat(hash_function,
+            equals_function)));
 
-    for (i = 0; i < list_size(p_path); ++i)
+    for (i = 0; i < 30; ++i)
     {
-        puts(directed_graph_node_to_string(list_get(p_path, i)));
+        sprintf(names[i], "%d", (int) i);
+        p_heads[i] = directed_graph_node_alloc(names[i]);
     }
 
-    printf("Path is a valid path: %d\n", is_valid_path(p_path));
-    printf("Path cost: %f\n",
-        compute_path_cost(p_path, p_data->p_weight_function));
+    /* Insert in an order unrelated to the node addresses. */
+    for (i = 0; i < 30; ++i)
+    {
+        ASSERT(directed_graph_weight_function_put(p_weight_function,
+            p_tail,
+            p_heads[(i * 7) % 30],
+            (double)((i * 7) % 30)));
+    }
 
-    /**** ASTAR ALGORITHM ****/
-    /*c = clock();
+    for (i = 0; i < 30; ++i)
+    {
+        ASSERT(*directed_graph_weight_function_get(p_weight_function,
+            p_tail,
+            p_heads[i]) == (double) i);
+    }
 
-    p_path = astar(p_source,
-        p_target,
-        p_data->p_weight_function,
-        p_data->p_point_map);
+    ASSERT(directed_graph_weight_function_put(p_weight_function,
+        p_tail,
+        p_heads[3],
+        100.0));
+    ASSERT(*directed_graph_weight_function_get(p_weight_function,
+        p_tail,
+        p_heads[3]) == 100.0);
 
-    duration = ((double)clock() - c);
+    /* A distinct but equal node object finds the same arc. */
+    p_alias = directed_graph_node_alloc("3");
+    ASSERT(*directed_graph_weight_function_get(p_weight_function,
+        p_tail,
+        p_alias) == 100.0);
+    ASSERT(directed_graph_weight_function_get(p_weight_function,
+        p_heads[0],
+        p_tail) == NULL);
 
-    printf("A* algorithm in %f seconds.\n", duration / CLOCKS_PER_SEC);
-    printf("Path:\n");
+    directed_graph_weight_function_free(p_weight_function);
+    directed_graph_node_free(p_alias);
 
-    for (i = 0; i < list_t_size(p_path); ++i)
+    for (i = 0; i < 30; ++i)
     {
-        puts(directed_graph_node_t_to_string(list_t_get(p_path, i)));
+        directed_graph_node_free(p_heads[i]);
     }
 
-    printf("Path is a valid path: %d\n", is_valid_path(p_path));
-    printf("Path cost: %f\n",
-        compute_path_cost(p_path, p_data->p_weight_function));*/
+    directed_graph_node_free(p_tail);
+}
 
-    /**** BIDIRECTIONAL DIJKSTRA'S ALGORITHM ****//*
-    c = clock();
+static double test_arc_length(void* p_tail_point,
+                              void* p_head_point,
+                              void* p_arg)
+{
+    return *(double*) p_arg * point_3d_distance(p_tail_point, p_head_point);
+}
 
-    p_path = bidirectional_dijkstra(p_source,
-        p_target,
-        p_data->p_weight_function);
+#define DECODED_TEST_HEADS   32
+#define DECODED_TEST_THREADS 4
 
-    duration = ((double)clock() - c);
+/*******************************************************************************
+* A thread reading its own share of the arcs of a weight function whose        *
+* weights are not stored as doubles. The weight of the arc to head 'i' is 'i'. *
+*******************************************************************************/
+typedef struct decoded_test_reader {
+    directed_graph_weight_function* p_weight_function;
+    directed_graph_node*            p_tail;
+    directed_graph_node**           p_heads;
+    size_t                          first;
+    bool                            failed;
+} decoded_test_reader;
 
-    printf("Bidirectional Dijkstra's algorithm in %f seconds.\n",
-        duration / CLOCKS_PER_SEC);
+static void* decoded_test_read(void* p_arg)
+{
+    decoded_test_reader* p_reader = p_arg;
+    double*              p_weight;
+    double               weight;
+    size_t               round;
+    size_t               i;
 
-    printf("Path:\n");
+    for (round = 0; round < 2000; ++round)
+    {
+        for (i = p_reader->first;
+             i < DECODED_TEST_HEADS;
+             i += DECODED_TEST_THREADS)
+        {
+            p_weight = directed_graph_weight_function_get(
+                           p_reader->p_weight_function,
+                           p_reader->p_tail,
+                           p_reader->p_heads[i]);
+
+            if (!p_weight || *p_weight != (double) i)
+            {
+                p_reader->failed = true;
+            }
+
+            if (!directed_graph_weight_function_get_value(
+                     p_reader->p_weight_function,
+                     p_reader->p_tail,
+                     p_reader->p_heads[i],
+                     &weight) ||
+                weight != (double) i)
+            {
+                p_reader->failed = true;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+* Reads the weights of the arcs from 'p_tail' to 'p_heads' in several threads  *
+* at once. Returns false if any thread saw a weight of another thread.         *
+*******************************************************************************/
+static bool read_decoded_weights_in_threads(
+    directed_graph_weight_function* p_weight_function,
+    directed_graph_node* p_tail,
+    directed_graph_node** p_heads)
+{
+    decoded_test_reader readers[DECODED_TEST_THREADS];
+    pthread_t           threads[DECODED_TEST_THREADS];
+    bool                ok;
+    size_t              i;
+
+    for (i = 0; i < DECODED_TEST_THREADS; ++i)
+    {
+        readers[i].p_weight_function = p_weight_function;
+        readers[i].p_tail = p_tail;
+        readers[i].p_heads = p_heads;
+        readers[i].first = i;
+        readers[i].failed = false;
+
+        if (pthread_create(&threads[i],
+                           NULL,
+                           decoded_test_read,
+                           &readers[i]) != 0)
+        {
+            return false;
+        }
+    }
+
+    ok = true;
+
+    for (i = 0; i < DECODED_TEST_THREADS; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        ok = ok && !readers[i].failed;
+    }
+
+    return ok;
+}
+
+static void test_decoded_weight_threads_correctness()
+{
+    directed_graph_weight_function* p_weight_function;
+    directed_graph_node*            p_tail;
+    directed_graph_node*            p_heads[DECODED_TEST_HEADS];
+    char                            names[DECODED_TEST_HEADS][8];
+    point_3d                        points[DECODED_TEST_HEADS + 1];
+    unordered_map*                  p_point_map;
+    double                          scale;
+    double                          weight;
+    size_t                          i;
+
+    p_tail = directed_graph_node_alloc("Tail");
+    scale = 1.0;
+
+    ASSERT((p_weight_function =
+               directed_graph_weight_function_alloc_flat_format(
+                   hash_function,
+                   equals_function,
+                   WEIGHT_FORMAT_FIXED_POINT,
+                   1.0)));
+
+    for (i = 0; i < DECODED_TEST_HEADS; ++i)
+    {
+        sprintf(names[i], "%d", (int) i);
+        p_heads[i] = directed_graph_node_alloc(names[i]);
+        ASSERT(directed_graph_weight_function_put(p_weight_function,
+                                                  p_tail,
+                                                  p_heads[i],
+                                                  (double) i));
+    }
+
+    ASSERT(!directed_graph_weight_function_get_value(p_weight_function,
+                                                     p_heads[0],
+                                                     p_tail,
+                                                     &weight));
+    ASSERT(read_decoded_weights_in_threads(p_weight_function,
+                                           p_tail,
+                                           p_heads));
+
+    directed_graph_weight_function_free(p_weight_function);
+
+    /* The same for weights computed as the distance from the origin. */
+    p_point_map = unordered_map_alloc(16, 1.0f, hash_function, equals_function);
+    points[0].x = 0.0;
+    points[0].y = 0.0;
+    points[0].z = 0.0;
+    unordered_map_put(p_point_map, p_tail, &points[0]);
+
+    for (i = 0; i < DECODED_TEST_HEADS; ++i)
+    {
+        points[i + 1].x = (double) i;
+        points[i + 1].y = 0.0;
+        points[i + 1].z = 0.0;
+        unordered_map_put(p_point_map, p_heads[i], &points[i + 1]);
+    }
+
+    ASSERT((p_weight_function =
+               directed_graph_weight_function_alloc_computed(test_arc_length,
+                                                             p_point_map,
+                                                             &scale)));
+    ASSERT(read_decoded_weights_in_threads(p_weight_function,
+                                           p_tail,
+                                           p_heads));
+
+    directed_graph_weight_function_free(p_weight_function);
+    unordered_map_free(p_point_map);
+
+    for (i = 0; i < DECODED_TEST_HEADS; ++i)
+    {
+        directed_graph_node_free(p_heads[i]);
+    }
+
+    directed_graph_node_free(p_tail);
+}
+
+static void test_computed_weight_function_correctness()
+{
+    directed_graph_weight_function* p_weight_function;
+    directed_graph_node*            p_node_a;
+    directed_graph_node*            p_node_b;
+    directed_graph_node*            p_node_c;
+    unordered_map*                  p_point_map;
+    point_3d                        point_a = { 0.0, 0.0, 0.0 };
+    point_3d                        point_b = { 3.0, 4.0, 0.0 };
+    double                          factor = 2.0;
+
+    p_node_a = directed_graph_node_alloc("Node A");
+    p_node_b = directed_graph_node_alloc("Node B");
+    p_node_c = directed_graph_node_alloc("Node C");
+
+    p_point_map = unordered_map_alloc(16, 1.0f, hash_function, equals_function);
+    unordered_map_put(p_point_map, p_node_a, &point_a);
+    unordered_map_put(p_point_map, p_node_b, &point_b);
+
+    ASSERT((p_weight_function =
+        directed_graph_weight_function_alloc_computed(test_arc_length,
+            p_point_map,
+            &factor)));
+
+    ASSERT(*directed_graph_weight_function_get(p_weight_function,
+        p_node_a,
+        p_node_b) == 10.0);
+    ASSERT(*directed_graph_weight_function_get(p_weight_function,
+        p_node_b,
+        p_node_b) == 0.0);
+
+    /* Node C has no coordinates. */
+    ASSERT(directed_graph_weight_function_get(p_weight_function,
+        p_node_a,
+        p_node_c) == NULL);
+    ASSERT(directed_graph_weight_function_put(p_weight_function,
+        p_node_a,
+        p_node_b,
+        1.0) == false);
+
+    directed_graph_weight_function_free(p_weight_function);
+    unordered_map_free(p_point_map);
+    directed_graph_node_free(p_node_a);
+    directed_graph_node_free(p_node_b);
+    directed_graph_node_free(p_node_c);
+}
+
+static void test_weight_update_batch_correctness()
+{
+    directed_graph_weight_function* p_weight_function;
+    directed_graph_node*            p_node_a;
+    directed_graph_node*            p_node_b;
+    directed_graph_node*            p_node_c;
+    weight_update                   updates[3];
+    double*                         p_weight;
+
+    p_node_a = directed_graph_node_alloc("Node A");
+    p_node_b = directed_graph_node_alloc("Node B");
+    p_node_c = directed_graph_node_alloc("Node C");
+
+    p_weight_function = directed_graph_weight_function_alloc(hash_function,
+        equals_function);
+
+    directed_graph_weight_function_put(p_weight_function,
+        p_node_a,
+        p_node_b,
+        1.0);
+    directed_graph_weight_function_put(p_weight_function,
+        p_node_b,
+        p_node_c,
+        2.0);
+
+    p_weight = directed_graph_weight_function_get(p_weight_function,
+        p_node_a,
+        p_node_b);
+
+    ASSERT(directed_graph_weight_function_dirty_tails(p_weight_function)
+        == NULL);
+    ASSERT(directed_graph_weight_function_track_changes(p_weight_function));
+
+    updates[0].p_tail = p_node_a;
+    updates[0].p_head = p_node_b;
+    updates[0].weight = 3.0;
+    updates[1].p_tail = p_node_b;
+    updates[1].p_head = p_node_c;
+    updates[1].weight = 2.0;
+    updates[2].p_tail = p_node_c;
+    updates[2].p_head = p_node_a;
+    updates[2].weight = 4.0;
+
+    ASSERT(directed_graph_weight_function_put_batch(p_weight_function,
+        updates,
+        3) == 3);
+
+    /* Updated in place. */
+    ASSERT(p_weight == directed_graph_weight_function_get(p_weight_function,
+        p_node_a,
+        p_node_b));
+    ASSERT(*p_weight == 3.0);
+
+    /* B -> C kept its weight. */
+    ASSERT(unordered_set_size(
+        directed_graph_weight_function_dirty_tails(p_weight_function)) == 2);
+    ASSERT(unordered_set_contains(
+        directed_graph_weight_function_dirty_tails(p_weight_function),
+        p_node_a));
+    ASSERT(unordered_set_contains(
+        directed_graph_weight_function_dirty_tails(p_weight_function),
+        p_node_b) == false);
+
+    directed_graph_weight_function_clear_dirty(p_weight_function);
+    ASSERT(unordered_set_size(
+        directed_graph_weight_function_dirty_tails(p_weight_function)) == 0);
+
+    directed_graph_weight_function_free(p_weight_function);
+    directed_graph_node_free(p_node_a);
+    directed_graph_node_free(p_node_b);
+    directed_graph_node_free(p_node_c);
+}
+
+static void test_dijkstra_correctness()
+{
+    directed_graph_node* p_node_a;
+    directed_graph_node* p_node_b;
+    directed_graph_node* p_node_c;
+    directed_graph_node* p_node_d;
+    directed_graph_node* p_node_e;
+    directed_graph_node* p_node_s;
+    directed_graph_node* p_node_t;
+
+    directed_graph_weight_function* p_weight_function;
+    path* p_path;
+    arena* p_scratch;
+    size_t reserved;
+
+    p_node_a = directed_graph_node_alloc("A");
+    p_node_b = directed_graph_node_alloc("B");
+    p_node_c = directed_graph_node_alloc("C");
+    p_node_d = directed_graph_node_alloc("D");
+    p_node_e = directed_graph_node_alloc("E");
+    p_node_s = directed_graph_node_alloc("Source");
+    p_node_t = directed_graph_node_alloc("Target");
+
+    p_weight_function = directed_graph_weight_function_alloc(hash_function,
+        equals_function);
+
+    directed_graph_node_add_arc(p_node_s, p_node_a);
+    directed_graph_weight_function_put(p_weight_function,
+        p_node_s,
+        p_node_a,
+        1.0);
+
+    directed_graph_node_add_arc(p_node_a, p_node_b);
+    directed_graph_weight_function_put(p_weight_function,
+        p_node_a,
+        p_node_b,
+        2.0);
+
+    directed_graph_node_add_arc(p_node_b, p_node_c);
+    directed_graph_weight_function_put(p_weight_function,
+        p_node_b,
+        p_node_c,
+        3.0);
+
+    directed_graph_node_add_arc(p_node_c, p_node_t);
+    directed_graph_weight_function_put(p_weight_function,
+        p_node_c,
+        p_node_t,
+        16.0);
+
+    directed_graph_node_add_arc(p_node_s, p_node_d);
+    directed_graph_weight_function_put(p_weight_function,
+        p_node_s,
+        p_node_d,
+        11.0);
+
+    directed_graph_node_add_arc(p_node_d, p_node_e);
+    directed_graph_weight_function_put(p_weight_function,
+        p_node_d,
+        p_node_e,
+        5.0);
+
+    directed_graph_node_add_arc(p_node_e, p_node_t);
+    directed_graph_weight_function_put(p_weight_function,
+        p_node_e,
+        p_node_t,
+        6.0);
+
+    directed_graph_node_add_arc(p_node_c, p_node_d);
+    directed_graph_weight_function_put(p_weight_function,
+        p_node_c,
+        p_node_d,
+        4.0);
+
+    p_path = dijkstra(p_node_s, p_node_t, p_weight_function);
+
+    ASSERT(path_size(p_path) == 7);
+    ASSERT(path_get(p_path, 0) == p_node_s);
+    ASSERT(path_get(p_path, 1) == p_node_a);
+    ASSERT(path_get(p_path, 2) == p_node_b);
+    ASSERT(path_get(p_path, 3) == p_node_c);
+    ASSERT(path_get(p_path, 4) == p_node_d);
+    ASSERT(path_get(p_path, 5) == p_node_e);
+    ASSERT(path_get(p_path, 6) == p_node_t);
+    ASSERT(path_cost(p_path) == 21.0);
+    path_free(p_path);
+
+    /* A reused scratch arena keeps its blocks across the queries. */
+    ASSERT((p_scratch = arena_alloc(512)));
+    ASSERT((p_path = dijkstra_with_arena(p_node_s,
+                                         p_node_t,
+                                         p_weight_function,
+                                         p_scratch)));
+    ASSERT(path_size(p_path) == 7 && path_cost(p_path) == 21.0);
+    ASSERT(arena_bytes(p_scratch) == 0);
+    reserved = arena_reserved_bytes(p_scratch);
+    ASSERT(reserved > 512);
+    path_free(p_path);
+
+    ASSERT((p_path = dijkstra_with_arena(p_node_s,
+                                         p_node_t,
+                                         p_weight_function,
+                                         p_scratch)));
+    ASSERT(path_get(p_path, 4) == p_node_d);
+    ASSERT(arena_reserved_bytes(p_scratch) == reserved);
+    path_free(p_path);
+
+    ASSERT((p_path = dijkstra_with_arena(p_node_t,
+                                         p_node_s,
+                                         p_weight_function,
+                                         p_scratch)));
+    ASSERT(path_size(p_path) == 0);
+    path_free(p_path);
+    arena_free(p_scratch);
+}
+
+static void test_compact_dijkstra_correctness()
+{
+    directed_graph_node*            p_nodes[5];
+    directed_graph_weight_function* p_weight_function;
+    compact_graph*                  p_graph;
+    compact_path*                   p_path;
+    weight_format                   formats[3];
+    size_t                          i;
+
+    p_nodes[0] = directed_graph_node_alloc("S");
+    p_nodes[1] = directed_graph_node_alloc("A");
+    p_nodes[2] = directed_graph_node_alloc("B");
+    p_nodes[3] = directed_graph_node_alloc("C");
+    p_nodes[4] = directed_graph_node_alloc("T");
+
+    p_weight_function =
+        directed_graph_weight_function_alloc_flat_format(hash_function,
+            equals_function,
+            WEIGHT_FORMAT_FIXED_POINT,
+            100.0);
+
+    ASSERT(directed_graph_weight_function_put(p_weight_function,
+        p_nodes[0],
+        p_nodes[1],
+        -1.0) == false);
+
+    directed_graph_node_add_arc(p_nodes[0], p_nodes[1]);
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[0],
+        p_nodes[1],
+        1.25);
+
+    directed_graph_node_add_arc(p_nodes[1], p_nodes[4]);
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[1],
+        p_nodes[4],
+        10.5);
+
+    directed_graph_node_add_arc(p_nodes[0], p_nodes[2]);
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[0],
+        p_nodes[2],
+        2.5);
+
+    directed_graph_node_add_arc(p_nodes[2], p_nodes[3]);
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[2],
+        p_nodes[3],
+        3.75);
+
+    directed_graph_node_add_arc(p_nodes[3], p_nodes[4]);
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[3],
+        p_nodes[4],
+        4.0);
+
+    ASSERT(*directed_graph_weight_function_get(p_weight_function,
+        p_nodes[2],
+        p_nodes[3]) == 3.75);
+
+    formats[0] = WEIGHT_FORMAT_DOUBLE;
+    formats[1] = WEIGHT_FORMAT_FLOAT;
+    formats[2] = WEIGHT_FORMAT_FIXED_POINT;
+
+    for (i = 0; i < 3; ++i)
+    {
+        ASSERT((p_graph = compact_graph_alloc(p_nodes,
+            5,
+            p_weight_function,
+            formats[i],
+            100.0)));
+
+        ASSERT(compact_graph_arc_count(p_graph) == 5);
+
+        p_path = compact_dijkstra(p_graph, 0, 4);
+
+        ASSERT(compact_path_size(p_path) == 4);
+        ASSERT(compact_path_ids(p_path)[1] == 2);
+        ASSERT(compact_path_ids(p_path)[2] == 3);
+        ASSERT(compact_path_cost(p_path) == 10.25);
+
+        compact_path_free(p_path);
+
+        /* Nothing leads back to the source. */
+        p_path = compact_dijkstra(p_graph, 4, 0);
+        ASSERT(compact_path_size(p_path) == 0);
+
+        compact_path_free(p_path);
+        compact_graph_free(p_graph);
+    }
+
+    directed_graph_weight_function_free(p_weight_function);
+
+    for (i = 0; i < 5; ++i)
+    {
+        directed_graph_node_free(p_nodes[i]);
+    }
+}
+
+static void test_weight_profile_correctness()
+{
+    directed_graph_node*            p_nodes[4];
+    directed_graph_weight_function* p_weight_function;
+    compact_graph*                  p_graph;
+    weight_profile*                 p_profile;
+    compact_path*                   p_path;
+    const uint32_t*                 p_offsets;
+    const uint32_t*                 p_heads;
+    double*                         p_tolls;
+    double                          coefficients[2];
+    size_t                          arc;
+    uint32_t                        id;
+
+    p_nodes[0] = directed_graph_node_alloc("S");
+    p_nodes[1] = directed_graph_node_alloc("A");
+    p_nodes[2] = directed_graph_node_alloc("B");
+    p_nodes[3] = directed_graph_node_alloc("T");
+
+    p_weight_function =
+        directed_graph_weight_function_alloc_flat(hash_function,
+            equals_function);
+
+    /* S -> A -> T is short but tolled, S -> B -> T is long but free. */
+    directed_graph_node_add_arc(p_nodes[0], p_nodes[1]);
+    directed_graph_node_add_arc(p_nodes[1], p_nodes[3]);
+    directed_graph_node_add_arc(p_nodes[0], p_nodes[2]);
+    directed_graph_node_add_arc(p_nodes[2], p_nodes[3]);
+
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[0], p_nodes[1], 1.0);
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[1], p_nodes[3], 1.0);
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[0], p_nodes[2], 5.0);
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[2], p_nodes[3], 5.0);
+
+    ASSERT((p_graph = compact_graph_alloc(p_nodes,
+        4,
+        p_weight_function,
+        WEIGHT_FORMAT_DOUBLE,
+        1.0)));
+    ASSERT(weight_profile_alloc(p_graph, SIZE_MAX / 2) == NULL);
+    ASSERT((p_profile = weight_profile_alloc(p_graph, 2)));
+    ASSERT(weight_profile_load(p_profile, 0, p_graph, p_weight_function));
+
+    /* A small graph has 32-bit offsets. */
+    ASSERT(!compact_graph_has_wide_offsets(p_graph));
+
+    p_offsets = compact_graph_offsets(p_graph);
+    p_heads = compact_graph_heads(p_graph);
+    p_tolls = weight_profile_column(p_profile, 1);
+
+    for (id = 0; id < 4; ++id)
+    {
+        for (arc = p_offsets[id]; arc < p_offsets[id + 1]; ++arc)
+        {
+            p_tolls[arc] = (id == 1 || p_heads[arc] == 1) ? 10.0 : 0.0;
+        }
+    }
+
+    coefficients[0] = 1.0;
+    coefficients[1] = 0.0;
+    p_path = compact_dijkstra_profile(p_graph, p_profile, coefficients, 0, 3);
+    ASSERT(compact_path_ids(p_path)[1] == 1);
+    ASSERT(compact_path_cost(p_path) == 2.0);
+    compact_path_free(p_path);
+
+    coefficients[0] = 1.0;
+    coefficients[1] = 0.5;
+    p_path = compact_dijkstra_profile(p_graph, p_profile, coefficients, 0, 3);
+    ASSERT(compact_path_ids(p_path)[1] == 2);
+    ASSERT(compact_path_cost(p_path) == 10.0);
+    compact_path_free(p_path);
+
+    coefficients[1] = -1.0;
+    ASSERT(compact_dijkstra_profile(p_graph,
+        p_profile,
+        coefficients,
+        0,
+        3) == NULL);
+
+    weight_profile_free(p_profile);
+    compact_graph_free(p_graph);
+    directed_graph_weight_function_free(p_weight_function);
+
+    for (id = 0; id < 4; ++id)
+    {
+        directed_graph_node_free(p_nodes[id]);
+    }
+}
+
+static void test_dimacs_load_correctness()
+{
+    static const char* GRAPH_FILE_NAME = "test_dimacs.gr";
+    static const char* COORDINATE_FILE_NAME = "test_dimacs.co";
+
+    graph_data* p_data;
+    path*       p_path;
+    point_3d*   p_point;
+    FILE*       p_file;
+
+    ASSERT((p_file = fopen(GRAPH_FILE_NAME, "w")));
+    fputs("c A small test graph\n"
+          "p sp 4 5\n"
+          "a 1 2 3\n"
+          "a 2 4 4\n"
+          "a 1 3 1\n"
+          "a 3 4 10\n"
+          "a 4 1 2\n", p_file);
+    fclose(p_file);
+
+    ASSERT((p_file = fopen(COORDINATE_FILE_NAME, "w")));
+    fputs("p aux sp co 4\n"
+          "v 1 -73530767 41085396\n"
+          "v 2 -73530538 41086098\n"
+          "v 3 -73519366 41048796\n"
+          "v 4 -73519377 41048654\n", p_file);
+    fclose(p_file);
+
+    ASSERT((p_data = dimacs_load(GRAPH_FILE_NAME, COORDINATE_FILE_NAME)));
+    ASSERT(directed_graph_node_child_count(p_data->p_node_array[0]) == 2);
+    ASSERT(strcmp(directed_graph_node_to_string(p_data->p_node_array[3]),
+        "[directed_graph_node_t: id = 4]") == 0);
+
+    p_path = dijkstra(p_data->p_node_array[0],
+        p_data->p_node_array[3],
+        p_data->p_weight_function);
+
+    ASSERT(path_size(p_path) == 3);
+    ASSERT(path_get(p_path, 1) == p_data->p_node_array[1]);
+    ASSERT(path_cost(p_path) == 7.0);
+
+    ASSERT((p_point = unordered_map_get(p_data->p_point_map,
+        p_data->p_node_array[2])));
+    ASSERT(p_point->x == -73519366.0 && p_point->y == 41048796.0);
+
+    path_free(p_path);
+    graph_data_free(p_data);
+
+    /* Of parallel arcs, the cheapest one is kept whatever their order. */
+    ASSERT((p_file = fopen(GRAPH_FILE_NAME, "w")));
+    fputs("p sp 2 4\n"
+          "a 1 2 5\n"
+          "a 1 2 2\n"
+          "a 1 2 7\n"
+          "a 2 1 4\n", p_file);
+    fclose(p_file);
+
+    ASSERT((p_data = dimacs_load(GRAPH_FILE_NAME, NULL)));
+    ASSERT(directed_graph_node_child_count(p_data->p_node_array[0]) == 1);
+    ASSERT(*directed_graph_weight_function_get(p_data->p_weight_function,
+                                               p_data->p_node_array[0],
+                                               p_data->p_node_array[1])
+           == 2.0);
+    ASSERT(p_data->p_points == NULL);
+    graph_data_free(p_data);
+
+    /* An arc to a node beyond the header's count. */
+    ASSERT((p_file = fopen(GRAPH_FILE_NAME, "w")));
+    fputs("p sp 2 1\n"
+          "a 1 3 1\n", p_file);
+    fclose(p_file);
+
+    ASSERT(dimacs_load(GRAPH_FILE_NAME, NULL) == NULL);
+
+    remove(GRAPH_FILE_NAME);
+    remove(COORDINATE_FILE_NAME);
+}
+
+/*******************************************************************************
+* Loads a road-like graph of short decimal names, as in the DIMACS road        *
+* graphs, whose names used to collide so much that the maps keyed by them      *
+* made loading and searching quadratic.                                        *
+*******************************************************************************/
+static void test_dimacs_load_scale_correctness()
+{
+    static const char* GRAPH_FILE_NAME = "test_dimacs_scale.gr";
+    static const char* COORDINATE_FILE_NAME = "test_dimacs_scale.co";
+
+    enum { NODE_COUNT = 100000 };
+
+    graph_data*    p_data;
+    compact_graph* p_graph;
+    compact_path*  p_compact_path;
+    path*          p_path;
+    FILE*          p_file;
+    uint32_t       seed;
+    double         start;
+    size_t         i;
+
+    ASSERT((p_file = fopen(GRAPH_FILE_NAME, "w")));
+    fprintf(p_file, "p sp %d %d\n", NODE_COUNT, 3 * NODE_COUNT);
+    seed = 1;
+
+    /* A ring keeps every node reachable; two chords per node add detours. */
+    for (i = 0; i < NODE_COUNT; ++i)
+    {
+        fprintf(p_file,
+                "a %lu %lu 10\n",
+                (unsigned long)(i + 1),
+                (unsigned long)((i + 1) % NODE_COUNT + 1));
+        seed = seed * 1103515245U + 12345U;
+        fprintf(p_file,
+                "a %lu %lu %lu\n",
+                (unsigned long)(i + 1),
+                (unsigned long)(seed >> 8) % NODE_COUNT + 1,
+                (unsigned long)(seed % 1000) + 1);
+        seed = seed * 1103515245U + 12345U;
+        fprintf(p_file,
+                "a %lu %lu %lu\n",
+                (unsigned long)(i + 1),
+                (unsigned long)(seed >> 8) % NODE_COUNT + 1,
+                (unsigned long)(seed % 1000) + 1);
+    }
+
+    fclose(p_file);
+
+    ASSERT((p_file = fopen(COORDINATE_FILE_NAME, "w")));
+    fprintf(p_file, "p aux sp co %d\n", NODE_COUNT);
+
+    for (i = 0; i < NODE_COUNT; ++i)
+    {
+        fprintf(p_file,
+                "v %lu %lu %lu\n",
+                (unsigned long)(i + 1),
+                (unsigned long) i,
+                (unsigned long)(i % 317));
+    }
 
-    for (i = 0; i < list_t_size(p_path); ++i)
+    fclose(p_file);
+
+    /* Loading and one search are linear; colliding names took minutes. */
+    start = benchmark_now();
+    ASSERT((p_data = dimacs_load(GRAPH_FILE_NAME, COORDINATE_FILE_NAME)));
+    ASSERT(unordered_map_size(p_data->p_point_map) == NODE_COUNT);
+
+    ASSERT((p_path = dijkstra(p_data->p_node_array[0],
+                              p_data->p_node_array[NODE_COUNT / 2],
+                              p_data->p_weight_function)));
+    ASSERT(benchmark_now() - start < 10.0);
+
+    ASSERT((p_graph = compact_graph_alloc(p_data->p_node_array,
+                                          NODE_COUNT,
+                                          p_data->p_weight_function,
+                                          WEIGHT_FORMAT_FIXED_POINT,
+                                          1.0)));
+    ASSERT((p_compact_path = compact_dijkstra(p_graph, 0, NODE_COUNT / 2)));
+    ASSERT(path_size(p_path) > 0);
+    ASSERT(path_cost(p_path) == compact_path_cost(p_compact_path));
+
+    compact_path_free(p_compact_path);
+    compact_graph_free(p_graph);
+    path_free(p_path);
+    graph_data_free(p_data);
+
+    remove(GRAPH_FILE_NAME);
+    remove(COORDINATE_FILE_NAME);
+}
+
+/*******************************************************************************
+* Writes the 'size' bytes of 'p_contents' to 'p_file_name' with the 'length'   *
+* bytes at 'position' replaced by 'p_patch', and returns whether the file can  *
+* be opened.                                                                   *
+*******************************************************************************/
+static bool open_patched_file(const char* p_file_name,
+                              const char* p_contents,
+                              size_t size,
+                              size_t position,
+                              const void* p_patch,
+                              size_t length)
+{
+    compact_graph* p_graph;
+    FILE*          p_file;
+
+    ASSERT((p_file = fopen(p_file_name, "wb")));
+    ASSERT(fwrite(p_contents, 1, position, p_file) == position);
+    ASSERT(fwrite(p_patch, 1, length, p_file) == length);
+    ASSERT(fwrite(p_contents + position + length,
+                  1,
+                  size - position - length,
+                  p_file) == size - position - length);
+    fclose(p_file);
+
+    if (!(p_graph = compact_graph_open(p_file_name))) return false;
+
+    compact_graph_free(p_graph);
+    return true;
+}
+
+static void test_compact_graph_validate_correctness()
+{
+    uint32_t offsets[4]      = { 0, 2, 1, 3 };
+    uint32_t heads[3]        = { 1, 2, 0 };
+    uint64_t name_offsets[4] = { 0, 2, 4, 6 };
+    char     names[6]        = { 'a', 0, 'b', 0, 'c', 0 };
+
+    /* The offsets decrease from the second node to the third. */
+    ASSERT(!compact_graph_validate(3, 3, offsets, heads, NULL, NULL, 0));
+
+    offsets[2] = 2;
+    ASSERT(compact_graph_validate(3, 3, offsets, heads, NULL, NULL, 0));
+    ASSERT(compact_graph_validate(3,
+                                  3,
+                                  offsets,
+                                  heads,
+                                  name_offsets,
+                                  names,
+                                  sizeof(names)));
+
+    /* The last offset must be the arc count. */
+    ASSERT(!compact_graph_validate(3, 2, offsets, heads, NULL, NULL, 0));
+
+    heads[1] = 3;
+    ASSERT(!compact_graph_validate(3, 3, offsets, heads, NULL, NULL, 0));
+    heads[1] = 2;
+
+    /* The names must fit in their characters and end with a zero. */
+    ASSERT(!compact_graph_validate(3,
+                                   3,
+                                   offsets,
+                                   heads,
+                                   name_offsets,
+                                   names,
+                                   sizeof(names) - 1));
+    names[3] = 'b';
+    ASSERT(!compact_graph_validate(3,
+                                   3,
+                                   offsets,
+                                   heads,
+                                   name_offsets,
+                                   names,
+                                   sizeof(names)));
+}
+
+static void test_compact_graph_file_correctness()
+{
+    static const char* FILE_NAME = "test_compact_graph.bin";
+
+    directed_graph_node*            p_nodes[3];
+    directed_graph_weight_function* p_weight_function;
+    unordered_map*                  p_point_map;
+    point_3d                        points[3] = { { 0.0, 0.0, 0.0 },
+                                                  { 1.0, 2.0, 3.0 },
+                                                  { 4.0, 5.0, 6.0 } };
+    compact_graph*                  p_graph;
+    compact_graph*                  p_loaded;
+    compact_path*                   p_path;
+    FILE*                           p_file;
+    char                            contents[512];
+    uint64_t                        arc_count;
+    uint32_t                        head;
+    size_t                          size;
+    size_t                          i;
+
+    p_nodes[0] = directed_graph_node_alloc("Alpha");
+    p_nodes[1] = directed_graph_node_alloc("Beta");
+    p_nodes[2] = directed_graph_node_alloc("Gamma");
+
+    p_weight_function =
+        directed_graph_weight_function_alloc_flat(hash_function,
+            equals_function);
+    p_point_map = unordered_map_alloc(16, 1.0f, hash_function, equals_function);
+
+    for (i = 0; i < 3; ++i)
+    {
+        unordered_map_put(p_point_map, p_nodes[i], &points[i]);
+    }
+
+    directed_graph_node_add_arc(p_nodes[0], p_nodes[1]);
+    directed_graph_node_add_arc(p_nodes[1], p_nodes[2]);
+    directed_graph_node_add_arc(p_nodes[0], p_nodes[2]);
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[0], p_nodes[1], 1.5);
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[1], p_nodes[2], 2.0);
+    directed_graph_weight_function_put(p_weight_function,
+        p_nodes[0], p_nodes[2], 4.0);
+
+    ASSERT((p_graph = compact_graph_alloc(p_nodes,
+        3,
+        p_weight_function,
+        WEIGHT_FORMAT_FLOAT,
+        1.0)));
+    ASSERT(compact_graph_attach_points(p_graph, p_point_map));
+    ASSERT(compact_graph_save(p_graph, FILE_NAME));
+    ASSERT((p_loaded = compact_graph_open(FILE_NAME)));
+
+    ASSERT(compact_graph_node_count(p_loaded) == 3);
+    ASSERT(compact_graph_arc_count(p_loaded) == 3);
+    ASSERT(compact_graph_weight_format(p_loaded) == WEIGHT_FORMAT_FLOAT);
+    ASSERT(compact_graph_node(p_loaded, 0) == NULL);
+    ASSERT(strcmp(compact_graph_name(p_loaded, 2), "Gamma") == 0);
+    ASSERT(compact_graph_points(p_loaded)[1].z == 3.0);
+
+    for (i = 0; i < compact_graph_arc_count(p_graph); ++i)
+    {
+        ASSERT(compact_graph_heads(p_loaded)[i] ==
+               compact_graph_heads(p_graph)[i]);
+        ASSERT(compact_graph_arc_weight(p_loaded, i) ==
+               compact_graph_arc_weight(p_graph, i));
+    }
+
+    p_path = compact_dijkstra(p_loaded, 0, 2);
+    ASSERT(compact_path_size(p_path) == 3);
+    ASSERT(compact_path_ids(p_path)[1] == 1);
+    ASSERT(compact_path_cost(p_path) == 3.5);
+
+    compact_path_free(p_path);
+    compact_graph_free(p_loaded);
+    compact_graph_free(p_graph);
+
+    ASSERT((p_file = fopen(FILE_NAME, "rb")));
+    ASSERT((size = fread(contents, 1, sizeof(contents), p_file)) == 240);
+    fclose(p_file);
+
+    /* A head beyond the nodes, at the start of the heads after the header
+       and the four offsets, is rejected. */
+    head = 3;
+    ASSERT(!open_patched_file(FILE_NAME, contents, size, 80, &head, 4));
+
+    /* So is an arc count whose sections would not fit in memory. */
+    arc_count = UINT64_MAX / 2;
+    ASSERT(!open_patched_file(FILE_NAME, contents, size, 24, &arc_count, 8));
+
+    /* A name running into the padding after the name table. */
+    ASSERT(!open_patched_file(FILE_NAME, contents, size, 232, "!", 1));
+
+    ASSERT(open_patched_file(FILE_NAME, contents, size, 0, "C", 1));
+
+    /* A file cut short after the magic is rejected. */
+    ASSERT((p_file = fopen(FILE_NAME, "wb")));
+    fputs("CMPGRAPH", p_file);
+    fclose(p_file);
+    ASSERT(compact_graph_open(FILE_NAME) == NULL);
+
+    remove(FILE_NAME);
+    ASSERT(compact_graph_open(FILE_NAME) == NULL);
+
+    unordered_map_free(p_point_map);
+    directed_graph_weight_function_free(p_weight_function);
+
+    for (i = 0; i < 3; ++i)
     {
-        puts(directed_graph_node_t_to_string(list_t_get(p_path, i)));
+        directed_graph_node_free(p_nodes[i]);
     }
+}
 
-    printf("Path is a valid path: %d\n", is_valid_path(p_path));
-    printf("Path cost: %f\n",
-        compute_path_cost(p_path, p_data->p_weight_function));
-        */
-    /**** BIDIRECTIONAL ASTAR ALGORITHM ****//*
-    c = clock();
+static void test_compact_graph_compression_correctness()
+{
+    enum { COUNT = 300 };
 
-    p_path = bidirectional_astar(p_source,
-        p_target,
-        p_data->p_weight_function,
-        p_data->p_point_map);
+    static char                     names[COUNT][8];
+    directed_graph_node**           p_nodes;
+    directed_graph_weight_function* p_weight_function;
+    compact_graph*                  p_plain;
+    compact_graph*                  p_compressed;
+    compact_path*                   p_plain_path;
+    compact_path*                   p_compressed_path;
+    compact_arc_iterator            arcs;
+    size_t                          arc;
+    uint32_t                        head;
+    uint32_t                        previous;
+    size_t                          degree;
+    size_t                          i;
+    size_t                          j;
+
+    ASSERT((p_nodes = malloc(sizeof(directed_graph_node*) * COUNT)));
+
+    for (i = 0; i < COUNT; ++i)
+    {
+        sprintf(names[i], "%lu", (unsigned long) i);
+        p_nodes[i] = directed_graph_node_alloc(names[i]);
+    }
 
-    duration = ((double)clock() - c);
+    p_weight_function =
+        directed_graph_weight_function_alloc_flat_format(hash_function,
+            equals_function,
+            WEIGHT_FORMAT_FIXED_POINT,
+            1.0);
 
-    printf("Bidirectional A* algorithm in %f seconds.\n",
-        duration / CLOCKS_PER_SEC);
+    /* The arcs are added out of order, some to distant nodes of either side
+       so as to need varints of several bytes. */
+    for (i = 0; i < COUNT; ++i)
+    {
+        for (j = 1; j <= i % 4 + 1; ++j)
+        {
+            size_t head_index = (i * 7 + j * j * 37) % COUNT;
+
+            if (head_index == i) continue;
+
+            directed_graph_node_add_arc(p_nodes[i], p_nodes[head_index]);
+            directed_graph_weight_function_put(p_weight_function,
+                p_nodes[i],
+                p_nodes[head_index],
+                (double)((i * 7 + j * 13) % 50 + 1));
+        }
+    }
+
+    ASSERT((p_plain = compact_graph_alloc(p_nodes,
+        COUNT,
+        p_weight_function,
+        WEIGHT_FORMAT_FIXED_POINT,
+        1.0)));
+    ASSERT((p_compressed = compact_graph_alloc(p_nodes,
+        COUNT,
+        p_weight_function,
+        WEIGHT_FORMAT_FIXED_POINT,
+        1.0)));
+
+    ASSERT(compact_graph_compress(p_compressed));
+    ASSERT(compact_graph_is_compressed(p_compressed));
+    ASSERT(!compact_graph_is_compressed(p_plain));
+    ASSERT(compact_graph_heads(p_compressed) == NULL);
+    ASSERT(compact_graph_adjacency_size(p_compressed) <
+           compact_graph_adjacency_size(p_plain));
+    ASSERT(!compact_graph_save(p_compressed, "test_compressed.bin"));
+
+    for (i = 0; i < COUNT; ++i)
+    {
+        degree = 0;
+        previous = 0;
+        compact_graph_arcs(p_compressed, (uint32_t) i, &arcs);
+
+        /* The heads come sorted, each with the weight of its arc. */
+        while (compact_arc_iterator_next(&arcs, &arc, &head))
+        {
+            ASSERT(head >= previous);
+            ASSERT(compact_graph_arc_weight(p_compressed, arc) ==
+                   *directed_graph_weight_function_get(p_weight_function,
+                       p_nodes[i],
+                       p_nodes[head]));
+            previous = head;
+            ++degree;
+        }
+
+        ASSERT(degree == directed_graph_node_child_count(p_nodes[i]));
+    }
+
+    for (i = 0; i < COUNT; i += 29)
+    {
+        for (j = 0; j < COUNT; j += 31)
+        {
+            p_plain_path = compact_dijkstra(p_plain,
+                (uint32_t) i,
+                (uint32_t) j);
+            p_compressed_path = compact_dijkstra(p_compressed,
+                (uint32_t) i,
+                (uint32_t) j);
+
+            ASSERT(compact_path_size(p_plain_path) ==
+                   compact_path_size(p_compressed_path));
+            ASSERT(compact_path_cost(p_plain_path) ==
+                   compact_path_cost(p_compressed_path));
+
+            compact_path_free(p_plain_path);
+            compact_path_free(p_compressed_path);
+        }
+    }
+
+    compact_graph_free(p_plain);
+    compact_graph_free(p_compressed);
+    directed_graph_weight_function_free(p_weight_function);
+
+    for (i = 0; i < COUNT; ++i)
+    {
+        directed_graph_node_free(p_nodes[i]);
+    }
+
+    free(p_nodes);
+}
+
+static void test_edge_list_correctness()
+{
+    enum { NODE_COUNT = 5000, EDGE_COUNT = 60000 };
+
+    weighted_edge*       p_edges;
+    compact_graph*       p_graph;
+    compact_path*        p_path;
+    const uint32_t*      p_offsets;
+    const uint32_t*      p_heads;
+    const uint32_t*      p_reverse_offsets;
+    const uint32_t*      p_reverse_tails;
+    const uint32_t*      p_reverse_arcs;
+    size_t*              p_cursors;
+    compact_arc_iterator arcs;
+    size_t               forward_arc;
+    uint32_t             head;
+    bool                 found;
+    size_t               edge_count;
+    uint32_t             node_count;
+    uint32_t             seed;
+    size_t               arc;
+    size_t               i;
+
+    ASSERT(edge_list_parse("# A small graph\n"
+                           "0 1 1.5\n"
+                           "1 2 2\n"
+                           "\n"
+                           "0 2 4\n"
+                           "2 0 1",
+                           4,
+                           &p_edges,
+                           &edge_count,
+                           &node_count));
+    ASSERT(edge_count == 4);
+    ASSERT(node_count == 3);
+    ASSERT(p_edges[2].head == 2 && p_edges[2].weight == 4.0);
+
+    ASSERT((p_graph = edge_list_build(p_edges,
+        edge_count,
+        node_count,
+        WEIGHT_FORMAT_DOUBLE,
+        1.0,
+        2)));
+    ASSERT(!compact_graph_has_wide_offsets(p_graph));
+    ASSERT(compact_graph_offset(p_graph, 1) == 2);
+    ASSERT(compact_graph_reverse_offset(p_graph, 3) == 4);
+    ASSERT(compact_graph_reverse_arc(p_graph, 0) == 3);
+    ASSERT(compact_graph_reverse_tails(p_graph)[0] == 2);
+
+    p_path = compact_dijkstra(p_graph, 0, 2);
+    ASSERT(compact_path_size(p_path) == 3);
+    ASSERT(compact_path_cost(p_path) == 3.5);
+
+    compact_path_free(p_path);
+    compact_graph_free(p_graph);
+    free(p_edges);
+
+    ASSERT(!edge_list_parse("0 1\n1 2 3\n", 1, &p_edges, &edge_count,
+        &node_count));
+    ASSERT(!edge_list_parse("0 1 -3\n", 1, &p_edges, &edge_count,
+        &node_count));
+
+    /* Enough arcs for several threads and radix passes. */
+    ASSERT((p_edges = malloc(sizeof(weighted_edge) * EDGE_COUNT)));
+    seed = 12345;
+
+    for (i = 0; i < EDGE_COUNT; ++i)
+    {
+        seed = seed * 1103515245U + 12345U;
+        p_edges[i].tail = (seed >> 8) % NODE_COUNT;
+        seed = seed * 1103515245U + 12345U;
+        p_edges[i].head = (seed >> 8) % NODE_COUNT;
+        p_edges[i].weight = (double)(i % 100 + 1);
+    }
+
+    ASSERT(!edge_list_build(p_edges,
+        EDGE_COUNT,
+        NODE_COUNT - 1,
+        WEIGHT_FORMAT_FLOAT,
+        1.0,
+        4));
+    ASSERT((p_graph = edge_list_build(p_edges,
+        EDGE_COUNT,
+        NODE_COUNT,
+        WEIGHT_FORMAT_FLOAT,
+        1.0,
+        4)));
+
+    /* The offsets and arc indices built as size_t are narrowed. */
+    ASSERT(!compact_graph_has_wide_offsets(p_graph));
+
+    p_offsets = compact_graph_offsets(p_graph);
+    p_heads = compact_graph_heads(p_graph);
+    p_reverse_offsets = compact_graph_reverse_offsets(p_graph);
+    p_reverse_tails = compact_graph_reverse_tails(p_graph);
+    p_reverse_arcs = compact_graph_reverse_arcs(p_graph);
+
+    ASSERT((p_cursors = malloc(sizeof(size_t) * NODE_COUNT)));
+
+    for (i = 0; i < NODE_COUNT; ++i)
+    {
+        p_cursors[i] = p_offsets[i];
+    }
+
+    /* The arcs of each tail keep their input order. */
+    for (i = 0; i < EDGE_COUNT; ++i)
+    {
+        arc = p_cursors[p_edges[i].tail]++;
+        ASSERT(arc < p_offsets[p_edges[i].tail + 1]);
+        ASSERT(p_heads[arc] == p_edges[i].head);
+        ASSERT(compact_graph_arc_weight(p_graph, arc) == p_edges[i].weight);
+    }
+
+    for (i = 0; i < NODE_COUNT; ++i)
+    {
+        for (arc = p_reverse_offsets[i]; arc < p_reverse_offsets[i + 1]; ++arc)
+        {
+            ASSERT(p_heads[p_reverse_arcs[arc]] == i);
+            ASSERT(p_offsets[p_reverse_tails[arc]] <= p_reverse_arcs[arc]);
+            ASSERT(p_reverse_arcs[arc] < p_offsets[p_reverse_tails[arc] + 1]);
+        }
+    }
+
+    /* Compressing reorders the arcs and updates the reverse adjacency. */
+    ASSERT(compact_graph_compress(p_graph));
+
+    for (i = 0; i < NODE_COUNT; i += 7)
+    {
+        for (arc = p_reverse_offsets[i]; arc < p_reverse_offsets[i + 1]; ++arc)
+        {
+            compact_graph_arcs(p_graph, p_reverse_tails[arc], &arcs);
+            forward_arc = SIZE_MAX;
+            head = COMPACT_GRAPH_NO_NODE;
+            found = false;
+
+            while (compact_arc_iterator_next(&arcs, &forward_arc, &head))
+            {
+                if ((found = forward_arc == p_reverse_arcs[arc])) break;
+            }
+
+            ASSERT(found);
+            ASSERT(head == i);
+        }
+    }
+
+    free(p_cursors);
+    compact_graph_free(p_graph);
+    free(p_edges);
+}
+
+static void test_name_index_correctness()
+{
+    enum { COUNT = 10000 };
+
+    string_pool*   p_pool;
+    name_index*    p_index;
+    const char**   p_names;
+    const char*    p_alpha;
+    const char*    duplicates[3] = { "x", "y", "x" };
+    char           name[24];
+    weighted_edge  edge = { 0, 1, 1.0 };
+    compact_graph* p_graph;
+    uint32_t       i;
+
+    /* Tiny blocks so that the strings spread over many of them. */
+    ASSERT((p_pool = string_pool_alloc(16)));
+    ASSERT((p_alpha = string_pool_intern(p_pool, "alpha")));
+    ASSERT(string_pool_intern(p_pool, "alpha") == p_alpha);
+    ASSERT(string_pool_intern(p_pool, "a name longer than a block"));
+    ASSERT(string_pool_size(p_pool) == 2);
+    ASSERT(string_pool_bytes(p_pool) == 6 + 27);
+
+    ASSERT((p_names = malloc(sizeof(char*) * COUNT)));
+
+    for (i = 0; i < COUNT; ++i)
+    {
+        sprintf(name, "node %lu", (unsigned long) i);
+        ASSERT((p_names[i] = string_pool_intern(p_pool, name)));
+    }
+
+    ASSERT(string_pool_intern(p_pool, "alpha") == p_alpha);
+    ASSERT(string_pool_size(p_pool) == COUNT + 2);
+
+    ASSERT((p_index = name_index_alloc(p_names, COUNT)));
+    ASSERT(name_index_size(p_index) == COUNT);
+
+    for (i = 0; i < COUNT; ++i)
+    {
+        sprintf(name, "node %lu", (unsigned long) i);
+        ASSERT(name_index_get(p_index, name) == i);
+    }
+
+    ASSERT(name_index_get(p_index, "alpha") == NAME_INDEX_NOT_FOUND);
+    ASSERT(name_index_get(p_index, "node 10000") == NAME_INDEX_NOT_FOUND);
+    name_index_free(p_index);
+
+    /* The spare slots keep the search short; without any displacement to
+       try, no function is found. */
+    ASSERT((p_index = name_index_alloc_with_limit(p_names, COUNT, 1U << 12)));
+    ASSERT(name_index_get(p_index, "node 9999") == COUNT - 1);
+    name_index_free(p_index);
+    ASSERT(name_index_alloc_with_limit(p_names, COUNT, 1) == NULL);
+
+    ASSERT(name_index_alloc(duplicates, 3) == NULL);
+    ASSERT((p_index = name_index_alloc(duplicates, 2)));
+    ASSERT(name_index_get(p_index, "y") == 1);
+    name_index_free(p_index);
+
+    ASSERT((p_index = name_index_alloc(NULL, 0)));
+    ASSERT(name_index_get(p_index, "x") == NAME_INDEX_NOT_FOUND);
+    name_index_free(p_index);
+
+    /* A graph built from an edge list has no names. */
+    ASSERT((p_graph = edge_list_build(&edge,
+        1,
+        2,
+        WEIGHT_FORMAT_DOUBLE,
+        1.0,
+        1)));
+    ASSERT(name_index_alloc_from_graph(p_graph) == NULL);
+    compact_graph_free(p_graph);
+
+    free(p_names);
+    string_pool_free(p_pool);
+}
+
+static void test_artifact_file_correctness()
+{
+    static const char* FILE_NAME = "test_artifacts.bin";
+
+    weighted_edge    edges[3] = { { 0, 1, 2.0 }, { 1, 2, 1.5 }, { 0, 2, 4.0 } };
+    double           distances[3] = { 0.0, 2.0, 3.5 };
+    uint32_t         order[3] = { 2, 0, 1 };
+    artifact_section sections[2];
+    artifact_file*   p_artifacts;
+    compact_graph*   p_graph;
+    compact_graph*   p_other;
+    const double*    p_distances;
+    const uint32_t*  p_order;
+    FILE*            p_file;
+    size_t           size;
+    long             position;
+
+    ASSERT((p_graph = edge_list_build(edges,
+                                      3,
+                                      3,
+                                      WEIGHT_FORMAT_DOUBLE,
+                                      1.0,
+                                      1)));
+
+    sections[0].p_name = "distances";
+    sections[0].p_data = distances;
+    sections[0].size = sizeof(distances);
+    sections[1].p_name = "order";
+    sections[1].p_data = order;
+    sections[1].size = sizeof(order);
+
+    ASSERT(artifact_file_save(FILE_NAME, p_graph, sections, 2));
+    ASSERT((p_artifacts = artifact_file_open(FILE_NAME, p_graph)));
+    ASSERT(artifact_file_section_count(p_artifacts) == 2);
+
+    ASSERT((p_distances = artifact_file_section(p_artifacts,
+                                                "distances",
+                                                &size)));
+    ASSERT(size == sizeof(distances));
+    ASSERT(memcmp(p_distances, distances, sizeof(distances)) == 0);
+
+    ASSERT((p_order = artifact_file_section(p_artifacts, "order", &size)));
+    ASSERT(size == sizeof(order));
+    ASSERT(p_order[0] == 2 && p_order[1] == 0 && p_order[2] == 1);
+    ASSERT(((uintptr_t) p_order) % 8 == 0);
+
+    ASSERT(artifact_file_section(p_artifacts, "labels", &size) == NULL);
+    artifact_file_close(p_artifacts);
+
+    /* Artifacts of a graph with other weights are rejected. */
+    edges[2].weight = 5.0;
+    ASSERT((p_other = edge_list_build(edges,
+                                      3,
+                                      3,
+                                      WEIGHT_FORMAT_DOUBLE,
+                                      1.0,
+                                      1)));
+    ASSERT(artifact_graph_checksum(p_other) !=
+           artifact_graph_checksum(p_graph));
+    ASSERT(artifact_file_open(FILE_NAME, p_other) == NULL);
+    compact_graph_free(p_other);
+
+    /* A flipped byte in the last section is detected. */
+    ASSERT((p_file = fopen(FILE_NAME, "r+b")));
+    fseek(p_file, 0, SEEK_END);
+    position = ftell(p_file) - 8;
+    fseek(p_file, position, SEEK_SET);
+    fputc(0x7f, p_file);
+    fclose(p_file);
+    ASSERT(artifact_file_open(FILE_NAME, p_graph) == NULL);
+
+    /* Section names must be unique. */
+    sections[1].p_name = "distances";
+    ASSERT(!artifact_file_save(FILE_NAME, p_graph, sections, 2));
+
+    ASSERT(artifact_file_save(FILE_NAME, p_graph, NULL, 0));
+    ASSERT((p_artifacts = artifact_file_open(FILE_NAME, p_graph)));
+    ASSERT(artifact_file_section_count(p_artifacts) == 0);
+    artifact_file_close(p_artifacts);
+
+    remove(FILE_NAME);
+    ASSERT(artifact_file_open(FILE_NAME, p_graph) == NULL);
+    compact_graph_free(p_graph);
+}
+
+static void test_node_order_correctness()
+{
+    /* A path 3 - 1 - 4 - 0 - 2 with arcs in both directions. */
+    weighted_edge   path_edges[8] = { { 3, 1, 1.0 }, { 1, 3, 1.0 },
+                                      { 1, 4, 2.0 }, { 4, 1, 2.0 },
+                                      { 4, 0, 3.0 }, { 0, 4, 3.0 },
+                                      { 0, 2, 4.0 }, { 2, 0, 4.0 } };
+    weighted_edge   grid_edges[16];
+    point_3d*       p_points;
+    compact_graph*  p_graph;
+    compact_graph*  p_renumbered;
+    compact_path*   p_path;
+    const point_3d* p_moved;
+    uint32_t*       p_order;
+    uint32_t*       p_rank;
+    uint32_t        id;
+    uint32_t        cell;
+    size_t          arc;
+    size_t          i;
+
+    ASSERT((p_graph = edge_list_build(path_edges,
+                                      8,
+                                      5,
+                                      WEIGHT_FORMAT_DOUBLE,
+                                      1.0,
+                                      1)));
+
+    ASSERT(!node_order_compute(p_graph,
+                               NODE_ORDER_HILBERT,
+                               &p_order,
+                               &p_rank));
+    ASSERT(node_order_compute(p_graph,
+                              NODE_ORDER_AUTOMATIC,
+                              &p_order,
+                              &p_rank));
+
+    /* Starts from the end with the smaller id and walks along the path. */
+    ASSERT(p_order[0] == 2 && p_order[1] == 0 && p_order[2] == 4);
+    ASSERT(p_order[3] == 1 && p_order[4] == 3);
+
+    for (id = 0; id < 5; ++id)
+    {
+        ASSERT(p_rank[p_order[id]] == id);
+    }
+
+    ASSERT(compact_graph_compress(p_graph));
+    ASSERT((p_renumbered = node_order_apply(p_graph, p_order, p_rank)));
+    ASSERT(!compact_graph_is_compressed(p_renumbered));
+    ASSERT(compact_graph_arc_count(p_renumbered) == 8);
+
+    /* The path runs through the ids in order now. */
+    for (id = 0; id < 5; ++id)
+    {
+        for (arc = compact_graph_offset(p_renumbered, id);
+             arc < compact_graph_offset(p_renumbered, id + 1);
+             ++arc)
+        {
+            ASSERT(compact_graph_heads(p_renumbered)[arc] + 1 == id ||
+                   compact_graph_heads(p_renumbered)[arc] == id + 1);
+        }
+    }
+
+    ASSERT(compact_graph_reverse_offsets(p_renumbered));
+
+    for (id = 0; id < 5; ++id)
+    {
+        for (arc = compact_graph_reverse_offset(p_renumbered, id);
+             arc < compact_graph_reverse_offset(p_renumbered, id + 1);
+             ++arc)
+        {
+            i = compact_graph_reverse_arc(p_renumbered, arc);
+            cell = compact_graph_reverse_tails(p_renumbered)[arc];
+            ASSERT(compact_graph_heads(p_renumbered)[i] == id);
+            ASSERT(i >= compact_graph_offset(p_renumbered, cell));
+            ASSERT(i < compact_graph_offset(p_renumbered, cell + 1));
+        }
+    }
+
+    p_path = compact_dijkstra(p_renumbered, p_rank[3], p_rank[2]);
+    ASSERT(compact_path_size(p_path) == 5);
+    ASSERT(compact_path_cost(p_path) == 10.0);
+    compact_path_free(p_path);
+
+    free(p_order);
+    free(p_rank);
+    compact_graph_free(p_renumbered);
+    compact_graph_free(p_graph);
+
+    /* A 4 x 4 grid whose ids run along the rows, the rows scrambled. */
+    ASSERT((p_points = malloc(sizeof(point_3d) * 16)));
+
+    for (id = 0; id < 16; ++id)
+    {
+        cell = (id / 4 * 3) % 4 * 4 + id % 4;
+        p_points[id].x = (double)(cell % 4);
+        p_points[id].y = (double)(cell / 4);
+        p_points[id].z = 0.0;
+        grid_edges[id].tail = id;
+        grid_edges[id].head = (id + 1) % 16;
+        grid_edges[id].weight = 1.0;
+    }
+
+    ASSERT((p_graph = edge_list_build(grid_edges,
+                                      16,
+                                      16,
+                                      WEIGHT_FORMAT_DOUBLE,
+                                      1.0,
+                                      1)));
+    ASSERT(compact_graph_adopt_node_data(p_graph, NULL, p_points));
+    ASSERT(node_order_compute(p_graph,
+                              NODE_ORDER_AUTOMATIC,
+                              &p_order,
+                              &p_rank));
+
+    /* Consecutive cells along a Hilbert curve are neighbours. */
+    for (id = 1; id < 16; ++id)
+    {
+        ASSERT(fabs(p_points[p_order[id]].x - p_points[p_order[id - 1]].x) +
+               fabs(p_points[p_order[id]].y - p_points[p_order[id - 1]].y)
+               == 1.0);
+    }
+
+    ASSERT((p_renumbered = node_order_apply(p_graph, p_order, p_rank)));
+    ASSERT((p_moved = compact_graph_points(p_renumbered)));
+
+    for (id = 0; id < 16; ++id)
+    {
+        ASSERT(p_moved[p_rank[id]].x == p_points[id].x);
+        ASSERT(p_moved[p_rank[id]].y == p_points[id].y);
+        ASSERT(compact_graph_heads(p_renumbered)[
+                   compact_graph_offset(p_renumbered, p_rank[id])] ==
+               p_rank[(id + 1) % 16]);
+    }
+
+    free(p_order);
+    free(p_rank);
+    compact_graph_free(p_renumbered);
+    compact_graph_free(p_graph);
+}
+
+static void test_arena_correctness()
+{
+    enum { COUNT = 40 };
+
+    static char          names[COUNT][8];
+    arena*               p_arena;
+    unordered_set*       p_set;
+    directed_graph_node* p_nodes[COUNT];
+    char*                p_small;
+    char*                p_large;
+    size_t               reserved;
+    size_t               i;
+
+    ASSERT((p_arena = arena_alloc(256)));
+    ASSERT((p_small = arena_allocate(p_arena, 3)));
+    ASSERT(((uintptr_t) p_small) % ARENA_ALIGNMENT == 0);
+    ASSERT((p_large = arena_allocate(p_arena, 1000)));
+    ASSERT(((uintptr_t) p_large) % ARENA_ALIGNMENT == 0);
+    memset(p_large, 1, 1000);
+    reserved = arena_reserved_bytes(p_arena);
+
+    /* The block of the small allocation still takes the next one. */
+    ASSERT(arena_allocate(p_arena, 5) == p_small + ARENA_ALIGNMENT);
+    ASSERT(arena_reserved_bytes(p_arena) == reserved);
+    ASSERT(arena_bytes(p_arena) == 1008);
+
+    /* Removed entries of a set are reused by later additions. */
+    ASSERT((p_set = unordered_set_alloc_in_arena(p_arena,
+                                                 4,
+                                                 1.0f,
+                                                 hash_function,
+                                                 equals_function)));
+
+    for (i = 0; i < COUNT; ++i)
+    {
+        sprintf(names[i], "%lu", (unsigned long) i);
+        ASSERT((p_nodes[i] = directed_graph_node_alloc_in_arena(p_arena,
+                                                                names[i])));
+        ASSERT(unordered_set_add(p_set, p_nodes[i]));
+    }
 
-    printf("Path:\n");
+    ASSERT(unordered_set_remove(p_set, p_nodes[7]));
+    reserved = arena_bytes(p_arena);
+    ASSERT(unordered_set_add(p_set, p_nodes[7]));
+    ASSERT(arena_bytes(p_arena) == reserved);
+    ASSERT(unordered_set_size(p_set) == COUNT);
+    ASSERT(unordered_set_is_healthy(p_set));
+    unordered_set_free(p_set);
 
-    for (i = 0; i < list_t_size(p_path); ++i)
+    /* Node 0 gets enough children for a neighbor index. */
+    for (i = 1; i < COUNT; ++i)
     {
-        puts(directed_graph_node_t_to_string(list_t_get(p_path, i)));
+        ASSERT(directed_graph_node_add_arc(p_nodes[0], p_nodes[i]));
+        ASSERT(directed_graph_node_add_arc(p_nodes[i], p_nodes[i % 5 + 1]));
     }
 
-    printf("Path is a valid path: %d\n", is_valid_path(p_path));
-    printf("Path cost: %f\n",
-        compute_path_cost(p_path, p_data->p_weight_function));*/
+    ASSERT(directed_graph_node_child_count(p_nodes[0]) == COUNT - 1);
+    ASSERT(directed_graph_node_has_child(p_nodes[0], p_nodes[COUNT - 1]));
+    ASSERT(directed_graph_node_remove_arc(p_nodes[0], p_nodes[COUNT - 1]));
+    ASSERT(!directed_graph_node_has_child(p_nodes[0], p_nodes[COUNT - 1]));
+    ASSERT(directed_graph_node_parent_count(p_nodes[COUNT - 1]) == 0);
+    ASSERT(strcmp(directed_graph_node_to_string(p_nodes[3]),
+                  "[directed_graph_node_t: id = 3]") == 0);
+
+    directed_graph_node_free(p_nodes[2]);
+    ASSERT(!directed_graph_node_has_child(p_nodes[0], p_nodes[2]));
+    ASSERT(directed_graph_node_child_count(p_nodes[0]) == COUNT - 3);
+
+    ASSERT(directed_graph_node_alloc_in_arena(NULL, names[0]) == NULL);
+    arena_free(p_arena);
+}
+
+static void test_forward_only_correctness()
+{
+    enum { COUNT = 6 };
+
+    static char           names[COUNT][8];
+    directed_graph_node*  p_nodes[COUNT];
+    directed_graph_node*  p_hub;
+    directed_graph_node** p_parents;
+    reverse_index*        p_index;
+    arena*                p_arena;
+    size_t                forward_only_size;
+    size_t                count;
+    size_t                i;
+
+    for (i = 0; i < COUNT; ++i)
+    {
+        sprintf(names[i], "f%lu", (unsigned long) i);
+        ASSERT((p_nodes[i] = directed_graph_node_alloc_with_mode(
+                                names[i],
+                                DIRECTED_GRAPH_NODE_FORWARD_ONLY,
+                                NULL)));
+    }
+
+    ASSERT((p_hub = directed_graph_node_alloc("hub")));
+    ASSERT(directed_graph_node_get_mode(p_nodes[0]) ==
+           DIRECTED_GRAPH_NODE_FORWARD_ONLY);
+    ASSERT(directed_graph_node_get_mode(p_hub) ==
+           DIRECTED_GRAPH_NODE_BIDIRECTIONAL);
+
+    /* Arcs 0 -> i and i -> hub for i > 0. */
+    for (i = 1; i < COUNT; ++i)
+    {
+        ASSERT(directed_graph_node_add_arc(p_nodes[0], p_nodes[i]));
+        ASSERT(directed_graph_node_add_arc(p_nodes[i], p_hub));
+    }
+
+    ASSERT(!directed_graph_node_add_arc(p_nodes[0], p_nodes[1]));
+    ASSERT(directed_graph_node_child_count(p_nodes[0]) == COUNT - 1);
+    ASSERT(directed_graph_node_parent_count(p_nodes[1]) == 0);
+    ASSERT(directed_graph_node_parents(p_nodes[1]) == NULL);
+
+    /* A bidirectional head still learns of its forward-only parents. */
+    ASSERT(directed_graph_node_parent_count(p_hub) == COUNT - 1);
+
+    ASSERT((p_index = reverse_index_alloc(p_nodes, COUNT)));
+    ASSERT(!reverse_index_is_built(p_index));
+    ASSERT((p_parents = reverse_index_parents(p_index, p_nodes[3], &count)));
+    ASSERT(reverse_index_is_built(p_index));
+    ASSERT(count == 1 && p_parents[0] == p_nodes[0]);
+
+    reverse_index_parents(p_index, p_nodes[0], &count);
+    ASSERT(count == 0);
+
+    /* The hub is not in the index. */
+    ASSERT(reverse_index_parents(p_index, p_hub, &count) == NULL);
+    ASSERT(count == 0);
+
+    ASSERT(directed_graph_node_remove_arc(p_nodes[0], p_nodes[3]));
+    reverse_index_parents(p_index, p_nodes[3], &count);
+    ASSERT(count == 1);
+    reverse_index_invalidate(p_index);
+    reverse_index_parents(p_index, p_nodes[3], &count);
+    ASSERT(count == 0);
+    reverse_index_free(p_index);
+
+    /* Clearing a forward-only node removes the arcs leaving it. */
+    directed_graph_node_clear(p_nodes[2]);
+    ASSERT(directed_graph_node_child_count(p_nodes[2]) == 0);
+    ASSERT(directed_graph_node_parent_count(p_hub) == COUNT - 2);
+    ASSERT(directed_graph_node_has_child(p_nodes[0], p_nodes[2]));
+
+    directed_graph_node_free(p_hub);
+    ASSERT(directed_graph_node_child_count(p_nodes[1]) == 0);
+
+    for (i = 0; i < COUNT; ++i)
+    {
+        directed_graph_node_free(p_nodes[i]);
+    }
+
+    /* Forward-only nodes take less memory. */
+    ASSERT((p_arena = arena_alloc(0)));
+    directed_graph_node_alloc_with_mode(names[0],
+                                        DIRECTED_GRAPH_NODE_FORWARD_ONLY,
+                                        p_arena);
+    forward_only_size = arena_bytes(p_arena);
+    directed_graph_node_alloc_in_arena(p_arena, names[1]);
+    ASSERT(arena_bytes(p_arena) - forward_only_size > forward_only_size);
+    arena_free(p_arena);
+}
+
+static void test_large_array_correctness()
+{
+    enum { NODE_COUNT = 100000, EDGE_COUNT = 600000 };
+
+    weighted_edge* p_edges;
+    compact_graph* p_graph;
+    compact_path*  p_before;
+    compact_path*  p_after;
+    char*          p_small;
+    char*          p_large;
+    size_t         large_size;
+    uint32_t       seed;
+    size_t         i;
+
+    ASSERT(large_array_numa_node_count() >= 1);
+
+    ASSERT((p_small = large_array_alloc(100, LARGE_ARRAY_LOCAL)));
+    memset(p_small, 1, 100);
+    large_array_free(p_small, 100);
+    large_array_free(large_array_alloc(0, LARGE_ARRAY_LOCAL), 0);
+
+    /* Not a multiple of the page size, so the last page is partly used. */
+    large_size = 3 * LARGE_ARRAY_PAGE_SIZE + 5;
+
+    ASSERT((p_large = large_array_alloc(large_size, LARGE_ARRAY_INTERLEAVED)));
+    memset(p_large, 2, large_size);
+    ASSERT(p_large[0] == 2 && p_large[large_size - 1] == 2);
+    large_array_free(p_large, large_size);
+
+    ASSERT((p_large = large_array_alloc(large_size, LARGE_ARRAY_LOCAL)));
+    memset(p_large, 3, large_size);
+    large_array_free(p_large, large_size);
+
+    /* Enough arcs for the heads to take more than a huge page. */
+    ASSERT((p_edges = malloc(sizeof(weighted_edge) * EDGE_COUNT)));
+    seed = 4242;
+
+    for (i = 0; i < EDGE_COUNT; ++i)
+    {
+        seed = seed * 1103515245U + 12345U;
+        p_edges[i].tail = (seed >> 8) % NODE_COUNT;
+        seed = seed * 1103515245U + 12345U;
+        p_edges[i].head = (seed >> 8) % NODE_COUNT;
+        p_edges[i].weight = (double)(i % 50 + 1);
+    }
+
+    ASSERT((p_graph = edge_list_build(p_edges,
+                                      EDGE_COUNT,
+                                      NODE_COUNT,
+                                      WEIGHT_FORMAT_FLOAT,
+                                      1.0,
+                                      2)));
+    free(p_edges);
+
+    p_before = compact_dijkstra(p_graph, 0, NODE_COUNT - 1);
+    ASSERT(compact_graph_place_arrays(p_graph, LARGE_ARRAY_INTERLEAVED));
+    ASSERT(compact_graph_place_arrays(p_graph, LARGE_ARRAY_INTERLEAVED));
+    p_after = compact_dijkstra(p_graph, 0, NODE_COUNT - 1);
+
+    ASSERT(compact_path_size(p_before) == compact_path_size(p_after));
+    ASSERT(compact_path_cost(p_before) == compact_path_cost(p_after));
+    ASSERT(compact_graph_reverse_offset(p_graph, NODE_COUNT) == EDGE_COUNT);
+
+    /* Placed arrays are final. */
+    ASSERT(!compact_graph_compress(p_graph));
+    ASSERT(!compact_graph_is_compressed(p_graph));
+
+    compact_path_free(p_before);
+    compact_path_free(p_after);
+    compact_graph_free(p_graph);
+}
+
+static void test_memory_usage_correctness()
+{
+    enum { COUNT = 100 };
+
+    static char                     names[COUNT][8];
+    directed_graph_node*            p_nodes[COUNT];
+    directed_graph_weight_function* p_weight_function;
+    unordered_map*                  p_map;
+    unordered_set*                  p_set;
+    list*                           p_list;
+    graph_data*                     p_data;
+    compact_graph*                  p_graph;
+    arena*                          p_scratch;
+    path*                           p_path;
+    memory_usage                    usage;
+    memory_usage                    total;
+    graph_memory_summary            summary;
+    size_t                          arc_count;
+    size_t                          i;
+
+    for (i = 0; i < COUNT; ++i)
+    {
+        sprintf(names[i], "m%lu", (unsigned long) i);
+        ASSERT((p_nodes[i] = directed_graph_node_alloc(names[i])));
+    }
+
+    p_map = unordered_map_alloc(16, 1.0f, hash_function, equals_function);
+    p_set = unordered_set_alloc(16, 1.0f, hash_function, equals_function);
+    p_list = list_alloc(16);
+
+    usage = unordered_map_memory_usage(p_map);
+    ASSERT(usage.live == 0 && usage.allocated > 0);
+
+    for (i = 0; i < COUNT; ++i)
+    {
+        unordered_map_put(p_map, p_nodes[i], p_nodes[i]);
+        unordered_set_add(p_set, p_nodes[i]);
+        list_push_back(p_list, p_nodes[i]);
+    }
+
+    /* The live part grows by one entry per element. */
+    usage = unordered_map_memory_usage(p_map);
+    ASSERT(usage.live > 0 && usage.live % COUNT == 0);
+    ASSERT(usage.allocated > usage.live);
+    usage = unordered_set_memory_usage(p_set);
+    ASSERT(usage.live > 0 && usage.live % COUNT == 0);
+    ASSERT(usage.allocated > usage.live);
+    usage = list_memory_usage(p_list);
+    ASSERT(usage.live == sizeof(void*) * COUNT);
+    ASSERT(usage.allocated >= usage.live);
+
+    unordered_map_clear(p_map);
+    ASSERT(unordered_map_memory_usage(p_map).live == 0);
+
+    unordered_map_free(p_map);
+    unordered_set_free(p_set);
+    list_free(p_list);
+
+    /* A star of arcs from the first node, 12 bytes each in a flat block. */
+    p_weight_function = directed_graph_weight_function_alloc_flat_format(
+                            hash_function,
+                            equals_function,
+                            WEIGHT_FORMAT_FLOAT,
+                            1.0);
+
+    for (i = 1; i < COUNT; ++i)
+    {
+        directed_graph_node_add_arc(p_nodes[0], p_nodes[i]);
+        directed_graph_weight_function_put(p_weight_function,
+                                           p_nodes[0],
+                                           p_nodes[i],
+                                           (double) i);
+    }
+
+    usage = directed_graph_node_memory_usage(p_nodes[0]);
+    ASSERT(usage.live == sizeof(directed_graph_node*) * (COUNT - 1));
+    ASSERT(usage.allocated > usage.live);
+    ASSERT(directed_graph_node_memory_usage(p_nodes[1]).live ==
+           sizeof(directed_graph_node*));
+
+    /* Besides the block, the tail has one live entry in the first level. */
+    usage = directed_graph_weight_function_memory_usage(p_weight_function);
+    ASSERT(usage.live > (sizeof(directed_graph_node*) + sizeof(float)) *
+                         (COUNT - 1));
+    ASSERT(usage.allocated > usage.live);
+
+    directed_graph_weight_function_free(p_weight_function);
+
+    for (i = 0; i < COUNT; ++i)
+    {
+        directed_graph_node_free(p_nodes[i]);
+    }
+
+    /* A search leaves its blocks in the scratch arena, but nothing live. */
+    ASSERT((p_data = create_random_graph(200, 800, 100.0, 100.0, 10.0)));
+    ASSERT((p_scratch = arena_alloc(0)));
+    p_path = dijkstra_with_arena(p_data->p_node_array[0],
+                                 p_data->p_node_array[1],
+                                 p_data->p_weight_function,
+                                 p_scratch);
+    ASSERT(p_path);
+    path_free(p_path);
+
+    arc_count = 0;
+
+    for (i = 0; i < 200; ++i)
+    {
+        arc_count += directed_graph_node_child_count(p_data->p_node_array[i]);
+    }
+
+    summary = graph_data_memory_summary(p_data, p_scratch);
+    ASSERT(summary.adjacency.live ==
+           2 * sizeof(directed_graph_node*) * arc_count);
+    ASSERT(summary.adjacency.allocated > summary.adjacency.live);
+    ASSERT(summary.names.live == string_pool_bytes(p_data->p_name_pool));
+    ASSERT(summary.coordinates.live >= sizeof(point_3d) * 200);
+    ASSERT(summary.search_scratch.allocated > 0);
+    ASSERT(summary.search_scratch.live == 0);
+
+    total = graph_memory_summary_total(&summary);
+    ASSERT(total.allocated >= total.live);
+    ASSERT(total.allocated ==
+           summary.adjacency.allocated + summary.weights.allocated +
+           summary.names.allocated + summary.coordinates.allocated +
+           summary.search_scratch.allocated);
+
+    arena_free(p_scratch);
+
+    ASSERT((p_graph = compact_graph_alloc(p_data->p_node_array,
+                                          200,
+                                          p_data->p_weight_function,
+                                          WEIGHT_FORMAT_FLOAT,
+                                          1.0)));
+    summary = compact_graph_memory_summary(p_graph);
+    ASSERT(summary.weights.allocated == sizeof(float) * arc_count);
+    ASSERT(summary.adjacency.allocated >=
+           sizeof(uint32_t) * (arc_count + 201));
+    ASSERT(summary.adjacency.live == summary.adjacency.allocated);
+    ASSERT(summary.search_scratch.allocated == 0);
+    compact_graph_free(p_graph);
+    graph_data_free(p_data);
+}
+
+static void test_benchmark_correctness()
+{
+    double           latencies[10];
+    benchmark_config config;
+    benchmark_result results[3];
+    benchmark_result repeated;
+    graph_memory_summary memory;
+    graph_data*      p_data;
+    compact_graph*   p_graph;
+    FILE*            p_file;
+    size_t           i;
+    double           start;
+
+    /* Nearest-rank percentiles of 10 latencies in shuffled order. */
+    for (i = 0; i < 10; ++i)
+    {
+        latencies[i] = (double)((i * 7) % 10 + 1);
+    }
+
+    ASSERT(benchmark_summarize(latencies, 10, 5.0, &results[0]));
+    ASSERT(results[0].queries == 10);
+    ASSERT(results[0].mean == 5.5);
+    ASSERT(results[0].median == 5.0);
+    ASSERT(results[0].p90 == 9.0);
+    ASSERT(results[0].p99 == 10.0);
+    ASSERT(results[0].max == 10.0);
+    ASSERT(results[0].queries_per_second == 2.0);
+    ASSERT(latencies[0] == 1.0 && latencies[9] == 10.0);
+    ASSERT(!benchmark_summarize(latencies, 0, 1.0, &results[0]));
+
+    start = benchmark_now();
+    ASSERT(benchmark_now() >= start);
+
+    ASSERT((p_data = create_random_graph(300, 1500, 100.0, 100.0, 10.0)));
+    ASSERT((p_graph = compact_graph_alloc(p_data->p_node_array,
+                                          300,
+                                          p_data->p_weight_function,
+                                          WEIGHT_FORMAT_DOUBLE,
+                                          1.0)));
+
+    config.seed = 7;
+    config.p_graph_file_name = NULL;
+    config.p_coordinate_file_name = NULL;
+    config.node_count = 300;
+    config.arc_count = 1500;
+    config.warmup_queries = 3;
+    config.measured_queries = 20;
+
+    /* All algorithms answer the same queries with paths of equal size. */
+    ASSERT(benchmark_run(p_data,
+                         NULL,
+                         BENCHMARK_DIJKSTRA,
+                         &config,
+                         &results[0]));
+    ASSERT(benchmark_run(p_data,
+                         NULL,
+                         BENCHMARK_DIJKSTRA_WITH_ARENA,
+                         &config,
+                         &results[1]));
+    ASSERT(benchmark_run(p_data,
+                         p_graph,
+                         BENCHMARK_COMPACT_DIJKSTRA,
+                         &config,
+                         &results[2]));
+    ASSERT(!benchmark_run(p_data,
+                          NULL,
+                          BENCHMARK_COMPACT_DIJKSTRA,
+                          &config,
+                          &repeated));
+
+    for (i = 0; i < 3; ++i)
+    {
+        ASSERT(results[i].queries == 20);
+        ASSERT(results[i].path_nodes == results[0].path_nodes);
+        ASSERT(results[i].median <= results[i].p90);
+        ASSERT(results[i].p90 <= results[i].p99);
+        ASSERT(results[i].p99 <= results[i].max);
+        ASSERT(results[i].queries_per_second > 0.0);
+    }
+
+    ASSERT(results[1].algorithm == BENCHMARK_DIJKSTRA_WITH_ARENA);
+
+    /* The same seed gives the same queries. */
+    ASSERT(benchmark_run(p_data,
+                         NULL,
+                         BENCHMARK_DIJKSTRA,
+                         &config,
+                         &repeated));
+    ASSERT(repeated.path_nodes == results[0].path_nodes);
+
+    config.measured_queries = 0;
+    ASSERT(!benchmark_run(p_data,
+                          NULL,
+                          BENCHMARK_DIJKSTRA,
+                          &config,
+                          &repeated));
+
+    memset(&memory, 0, sizeof(memory));
+
+    ASSERT((p_file = tmpfile()));
+    benchmark_write_json(p_file,
+                         &config,
+                         0.5,
+                         &memory,
+                         results,
+                         3);
+    ASSERT(ftell(p_file) > 0);
+    fclose(p_file);
+
+    compact_graph_free(p_graph);
+    graph_data_free(p_data);
+}
+
+
+static const size_t NODES = 20000;
+static const size_t EDGES = 20000 * 9;
+static const double MAXX = 10000.0;
+static const double MAXY = 10000.0;
+static const double MAXZ = 200.0;
+static const size_t WARMUP_QUERIES = 10;
+static const size_t MEASURED_QUERIES = 100;
+
+static void print_usage(const char* p_program_name)
+{
+    fprintf(stderr,
+            "Usage: %s [--seed N] [--nodes N] [--arcs N]\n"
+            "       [--graph FILE.gr [--coordinates FILE.co]]\n"
+            "       [--warmup N] [--queries N] [--output FILE.json]\n"
+            "       [--skip-tests]\n",
+            p_program_name);
+}
+
+/*******************************************************************************
+* Parses the decimal number 'p_text' into '*p_value'.                          *
+*******************************************************************************/
+static bool parse_number(const char* p_text, unsigned long* p_value)
+{
+    char* p_end;
+
+    if (*p_text < '0' || *p_text > '9') return false;
+
+    *p_value = strtoul(p_text, &p_end, 10);
+    return *p_end == '\0';
+}
+
+int main(int argc, char** argv) {
+    static const benchmark_algorithm ALGORITHMS[] = {
+        BENCHMARK_DIJKSTRA,
+        BENCHMARK_DIJKSTRA_WITH_ARENA,
+        BENCHMARK_COMPACT_DIJKSTRA
+    };
+
+    benchmark_config     config;
+    benchmark_result     results[3];
+    graph_memory_summary memory;
+    graph_data*          p_data;
+    compact_graph*       p_compact;
+    const char*          p_output_file_name;
+    FILE*                p_output;
+    unsigned long        value;
+    double               start;
+    double               build_seconds;
+    bool                 run_tests;
+    size_t               id;
+    int                  i;
+
+    config.seed = 1;
+    config.p_graph_file_name = NULL;
+    config.p_coordinate_file_name = NULL;
+    config.node_count = NODES;
+    config.arc_count = EDGES;
+    config.warmup_queries = WARMUP_QUERIES;
+    config.measured_queries = MEASURED_QUERIES;
+    p_output_file_name = NULL;
+    run_tests = true;
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--skip-tests") == 0)
+        {
+            run_tests = false;
+            continue;
+        }
+
+        if (i + 1 == argc)
+        {
+            print_usage(argv[0]);
+            return (EXIT_FAILURE);
+        }
+
+        if (strcmp(argv[i], "--graph") == 0)
+        {
+            config.p_graph_file_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "--coordinates") == 0)
+        {
+            config.p_coordinate_file_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "--output") == 0)
+        {
+            p_output_file_name = argv[++i];
+        }
+        else if (!parse_number(argv[i + 1], &value))
+        {
+            print_usage(argv[0]);
+            return (EXIT_FAILURE);
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            config.seed = value;
+            ++i;
+        }
+        else if (strcmp(argv[i], "--nodes") == 0)
+        {
+            config.node_count = value;
+            ++i;
+        }
+        else if (strcmp(argv[i], "--arcs") == 0)
+        {
+            config.arc_count = value;
+            ++i;
+        }
+        else if (strcmp(argv[i], "--warmup") == 0)
+        {
+            config.warmup_queries = value;
+            ++i;
+        }
+        else if (strcmp(argv[i], "--queries") == 0)
+        {
+            config.measured_queries = value;
+            ++i;
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return (EXIT_FAILURE);
+        }
+    }
+
+    if (config.p_coordinate_file_name && !config.p_graph_file_name)
+    {
+        print_usage(argv[0]);
+        return (EXIT_FAILURE);
+    }
+
+    /* The tests draw from 'rand' as well; the graph gets a fresh seed. */
+    if (run_tests)
+    {
+        srand((unsigned) config.seed);
+
+        test_directed_graph_node_correctness();
+        test_directed_graph_node_high_degree_correctness();
+        test_hash_container_bulk_correctness();
+        test_batched_lookup_correctness();
+        test_list_correctness();
+        test_typed_containers_correctness();
+        test_weight_function_correctness();
+        test_concurrent_weight_function_correctness();
+        test_concurrent_weight_function_threads_correctness();
+        test_flat_weight_function_correctness();
+        test_decoded_weight_threads_correctness();
+        test_computed_weight_function_correctness();
+        test_weight_update_batch_correctness();
+        test_dijkstra_correctness();
+        test_compact_dijkstra_correctness();
+        test_weight_profile_correctness();
+        test_dimacs_load_correctness();
+        test_dimacs_load_scale_correctness();
+        test_compact_graph_validate_correctness();
+        test_compact_graph_file_correctness();
+        test_compact_graph_compression_correctness();
+        test_edge_list_correctness();
+        test_name_index_correctness();
+        test_artifact_file_correctness();
+        test_node_order_correctness();
+        test_arena_correctness();
+        test_forward_only_correctness();
+        test_large_array_correctness();
+        test_memory_usage_correctness();
+        test_benchmark_correctness();
+    }
+
+    srand((unsigned) config.seed);
+    start = benchmark_now();
+
+    if (config.p_graph_file_name)
+    {
+        p_data = dimacs_load(config.p_graph_file_name,
+                             config.p_coordinate_file_name);
+    }
+    else
+    {
+        p_data = create_random_graph(config.node_count,
+                                     config.arc_count,
+                                     MAXX,
+                                     MAXY,
+                                     MAXZ);
+    }
+
+    build_seconds = benchmark_now() - start;
+
+    if (!p_data)
+    {
+        fprintf(stderr, "Could not build the graph.\n");
+        return (EXIT_FAILURE);
+    }
+
+    config.node_count = p_data->node_count;
+    config.arc_count = 0;
+
+    for (id = 0; id < p_data->node_count; ++id)
+    {
+        config.arc_count +=
+            directed_graph_node_child_count(p_data->p_node_array[id]);
+    }
+
+    memory = graph_data_memory_summary(p_data, NULL);
+
+    if (!(p_compact = compact_graph_alloc(p_data->p_node_array,
+                                          p_data->node_count,
+                                          p_data->p_weight_function,
+                                          WEIGHT_FORMAT_DOUBLE,
+                                          1.0)))
+    {
+        fprintf(stderr, "Could not build the compact graph.\n");
+        return (EXIT_FAILURE);
+    }
+
+    for (i = 0; i < 3; ++i)
+    {
+        if (!benchmark_run(p_data,
+                           p_compact,
+                           ALGORITHMS[i],
+                           &config,
+                           &results[i]))
+        {
+            fprintf(stderr,
+                    "Could not run %s.\n",
+                    benchmark_algorithm_name(ALGORITHMS[i]));
+            return (EXIT_FAILURE);
+        }
+    }
+
+    if (!p_output_file_name)
+    {
+        p_output = stdout;
+    }
+    else if (!(p_output = fopen(p_output_file_name, "w")))
+    {
+        fprintf(stderr, "Could not open '%s'.\n", p_output_file_name);
+        return (EXIT_FAILURE);
+    }
+
+    benchmark_write_json(p_output,
+                         &config,
+                         build_seconds,
+                         &memory,
+                         results,
+                         3);
+
+    if (p_output != stdout)
+    {
+        fclose(p_output);
+    }
 
+    compact_graph_free(p_compact);
+    graph_data_free(p_data);
     return (EXIT_SUCCESS);
 }
@@ -0,0 +1,40 @@
+#include "memory_usage.h"
+
+static void print_row(FILE* p_file, const char* p_category, memory_usage usage)
+{
+    fprintf(p_file,
+            "%-16s %14lu %14lu\n",
+            p_category,
+            (unsigned long) usage.allocated,
+            (unsigned long) usage.live);
+}
+
+void memory_usage_add(memory_usage* p_total, memory_usage usage)
+{
+    p_total->allocated += usage.allocated;
+    p_total->live += usage.live;
+}
+
+memory_usage graph_memory_summary_total(const graph_memory_summary* p_summary)
+{
+    memory_usage total = { 0, 0 };
+
+    memory_usage_add(&total, p_summary->adjacency);
+    memory_usage_add(&total, p_summary->weights);
+    memory_usage_add(&total, p_summary->names);
+    memory_usage_add(&total, p_summary->coordinates);
+    memory_usage_add(&total, p_summary->search_scratch);
+    return total;
+}
+
+void graph_memory_summary_print(const graph_memory_summary* p_summary,
+                                FILE* p_file)
+{
+    fprintf(p_file, "%-16s %14s %14s\n", "Category", "Allocated", "Live");
+    print_row(p_file, "Adjacency", p_summary->adjacency);
+    print_row(p_file, "Weights", p_summary->weights);
+    print_row(p_file, "Names", p_summary->names);
+    print_row(p_file, "Coordinates", p_summary->coordinates);
+    print_row(p_file, "Search scratch", p_summary->search_scratch);
+    print_row(p_file, "Total", graph_memory_summary_total(p_summary));
+}
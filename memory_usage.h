@@ -0,0 +1,59 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * The memory taken by a structure. 'allocated' is the amount of bytes it   *
+    * has obtained from 'malloc' or from an arena and still holds, and 'live'  *
+    * the part of them holding the elements stored right now; the rest goes to *
+    * headers, empty buckets, spare capacity and entries kept for reuse. The   *
+    * bookkeeping of 'malloc' is not counted, nor is memory the elements point *
+    * to unless the structure owns it.                                         *
+    ***************************************************************************/
+    typedef struct memory_usage {
+        size_t allocated;
+        size_t live;
+    } memory_usage;
+
+    /***************************************************************************
+    * The memory taken by a graph, by what it is spent on.                     *
+    ***************************************************************************/
+    typedef struct graph_memory_summary {
+        /* The nodes and their arcs, or the offsets and the heads. */
+        memory_usage adjacency;
+        memory_usage weights;
+        memory_usage names;
+        memory_usage coordinates;
+
+        /* The memory kept by a search between queries. */
+        memory_usage search_scratch;
+    } graph_memory_summary;
+
+    /***************************************************************************
+    * Adds 'usage' to '*p_total'.                                              *
+    ***************************************************************************/
+    void memory_usage_add(memory_usage* p_total, memory_usage usage);
+
+    /***************************************************************************
+    * Returns the sum of all the categories of the summary.                    *
+    ***************************************************************************/
+    memory_usage graph_memory_summary_total(
+                     const graph_memory_summary* p_summary);
+
+    /***************************************************************************
+    * Prints the summary to 'p_file' as a table of one category per line.      *
+    ***************************************************************************/
+    void graph_memory_summary_print(const graph_memory_summary* p_summary,
+                                    FILE* p_file);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* MEMORY_USAGE_H */
@@ -0,0 +1,428 @@
+#include "name_index.h"
+#include "string_pool.h"
+#include "typed_common.h"
+#include <string.h>
+
+/*******************************************************************************
+* The average amount of names per bucket. Fewer names per bucket make the      *
+* function faster to find but take more displacements to store.                *
+*******************************************************************************/
+#define NAMES_PER_BUCKET 3
+
+/*******************************************************************************
+* The amount of names per spare slot. With no spare slot, the last buckets     *
+* placed search for the few slots still free, which takes about as many        *
+* displacements as there are names. With one slot in a hundred free, that      *
+* search stays short for any amount of names.                                  *
+*******************************************************************************/
+#define NAMES_PER_SPARE_SLOT 99
+
+/*******************************************************************************
+* The amount of seeds tried before giving up.                                  *
+*******************************************************************************/
+#define MAX_SEEDS 16
+
+typedef struct name_index_state {
+    uint32_t     count;
+    uint32_t     slot_count;
+    uint32_t     bucket_count;
+    uint32_t     max_displacements;
+    uint64_t     seed;
+    uint32_t*    p_displacements;
+    uint32_t*    p_slot_ids;
+    const char** p_names;
+} name_index_state;
+
+typedef enum build_result {
+    BUILD_DONE,
+    BUILD_RETRY,
+    BUILD_FAILED
+} build_result;
+
+/*******************************************************************************
+* The temporary arrays of the search: the hash value of each name, the ids of  *
+* the names grouped by bucket, the buckets by decreasing size, and the slots   *
+* taken so far.                                                                *
+*******************************************************************************/
+typedef struct build_workspace {
+    uint64_t*      p_hashes;
+    uint32_t*      p_bucket_offsets;
+    uint32_t*      p_bucket_ids;
+    uint32_t*      p_order;
+    uint32_t*      p_size_counts;
+    uint32_t*      p_bucket_slots;
+    unsigned char* p_taken;
+} build_workspace;
+
+static uint32_t bucket_of(uint64_t hash, uint32_t bucket_count)
+{
+    return (uint32_t)((hash >> 32) % bucket_count);
+}
+
+static uint32_t slot_of(uint64_t hash, uint32_t displacement, uint32_t count)
+{
+    return (uint32_t)(typed_hash_u64(hash + 0x9e3779b97f4a7c15ULL *
+                                     ((uint64_t) displacement + 1)) % count);
+}
+
+/*******************************************************************************
+* Groups the ids of the names by bucket, and orders the buckets by decreasing  *
+* size. Returns the size of the largest bucket.                                *
+*******************************************************************************/
+static uint32_t fill_buckets(name_index_state* p_state,
+                             build_workspace* p_workspace)
+{
+    uint32_t bucket;
+    uint32_t max_size;
+    uint32_t size;
+    uint32_t position;
+    uint32_t tmp;
+    uint32_t i;
+
+    memset(p_workspace->p_bucket_offsets,
+           0,
+           sizeof(uint32_t) * (p_state->bucket_count + 1));
+
+    for (i = 0; i < p_state->count; ++i)
+    {
+        bucket = bucket_of(p_workspace->p_hashes[i], p_state->bucket_count);
+        p_workspace->p_bucket_offsets[bucket + 1]++;
+    }
+
+    max_size = 0;
+
+    for (bucket = 0; bucket < p_state->bucket_count; ++bucket)
+    {
+        size = p_workspace->p_bucket_offsets[bucket + 1];
+
+        if (size > max_size) max_size = size;
+
+        p_workspace->p_bucket_offsets[bucket + 1] +=
+            p_workspace->p_bucket_offsets[bucket];
+        p_workspace->p_order[bucket] = p_workspace->p_bucket_offsets[bucket];
+    }
+
+    for (i = 0; i < p_state->count; ++i)
+    {
+        bucket = bucket_of(p_workspace->p_hashes[i], p_state->bucket_count);
+        p_workspace->p_bucket_ids[p_workspace->p_order[bucket]++] = i;
+    }
+
+    /* Counting sort of the buckets by size, the largest ones first. */
+    memset(p_workspace->p_size_counts, 0, sizeof(uint32_t) * (max_size + 1));
+
+    for (bucket = 0; bucket < p_state->bucket_count; ++bucket)
+    {
+        p_workspace->p_size_counts[p_workspace->p_bucket_offsets[bucket + 1] -
+                                   p_workspace->p_bucket_offsets[bucket]]++;
+    }
+
+    position = 0;
+
+    for (size = max_size + 1; size > 0; --size)
+    {
+        tmp = p_workspace->p_size_counts[size - 1];
+        p_workspace->p_size_counts[size - 1] = position;
+        position += tmp;
+    }
+
+    for (bucket = 0; bucket < p_state->bucket_count; ++bucket)
+    {
+        size = p_workspace->p_bucket_offsets[bucket + 1] -
+               p_workspace->p_bucket_offsets[bucket];
+        p_workspace->p_order[p_workspace->p_size_counts[size]++] = bucket;
+    }
+
+    return max_size;
+}
+
+/*******************************************************************************
+* Tries to find a displacement for the bucket 'bucket' placing all its names   *
+* into free slots, and takes the slots.                                        *
+*******************************************************************************/
+static build_result place_bucket(name_index_state* p_state,
+                                 build_workspace* p_workspace,
+                                 uint32_t bucket)
+{
+    const uint32_t* p_ids;
+    uint32_t        size;
+    uint32_t        displacement;
+    uint32_t        slot;
+    uint32_t        i;
+    uint32_t        j;
+
+    p_ids = p_workspace->p_bucket_ids + p_workspace->p_bucket_offsets[bucket];
+    size = p_workspace->p_bucket_offsets[bucket + 1] -
+           p_workspace->p_bucket_offsets[bucket];
+
+    /* Names of equal hash values never get apart, and equal names are an
+       error. */
+    for (i = 0; i < size; ++i)
+    {
+        for (j = i + 1; j < size; ++j)
+        {
+            if (p_workspace->p_hashes[p_ids[i]] !=
+                p_workspace->p_hashes[p_ids[j]])
+            {
+                continue;
+            }
+
+            return strcmp(p_state->p_names[p_ids[i]],
+                          p_state->p_names[p_ids[j]]) == 0
+                   ? BUILD_FAILED
+                   : BUILD_RETRY;
+        }
+    }
+
+    for (displacement = 0;
+         displacement < p_state->max_displacements;
+         ++displacement)
+    {
+        for (i = 0; i < size; ++i)
+        {
+            slot = slot_of(p_workspace->p_hashes[p_ids[i]],
+                           displacement,
+                           p_state->slot_count);
+
+            if (p_workspace->p_taken[slot]) break;
+
+            p_workspace->p_taken[slot] = 1;
+            p_workspace->p_bucket_slots[i] = slot;
+        }
+
+        if (i == size)
+        {
+            for (i = 0; i < size; ++i)
+            {
+                p_state->p_slot_ids[p_workspace->p_bucket_slots[i]] = p_ids[i];
+            }
+
+            p_state->p_displacements[bucket] = displacement;
+            return BUILD_DONE;
+        }
+
+        while (i > 0)
+        {
+            p_workspace->p_taken[p_workspace->p_bucket_slots[--i]] = 0;
+        }
+    }
+
+    return BUILD_RETRY;
+}
+
+static build_result build_function(name_index_state* p_state,
+                                   build_workspace* p_workspace)
+{
+    build_result result;
+    uint32_t     max_size;
+    uint32_t     bucket;
+    uint32_t     i;
+
+    for (i = 0; i < p_state->count; ++i)
+    {
+        p_workspace->p_hashes[i] = string_hash(p_state->p_names[i],
+                                               p_state->seed);
+    }
+
+    max_size = fill_buckets(p_state, p_workspace);
+
+    if (!(p_workspace->p_bucket_slots = malloc(sizeof(uint32_t) *
+                                               (max_size + 1))))
+    {
+        return BUILD_FAILED;
+    }
+
+    memset(p_workspace->p_taken, 0, p_state->slot_count);
+    result = BUILD_DONE;
+
+    for (i = 0; i < p_state->bucket_count && result == BUILD_DONE; ++i)
+    {
+        bucket = p_workspace->p_order[i];
+        p_state->p_displacements[bucket] = 0;
+
+        if (p_workspace->p_bucket_offsets[bucket + 1] >
+            p_workspace->p_bucket_offsets[bucket])
+        {
+            result = place_bucket(p_state, p_workspace, bucket);
+        }
+    }
+
+    free(p_workspace->p_bucket_slots);
+    return result;
+}
+
+/*******************************************************************************
+* Builds the index over the names 'p_names', which the index takes over,       *
+* trying at most 'max_displacements' displacements per bucket and seed.        *
+*******************************************************************************/
+static name_index* build_index(const char** p_names,
+                               uint32_t count,
+                               uint32_t max_displacements)
+{
+    name_index*       p_index;
+    name_index_state* p_state;
+    build_workspace   workspace;
+    build_result      result;
+    uint32_t          seed;
+
+    if (!(p_index = malloc(sizeof(*p_index))))
+    {
+        free(p_names);
+        return NULL;
+    }
+
+    if (!(p_state = calloc(1, sizeof(*p_state))))
+    {
+        free(p_names);
+        free(p_index);
+        return NULL;
+    }
+
+    p_index->state = p_state;
+    p_state->p_names = p_names;
+    p_state->count = count;
+    p_state->slot_count =
+        count < UINT32_MAX - count / NAMES_PER_SPARE_SLOT - 1
+        ? count + count / NAMES_PER_SPARE_SLOT + 1
+        : UINT32_MAX;
+    p_state->bucket_count = count / NAMES_PER_BUCKET + 1;
+    p_state->max_displacements = max_displacements;
+
+    p_state->p_displacements = malloc(sizeof(uint32_t) *
+                                      p_state->bucket_count);
+
+    /* The spare slots keep id 0, whose name does not match what lands
+       there. */
+    p_state->p_slot_ids = calloc(p_state->slot_count, sizeof(uint32_t));
+
+    workspace.p_hashes = malloc(sizeof(uint64_t) * (count + 1));
+    workspace.p_bucket_offsets = malloc(sizeof(uint32_t) *
+                                        (p_state->bucket_count + 1));
+    workspace.p_bucket_ids = malloc(sizeof(uint32_t) * (count + 1));
+    workspace.p_order = malloc(sizeof(uint32_t) * p_state->bucket_count);
+    workspace.p_size_counts = malloc(sizeof(uint32_t) * (count + 2));
+    workspace.p_taken = malloc(p_state->slot_count);
+
+    result = BUILD_FAILED;
+
+    if (p_state->p_displacements  && p_state->p_slot_ids      &&
+        workspace.p_hashes        && workspace.p_bucket_offsets &&
+        workspace.p_bucket_ids    && workspace.p_order          &&
+        workspace.p_size_counts   && workspace.p_taken)
+    {
+        result = BUILD_RETRY;
+
+        for (seed = 0; seed < MAX_SEEDS && result == BUILD_RETRY; ++seed)
+        {
+            p_state->seed = 0x9e3779b97f4a7c15ULL * (seed + 1);
+            result = build_function(p_state, &workspace);
+        }
+    }
+
+    free(workspace.p_hashes);
+    free(workspace.p_bucket_offsets);
+    free(workspace.p_bucket_ids);
+    free(workspace.p_order);
+    free(workspace.p_size_counts);
+    free(workspace.p_taken);
+
+    if (result != BUILD_DONE)
+    {
+        name_index_free(p_index);
+        return NULL;
+    }
+
+    return p_index;
+}
+
+name_index* name_index_alloc(const char* const* p_names, uint32_t count)
+{
+    return name_index_alloc_with_limit(p_names,
+                                       count,
+                                       NAME_INDEX_MAX_DISPLACEMENTS);
+}
+
+name_index* name_index_alloc_with_limit(const char* const* p_names,
+                                        uint32_t count,
+                                        uint32_t max_displacements)
+{
+    const char** p_copy;
+
+    if (!p_names && count > 0)          return NULL;
+    if (count == NAME_INDEX_NOT_FOUND) return NULL;
+
+    if (!(p_copy = malloc(sizeof(char*) * (count + 1)))) return NULL;
+
+    if (count > 0)
+    {
+        memcpy(p_copy, p_names, sizeof(char*) * count);
+    }
+
+    return build_index(p_copy, count, max_displacements);
+}
+
+name_index* name_index_alloc_from_graph(compact_graph* p_graph)
+{
+    const char** p_names;
+    uint32_t     count;
+    uint32_t     id;
+
+    if (!p_graph) return NULL;
+
+    count = compact_graph_node_count(p_graph);
+
+    if (!(p_names = malloc(sizeof(char*) * (count + 1)))) return NULL;
+
+    for (id = 0; id < count; ++id)
+    {
+        if (!(p_names[id] = compact_graph_name(p_graph, id)))
+        {
+            free(p_names);
+            return NULL;
+        }
+    }
+
+    return build_index(p_names, count, NAME_INDEX_MAX_DISPLACEMENTS);
+}
+
+uint32_t name_index_get(name_index* p_index, const char* p_name)
+{
+    name_index_state* p_state;
+    uint64_t          hash;
+    uint32_t          displacement;
+    uint32_t          id;
+
+    if (!p_index || !p_name) return NAME_INDEX_NOT_FOUND;
+
+    p_state = p_index->state;
+
+    if (p_state->count == 0) return NAME_INDEX_NOT_FOUND;
+
+    hash = string_hash(p_name, p_state->seed);
+    displacement = p_state->p_displacements[bucket_of(hash,
+                                                      p_state->bucket_count)];
+    id = p_state->p_slot_ids[slot_of(hash,
+                                     displacement,
+                                     p_state->slot_count)];
+
+    /* A name not in the index lands on the slot of some other name. */
+    return strcmp(p_state->p_names[id], p_name) == 0
+           ? id
+           : NAME_INDEX_NOT_FOUND;
+}
+
+uint32_t name_index_size(name_index* p_index)
+{
+    return p_index ? p_index->state->count : 0;
+}
+
+void name_index_free(name_index* p_index)
+{
+    if (!p_index) return;
+
+    free(p_index->state->p_displacements);
+    free(p_index->state->p_slot_ids);
+    free((void*) p_index->state->p_names);
+    free(p_index->state);
+    free(p_index);
+}
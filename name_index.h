@@ -0,0 +1,76 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include "compact_graph.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+* Returned by 'name_index_get' for a name not in the index.                    *
+*******************************************************************************/
+#define NAME_INDEX_NOT_FOUND UINT32_MAX
+
+/*******************************************************************************
+* The amount of displacements 'name_index_alloc' tries per bucket before       *
+* starting over with another hash function.                                    *
+*******************************************************************************/
+#define NAME_INDEX_MAX_DISPLACEMENTS (1U << 24)
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * A static index from the names of nodes to their ids, based on a perfect  *
+    * hash function: each of the 'n' names hashes to its own slot out of about *
+    * 'n / 0.99', so a lookup takes two hash evaluations and one comparison of *
+    * names, without probing. The function is found by hash and displace: the  *
+    * names are grouped into buckets, and the buckets, largest first, are each *
+    * given the first displacement placing all their names in free slots.      *
+    ***************************************************************************/
+    typedef struct name_index {
+        struct name_index_state* state;
+    } name_index;
+
+    /***************************************************************************
+    * Builds the index of the 'count' names in 'p_names', name 'i' having id   *
+    * 'i'. The names are not copied and must outlive the index. Returns NULL   *
+    * if two names are equal or memory runs out.                               *
+    ***************************************************************************/
+    name_index* name_index_alloc(const char* const* p_names, uint32_t count);
+
+    /***************************************************************************
+    * Like 'name_index_alloc', trying at most 'max_displacements'              *
+    * displacements per bucket instead of 'NAME_INDEX_MAX_DISPLACEMENTS'.      *
+    * Also returns NULL if no function is found within that limit.             *
+    ***************************************************************************/
+    name_index* name_index_alloc_with_limit(const char* const* p_names,
+                                            uint32_t count,
+                                            uint32_t max_displacements);
+
+    /***************************************************************************
+    * Builds the index of the names of the nodes of the compact graph. Returns *
+    * NULL if the graph has no names, two names are equal or memory runs out.  *
+    ***************************************************************************/
+    name_index* name_index_alloc_from_graph(compact_graph* p_graph);
+
+    /***************************************************************************
+    * Returns the id of the name 'p_name', or 'NAME_INDEX_NOT_FOUND'.          *
+    ***************************************************************************/
+    uint32_t name_index_get(name_index* p_index, const char* p_name);
+
+    /***************************************************************************
+    * Returns the amount of names in the index.                                *
+    ***************************************************************************/
+    uint32_t name_index_size(name_index* p_index);
+
+    /***************************************************************************
+    * Deallocates the index. The names are not touched.                        *
+    ***************************************************************************/
+    void name_index_free(name_index* p_index);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* NAME_INDEX_H */
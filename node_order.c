@@ -0,0 +1,576 @@
+#include "node_order.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+* The resolution of the Hilbert curve: the coordinates are mapped into a grid  *
+* of 2^HILBERT_BITS cells along each axis.                                     *
+*******************************************************************************/
+#define HILBERT_BITS 16
+
+/*******************************************************************************
+* A node together with the quantity it is sorted by.                           *
+*******************************************************************************/
+typedef struct keyed_node {
+    uint64_t key;
+    uint32_t id;
+} keyed_node;
+
+static int keyed_node_cmp(const void* pa, const void* pb)
+{
+    const keyed_node* p_a = pa;
+    const keyed_node* p_b = pb;
+
+    if (p_a->key != p_b->key) return p_a->key < p_b->key ? -1 : 1;
+    if (p_a->id != p_b->id)   return p_a->id < p_b->id ? -1 : 1;
+
+    return 0;
+}
+
+/*******************************************************************************
+* Returns the position of the cell '(x, y)' along the Hilbert curve filling    *
+* the grid.                                                                    *
+*******************************************************************************/
+static uint64_t hilbert_index(uint32_t x, uint32_t y)
+{
+    uint64_t index;
+    uint32_t s;
+    uint32_t rx;
+    uint32_t ry;
+    uint32_t t;
+
+    index = 0;
+
+    for (s = 1U << (HILBERT_BITS - 1); s > 0; s >>= 1)
+    {
+        rx = (x & s) != 0;
+        ry = (y & s) != 0;
+        index += (uint64_t) s * s * ((3 * rx) ^ ry);
+
+        /* Rotates the quadrant so that the curve inside it starts and ends
+           where the curve of the whole grid does. */
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+
+            t = x;
+            x = y;
+            y = t;
+        }
+    }
+
+    return index;
+}
+
+static uint32_t grid_cell(double value, double min, double max)
+{
+    if (!(max > min)) return 0;
+
+    return (uint32_t)((value - min) / (max - min) *
+                      ((1U << HILBERT_BITS) - 1));
+}
+
+static bool hilbert_order(compact_graph* p_graph, uint32_t* p_order)
+{
+    const point_3d* p_points;
+    keyed_node*     p_keyed;
+    uint32_t        node_count;
+    uint32_t        id;
+    double          min_x;
+    double          max_x;
+    double          min_y;
+    double          max_y;
+
+    if (!(p_points = compact_graph_points(p_graph))) return false;
+
+    node_count = compact_graph_node_count(p_graph);
+
+    if (!(p_keyed = malloc(sizeof(keyed_node) * ((size_t) node_count + 1))))
+    {
+        return false;
+    }
+
+    min_x = max_x = node_count > 0 ? p_points[0].x : 0.0;
+    min_y = max_y = node_count > 0 ? p_points[0].y : 0.0;
+
+    for (id = 1; id < node_count; ++id)
+    {
+        if (p_points[id].x < min_x) min_x = p_points[id].x;
+        if (p_points[id].x > max_x) max_x = p_points[id].x;
+        if (p_points[id].y < min_y) min_y = p_points[id].y;
+        if (p_points[id].y > max_y) max_y = p_points[id].y;
+    }
+
+    for (id = 0; id < node_count; ++id)
+    {
+        p_keyed[id].id = id;
+        p_keyed[id].key =
+            hilbert_index(grid_cell(p_points[id].x, min_x, max_x),
+                          grid_cell(p_points[id].y, min_y, max_y));
+    }
+
+    qsort(p_keyed, node_count, sizeof(keyed_node), keyed_node_cmp);
+
+    for (id = 0; id < node_count; ++id)
+    {
+        p_order[id] = p_keyed[id].id;
+    }
+
+    free(p_keyed);
+    return true;
+}
+
+/*******************************************************************************
+* Builds the undirected adjacency of the graph: each arc is listed at both of  *
+* its end nodes. The neighbours of node 'i' are 'p_neighbours[p_offsets[i]]'   *
+* to 'p_neighbours[p_offsets[i + 1] - 1]'.                                     *
+*******************************************************************************/
+static bool undirected_adjacency(compact_graph* p_graph,
+                                 size_t** pp_offsets,
+                                 uint32_t** pp_neighbours)
+{
+    compact_arc_iterator arcs;
+    size_t*              p_offsets;
+    uint32_t*            p_neighbours;
+    uint32_t             node_count;
+    uint32_t             id;
+    uint32_t             head;
+    size_t               arc;
+
+    node_count = compact_graph_node_count(p_graph);
+
+    p_offsets = calloc((size_t) node_count + 2, sizeof(size_t));
+    p_neighbours = malloc(sizeof(uint32_t) *
+                          (2 * compact_graph_arc_count(p_graph) + 1));
+
+    if (!p_offsets || !p_neighbours)
+    {
+        free(p_offsets);
+        free(p_neighbours);
+        return false;
+    }
+
+    /* Counts the neighbours of node 'i' at 'p_offsets[i + 2]', so that after
+       the prefix sum 'p_offsets[i + 1]' is where they are written. */
+    for (id = 0; id < node_count; ++id)
+    {
+        compact_graph_arcs(p_graph, id, &arcs);
+
+        while (compact_arc_iterator_next(&arcs, &arc, &head))
+        {
+            p_offsets[id + 2]++;
+            p_offsets[head + 2]++;
+        }
+    }
+
+    for (id = 2; id < node_count + 2; ++id)
+    {
+        p_offsets[id] += p_offsets[id - 1];
+    }
+
+    for (id = 0; id < node_count; ++id)
+    {
+        compact_graph_arcs(p_graph, id, &arcs);
+
+        while (compact_arc_iterator_next(&arcs, &arc, &head))
+        {
+            p_neighbours[p_offsets[id + 1]++] = head;
+            p_neighbours[p_offsets[head + 1]++] = id;
+        }
+    }
+
+    *pp_offsets = p_offsets;
+    *pp_neighbours = p_neighbours;
+    return true;
+}
+
+static size_t degree(const size_t* p_offsets, uint32_t id)
+{
+    return p_offsets[id + 1] - p_offsets[id];
+}
+
+/*******************************************************************************
+* Sorts the queued nodes 'p_queue[begin]' to 'p_queue[end - 1]' by degree,     *
+* breaking ties by id. The runs are as short as the degrees of road networks.  *
+*******************************************************************************/
+static void sort_by_degree(uint32_t* p_queue,
+                           size_t begin,
+                           size_t end,
+                           const size_t* p_offsets)
+{
+    uint32_t id;
+    size_t   i;
+    size_t   j;
+
+    for (i = begin + 1; i < end; ++i)
+    {
+        id = p_queue[i];
+
+        for (j = i; j > begin; --j)
+        {
+            if (degree(p_offsets, p_queue[j - 1]) < degree(p_offsets, id))
+            {
+                break;
+            }
+
+            if (degree(p_offsets, p_queue[j - 1]) == degree(p_offsets, id) &&
+                p_queue[j - 1] < id)
+            {
+                break;
+            }
+
+            p_queue[j] = p_queue[j - 1];
+        }
+
+        p_queue[j] = id;
+    }
+}
+
+static bool cuthill_mckee_order(compact_graph* p_graph,
+                                uint32_t* p_order,
+                                uint32_t* p_rank)
+{
+    keyed_node* p_starts;
+    size_t*     p_offsets;
+    uint32_t*   p_neighbours;
+    uint32_t    node_count;
+    uint32_t    id;
+    uint32_t    other;
+    size_t      queue_head;
+    size_t      queue_tail;
+    size_t      first;
+    size_t      neighbour;
+    size_t      i;
+
+    node_count = compact_graph_node_count(p_graph);
+
+    if (!undirected_adjacency(p_graph, &p_offsets, &p_neighbours))
+    {
+        return false;
+    }
+
+    if (!(p_starts = malloc(sizeof(keyed_node) * ((size_t) node_count + 1))))
+    {
+        free(p_offsets);
+        free(p_neighbours);
+        return false;
+    }
+
+    /* The candidates for starting a component, least degree first. */
+    for (id = 0; id < node_count; ++id)
+    {
+        p_starts[id].id = id;
+        p_starts[id].key = degree(p_offsets, id);
+        p_rank[id] = COMPACT_GRAPH_NO_NODE;
+    }
+
+    qsort(p_starts, node_count, sizeof(keyed_node), keyed_node_cmp);
+
+    /* The order doubles as the queue of the breadth-first search. */
+    queue_head = 0;
+    queue_tail = 0;
+
+    for (i = 0; i < node_count; ++i)
+    {
+        if (p_rank[p_starts[i].id] != COMPACT_GRAPH_NO_NODE) continue;
+
+        p_rank[p_starts[i].id] = (uint32_t) queue_tail;
+        p_order[queue_tail++] = p_starts[i].id;
+
+        while (queue_head < queue_tail)
+        {
+            id = p_order[queue_head++];
+            first = queue_tail;
+
+            for (neighbour = p_offsets[id];
+                 neighbour < p_offsets[id + 1];
+                 ++neighbour)
+            {
+                other = p_neighbours[neighbour];
+
+                if (p_rank[other] == COMPACT_GRAPH_NO_NODE)
+                {
+                    p_rank[other] = (uint32_t) queue_tail;
+                    p_order[queue_tail++] = other;
+                }
+            }
+
+            sort_by_degree(p_order, first, queue_tail, p_offsets);
+        }
+    }
+
+    free(p_starts);
+    free(p_offsets);
+    free(p_neighbours);
+    return true;
+}
+
+bool node_order_compute(compact_graph* p_graph,
+                        node_order_method method,
+                        uint32_t** pp_order,
+                        uint32_t** pp_rank)
+{
+    uint32_t* p_order;
+    uint32_t* p_rank;
+    uint32_t  node_count;
+    uint32_t  id;
+    bool      ok;
+
+    if (!p_graph || !pp_order || !pp_rank) return false;
+
+    if (method == NODE_ORDER_AUTOMATIC)
+    {
+        method = compact_graph_points(p_graph) ? NODE_ORDER_HILBERT
+                                               : NODE_ORDER_CUTHILL_MCKEE;
+    }
+
+    node_count = compact_graph_node_count(p_graph);
+
+    p_order = malloc(sizeof(uint32_t) * ((size_t) node_count + 1));
+    p_rank  = malloc(sizeof(uint32_t) * ((size_t) node_count + 1));
+
+    if (!p_order || !p_rank)
+    {
+        free(p_order);
+        free(p_rank);
+        return false;
+    }
+
+    switch (method)
+    {
+        case NODE_ORDER_HILBERT:
+            ok = hilbert_order(p_graph, p_order);
+            break;
+
+        case NODE_ORDER_CUTHILL_MCKEE:
+            ok = cuthill_mckee_order(p_graph, p_order, p_rank);
+            break;
+
+        default:
+            ok = false;
+            break;
+    }
+
+    if (!ok)
+    {
+        free(p_order);
+        free(p_rank);
+        return false;
+    }
+
+    for (id = 0; id < node_count; ++id)
+    {
+        p_rank[p_order[id]] = id;
+    }
+
+    *pp_order = p_order;
+    *pp_rank = p_rank;
+    return true;
+}
+
+/*******************************************************************************
+* Writes the reverse adjacency of the renumbered graph. 'p_arc_map' maps each  *
+* arc of the original graph to its index in the renumbered one.                *
+*******************************************************************************/
+static void permute_reverse(compact_graph* p_graph,
+                            const uint32_t* p_order,
+                            const uint32_t* p_rank,
+                            const size_t* p_arc_map,
+                            size_t* p_reverse_offsets,
+                            uint32_t* p_reverse_tails,
+                            size_t* p_reverse_arcs)
+{
+    const uint32_t* p_tails;
+    uint32_t        node_count;
+    uint32_t        id;
+    size_t          position;
+    size_t          arc;
+    size_t          arc_end;
+
+    p_tails = compact_graph_reverse_tails(p_graph);
+    node_count = compact_graph_node_count(p_graph);
+    position = 0;
+
+    for (id = 0; id < node_count; ++id)
+    {
+        p_reverse_offsets[id] = position;
+        arc_end = compact_graph_reverse_offset(p_graph, p_order[id] + 1);
+
+        for (arc = compact_graph_reverse_offset(p_graph, p_order[id]);
+             arc < arc_end;
+             ++arc, ++position)
+        {
+            p_reverse_tails[position] = p_rank[p_tails[arc]];
+            p_reverse_arcs[position] =
+                p_arc_map[compact_graph_reverse_arc(p_graph, arc)];
+        }
+    }
+
+    p_reverse_offsets[node_count] = position;
+}
+
+compact_graph* node_order_apply(compact_graph* p_graph,
+                                const uint32_t* p_order,
+                                const uint32_t* p_rank)
+{
+    compact_graph*        p_renumbered;
+    compact_arc_iterator  arcs;
+    const point_3d*       p_old_points;
+    const char*           p_old_weights;
+    size_t*               p_offsets;
+    uint32_t*             p_heads;
+    char*                 p_weights;
+    size_t*               p_arc_map;
+    size_t*               p_reverse_offsets;
+    uint32_t*             p_reverse_tails;
+    size_t*               p_reverse_arcs;
+    directed_graph_node** p_nodes;
+    point_3d*             p_points;
+    uint32_t              node_count;
+    uint32_t              id;
+    uint32_t              head;
+    size_t                arc_count;
+    size_t                weight_size;
+    size_t                arc;
+    size_t                position;
+    bool                  has_reverse;
+    bool                  ok;
+
+    if (!p_graph || !p_order || !p_rank) return NULL;
+
+    node_count = compact_graph_node_count(p_graph);
+    arc_count = compact_graph_arc_count(p_graph);
+    weight_size = weight_format_size(compact_graph_weight_format(p_graph));
+    p_old_weights = compact_graph_weights(p_graph);
+    p_old_points = compact_graph_points(p_graph);
+    has_reverse = compact_graph_reverse_offsets(p_graph) != NULL;
+
+    p_offsets = malloc(sizeof(size_t) * ((size_t) node_count + 1));
+    p_heads   = malloc(sizeof(uint32_t) * (arc_count + 1));
+    p_weights = malloc(weight_size * (arc_count + 1));
+    p_arc_map = NULL;
+    p_reverse_offsets = NULL;
+    p_reverse_tails = NULL;
+    p_reverse_arcs = NULL;
+    p_nodes = NULL;
+    p_points = NULL;
+
+    ok = p_offsets && p_heads && p_weights;
+
+    if (ok && has_reverse)
+    {
+        p_arc_map = malloc(sizeof(size_t) * (arc_count + 1));
+        p_reverse_offsets = malloc(sizeof(size_t) *
+                                   ((size_t) node_count + 1));
+        p_reverse_tails = malloc(sizeof(uint32_t) * (arc_count + 1));
+        p_reverse_arcs = malloc(sizeof(size_t) * (arc_count + 1));
+
+        ok = p_arc_map && p_reverse_offsets && p_reverse_tails &&
+             p_reverse_arcs;
+    }
+
+    if (ok && node_count > 0 && compact_graph_node(p_graph, 0))
+    {
+        ok = (p_nodes = malloc(sizeof(directed_graph_node*) *
+                               ((size_t) node_count + 1))) != NULL;
+    }
+
+    if (ok && p_old_points)
+    {
+        ok = (p_points = malloc(sizeof(point_3d) *
+                                ((size_t) node_count + 1))) != NULL;
+    }
+
+    if (!ok)
+    {
+        free(p_offsets);
+        free(p_heads);
+        free(p_weights);
+        free(p_arc_map);
+        free(p_reverse_offsets);
+        free(p_reverse_tails);
+        free(p_reverse_arcs);
+        free(p_nodes);
+        free(p_points);
+        return NULL;
+    }
+
+    position = 0;
+
+    for (id = 0; id < node_count; ++id)
+    {
+        p_offsets[id] = position;
+        compact_graph_arcs(p_graph, p_order[id], &arcs);
+
+        while (compact_arc_iterator_next(&arcs, &arc, &head))
+        {
+            p_heads[position] = p_rank[head];
+            memcpy(p_weights + weight_size * position,
+                   p_old_weights + weight_size * arc,
+                   weight_size);
+
+            if (p_arc_map)
+            {
+                p_arc_map[arc] = position;
+            }
+
+            ++position;
+        }
+
+        if (p_nodes)
+        {
+            p_nodes[id] = compact_graph_node(p_graph, p_order[id]);
+        }
+
+        if (p_points)
+        {
+            p_points[id] = p_old_points[p_order[id]];
+        }
+    }
+
+    p_offsets[node_count] = position;
+
+    if (has_reverse)
+    {
+        permute_reverse(p_graph,
+                        p_order,
+                        p_rank,
+                        p_arc_map,
+                        p_reverse_offsets,
+                        p_reverse_tails,
+                        p_reverse_arcs);
+        free(p_arc_map);
+    }
+
+    p_renumbered = compact_graph_adopt(
+                       node_count,
+                       arc_count,
+                       p_offsets,
+                       p_heads,
+                       p_weights,
+                       compact_graph_weight_format(p_graph),
+                       compact_graph_fixed_point_scale(p_graph),
+                       p_reverse_offsets,
+                       p_reverse_tails,
+                       p_reverse_arcs);
+
+    if (!p_renumbered)
+    {
+        free(p_offsets);
+        free(p_heads);
+        free(p_weights);
+        free(p_reverse_offsets);
+        free(p_reverse_tails);
+        free(p_reverse_arcs);
+        free(p_nodes);
+        free(p_points);
+        return NULL;
+    }
+
+    compact_graph_adopt_node_data(p_renumbered, p_nodes, p_points);
+    return p_renumbered;
+}
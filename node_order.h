@@ -0,0 +1,60 @@
+#ifndef NODE_ORDER_H
+#define NODE_ORDER_H
+
+#include "compact_graph.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * The ways of numbering the nodes of a compact graph so that nodes close   *
+    * to each other in the graph get close ids, and thus their offsets, arcs   *
+    * and search state share cache lines.                                      *
+    ***************************************************************************/
+    typedef enum node_order_method {
+        /* Hilbert order if the graph has coordinates, Cuthill-McKee order
+           otherwise. */
+        NODE_ORDER_AUTOMATIC,
+
+        /* The order of the nodes along a Hilbert curve over their x- and
+           y-coordinates. The z-coordinate is ignored. */
+        NODE_ORDER_HILBERT,
+
+        /* Breadth-first order over the arcs taken in both directions,
+           starting each component at a node of least degree and visiting
+           the neighbours of a node by increasing degree. */
+        NODE_ORDER_CUTHILL_MCKEE
+    } node_order_method;
+
+    /***************************************************************************
+    * Computes a new numbering of the nodes of 'p_graph' by 'method'. On       *
+    * success stores into '*pp_order' a new array holding for each new id the  *
+    * old id of the node, and into '*pp_rank' its inverse, holding for each    *
+    * old id the new id. Returns false if the Hilbert order is requested for a *
+    * graph without coordinates or memory runs out.                            *
+    ***************************************************************************/
+    bool node_order_compute(compact_graph* p_graph,
+                            node_order_method method,
+                            uint32_t** pp_order,
+                            uint32_t** pp_rank);
+
+    /***************************************************************************
+    * Returns a copy of 'p_graph' with its nodes renumbered: node 'p_order[i]' *
+    * of 'p_graph' becomes node 'i', and 'p_rank' is the inverse of 'p_order'. *
+    * The arcs of each node keep their order and weights; the reverse          *
+    * adjacency, the coordinates and the original nodes are carried over when  *
+    * the graph has them. Names of a graph mapped from a file are not. The     *
+    * copy stores its heads plainly. Returns NULL if memory runs out.          *
+    ***************************************************************************/
+    compact_graph* node_order_apply(compact_graph* p_graph,
+                                    const uint32_t* p_order,
+                                    const uint32_t* p_rank);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* NODE_ORDER_H */
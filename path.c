@@ -0,0 +1,106 @@
+#include "path.h"
+#include <stdlib.h>
+
+typedef struct path_state {
+    directed_graph_node** p_nodes;
+    size_t                size;
+    double                cost;
+} path_state;
+
+typedef struct compact_path_state {
+    uint32_t* p_ids;
+    size_t    size;
+    double    cost;
+} compact_path_state;
+
+path* path_alloc(size_t size, double cost)
+{
+    path* p_path;
+
+    if (!(p_path = malloc(sizeof(*p_path)))) return NULL;
+
+    /* Keep the nodes in the same block as the state. */
+    if (!(p_path->state = malloc(sizeof(path_state) +
+                                 sizeof(directed_graph_node*) * size)))
+    {
+        free(p_path);
+        return NULL;
+    }
+
+    p_path->state->p_nodes = (directed_graph_node**)(p_path->state + 1);
+    p_path->state->size = size;
+    p_path->state->cost = cost;
+    return p_path;
+}
+
+size_t path_size(path* p_path)
+{
+    return p_path ? p_path->state->size : 0;
+}
+
+directed_graph_node* path_get(path* p_path, size_t index)
+{
+    if (!p_path || index >= p_path->state->size) return NULL;
+
+    return p_path->state->p_nodes[index];
+}
+
+directed_graph_node** path_nodes(path* p_path)
+{
+    return p_path ? p_path->state->p_nodes : NULL;
+}
+
+double path_cost(path* p_path)
+{
+    return p_path ? p_path->state->cost : 0.0;
+}
+
+void path_free(path* p_path)
+{
+    if (!p_path) return;
+
+    free(p_path->state);
+    free(p_path);
+}
+
+compact_path* compact_path_alloc(size_t size, double cost)
+{
+    compact_path* p_path;
+
+    if (!(p_path = malloc(sizeof(*p_path)))) return NULL;
+
+    if (!(p_path->state = malloc(sizeof(compact_path_state) +
+                                 sizeof(uint32_t) * size)))
+    {
+        free(p_path);
+        return NULL;
+    }
+
+    p_path->state->p_ids = (uint32_t*)(p_path->state + 1);
+    p_path->state->size = size;
+    p_path->state->cost = cost;
+    return p_path;
+}
+
+size_t compact_path_size(compact_path* p_path)
+{
+    return p_path ? p_path->state->size : 0;
+}
+
+uint32_t* compact_path_ids(compact_path* p_path)
+{
+    return p_path ? p_path->state->p_ids : NULL;
+}
+
+double compact_path_cost(compact_path* p_path)
+{
+    return p_path ? p_path->state->cost : 0.0;
+}
+
+void compact_path_free(compact_path* p_path)
+{
+    if (!p_path) return;
+
+    free(p_path->state);
+    free(p_path);
+}
@@ -0,0 +1,93 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include "directed_graph_node.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * A search result: the nodes of a path stored contiguously from the source *
+    * to the target, together with the total cost of the path. An empty path   *
+    * denotes that the target is not reachable.                                *
+    ***************************************************************************/
+    typedef struct path {
+        struct path_state* state;
+    } path;
+
+    /***************************************************************************
+    * Allocates a path of 'size' nodes with total cost 'cost'. The nodes are   *
+    * undefined until written through 'path_nodes'.                            *
+    ***************************************************************************/
+    path* path_alloc(size_t size, double cost);
+
+    /***************************************************************************
+    * Returns the amount of nodes on the path.                                 *
+    ***************************************************************************/
+    size_t path_size(path* p_path);
+
+    /***************************************************************************
+    * Returns the index'th node of the path, or NULL if the index is out of    *
+    * range.                                                                   *
+    ***************************************************************************/
+    directed_graph_node* path_get(path* p_path, size_t index);
+
+    /***************************************************************************
+    * Returns the contiguous array of the 'path_size' nodes of the path.       *
+    ***************************************************************************/
+    directed_graph_node** path_nodes(path* p_path);
+
+    /***************************************************************************
+    * Returns the total cost of the path.                                      *
+    ***************************************************************************/
+    double path_cost(path* p_path);
+
+    /***************************************************************************
+    * Deallocates the path. The nodes are not deallocated.                     *
+    ***************************************************************************/
+    void path_free(path* p_path);
+
+    /***************************************************************************
+    * A search result on a compact graph: the ids of the nodes on the path     *
+    * from the source to the target and the total cost of the path. An empty   *
+    * path denotes that the target is not reachable.                           *
+    ***************************************************************************/
+    typedef struct compact_path {
+        struct compact_path_state* state;
+    } compact_path;
+
+    /***************************************************************************
+    * Allocates a compact path of 'size' node ids with total cost 'cost'. The  *
+    * ids are undefined until written through 'compact_path_ids'.              *
+    ***************************************************************************/
+    compact_path* compact_path_alloc(size_t size, double cost);
+
+    /***************************************************************************
+    * Returns the amount of nodes on the compact path.                         *
+    ***************************************************************************/
+    size_t compact_path_size(compact_path* p_path);
+
+    /***************************************************************************
+    * Returns the contiguous array of the 'compact_path_size' node ids of the  *
+    * path.                                                                    *
+    ***************************************************************************/
+    uint32_t* compact_path_ids(compact_path* p_path);
+
+    /***************************************************************************
+    * Returns the total cost of the compact path.                              *
+    ***************************************************************************/
+    double compact_path_cost(compact_path* p_path);
+
+    /***************************************************************************
+    * Deallocates the compact path.                                            *
+    ***************************************************************************/
+    void compact_path_free(compact_path* p_path);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* PATH_H */
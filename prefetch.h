@@ -0,0 +1,22 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+/*******************************************************************************
+* Hints the processor to fetch the cache line at 'ADDRESS' ahead of its use.   *
+*******************************************************************************/
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#define PREFETCH(ADDRESS) _mm_prefetch((const char*)(ADDRESS), _MM_HINT_T0)
+#elif defined(__GNUC__)
+#define PREFETCH(ADDRESS) __builtin_prefetch(ADDRESS)
+#else
+#define PREFETCH(ADDRESS) ((void)(ADDRESS))
+#endif
+
+/*******************************************************************************
+* The amount of keys whose buckets are fetched concurrently by the batched     *
+* lookups.                                                                     *
+*******************************************************************************/
+#define PREFETCH_BATCH_SIZE 16
+
+#endif  /* PREFETCH_H */
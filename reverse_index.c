@@ -0,0 +1,198 @@
+#include "reverse_index.h"
+#include "typed_map.h"
+#include <stdint.h>
+
+#define NODE_HASH(P_NODE)       typed_hash_u64((uint64_t)(uintptr_t)(P_NODE))
+#define NODE_EQUALS(P_A, P_B)   ((P_A) == (P_B))
+
+TYPED_MAP_DEFINE(slot_map,
+                 directed_graph_node*,
+                 size_t,
+                 NODE_HASH,
+                 NODE_EQUALS)
+
+typedef struct reverse_index_state {
+    directed_graph_node** p_nodes;
+    size_t                node_count;
+    slot_map*             p_slot_map;
+    size_t*               p_offsets;
+    directed_graph_node** p_parents;
+} reverse_index_state;
+
+reverse_index* reverse_index_alloc(directed_graph_node** p_nodes,
+                                   size_t node_count)
+{
+    reverse_index* p_index;
+
+    if (!p_nodes && node_count > 0) return NULL;
+
+    if (!(p_index = malloc(sizeof(*p_index)))) return NULL;
+
+    if (!(p_index->state = calloc(1, sizeof(*p_index->state))))
+    {
+        free(p_index);
+        return NULL;
+    }
+
+    p_index->state->p_nodes = p_nodes;
+    p_index->state->node_count = node_count;
+    return p_index;
+}
+
+/*******************************************************************************
+* Counts the parents of each node into 'p_offsets[slot + 2]' and turns the     *
+* counts into positions, so that 'p_offsets[slot + 1]' is where the parents of *
+* the node in slot 'slot' are written.                                         *
+*******************************************************************************/
+static void count_parents(reverse_index_state* p_state, size_t* p_offsets)
+{
+    directed_graph_node** p_children;
+    size_t                child_count;
+    size_t                slot;
+    size_t                i;
+    size_t                j;
+
+    for (i = 0; i < p_state->node_count; ++i)
+    {
+        p_children = directed_graph_node_children(p_state->p_nodes[i]);
+        child_count = directed_graph_node_child_count(p_state->p_nodes[i]);
+
+        for (j = 0; j < child_count; ++j)
+        {
+            if (slot_map_get(p_state->p_slot_map, p_children[j], &slot))
+            {
+                p_offsets[slot + 2]++;
+            }
+        }
+    }
+
+    for (i = 2; i < p_state->node_count + 2; ++i)
+    {
+        p_offsets[i] += p_offsets[i - 1];
+    }
+}
+
+static void fill_parents(reverse_index_state* p_state)
+{
+    directed_graph_node** p_children;
+    size_t                child_count;
+    size_t                slot;
+    size_t                i;
+    size_t                j;
+
+    for (i = 0; i < p_state->node_count; ++i)
+    {
+        p_children = directed_graph_node_children(p_state->p_nodes[i]);
+        child_count = directed_graph_node_child_count(p_state->p_nodes[i]);
+
+        for (j = 0; j < child_count; ++j)
+        {
+            if (slot_map_get(p_state->p_slot_map, p_children[j], &slot))
+            {
+                p_state->p_parents[p_state->p_offsets[slot + 1]++] =
+                    p_state->p_nodes[i];
+            }
+        }
+    }
+}
+
+bool reverse_index_build(reverse_index* p_index)
+{
+    reverse_index_state* p_state;
+    size_t               i;
+
+    if (!p_index) return false;
+
+    p_state = p_index->state;
+
+    if (p_state->p_slot_map) return true;
+
+    if (!(p_state->p_slot_map = slot_map_alloc(p_state->node_count)))
+    {
+        return false;
+    }
+
+    p_state->p_offsets = calloc(p_state->node_count + 2, sizeof(size_t));
+
+    if (!p_state->p_offsets)
+    {
+        reverse_index_invalidate(p_index);
+        return false;
+    }
+
+    for (i = 0; i < p_state->node_count; ++i)
+    {
+        if (!slot_map_put(p_state->p_slot_map, p_state->p_nodes[i], i))
+        {
+            reverse_index_invalidate(p_index);
+            return false;
+        }
+    }
+
+    count_parents(p_state, p_state->p_offsets);
+
+    p_state->p_parents =
+        malloc(sizeof(directed_graph_node*) *
+               (p_state->p_offsets[p_state->node_count + 1] + 1));
+
+    if (!p_state->p_parents)
+    {
+        reverse_index_invalidate(p_index);
+        return false;
+    }
+
+    fill_parents(p_state);
+    return true;
+}
+
+bool reverse_index_is_built(reverse_index* p_index)
+{
+    return p_index && p_index->state->p_parents;
+}
+
+directed_graph_node** reverse_index_parents(reverse_index* p_index,
+                                            directed_graph_node* p_node,
+                                            size_t* p_count)
+{
+    reverse_index_state* p_state;
+    size_t               slot;
+
+    if (p_count)
+    {
+        *p_count = 0;
+    }
+
+    if (!reverse_index_build(p_index)) return NULL;
+
+    p_state = p_index->state;
+
+    if (!slot_map_get(p_state->p_slot_map, p_node, &slot)) return NULL;
+
+    if (p_count)
+    {
+        *p_count = p_state->p_offsets[slot + 1] - p_state->p_offsets[slot];
+    }
+
+    return p_state->p_parents + p_state->p_offsets[slot];
+}
+
+void reverse_index_invalidate(reverse_index* p_index)
+{
+    if (!p_index) return;
+
+    slot_map_free(p_index->state->p_slot_map);
+    free(p_index->state->p_offsets);
+    free(p_index->state->p_parents);
+    p_index->state->p_slot_map = NULL;
+    p_index->state->p_offsets = NULL;
+    p_index->state->p_parents = NULL;
+}
+
+void reverse_index_free(reverse_index* p_index)
+{
+    if (!p_index) return;
+
+    reverse_index_invalidate(p_index);
+    free(p_index->state);
+    free(p_index);
+}
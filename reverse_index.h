@@ -0,0 +1,66 @@
+#ifndef REVERSE_INDEX_H
+#define REVERSE_INDEX_H
+
+#include "directed_graph_node.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * The parents of the nodes of a graph, derived from their child arrays.    *
+    * Lets backward searches run over forward-only nodes. The index is built   *
+    * on the first query, into one array of parents grouped by node, and       *
+    * reflects the arcs as they were then.                                     *
+    ***************************************************************************/
+    typedef struct reverse_index {
+        struct reverse_index_state* state;
+    } reverse_index;
+
+    /***************************************************************************
+    * Allocates an unbuilt reverse index over the 'node_count' nodes in        *
+    * 'p_nodes'. The node array is used, not copied, and must stay unchanged   *
+    * until the index is built. Arcs to nodes outside of the array are         *
+    * ignored.                                                                 *
+    ***************************************************************************/
+    reverse_index* reverse_index_alloc(directed_graph_node** p_nodes,
+                                       size_t node_count);
+
+    /***************************************************************************
+    * Builds the index unless it is built already. Returns false if memory     *
+    * runs out.                                                                *
+    ***************************************************************************/
+    bool reverse_index_build(reverse_index* p_index);
+
+    /***************************************************************************
+    * Returns true if the index has been built.                                *
+    ***************************************************************************/
+    bool reverse_index_is_built(reverse_index* p_index);
+
+    /***************************************************************************
+    * Returns the parents of 'p_node' and stores their amount into '*p_count', *
+    * building the index first if needed. Stores zero and returns NULL if the  *
+    * node is not indexed or the index cannot be built.                        *
+    ***************************************************************************/
+    directed_graph_node** reverse_index_parents(reverse_index* p_index,
+                                                directed_graph_node* p_node,
+                                                size_t* p_count);
+
+    /***************************************************************************
+    * Drops the built index, so that the next query builds it anew from the    *
+    * current arcs.                                                            *
+    ***************************************************************************/
+    void reverse_index_invalidate(reverse_index* p_index);
+
+    /***************************************************************************
+    * Deallocates the index. The nodes are not touched.                        *
+    ***************************************************************************/
+    void reverse_index_free(reverse_index* p_index);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* REVERSE_INDEX_H */
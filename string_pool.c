@@ -0,0 +1,176 @@
+#include "string_pool.h"
+#include "typed_map.h"
+#include <string.h>
+
+#define DEFAULT_BLOCK_SIZE 65536
+
+#define STRING_HASH(P_STRING)   ((size_t) string_hash(P_STRING, 0))
+#define STRING_EQUALS(P_A, P_B) (strcmp(P_A, P_B) == 0)
+
+TYPED_MAP_DEFINE(string_map, const char*, char*, STRING_HASH, STRING_EQUALS)
+
+/*******************************************************************************
+* A block of string storage. The blocks are chained from the newest one, which *
+* is the only one still being filled.                                          *
+*******************************************************************************/
+typedef struct pool_block {
+    struct pool_block* p_next;
+    size_t             size;
+    size_t             capacity;
+    char               data[];
+} pool_block;
+
+typedef struct string_pool_state {
+    pool_block* p_blocks;
+    size_t      block_size;
+    size_t      bytes;
+    string_map* p_map;
+} string_pool_state;
+
+uint64_t string_hash(const char* p_string, uint64_t seed)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL ^ seed;
+
+    while (*p_string)
+    {
+        hash ^= (unsigned char) *p_string++;
+        hash *= 0x100000001b3ULL;
+    }
+
+    /* FNV-1a leaves the high bits poorly mixed. */
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+string_pool* string_pool_alloc(size_t block_size)
+{
+    string_pool* p_pool;
+
+    if (!(p_pool = malloc(sizeof(*p_pool)))) return NULL;
+
+    if (!(p_pool->state = malloc(sizeof(*p_pool->state))))
+    {
+        free(p_pool);
+        return NULL;
+    }
+
+    if (!(p_pool->state->p_map = string_map_alloc(16)))
+    {
+        free(p_pool->state);
+        free(p_pool);
+        return NULL;
+    }
+
+    p_pool->state->p_blocks = NULL;
+    p_pool->state->block_size = block_size ? block_size : DEFAULT_BLOCK_SIZE;
+    p_pool->state->bytes = 0;
+    return p_pool;
+}
+
+/*******************************************************************************
+* Returns room for 'size' bytes, starting a new block if the newest one is     *
+* full.                                                                        *
+*******************************************************************************/
+static char* reserve_bytes(string_pool_state* p_state, size_t size)
+{
+    pool_block* p_block;
+    size_t      capacity;
+
+    p_block = p_state->p_blocks;
+
+    if (!p_block || p_block->capacity - p_block->size < size)
+    {
+        capacity = size > p_state->block_size ? size : p_state->block_size;
+
+        if (!(p_block = malloc(sizeof(pool_block) + capacity))) return NULL;
+
+        p_block->p_next = p_state->p_blocks;
+        p_block->size = 0;
+        p_block->capacity = capacity;
+        p_state->p_blocks = p_block;
+    }
+
+    return p_block->data + p_block->size;
+}
+
+char* string_pool_intern(string_pool* p_pool, const char* p_string)
+{
+    string_pool_state* p_state;
+    char*              p_copy;
+    size_t             size;
+
+    if (!p_pool || !p_string) return NULL;
+
+    p_state = p_pool->state;
+
+    if (string_map_get(p_state->p_map, p_string, &p_copy)) return p_copy;
+
+    size = strlen(p_string) + 1;
+
+    if (!(p_copy = reserve_bytes(p_state, size))) return NULL;
+
+    memcpy(p_copy, p_string, size);
+
+    if (!string_map_put(p_state->p_map, p_copy, p_copy)) return NULL;
+
+    /* The copy is committed only once it is mapped. */
+    p_state->p_blocks->size += size;
+    p_state->bytes += size;
+    return p_copy;
+}
+
+size_t string_pool_size(string_pool* p_pool)
+{
+    return p_pool ? string_map_size(p_pool->state->p_map) : 0;
+}
+
+size_t string_pool_bytes(string_pool* p_pool)
+{
+    return p_pool ? p_pool->state->bytes : 0;
+}
+
+memory_usage string_pool_memory_usage(string_pool* p_pool)
+{
+    memory_usage usage = { 0, 0 };
+    pool_block*  p_block;
+    string_map*  p_map;
+
+    if (!p_pool) return usage;
+
+    p_map = p_pool->state->p_map;
+
+    usage.live = p_pool->state->bytes;
+    usage.allocated = sizeof(*p_pool) + sizeof(*p_pool->state) +
+                      sizeof(*p_map) +
+                      (sizeof(*p_map->keys) + sizeof(*p_map->values) +
+                       sizeof(*p_map->used)) * (p_map->mask + 1);
+
+    for (p_block = p_pool->state->p_blocks; p_block; p_block = p_block->p_next)
+    {
+        usage.allocated += sizeof(pool_block) + p_block->capacity;
+    }
+
+    return usage;
+}
+
+void string_pool_free(string_pool* p_pool)
+{
+    pool_block* p_block;
+    pool_block* p_next;
+
+    if (!p_pool) return;
+
+    for (p_block = p_pool->state->p_blocks; p_block; p_block = p_next)
+    {
+        p_next = p_block->p_next;
+        free(p_block);
+    }
+
+    string_map_free(p_pool->state->p_map);
+    free(p_pool->state);
+    free(p_pool);
+}
@@ -0,0 +1,66 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include "memory_usage.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * A pool of interned strings. Each distinct string is stored once, packed  *
+    * with the others into large blocks, and keeps its address for the life    *
+    * of the pool, so the interned strings may serve as node names.            *
+    ***************************************************************************/
+    typedef struct string_pool {
+        struct string_pool_state* state;
+    } string_pool;
+
+    /***************************************************************************
+    * Allocates an empty string pool whose blocks hold 'block_size' bytes, or  *
+    * a default amount if 'block_size' is zero. Longer strings get a block of  *
+    * their own.                                                               *
+    ***************************************************************************/
+    string_pool* string_pool_alloc(size_t block_size);
+
+    /***************************************************************************
+    * Returns the pooled copy of 'p_string', copying it into the pool if it is *
+    * not there yet. Returns NULL if memory runs out.                          *
+    ***************************************************************************/
+    char* string_pool_intern(string_pool* p_pool, const char* p_string);
+
+    /***************************************************************************
+    * Returns the amount of distinct strings in the pool.                      *
+    ***************************************************************************/
+    size_t string_pool_size(string_pool* p_pool);
+
+    /***************************************************************************
+    * Returns the amount of bytes taken by the strings, terminators included.  *
+    ***************************************************************************/
+    size_t string_pool_bytes(string_pool* p_pool);
+
+    /***************************************************************************
+    * Returns the memory taken by the pool: the blocks holding the strings,    *
+    * which are live, and the index over them.                                 *
+    ***************************************************************************/
+    memory_usage string_pool_memory_usage(string_pool* p_pool);
+
+    /***************************************************************************
+    * Deallocates the pool along with all the strings in it.                   *
+    ***************************************************************************/
+    void string_pool_free(string_pool* p_pool);
+
+    /***************************************************************************
+    * Returns a 64-bit hash value of the string 'p_string'. Different seeds    *
+    * give independent hash functions.                                         *
+    ***************************************************************************/
+    uint64_t string_hash(const char* p_string, uint64_t seed);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* STRING_POOL_H */
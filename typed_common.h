@@ -0,0 +1,75 @@
+#ifndef TYPED_COMMON_H
+#define TYPED_COMMON_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* The storage class of all the functions generated by the typed container      *
+* templates. Being static and inline, the hash, equality and comparison        *
+* callbacks are inlined into every generated operation.                        *
+*******************************************************************************/
+#if defined(_MSC_VER) && !defined(__cplusplus)
+#define TYPED_INLINE static __inline
+#else
+#define TYPED_INLINE static inline
+#endif
+
+/*******************************************************************************
+* The default equality and order relations for the scalar keys.                *
+*******************************************************************************/
+#define TYPED_EQUALS(A, B) ((A) == (B))
+#define TYPED_LESS(A, B)   ((A) < (B))
+
+/*******************************************************************************
+* Mixes all the bits of a 32-bit key so that the low bits used for indexing    *
+* the tables depend on the entire key.                                         *
+*******************************************************************************/
+TYPED_INLINE size_t typed_hash_u32(uint32_t key)
+{
+    key ^= key >> 16;
+    key *= 0x85ebca6bU;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35U;
+    key ^= key >> 16;
+    return key;
+}
+
+/*******************************************************************************
+* Mixes all the bits of a 64-bit key.                                          *
+*******************************************************************************/
+TYPED_INLINE size_t typed_hash_u64(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return (size_t) key;
+}
+
+/*******************************************************************************
+* Returns the smallest power of two no less than 'capacity' and 16.            *
+*******************************************************************************/
+TYPED_INLINE size_t typed_fix_capacity(size_t capacity)
+{
+    size_t ret = 16;
+
+    while (ret < capacity)
+    {
+        ret <<= 1;
+    }
+
+    return ret;
+}
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* TYPED_COMMON_H */
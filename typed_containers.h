@@ -0,0 +1,31 @@
+#ifndef TYPED_CONTAINERS_H
+#define TYPED_CONTAINERS_H
+
+#include "typed_common.h"
+#include "typed_map.h"
+#include "typed_set.h"
+#include "typed_heap.h"
+#include "typed_list.h"
+#include <stdint.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* The containers for id-based graph algorithm state. Other instantiations can  *
+* be generated with the TYPED_*_DEFINE macros.                                 *
+*******************************************************************************/
+TYPED_MAP_DEFINE(u32_u32_map, uint32_t, uint32_t, typed_hash_u32, TYPED_EQUALS)
+TYPED_MAP_DEFINE(u32_double_map, uint32_t, double, typed_hash_u32, TYPED_EQUALS)
+TYPED_SET_DEFINE(u32_set, uint32_t, typed_hash_u32, TYPED_EQUALS)
+TYPED_SET_DEFINE(u64_set, uint64_t, typed_hash_u64, TYPED_EQUALS)
+TYPED_HEAP_DEFINE(u32_double_heap, double, TYPED_LESS, 4)
+TYPED_HEAP_DEFINE(u32_u64_heap, uint64_t, TYPED_LESS, 4)
+TYPED_LIST_DEFINE(u32_list, uint32_t)
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* TYPED_CONTAINERS_H */
@@ -0,0 +1,256 @@
+#ifndef TYPED_HEAP_H
+#define TYPED_HEAP_H
+
+#include "typed_common.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+* Denotes an element that is not in a typed heap.                              *
+*******************************************************************************/
+#define TYPED_HEAP_NO_POSITION UINT32_MAX
+
+/*******************************************************************************
+* Generates an indexed d-ary min-heap type 'NAME' whose elements are the       *
+* dense ids '0, 1, ..., id_capacity - 1' and whose priorities are of type      *
+* 'PRIORITY_TYPE'. The heap position of every id is kept in a flat array       *
+* instead of a hash map, and 'LESS' is expanded inline. The generated          *
+* operations are:                                                              *
+*                                                                              *
+*   NAME*    NAME_alloc(size_t id_capacity);                                   *
+*   bool     NAME_add(NAME* heap, uint32_t id, PRIORITY_TYPE priority);        *
+*   bool     NAME_decrease_key(NAME* heap, uint32_t id,                        *
+*                              PRIORITY_TYPE priority);                        *
+*   bool     NAME_contains(NAME* heap, uint32_t id);                           *
+*   uint32_t NAME_min(NAME* heap);                                             *
+*   uint32_t NAME_extract_min(NAME* heap, PRIORITY_TYPE* p_priority);          *
+*   size_t   NAME_size(NAME* heap);                                            *
+*   void     NAME_clear(NAME* heap);                                           *
+*   void     NAME_free(NAME* heap);                                            *
+*                                                                              *
+* 'NAME_min' and 'NAME_extract_min' must not be called on an empty heap.       *
+* 'p_priority' may be NULL. 'NAME_clear' runs in time proportional to the      *
+* size of the heap, not to the id capacity.                                    *
+*******************************************************************************/
+#define TYPED_HEAP_DEFINE(NAME, PRIORITY_TYPE, LESS, DEGREE)                  \
+typedef struct NAME {                                                         \
+    uint32_t*      ids;                                                       \
+    PRIORITY_TYPE* priorities;                                                \
+    uint32_t*      positions;                                                 \
+    size_t         size;                                                      \
+    size_t         id_capacity;                                               \
+} NAME;                                                                       \
+                                                                              \
+TYPED_INLINE NAME* NAME##_alloc(size_t id_capacity)                           \
+{                                                                             \
+    NAME*  heap = (NAME*) malloc(sizeof(*heap));                              \
+    size_t slots = id_capacity + 1;                                           \
+    size_t i;                                                                 \
+                                                                              \
+    if (!heap)                                                                \
+    {                                                                         \
+        return NULL;                                                          \
+    }                                                                         \
+                                                                              \
+    heap->ids = (uint32_t*) malloc(sizeof(uint32_t) * slots);                 \
+    heap->positions = (uint32_t*) malloc(sizeof(uint32_t) * slots);           \
+    heap->priorities =                                                        \
+        (PRIORITY_TYPE*) malloc(sizeof(PRIORITY_TYPE) * slots);               \
+                                                                              \
+    if (!heap->ids || !heap->priorities || !heap->positions)                  \
+    {                                                                         \
+        free(heap->ids);                                                      \
+        free(heap->priorities);                                               \
+        free(heap->positions);                                                \
+        free(heap);                                                           \
+        return NULL;                                                          \
+    }                                                                         \
+                                                                              \
+    for (i = 0; i < id_capacity; ++i)                                         \
+    {                                                                         \
+        heap->positions[i] = TYPED_HEAP_NO_POSITION;                          \
+    }                                                                         \
+                                                                              \
+    heap->size = 0;                                                           \
+    heap->id_capacity = id_capacity;                                          \
+    return heap;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE void NAME##_sift_up(NAME* heap, size_t index)                    \
+{                                                                             \
+    uint32_t      id       = heap->ids[index];                                \
+    PRIORITY_TYPE priority = heap->priorities[index];                         \
+    size_t        parent_index;                                               \
+                                                                              \
+    while (index > 0)                                                         \
+    {                                                                         \
+        parent_index = (index - 1) / (DEGREE);                                \
+                                                                              \
+        if (!LESS(priority, heap->priorities[parent_index]))                  \
+        {                                                                     \
+            break;                                                            \
+        }                                                                     \
+                                                                              \
+        heap->ids[index] = heap->ids[parent_index];                           \
+        heap->priorities[index] = heap->priorities[parent_index];             \
+        heap->positions[heap->ids[index]] = (uint32_t) index;                 \
+        index = parent_index;                                                 \
+    }                                                                         \
+                                                                              \
+    heap->ids[index] = id;                                                    \
+    heap->priorities[index] = priority;                                       \
+    heap->positions[id] = (uint32_t) index;                                   \
+}                                                                             \
+                                                                              \
+TYPED_INLINE void NAME##_sift_down(NAME* heap, size_t index)                  \
+{                                                                             \
+    uint32_t      id       = heap->ids[index];                                \
+    PRIORITY_TYPE priority = heap->priorities[index];                         \
+    size_t        first_child_index;                                          \
+    size_t        last_child_index;                                           \
+    size_t        min_child_index;                                            \
+    size_t        i;                                                          \
+                                                                              \
+    for (;;)                                                                  \
+    {                                                                         \
+        first_child_index = (DEGREE) * index + 1;                             \
+                                                                              \
+        if (first_child_index >= heap->size)                                  \
+        {                                                                     \
+            break;                                                            \
+        }                                                                     \
+                                                                              \
+        last_child_index = first_child_index + (DEGREE);                      \
+                                                                              \
+        if (last_child_index > heap->size)                                    \
+        {                                                                     \
+            last_child_index = heap->size;                                    \
+        }                                                                     \
+                                                                              \
+        min_child_index = first_child_index;                                  \
+                                                                              \
+        for (i = first_child_index + 1; i < last_child_index; ++i)            \
+        {                                                                     \
+            if (LESS(heap->priorities[i], heap->priorities[min_child_index])) \
+            {                                                                 \
+                min_child_index = i;                                          \
+            }                                                                 \
+        }                                                                     \
+                                                                              \
+        if (!LESS(heap->priorities[min_child_index], priority))               \
+        {                                                                     \
+            break;                                                            \
+        }                                                                     \
+                                                                              \
+        heap->ids[index] = heap->ids[min_child_index];                        \
+        heap->priorities[index] = heap->priorities[min_child_index];          \
+        heap->positions[heap->ids[index]] = (uint32_t) index;                 \
+        index = min_child_index;                                              \
+    }                                                                         \
+                                                                              \
+    heap->ids[index] = id;                                                    \
+    heap->priorities[index] = priority;                                       \
+    heap->positions[id] = (uint32_t) index;                                   \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_contains(NAME* heap, uint32_t id)                    \
+{                                                                             \
+    return id < heap->id_capacity &&                                          \
+           heap->positions[id] != TYPED_HEAP_NO_POSITION;                     \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_add(NAME* heap, uint32_t id, PRIORITY_TYPE priority) \
+{                                                                             \
+    if (id >= heap->id_capacity || NAME##_contains(heap, id))                 \
+    {                                                                         \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    heap->ids[heap->size] = id;                                               \
+    heap->priorities[heap->size] = priority;                                  \
+    NAME##_sift_up(heap, heap->size++);                                       \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_decrease_key(NAME* heap,                             \
+                                      uint32_t id,                            \
+                                      PRIORITY_TYPE priority)                 \
+{                                                                             \
+    uint32_t position;                                                        \
+                                                                              \
+    if (!NAME##_contains(heap, id))                                           \
+    {                                                                         \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    position = heap->positions[id];                                           \
+                                                                              \
+    if (!LESS(priority, heap->priorities[position]))                          \
+    {                                                                         \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    heap->priorities[position] = priority;                                    \
+    NAME##_sift_up(heap, position);                                           \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE uint32_t NAME##_min(NAME* heap)                                  \
+{                                                                             \
+    return heap->ids[0];                                                      \
+}                                                                             \
+                                                                              \
+TYPED_INLINE uint32_t NAME##_extract_min(NAME* heap,                          \
+                                         PRIORITY_TYPE* p_priority)           \
+{                                                                             \
+    uint32_t id = heap->ids[0];                                               \
+                                                                              \
+    if (p_priority)                                                           \
+    {                                                                         \
+        *p_priority = heap->priorities[0];                                    \
+    }                                                                         \
+                                                                              \
+    heap->positions[id] = TYPED_HEAP_NO_POSITION;                             \
+                                                                              \
+    if (--heap->size > 0)                                                     \
+    {                                                                         \
+        heap->ids[0] = heap->ids[heap->size];                                 \
+        heap->priorities[0] = heap->priorities[heap->size];                   \
+        NAME##_sift_down(heap, 0);                                            \
+    }                                                                         \
+                                                                              \
+    return id;                                                                \
+}                                                                             \
+                                                                              \
+TYPED_INLINE size_t NAME##_size(NAME* heap)                                   \
+{                                                                             \
+    return heap->size;                                                        \
+}                                                                             \
+                                                                              \
+TYPED_INLINE void NAME##_clear(NAME* heap)                                    \
+{                                                                             \
+    size_t i;                                                                 \
+                                                                              \
+    for (i = 0; i < heap->size; ++i)                                          \
+    {                                                                         \
+        heap->positions[heap->ids[i]] = TYPED_HEAP_NO_POSITION;               \
+    }                                                                         \
+                                                                              \
+    heap->size = 0;                                                           \
+}                                                                             \
+                                                                              \
+TYPED_INLINE void NAME##_free(NAME* heap)                                     \
+{                                                                             \
+    if (!heap)                                                                \
+    {                                                                         \
+        return;                                                               \
+    }                                                                         \
+                                                                              \
+    free(heap->ids);                                                          \
+    free(heap->priorities);                                                   \
+    free(heap->positions);                                                    \
+    free(heap);                                                               \
+}
+
+#endif  /* TYPED_HEAP_H */
@@ -0,0 +1,134 @@
+#ifndef TYPED_LIST_H
+#define TYPED_LIST_H
+
+#include "typed_common.h"
+#include <stdlib.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+* Generates an array list type 'NAME' of unboxed elements of type 'TYPE'. The  *
+* generated operations are:                                                    *
+*                                                                              *
+*   NAME*  NAME_alloc(size_t initial_capacity);                                *
+*   bool   NAME_reserve(NAME* list, size_t expected_size);                     *
+*   bool   NAME_push_back(NAME* list, TYPE element);                           *
+*   TYPE   NAME_pop_back(NAME* list);                                          *
+*   TYPE   NAME_get(NAME* list, size_t index);                                 *
+*   void   NAME_set(NAME* list, size_t index, TYPE element);                   *
+*   size_t NAME_size(NAME* list);                                              *
+*   void   NAME_clear(NAME* list);                                             *
+*   void   NAME_free(NAME* list);                                              *
+*                                                                              *
+* The index and emptiness preconditions are not checked. The elements are      *
+* stored contiguously in 'list->storage'.                                      *
+*******************************************************************************/
+#define TYPED_LIST_DEFINE(NAME, TYPE)                                         \
+typedef struct NAME {                                                         \
+    TYPE*  storage;                                                           \
+    size_t size;                                                              \
+    size_t capacity;                                                          \
+} NAME;                                                                       \
+                                                                              \
+TYPED_INLINE NAME* NAME##_alloc(size_t initial_capacity)                      \
+{                                                                             \
+    NAME* list = (NAME*) malloc(sizeof(*list));                               \
+                                                                              \
+    if (!list)                                                                \
+    {                                                                         \
+        return NULL;                                                          \
+    }                                                                         \
+                                                                              \
+    initial_capacity = typed_fix_capacity(initial_capacity);                  \
+                                                                              \
+    list->storage = (TYPE*) malloc(sizeof(TYPE) * initial_capacity);          \
+                                                                              \
+    if (!list->storage)                                                       \
+    {                                                                         \
+        free(list);                                                           \
+        return NULL;                                                          \
+    }                                                                         \
+                                                                              \
+    list->size = 0;                                                           \
+    list->capacity = initial_capacity;                                        \
+    return list;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_reserve(NAME* list, size_t expected_size)            \
+{                                                                             \
+    TYPE*  new_storage;                                                       \
+    size_t new_capacity = list->capacity;                                     \
+                                                                              \
+    while (new_capacity < expected_size)                                      \
+    {                                                                         \
+        if (new_capacity > SIZE_MAX / 2 / sizeof(TYPE)) return false;         \
+                                                                              \
+        new_capacity <<= 1;                                                   \
+    }                                                                         \
+                                                                              \
+    if (new_capacity == list->capacity)                                       \
+    {                                                                         \
+        return true;                                                          \
+    }                                                                         \
+                                                                              \
+    new_storage =                                                             \
+        (TYPE*) realloc(list->storage, sizeof(TYPE) * new_capacity);          \
+                                                                              \
+    if (!new_storage)                                                         \
+    {                                                                         \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    list->storage = new_storage;                                              \
+    list->capacity = new_capacity;                                            \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_push_back(NAME* list, TYPE element)                  \
+{                                                                             \
+    if (list->size == list->capacity &&                                       \
+        !NAME##_reserve(list, list->size + 1))                                \
+    {                                                                         \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    list->storage[list->size++] = element;                                    \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE TYPE NAME##_pop_back(NAME* list)                                 \
+{                                                                             \
+    return list->storage[--list->size];                                       \
+}                                                                             \
+                                                                              \
+TYPED_INLINE TYPE NAME##_get(NAME* list, size_t index)                        \
+{                                                                             \
+    return list->storage[index];                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE void NAME##_set(NAME* list, size_t index, TYPE element)          \
+{                                                                             \
+    list->storage[index] = element;                                           \
+}                                                                             \
+                                                                              \
+TYPED_INLINE size_t NAME##_size(NAME* list)                                   \
+{                                                                             \
+    return list->size;                                                        \
+}                                                                             \
+                                                                              \
+TYPED_INLINE void NAME##_clear(NAME* list)                                    \
+{                                                                             \
+    list->size = 0;                                                           \
+}                                                                             \
+                                                                              \
+TYPED_INLINE void NAME##_free(NAME* list)                                     \
+{                                                                             \
+    if (!list)                                                                \
+    {                                                                         \
+        return;                                                               \
+    }                                                                         \
+                                                                              \
+    free(list->storage);                                                      \
+    free(list);                                                               \
+}
+
+#endif  /* TYPED_LIST_H */
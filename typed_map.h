@@ -0,0 +1,249 @@
+#ifndef TYPED_MAP_H
+#define TYPED_MAP_H
+
+#include "typed_common.h"
+#include <stdlib.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+* Generates a hash map type 'NAME' mapping keys of type 'KEY_TYPE' to values   *
+* of type 'VALUE_TYPE'. Keys and values are stored unboxed in open-addressed   *
+* arrays with linear probing, and 'HASH' and 'EQUALS' are expanded inline.     *
+* The generated operations are:                                                *
+*                                                                              *
+*   NAME*  NAME_alloc(size_t initial_capacity);                                *
+*   bool   NAME_reserve(NAME* map, size_t expected_size);                      *
+*   bool   NAME_put(NAME* map, KEY_TYPE key, VALUE_TYPE value);                *
+*   bool   NAME_get(NAME* map, KEY_TYPE key, VALUE_TYPE* p_value);             *
+*   bool   NAME_contains_key(NAME* map, KEY_TYPE key);                         *
+*   bool   NAME_remove(NAME* map, KEY_TYPE key);                               *
+*   size_t NAME_size(NAME* map);                                               *
+*   void   NAME_clear(NAME* map);                                              *
+*   void   NAME_free(NAME* map);                                               *
+*                                                                              *
+* 'NAME_put' returns false only if the map could not grow. 'NAME_get' returns  *
+* false if the key is not mapped and leaves '*p_value' untouched then.         *
+* 'NAME_reserve' returns false if the map could not grow or its capacity would *
+* overflow.                                                                    *
+*******************************************************************************/
+#define TYPED_MAP_DEFINE(NAME, KEY_TYPE, VALUE_TYPE, HASH, EQUALS)            \
+typedef struct NAME {                                                         \
+    KEY_TYPE*      keys;                                                      \
+    VALUE_TYPE*    values;                                                    \
+    unsigned char* used;                                                      \
+    size_t         size;                                                      \
+    size_t         mask;                                                      \
+    size_t         max_allowed_size;                                          \
+} NAME;                                                                       \
+                                                                              \
+TYPED_INLINE bool NAME##_init_table(NAME* map, size_t capacity)               \
+{                                                                             \
+    map->keys   = (KEY_TYPE*) malloc(sizeof(KEY_TYPE) * capacity);            \
+    map->values = (VALUE_TYPE*) malloc(sizeof(VALUE_TYPE) * capacity);        \
+    map->used   = (unsigned char*) calloc(capacity, sizeof(unsigned char));   \
+                                                                              \
+    if (!map->keys || !map->values || !map->used)                             \
+    {                                                                         \
+        free(map->keys);                                                      \
+        free(map->values);                                                    \
+        free(map->used);                                                      \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    map->mask = capacity - 1;                                                 \
+    map->max_allowed_size = capacity / 4 * 3;                                 \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE NAME* NAME##_alloc(size_t initial_capacity)                      \
+{                                                                             \
+    NAME* map = (NAME*) malloc(sizeof(*map));                                 \
+                                                                              \
+    if (!map)                                                                 \
+    {                                                                         \
+        return NULL;                                                          \
+    }                                                                         \
+                                                                              \
+    if (!NAME##_init_table(map, typed_fix_capacity(initial_capacity)))        \
+    {                                                                         \
+        free(map);                                                            \
+        return NULL;                                                          \
+    }                                                                         \
+                                                                              \
+    map->size = 0;                                                            \
+    return map;                                                               \
+}                                                                             \
+                                                                              \
+TYPED_INLINE size_t NAME##_find_slot(NAME* map, KEY_TYPE key)                 \
+{                                                                             \
+    size_t index = HASH(key) & map->mask;                                     \
+                                                                              \
+    while (map->used[index] && !EQUALS(map->keys[index], key))                \
+    {                                                                         \
+        index = (index + 1) & map->mask;                                      \
+    }                                                                         \
+                                                                              \
+    return index;                                                             \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_resize(NAME* map, size_t new_capacity)               \
+{                                                                             \
+    KEY_TYPE*      old_keys     = map->keys;                                  \
+    VALUE_TYPE*    old_values   = map->values;                                \
+    unsigned char* old_used     = map->used;                                  \
+    size_t         old_capacity = map->mask + 1;                              \
+    size_t         index;                                                     \
+    size_t         i;                                                         \
+                                                                              \
+    if (!NAME##_init_table(map, new_capacity))                                \
+    {                                                                         \
+        map->keys   = old_keys;                                               \
+        map->values = old_values;                                             \
+        map->used   = old_used;                                               \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    for (i = 0; i < old_capacity; ++i)                                        \
+    {                                                                         \
+        if (old_used[i])                                                      \
+        {                                                                     \
+            index = NAME##_find_slot(map, old_keys[i]);                       \
+            map->keys[index]   = old_keys[i];                                 \
+            map->values[index] = old_values[i];                               \
+            map->used[index]   = 1;                                           \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    free(old_keys);                                                           \
+    free(old_values);                                                         \
+    free(old_used);                                                           \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_reserve(NAME* map, size_t expected_size)             \
+{                                                                             \
+    size_t new_capacity = map->mask + 1;                                      \
+                                                                              \
+    while (new_capacity / 4 * 3 < expected_size)                              \
+    {                                                                         \
+        /* Both arrays of the doubled capacity must stay addressable. */      \
+        if (new_capacity > SIZE_MAX / 2 /                                     \
+                           (sizeof(KEY_TYPE) + sizeof(VALUE_TYPE)))           \
+        {                                                                     \
+            return false;                                                     \
+        }                                                                     \
+                                                                              \
+        new_capacity <<= 1;                                                   \
+    }                                                                         \
+                                                                              \
+    return new_capacity == map->mask + 1 ? true :                             \
+           NAME##_resize(map, new_capacity);                                  \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_put(NAME* map, KEY_TYPE key, VALUE_TYPE value)       \
+{                                                                             \
+    size_t index = NAME##_find_slot(map, key);                                \
+                                                                              \
+    if (map->used[index])                                                     \
+    {                                                                         \
+        map->values[index] = value;                                           \
+        return true;                                                          \
+    }                                                                         \
+                                                                              \
+    if (map->size >= map->max_allowed_size)                                   \
+    {                                                                         \
+        if (!NAME##_resize(map, 2 * (map->mask + 1)))                         \
+        {                                                                     \
+            return false;                                                     \
+        }                                                                     \
+                                                                              \
+        index = NAME##_find_slot(map, key);                                   \
+    }                                                                         \
+                                                                              \
+    map->keys[index]   = key;                                                 \
+    map->values[index] = value;                                               \
+    map->used[index]   = 1;                                                   \
+    map->size++;                                                              \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_get(NAME* map, KEY_TYPE key, VALUE_TYPE* p_value)    \
+{                                                                             \
+    size_t index = NAME##_find_slot(map, key);                                \
+                                                                              \
+    if (!map->used[index])                                                    \
+    {                                                                         \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    *p_value = map->values[index];                                            \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_contains_key(NAME* map, KEY_TYPE key)                \
+{                                                                             \
+    return map->used[NAME##_find_slot(map, key)] != 0;                        \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_remove(NAME* map, KEY_TYPE key)                      \
+{                                                                             \
+    size_t hole = NAME##_find_slot(map, key);                                 \
+    size_t index;                                                             \
+    size_t home;                                                              \
+                                                                              \
+    if (!map->used[hole])                                                     \
+    {                                                                         \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    /* Shift the following entries of the probe run back over the hole. */    \
+    for (index = (hole + 1) & map->mask;                                      \
+         map->used[index];                                                    \
+         index = (index + 1) & map->mask)                                     \
+    {                                                                         \
+        home = HASH(map->keys[index]) & map->mask;                            \
+                                                                              \
+        if (((index - home) & map->mask) >= ((index - hole) & map->mask))     \
+        {                                                                     \
+            map->keys[hole]   = map->keys[index];                             \
+            map->values[hole] = map->values[index];                           \
+            hole = index;                                                     \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    map->used[hole] = 0;                                                      \
+    map->size--;                                                              \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE size_t NAME##_size(NAME* map)                                    \
+{                                                                             \
+    return map->size;                                                         \
+}                                                                             \
+                                                                              \
+TYPED_INLINE void NAME##_clear(NAME* map)                                     \
+{                                                                             \
+    size_t i;                                                                 \
+                                                                              \
+    for (i = 0; i <= map->mask; ++i)                                          \
+    {                                                                         \
+        map->used[i] = 0;                                                     \
+    }                                                                         \
+                                                                              \
+    map->size = 0;                                                            \
+}                                                                             \
+                                                                              \
+TYPED_INLINE void NAME##_free(NAME* map)                                      \
+{                                                                             \
+    if (!map)                                                                 \
+    {                                                                         \
+        return;                                                               \
+    }                                                                         \
+                                                                              \
+    free(map->keys);                                                          \
+    free(map->values);                                                        \
+    free(map->used);                                                          \
+    free(map);                                                                \
+}
+
+#endif  /* TYPED_MAP_H */
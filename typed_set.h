@@ -0,0 +1,217 @@
+#ifndef TYPED_SET_H
+#define TYPED_SET_H
+
+#include "typed_common.h"
+#include <stdlib.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+* Generates a hash set type 'NAME' of elements of type 'KEY_TYPE'. The         *
+* elements are stored unboxed in an open-addressed array with linear probing,  *
+* and 'HASH' and 'EQUALS' are expanded inline. The generated operations are:   *
+*                                                                              *
+*   NAME*  NAME_alloc(size_t initial_capacity);                                *
+*   bool   NAME_reserve(NAME* set, size_t expected_size);                      *
+*   bool   NAME_add(NAME* set, KEY_TYPE key);                                  *
+*   bool   NAME_contains(NAME* set, KEY_TYPE key);                             *
+*   bool   NAME_remove(NAME* set, KEY_TYPE key);                               *
+*   size_t NAME_size(NAME* set);                                               *
+*   void   NAME_clear(NAME* set);                                              *
+*   void   NAME_free(NAME* set);                                               *
+*                                                                              *
+* 'NAME_add' returns true only if the element was not yet in the set and was   *
+* added. 'NAME_reserve' returns false if the set could not grow or its         *
+* capacity would overflow.                                                     *
+*******************************************************************************/
+#define TYPED_SET_DEFINE(NAME, KEY_TYPE, HASH, EQUALS)                        \
+typedef struct NAME {                                                         \
+    KEY_TYPE*      keys;                                                      \
+    unsigned char* used;                                                      \
+    size_t         size;                                                      \
+    size_t         mask;                                                      \
+    size_t         max_allowed_size;                                          \
+} NAME;                                                                       \
+                                                                              \
+TYPED_INLINE bool NAME##_init_table(NAME* set, size_t capacity)               \
+{                                                                             \
+    set->keys = (KEY_TYPE*) malloc(sizeof(KEY_TYPE) * capacity);              \
+    set->used = (unsigned char*) calloc(capacity, sizeof(unsigned char));     \
+                                                                              \
+    if (!set->keys || !set->used)                                             \
+    {                                                                         \
+        free(set->keys);                                                      \
+        free(set->used);                                                      \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    set->mask = capacity - 1;                                                 \
+    set->max_allowed_size = capacity / 4 * 3;                                 \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE NAME* NAME##_alloc(size_t initial_capacity)                      \
+{                                                                             \
+    NAME* set = (NAME*) malloc(sizeof(*set));                                 \
+                                                                              \
+    if (!set)                                                                 \
+    {                                                                         \
+        return NULL;                                                          \
+    }                                                                         \
+                                                                              \
+    if (!NAME##_init_table(set, typed_fix_capacity(initial_capacity)))        \
+    {                                                                         \
+        free(set);                                                            \
+        return NULL;                                                          \
+    }                                                                         \
+                                                                              \
+    set->size = 0;                                                            \
+    return set;                                                               \
+}                                                                             \
+                                                                              \
+TYPED_INLINE size_t NAME##_find_slot(NAME* set, KEY_TYPE key)                 \
+{                                                                             \
+    size_t index = HASH(key) & set->mask;                                     \
+                                                                              \
+    while (set->used[index] && !EQUALS(set->keys[index], key))                \
+    {                                                                         \
+        index = (index + 1) & set->mask;                                      \
+    }                                                                         \
+                                                                              \
+    return index;                                                             \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_resize(NAME* set, size_t new_capacity)               \
+{                                                                             \
+    KEY_TYPE*      old_keys     = set->keys;                                  \
+    unsigned char* old_used     = set->used;                                  \
+    size_t         old_capacity = set->mask + 1;                              \
+    size_t         index;                                                     \
+    size_t         i;                                                         \
+                                                                              \
+    if (!NAME##_init_table(set, new_capacity))                                \
+    {                                                                         \
+        set->keys = old_keys;                                                 \
+        set->used = old_used;                                                 \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    for (i = 0; i < old_capacity; ++i)                                        \
+    {                                                                         \
+        if (old_used[i])                                                      \
+        {                                                                     \
+            index = NAME##_find_slot(set, old_keys[i]);                       \
+            set->keys[index] = old_keys[i];                                   \
+            set->used[index] = 1;                                             \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    free(old_keys);                                                           \
+    free(old_used);                                                           \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_reserve(NAME* set, size_t expected_size)             \
+{                                                                             \
+    size_t new_capacity = set->mask + 1;                                      \
+                                                                              \
+    while (new_capacity / 4 * 3 < expected_size)                              \
+    {                                                                         \
+        if (new_capacity > SIZE_MAX / 2 / sizeof(KEY_TYPE)) return false;     \
+                                                                              \
+        new_capacity <<= 1;                                                   \
+    }                                                                         \
+                                                                              \
+    return new_capacity == set->mask + 1 ? true :                             \
+           NAME##_resize(set, new_capacity);                                  \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_add(NAME* set, KEY_TYPE key)                         \
+{                                                                             \
+    size_t index = NAME##_find_slot(set, key);                                \
+                                                                              \
+    if (set->used[index])                                                     \
+    {                                                                         \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    if (set->size >= set->max_allowed_size)                                   \
+    {                                                                         \
+        if (!NAME##_resize(set, 2 * (set->mask + 1)))                         \
+        {                                                                     \
+            return false;                                                     \
+        }                                                                     \
+                                                                              \
+        index = NAME##_find_slot(set, key);                                   \
+    }                                                                         \
+                                                                              \
+    set->keys[index] = key;                                                   \
+    set->used[index] = 1;                                                     \
+    set->size++;                                                              \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_contains(NAME* set, KEY_TYPE key)                    \
+{                                                                             \
+    return set->used[NAME##_find_slot(set, key)] != 0;                        \
+}                                                                             \
+                                                                              \
+TYPED_INLINE bool NAME##_remove(NAME* set, KEY_TYPE key)                      \
+{                                                                             \
+    size_t hole = NAME##_find_slot(set, key);                                 \
+    size_t index;                                                             \
+    size_t home;                                                              \
+                                                                              \
+    if (!set->used[hole])                                                     \
+    {                                                                         \
+        return false;                                                         \
+    }                                                                         \
+                                                                              \
+    /* Shift the following elements of the probe run back over the hole. */   \
+    for (index = (hole + 1) & set->mask;                                      \
+         set->used[index];                                                    \
+         index = (index + 1) & set->mask)                                     \
+    {                                                                         \
+        home = HASH(set->keys[index]) & set->mask;                            \
+                                                                              \
+        if (((index - home) & set->mask) >= ((index - hole) & set->mask))     \
+        {                                                                     \
+            set->keys[hole] = set->keys[index];                               \
+            hole = index;                                                     \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    set->used[hole] = 0;                                                      \
+    set->size--;                                                              \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+TYPED_INLINE size_t NAME##_size(NAME* set)                                    \
+{                                                                             \
+    return set->size;                                                         \
+}                                                                             \
+                                                                              \
+TYPED_INLINE void NAME##_clear(NAME* set)                                     \
+{                                                                             \
+    size_t i;                                                                 \
+                                                                              \
+    for (i = 0; i <= set->mask; ++i)                                          \
+    {                                                                         \
+        set->used[i] = 0;                                                     \
+    }                                                                         \
+                                                                              \
+    set->size = 0;                                                            \
+}                                                                             \
+                                                                              \
+TYPED_INLINE void NAME##_free(NAME* set)                                      \
+{                                                                             \
+    if (!set)                                                                 \
+    {                                                                         \
+        return;                                                               \
+    }                                                                         \
+                                                                              \
+    free(set->keys);                                                          \
+    free(set->used);                                                          \
+    free(set);                                                                \
+}
+
+#endif  /* TYPED_SET_H */
@@ -1,6 +1,9 @@
 #include "unordered_map.h"
+#include "prefetch.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 typedef struct unordered_map_entry {
     void*                       key;
@@ -22,6 +25,8 @@ typedef struct unordered_map_state {
     size_t                max_allowed_size;
     size_t                mask;
     float                 load_factor;
+    arena*                p_arena;
+    unordered_map_entry*  free_entries;
 } unordered_map_state;
 /*
 typedef struct unordered_map {
@@ -35,9 +40,48 @@ typedef struct unordered_map_iterator {
     size_t               expected_mod_count;
 } unordered_map_iterator;
 
-static unordered_map_entry* unordered_map_entry_alloc(void* key, void* value)
+/*******************************************************************************
+* Returns zeroed memory for a table of 'capacity' buckets, taken from the      *
+* arena of the map if it has one.                                              *
+*******************************************************************************/
+static unordered_map_entry** table_alloc(arena* p_arena, size_t capacity)
 {
-    unordered_map_entry* entry = malloc(sizeof(*entry));
+    unordered_map_entry** table;
+
+    if (!p_arena)
+    {
+        return calloc(capacity, sizeof(unordered_map_entry*));
+    }
+
+    table = arena_allocate(p_arena, sizeof(unordered_map_entry*) * capacity);
+
+    if (table)
+    {
+        memset(table, 0, sizeof(unordered_map_entry*) * capacity);
+    }
+
+    return table;
+}
+
+static unordered_map_entry* unordered_map_entry_alloc(unordered_map* map,
+                                                      void* key,
+                                                      void* value)
+{
+    unordered_map_entry* entry;
+
+    if (!map->state->p_arena)
+    {
+        entry = malloc(sizeof(*entry));
+    }
+    else if ((entry = map->state->free_entries))
+    {
+        /* Entries of arena maps are recycled instead of freed. */
+        map->state->free_entries = entry->next;
+    }
+    else
+    {
+        entry = arena_allocate(map->state->p_arena, sizeof(*entry));
+    }
 
     if (!entry)
     {
@@ -53,6 +97,19 @@ static unordered_map_entry* unordered_map_entry_alloc(void* key, void* value)
     return entry;
 }
 
+static void unordered_map_entry_free(unordered_map* map,
+                                     unordered_map_entry* entry)
+{
+    if (!map->state->p_arena)
+    {
+        free(entry);
+        return;
+    }
+
+    entry->next = map->state->free_entries;
+    map->state->free_entries = entry;
+}
+
 static const float  MINIMUM_LOAD_FACTOR = 0.2f;
 static const size_t MINIMUM_INITIAL_CAPACITY = 16;
 
@@ -93,10 +150,11 @@ static size_t fix_initial_capacity(size_t initial_capacity)
     return ret;
 }
 
-unordered_map* unordered_map_alloc(size_t initial_capacity,
-    float load_factor,
-    size_t(*hash_function)(void*),
-    bool(*equals_function)(void*, void*))
+static unordered_map* map_alloc(arena* p_arena,
+                                size_t initial_capacity,
+                                float load_factor,
+                                size_t(*hash_function)(void*),
+                                bool(*equals_function)(void*, void*))
 {
     unordered_map* map;
 
@@ -105,15 +163,16 @@ unordered_map* unordered_map_alloc(size_t initial_capacity,
         return NULL;
     }
 
-    map = malloc(sizeof(*map));
+    map = p_arena ? arena_allocate(p_arena, sizeof(*map) + sizeof(*map->state))
+                  : malloc(sizeof(*map) + sizeof(*map->state));
 
     if (!map)
     {
         return NULL;
     }
 
-    map->state = malloc(sizeof(*map->state));
-
+    /* The state shares the allocation of the map. */
+    map->state = (unordered_map_state*)(map + 1);
     load_factor = fix_load_factor(load_factor);
     initial_capacity = fix_initial_capacity(initial_capacity);
 
@@ -123,37 +182,74 @@ unordered_map* unordered_map_alloc(size_t initial_capacity,
     map->state->mod_count = 0;
     map->state->head = NULL;
     map->state->tail = NULL;
-    map->state->table = calloc(initial_capacity,
-        sizeof(unordered_map_entry*));
-
+    map->state->table = table_alloc(p_arena, initial_capacity);
     map->state->hash_function = hash_function;
     map->state->equals_function = equals_function;
     map->state->mask = initial_capacity - 1;
     map->state->max_allowed_size = (size_t)(initial_capacity * load_factor);
+    map->state->p_arena = p_arena;
+    map->state->free_entries = NULL;
+
+    if (!map->state->table)
+    {
+        if (!p_arena)
+        {
+            free(map);
+        }
+
+        return NULL;
+    }
 
     return map;
 }
 
-static void ensure_capacity(unordered_map* map)
+unordered_map* unordered_map_alloc(size_t initial_capacity,
+    float load_factor,
+    size_t(*hash_function)(void*),
+    bool(*equals_function)(void*, void*))
 {
-    size_t new_capacity;
-    size_t new_mask;
-    size_t index;
-    unordered_map_entry* entry;
-    unordered_map_entry** new_table;
+    return map_alloc(NULL,
+                     initial_capacity,
+                     load_factor,
+                     hash_function,
+                     equals_function);
+}
 
-    if (map->state->size < map->state->max_allowed_size)
+unordered_map* unordered_map_alloc_in_arena(arena* p_arena,
+    size_t initial_capacity,
+    float load_factor,
+    size_t(*hash_function)(void*),
+    bool(*equals_function)(void*, void*))
+{
+    if (!p_arena)
     {
-        return;
+        return NULL;
     }
 
-    new_capacity = 2 * map->state->table_capacity;
+    return map_alloc(p_arena,
+                     initial_capacity,
+                     load_factor,
+                     hash_function,
+                     equals_function);
+}
+
+/*******************************************************************************
+* Rehashes all the entries into a new table of capacity 'new_capacity', which  *
+* must be a power of two.                                                      *
+*******************************************************************************/
+static bool resize(unordered_map* map, size_t new_capacity)
+{
+    size_t new_mask;
+    size_t index;
+    unordered_map_entry*  entry;
+    unordered_map_entry** new_table;
+
     new_mask = new_capacity - 1;
-    new_table = calloc(new_capacity, sizeof(unordered_map_entry*));
+    new_table = table_alloc(map->state->p_arena, new_capacity);
 
     if (!new_table)
     {
-        return;
+        return false;
     }
 
     /* Rehash the entries. */
@@ -164,12 +260,56 @@ static void ensure_capacity(unordered_map* map)
         new_table[index] = entry;
     }
 
-    free(map->state->table);
+    /* An arena takes the old table back only when it is deallocated. */
+    if (!map->state->p_arena)
+    {
+        free(map->state->table);
+    }
 
     map->state->table = new_table;
     map->state->table_capacity = new_capacity;
     map->state->mask = new_mask;
     map->state->max_allowed_size = (size_t)(new_capacity * map->state->load_factor);
+    return true;
+}
+
+static void ensure_capacity(unordered_map* map)
+{
+    if (map->state->size < map->state->max_allowed_size)
+    {
+        return;
+    }
+
+    resize(map, 2 * map->state->table_capacity);
+}
+
+bool unordered_map_reserve(unordered_map* map, size_t expected_size)
+{
+    size_t new_capacity;
+
+    if (!map)
+    {
+        return false;
+    }
+
+    new_capacity = map->state->table_capacity;
+
+    while ((size_t)(new_capacity * map->state->load_factor) < expected_size)
+    {
+        if (new_capacity > SIZE_MAX / 2)
+        {
+            return false;
+        }
+
+        new_capacity <<= 1;
+    }
+
+    if (new_capacity == map->state->table_capacity)
+    {
+        return true;
+    }
+
+    return resize(map, new_capacity);
 }
 
 void* unordered_map_put(unordered_map* map, void* key, void* value)
@@ -201,7 +341,13 @@ void* unordered_map_put(unordered_map* map, void* key, void* value)
 
     /* Recompute the index since it is possibly changed by 'ensure_capacity' */
     index = hash_value & map->state->mask;
-    entry = unordered_map_entry_alloc(key, value);
+    entry = unordered_map_entry_alloc(map, key, value);
+
+    if (!entry)
+    {
+        return NULL;
+    }
+
     entry->chain_next = map->state->table[index];
     map->state->table[index] = entry;
 
@@ -224,6 +370,30 @@ void* unordered_map_put(unordered_map* map, void* key, void* value)
     return NULL;
 }
 
+size_t unordered_map_put_all(unordered_map* map,
+    void** keys,
+    void** values,
+    size_t count)
+{
+    size_t i;
+    size_t old_size;
+
+    if (!map || !keys || !values)
+    {
+        return 0;
+    }
+
+    old_size = map->state->size;
+    unordered_map_reserve(map, old_size + count);
+
+    for (i = 0; i < count; ++i)
+    {
+        unordered_map_put(map, keys[i], values[i]);
+    }
+
+    return map->state->size - old_size;
+}
+
 bool unordered_map_contains_key(unordered_map* map, void* key)
 {
     size_t index;
@@ -270,6 +440,63 @@ void* unordered_map_get(unordered_map* map, void* key)
     return NULL;
 }
 
+void unordered_map_get_many(unordered_map* map,
+    void** keys,
+    void** values,
+    size_t count)
+{
+    size_t               indices[PREFETCH_BATCH_SIZE];
+    unordered_map_entry* entries[PREFETCH_BATCH_SIZE];
+    unordered_map_entry* entry;
+    size_t               batch_size;
+    size_t               i;
+    size_t               j;
+
+    if (!map || !keys || !values)
+    {
+        return;
+    }
+
+    for (i = 0; i < count; i += batch_size)
+    {
+        batch_size = count - i < PREFETCH_BATCH_SIZE ?
+                     count - i : PREFETCH_BATCH_SIZE;
+
+        /* Hash all the keys and request their buckets. */
+        for (j = 0; j < batch_size; ++j)
+        {
+            indices[j] = map->state->hash_function(keys[i + j]) &
+                         map->state->mask;
+            PREFETCH(&map->state->table[indices[j]]);
+        }
+
+        /* Request the first entries of the collision chains. */
+        for (j = 0; j < batch_size; ++j)
+        {
+            entries[j] = map->state->table[indices[j]];
+
+            if (entries[j])
+            {
+                PREFETCH(entries[j]);
+            }
+        }
+
+        for (j = 0; j < batch_size; ++j)
+        {
+            values[i + j] = NULL;
+
+            for (entry = entries[j]; entry; entry = entry->chain_next)
+            {
+                if (map->state->equals_function(keys[i + j], entry->key))
+                {
+                    values[i + j] = entry->value;
+                    break;
+                }
+            }
+        }
+    }
+}
+
 void* unordered_map_remove(unordered_map* map, void* key)
 {
     void*  value;
@@ -324,7 +551,7 @@ void* unordered_map_remove(unordered_map* map, void* key)
             value = current_entry->value;
             map->state->size--;
             map->state->mod_count++;
-            free(current_entry);
+            unordered_map_entry_free(map, current_entry);
             return value;
         }
 
@@ -351,7 +578,7 @@ void unordered_map_clear(unordered_map* map)
     {
         index = map->state->hash_function(entry->key) & map->state->mask;
         next_entry = entry->next;
-        free(entry);
+        unordered_map_entry_free(map, entry);
         entry = next_entry;
         map->state->table[index] = NULL;
     }
@@ -367,6 +594,28 @@ size_t unordered_map_size(unordered_map* map)
     return map ? map->state->size : 0;
 }
 
+memory_usage unordered_map_memory_usage(unordered_map* map)
+{
+    memory_usage         usage = { 0, 0 };
+    unordered_map_entry* entry;
+
+    if (!map) return usage;
+
+    usage.live = sizeof(unordered_map_entry) * map->state->size;
+    usage.allocated = sizeof(*map) + sizeof(*map->state) +
+                      sizeof(unordered_map_entry*) *
+                      map->state->table_capacity +
+                      usage.live;
+
+    /* Maps in an arena keep their removed entries for reuse. */
+    for (entry = map->state->free_entries; entry; entry = entry->next)
+    {
+        usage.allocated += sizeof(*entry);
+    }
+
+    return usage;
+}
+
 bool unordered_map_is_healthy(unordered_map* map)
 {
     size_t counter;
@@ -400,6 +649,12 @@ void unordered_map_free(unordered_map* map)
         return;
     }
 
+    /* An arena map goes away with its arena. */
+    if (map->state->p_arena)
+    {
+        return;
+    }
+
     unordered_map_clear(map);
     free(map->state->table);
     free(map);
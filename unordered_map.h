@@ -1,6 +1,8 @@
 #ifndef UNORDERED_MAP_H
 #define	UNORDERED_MAP_H
 
+#include "arena.h"
+#include "memory_usage.h"
 #include <stdlib.h>
 #include <stdbool.h>
 
@@ -24,6 +26,18 @@ extern "C" {
         size_t(*hash_function)(void*),
         bool(*equals_function)(void*, void*));
 
+    /***************************************************************************
+    * Allocates a new, empty map whose table and entries are allocated from    *
+    * 'p_arena'. Removed entries are reused by later insertions. Freeing the   *
+    * map does nothing; the memory is released along with the arena.           *
+    ***************************************************************************/
+    unordered_map* unordered_map_alloc_in_arena(
+                       arena* p_arena,
+                       size_t initial_capacity,
+                       float load_factor,
+                       size_t(*p_hash_function)(void*),
+                       bool(*p_equals_function)(void*, void*));
+
     /***************************************************************************
     * If p_map does not contain the key p_key, inserts it in the map,          *
     * associates p_value with it and return NULL. Otherwise updates the value  *
@@ -31,6 +45,23 @@ extern "C" {
     ***************************************************************************/
     void* unordered_map_put(unordered_map* map, void* key, void* value);
 
+    /***************************************************************************
+    * Grows the table so that 'expected_size' mappings fit in the map without  *
+    * further rehashing. Returns false if the table could not be grown or its  *
+    * capacity would overflow.                                                 *
+    ***************************************************************************/
+    bool unordered_map_reserve(unordered_map* map, size_t expected_size);
+
+    /***************************************************************************
+    * Maps each 'keys[i]' to 'values[i]' for all 'i < count'. The table is     *
+    * sized once for all the new keys. Values of already mapped keys are       *
+    * overwritten. Returns the number of new mappings.                         *
+    ***************************************************************************/
+    size_t unordered_map_put_all(unordered_map* map,
+                                 void** keys,
+                                 void** values,
+                                 size_t count);
+
     /***************************************************************************
     * Returns a positive value if p_key is mapped to some value in this map.   *
     ***************************************************************************/
@@ -42,6 +73,17 @@ extern "C" {
     ***************************************************************************/
     void* unordered_map_get(unordered_map* map, void* key);
 
+    /***************************************************************************
+    * Looks up the first 'count' keys and stores the value of 'keys[i]' (or    *
+    * NULL if not mapped) in 'values[i]'. The buckets of a batch of keys are   *
+    * prefetched before any of them is resolved so that the cache misses       *
+    * overlap.                                                                 *
+    ***************************************************************************/
+    void unordered_map_get_many(unordered_map* map,
+                                void** keys,
+                                void** values,
+                                size_t count);
+
     /***************************************************************************
     * If p_key is mapped in the map, removes the mapping and returns the value *
     * of that mapping. If the map did not contain the mapping, returns NULL.   *
@@ -59,6 +101,13 @@ extern "C" {
     ***************************************************************************/
     size_t unordered_map_size(unordered_map* map);
 
+    /***************************************************************************
+    * Returns the memory taken by the map: its table and its entries, but not  *
+    * the keys and the values they refer to. Entries of a map in an arena      *
+    * count from the arena as well.                                            *
+    ***************************************************************************/
+    memory_usage unordered_map_memory_usage(unordered_map* map);
+
     /***************************************************************************
     * Checks that the map is in valid state.                                   *
     ***************************************************************************/
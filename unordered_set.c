@@ -1,6 +1,9 @@
 #include "unordered_set.h"
+#include "prefetch.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 typedef struct unordered_set_entry {
     void*                       key;
@@ -21,6 +24,8 @@ typedef struct unordered_set_state {
     size_t                mask;
     size_t                max_allowed_size;
     float                 load_factor;
+    arena*                p_arena;
+    unordered_set_entry*  free_entries;
 } unordered_set_state;
 /*
 typedef struct unordered_set {
@@ -34,9 +39,47 @@ typedef struct unordered_set_iterator {
     size_t               expected_mod_count;
 } unordered_set_iterator;
 
-static unordered_set_entry* unordered_set_entry_alloc(void* key)
+/*******************************************************************************
+* Returns zeroed memory for a table of 'capacity' buckets, taken from the      *
+* arena of the set if it has one.                                              *
+*******************************************************************************/
+static unordered_set_entry** table_alloc(arena* p_arena, size_t capacity)
 {
-    unordered_set_entry* entry = malloc(sizeof(*entry));
+    unordered_set_entry** table;
+
+    if (!p_arena)
+    {
+        return calloc(capacity, sizeof(unordered_set_entry*));
+    }
+
+    table = arena_allocate(p_arena, sizeof(unordered_set_entry*) * capacity);
+
+    if (table)
+    {
+        memset(table, 0, sizeof(unordered_set_entry*) * capacity);
+    }
+
+    return table;
+}
+
+static unordered_set_entry* unordered_set_entry_alloc(unordered_set* set,
+                                                      void* key)
+{
+    unordered_set_entry* entry;
+
+    if (!set->state->p_arena)
+    {
+        entry = malloc(sizeof(*entry));
+    }
+    else if ((entry = set->state->free_entries))
+    {
+        /* Entries of arena sets are recycled instead of freed. */
+        set->state->free_entries = entry->next;
+    }
+    else
+    {
+        entry = arena_allocate(set->state->p_arena, sizeof(*entry));
+    }
 
     if (!entry)
     {
@@ -51,6 +94,19 @@ static unordered_set_entry* unordered_set_entry_alloc(void* key)
     return entry;
 }
 
+static void unordered_set_entry_free(unordered_set* set,
+                                     unordered_set_entry* entry)
+{
+    if (!set->state->p_arena)
+    {
+        free(entry);
+        return;
+    }
+
+    entry->next = set->state->free_entries;
+    set->state->free_entries = entry;
+}
+
 static const float  MINIMUM_LOAD_FACTOR = 0.2f;
 static const int MINIMUM_INITIAL_CAPACITY = 16;
 
@@ -91,10 +147,11 @@ static size_t fix_initial_capacity(size_t initial_capacity)
     return ret;
 }
 
-unordered_set* unordered_set_alloc(size_t initial_capacity,
-    float load_factor,
-    size_t(*hash_function)(void*),
-    bool(*equals_function)(void*, void*))
+static unordered_set* set_alloc(arena* p_arena,
+                                size_t initial_capacity,
+                                float load_factor,
+                                size_t(*hash_function)(void*),
+                                bool(*equals_function)(void*, void*))
 {
     unordered_set* set;
 
@@ -103,14 +160,16 @@ unordered_set* unordered_set_alloc(size_t initial_capacity,
         return NULL;
     }
 
-    set = malloc(sizeof(*set));
+    set = p_arena ? arena_allocate(p_arena, sizeof(*set) + sizeof(*set->state))
+                  : malloc(sizeof(*set) + sizeof(*set->state));
 
     if (!set)
     {
         return NULL;
     }
 
-    set->state = malloc(sizeof(*set->state));
+    /* The state shares the allocation of the set. */
+    set->state = (unordered_set_state*)(set + 1);
     load_factor = fix_load_factor(load_factor);
     initial_capacity = fix_initial_capacity(initial_capacity);
 
@@ -120,36 +179,74 @@ unordered_set* unordered_set_alloc(size_t initial_capacity,
     set->state->mod_count = 0;
     set->state->head = NULL;
     set->state->tail = NULL;
-    set->state->table = calloc(initial_capacity,
-        sizeof(unordered_set_entry*));
+    set->state->table = table_alloc(p_arena, initial_capacity);
     set->state->hash_function = hash_function;
     set->state->equals_function = equals_function;
     set->state->mask = initial_capacity - 1;
     set->state->max_allowed_size = (size_t)(initial_capacity * load_factor);
+    set->state->p_arena = p_arena;
+    set->state->free_entries = NULL;
+
+    if (!set->state->table)
+    {
+        if (!p_arena)
+        {
+            free(set);
+        }
+
+        return NULL;
+    }
 
     return set;
 }
 
-static void ensure_capacity(unordered_set* set)
+unordered_set* unordered_set_alloc(size_t initial_capacity,
+    float load_factor,
+    size_t(*hash_function)(void*),
+    bool(*equals_function)(void*, void*))
+{
+    return set_alloc(NULL,
+                     initial_capacity,
+                     load_factor,
+                     hash_function,
+                     equals_function);
+}
+
+unordered_set* unordered_set_alloc_in_arena(arena* p_arena,
+    size_t initial_capacity,
+    float load_factor,
+    size_t(*hash_function)(void*),
+    bool(*equals_function)(void*, void*))
+{
+    if (!p_arena)
+    {
+        return NULL;
+    }
+
+    return set_alloc(p_arena,
+                     initial_capacity,
+                     load_factor,
+                     hash_function,
+                     equals_function);
+}
+
+/*******************************************************************************
+* Rehashes all the entries into a new table of capacity 'new_capacity', which  *
+* must be a power of two.                                                      *
+*******************************************************************************/
+static bool resize(unordered_set* set, size_t new_capacity)
 {
-    size_t new_capacity;
     size_t new_mask;
     size_t index;
     unordered_set_entry*  entry;
     unordered_set_entry** new_table;
 
-    if (set->state->size < set->state->max_allowed_size)
-    {
-        return;
-    }
-
-    new_capacity = 2 * set->state->table_capacity;
     new_mask = new_capacity - 1;
-    new_table = calloc(new_capacity, sizeof(unordered_set_entry*));
+    new_table = table_alloc(set->state->p_arena, new_capacity);
 
     if (!new_table)
     {
-        return;
+        return false;
     }
 
     /* Rehash the entries. */
@@ -160,12 +257,56 @@ static void ensure_capacity(unordered_set* set)
         new_table[index] = entry;
     }
 
-    free(set->state->table);
+    /* An arena takes the old table back only when it is deallocated. */
+    if (!set->state->p_arena)
+    {
+        free(set->state->table);
+    }
 
     set->state->table = new_table;
     set->state->table_capacity = new_capacity;
     set->state->mask = new_mask;
     set->state->max_allowed_size = (size_t)(new_capacity * set->state->load_factor);
+    return true;
+}
+
+static void ensure_capacity(unordered_set* set)
+{
+    if (set->state->size < set->state->max_allowed_size)
+    {
+        return;
+    }
+
+    resize(set, 2 * set->state->table_capacity);
+}
+
+bool unordered_set_reserve(unordered_set* set, size_t expected_size)
+{
+    size_t new_capacity;
+
+    if (!set)
+    {
+        return false;
+    }
+
+    new_capacity = set->state->table_capacity;
+
+    while ((size_t)(new_capacity * set->state->load_factor) < expected_size)
+    {
+        if (new_capacity > SIZE_MAX / 2)
+        {
+            return false;
+        }
+
+        new_capacity <<= 1;
+    }
+
+    if (new_capacity == set->state->table_capacity)
+    {
+        return true;
+    }
+
+    return resize(set, new_capacity);
 }
 
 bool unordered_set_add(unordered_set* set, void* key)
@@ -194,7 +335,13 @@ bool unordered_set_add(unordered_set* set, void* key)
 
     /* Recompute the index since it is possibly changed by 'ensure_capacity' */
     index = hash_value & set->state->mask;
-    entry = unordered_set_entry_alloc(key);
+    entry = unordered_set_entry_alloc(set, key);
+
+    if (!entry)
+    {
+        return false;
+    }
+
     entry->chain_next = set->state->table[index];
     set->state->table[index] = entry;
 
@@ -217,6 +364,29 @@ bool unordered_set_add(unordered_set* set, void* key)
     return true;
 }
 
+size_t unordered_set_add_all(unordered_set* set,
+    void** keys,
+    size_t count)
+{
+    size_t i;
+    size_t old_size;
+
+    if (!set || !keys)
+    {
+        return 0;
+    }
+
+    old_size = set->state->size;
+    unordered_set_reserve(set, old_size + count);
+
+    for (i = 0; i < count; ++i)
+    {
+        unordered_set_add(set, keys[i]);
+    }
+
+    return set->state->size - old_size;
+}
+
 bool unordered_set_contains(unordered_set* set, void* key)
 {
     size_t index;
@@ -240,6 +410,69 @@ bool unordered_set_contains(unordered_set* set, void* key)
     return false;
 }
 
+size_t unordered_set_contains_many(unordered_set* set,
+    void** keys,
+    bool* results,
+    size_t count)
+{
+    size_t               indices[PREFETCH_BATCH_SIZE];
+    unordered_set_entry* entries[PREFETCH_BATCH_SIZE];
+    unordered_set_entry* entry;
+    size_t               batch_size;
+    size_t               found;
+    size_t               i;
+    size_t               j;
+
+    if (!set || !keys || !results)
+    {
+        return 0;
+    }
+
+    found = 0;
+
+    for (i = 0; i < count; i += batch_size)
+    {
+        batch_size = count - i < PREFETCH_BATCH_SIZE ?
+                     count - i : PREFETCH_BATCH_SIZE;
+
+        /* Hash all the keys and request their buckets. */
+        for (j = 0; j < batch_size; ++j)
+        {
+            indices[j] = set->state->hash_function(keys[i + j]) &
+                         set->state->mask;
+            PREFETCH(&set->state->table[indices[j]]);
+        }
+
+        /* Request the first entries of the collision chains. */
+        for (j = 0; j < batch_size; ++j)
+        {
+            entries[j] = set->state->table[indices[j]];
+
+            if (entries[j])
+            {
+                PREFETCH(entries[j]);
+            }
+        }
+
+        for (j = 0; j < batch_size; ++j)
+        {
+            results[i + j] = false;
+
+            for (entry = entries[j]; entry; entry = entry->chain_next)
+            {
+                if (set->state->equals_function(keys[i + j], entry->key))
+                {
+                    results[i + j] = true;
+                    found++;
+                    break;
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
 bool unordered_set_remove(unordered_set* set, void* key)
 {
     size_t index;
@@ -292,7 +525,7 @@ bool unordered_set_remove(unordered_set* set, void* key)
 
             set->state->size--;
             set->state->mod_count++;
-            free(current_entry);
+            unordered_set_entry_free(set, current_entry);
             return true;
         }
 
@@ -319,7 +552,7 @@ void unordered_set_clear(unordered_set* set)
     {
         index = set->state->hash_function(entry->key) & set->state->mask;
         next_entry = entry->next;
-        free(entry);
+        unordered_set_entry_free(set, entry);
         entry = next_entry;
         set->state->table[index] = NULL;
     }
@@ -335,6 +568,28 @@ size_t unordered_set_size(unordered_set* set)
     return set ? set->state->size : 0;
 }
 
+memory_usage unordered_set_memory_usage(unordered_set* set)
+{
+    memory_usage         usage = { 0, 0 };
+    unordered_set_entry* entry;
+
+    if (!set) return usage;
+
+    usage.live = sizeof(unordered_set_entry) * set->state->size;
+    usage.allocated = sizeof(*set) + sizeof(*set->state) +
+                      sizeof(unordered_set_entry*) *
+                      set->state->table_capacity +
+                      usage.live;
+
+    /* Sets in an arena keep their removed entries for reuse. */
+    for (entry = set->state->free_entries; entry; entry = entry->next)
+    {
+        usage.allocated += sizeof(*entry);
+    }
+
+    return usage;
+}
+
 bool unordered_set_is_healthy(unordered_set* set)
 {
     size_t counter;
@@ -368,6 +623,12 @@ void unordered_set_free(unordered_set* set)
         return;
     }
 
+    /* An arena set goes away with its arena. */
+    if (set->state->p_arena)
+    {
+        return;
+    }
+
     unordered_set_clear(set);
     free(set->state->table);
     free(set);
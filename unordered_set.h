@@ -1,6 +1,8 @@
 #ifndef UNORDERED_SET_H
 #define	UNORDERED_SET_H
 
+#include "arena.h"
+#include "memory_usage.h"
 #include <stdlib.h>
 #include <stdbool.h>
 
@@ -23,17 +25,55 @@ extern "C" {
                                        size_t(*p_hash_function)(void*),
                                        bool(*p_equals_function)(void*, void*));
 
+    /***************************************************************************
+    * Allocates a new, empty set whose table and entries are allocated from    *
+    * 'p_arena'. Removed entries are reused by later additions. Freeing the    *
+    * set does nothing; the memory is released along with the arena.           *
+    ***************************************************************************/
+    unordered_set* unordered_set_alloc_in_arena(
+                       arena* p_arena,
+                       size_t initial_capacity,
+                       float load_factor,
+                       size_t(*p_hash_function)(void*),
+                       bool(*p_equals_function)(void*, void*));
+
     /***************************************************************************
     * Adds 'p_element' to the set if not already there. Returns true if the    *
     * structure of the set changed.                                            *
     ***************************************************************************/
     bool  unordered_set_add(unordered_set* p_set, void* p_element);
 
+    /***************************************************************************
+    * Grows the table so that 'expected_size' elements fit in the set without  *
+    * further rehashing. Returns false if the table could not be grown or its  *
+    * capacity would overflow.                                                 *
+    ***************************************************************************/
+    bool  unordered_set_reserve(unordered_set* p_set, size_t expected_size);
+
+    /***************************************************************************
+    * Adds the first 'count' elements of 'pp_elements' to the set. The table   *
+    * is sized once for all the elements. Returns the number of elements that  *
+    * were not already in the set.                                             *
+    ***************************************************************************/
+    size_t unordered_set_add_all(unordered_set* p_set,
+                                 void** pp_elements,
+                                 size_t count);
+
     /***************************************************************************
     * Returns true if the set contains the element.                            *
     ***************************************************************************/
     bool  unordered_set_contains(unordered_set* p_set, void* p_element);
 
+    /***************************************************************************
+    * Sets 'p_results[i]' to true if the set contains 'pp_elements[i]' for all *
+    * 'i < count'. The buckets of a batch of elements are prefetched before    *
+    * any of them is resolved. Returns the number of contained elements.       *
+    ***************************************************************************/
+    size_t unordered_set_contains_many(unordered_set* p_set,
+                                       void** pp_elements,
+                                       bool* p_results,
+                                       size_t count);
+
     /***************************************************************************
     * If the element is in the set, removes it and returns true.               *
     ***************************************************************************/
@@ -49,6 +89,13 @@ extern "C" {
     ***************************************************************************/
     size_t unordered_set_size(unordered_set* p_set);
 
+    /***************************************************************************
+    * Returns the memory taken by the set: its table and its entries, but not  *
+    * the keys they refer to. Entries of a set in an arena count from the      *
+    * arena as well.                                                           *
+    ***************************************************************************/
+    memory_usage unordered_set_memory_usage(unordered_set* p_set);
+
     /***************************************************************************
     * Checks that the set is in valid state.                                   *
     ***************************************************************************/
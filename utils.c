@@ -1,9 +1,10 @@
 #include "directed_graph_node.h"
 #include "unordered_map.h"
 #include "utils.h"
-#include "list.h"
+#include "path.h"
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 
 point_3d* random_point(double maxx, double maxy, double maxz)
 {
@@ -34,6 +35,15 @@ directed_graph_node* choose(directed_graph_node** p_table,
     return p_table[index];
 }
 
+/*******************************************************************************
+* The weight of an arc of a random graph: its length with some detour.         *
+*******************************************************************************/
+static double arc_length(void* p_tail_point, void* p_head_point, void* p_arg)
+{
+    (void) p_arg;
+    return 1.2 * point_3d_distance(p_tail_point, p_head_point);
+}
+
 graph_data* create_random_graph(const size_t nodes,
     size_t edges,
     const double maxx,
@@ -41,111 +51,182 @@ graph_data* create_random_graph(const size_t nodes,
     const double maxz)
 {
     size_t i;
-    char* p_name;
-
-    directed_graph_node*            p_tail;
-    directed_graph_node*            p_head;
-    directed_graph_weight_function* p_weight_function;
-    unordered_map*                  p_point_map;
-    point_3d*                       p_a;
-    point_3d*                       p_b;
-    graph_data*                     p_ret;
-
-    p_ret = malloc(sizeof(*p_ret));
-
-    if (!p_ret) return NULL;
-
-    directed_graph_node** p_node_array =
-        malloc(sizeof(directed_graph_node*) * nodes);
-
-    if (!p_ret)
+    char name[24];
+
+    directed_graph_node* p_tail;
+    directed_graph_node* p_head;
+    point_3d**           p_point_array;
+    char*                p_name;
+    graph_data*          p_ret;
+
+    if (!(p_ret = calloc(1, sizeof(*p_ret)))) return NULL;
+
+    p_ret->p_node_array = malloc(sizeof(directed_graph_node*) * nodes);
+    p_ret->p_points = malloc(sizeof(point_3d) * nodes);
+    p_ret->p_point_map = unordered_map_alloc(16,
+                                             1.0f,
+                                             hash_function,
+                                             equals_function);
+
+    /* All the names live in one pool instead of a block each, and the nodes
+       and their adjacencies are released in one go with the arena. */
+    p_ret->p_name_pool = string_pool_alloc(0);
+    p_ret->p_arena = arena_alloc(0);
+    p_point_array = malloc(sizeof(point_3d*) * nodes);
+
+    if (!p_ret->p_node_array || !p_ret->p_points || !p_ret->p_point_map ||
+        !p_ret->p_name_pool  || !p_ret->p_arena  || !p_point_array)
     {
-        free(p_ret);
+        free(p_point_array);
+        graph_data_free(p_ret);
         return NULL;
     }
 
-    if (!(p_weight_function =
-        directed_graph_weight_function_alloc(hash_function,
-            equals_function)))
+    /* The weights are derived from the coordinates on demand. */
+    if (!(p_ret->p_weight_function =
+              directed_graph_weight_function_alloc_computed(arc_length,
+                                                            p_ret->p_point_map,
+                                                            NULL)))
     {
-        free(p_ret);
-        free(p_node_array);
+        free(p_point_array);
+        graph_data_free(p_ret);
         return NULL;
     }
 
-    if (!(p_point_map = unordered_map_alloc(16,
-        1.0f,
-        hash_function,
-        equals_function)))
+    for (i = 0; i < nodes; ++i)
     {
-        directed_graph_weight_function_free(p_weight_function);
-        free(p_ret);
-        free(p_node_array);
-        return NULL;
+        snprintf(name, sizeof(name), "%lu", (unsigned long) i);
+
+        if (!(p_name = string_pool_intern(p_ret->p_name_pool, name)) ||
+            !(p_ret->p_node_array[i] =
+                  directed_graph_node_alloc_in_arena(p_ret->p_arena, p_name)))
+        {
+            free(p_point_array);
+            graph_data_free(p_ret);
+            return NULL;
+        }
+
+        p_ret->node_count = i + 1;
+        p_ret->p_points[i].x = ((double)rand() / (double)RAND_MAX) * maxx;
+        p_ret->p_points[i].y = ((double)rand() / (double)RAND_MAX) * maxy;
+        p_ret->p_points[i].z = ((double)rand() / (double)RAND_MAX) * maxz;
+        p_point_array[i] = &p_ret->p_points[i];
     }
 
-    for (i = 0; i < nodes; ++i)
+    i = unordered_map_put_all(p_ret->p_point_map,
+                              (void**) p_ret->p_node_array,
+                              (void**) p_point_array,
+                              nodes);
+    free(p_point_array);
+
+    if (i != nodes)
     {
-        p_name = malloc(sizeof(char) * 20);
- //       sprintf_s(p_name, "%d", i);
-        p_node_array[i] = directed_graph_node_alloc(p_name);
-        //        printf("%s\n", directed_graph_node_t_to_string(p_node_array[i]));
-        unordered_map_put(p_point_map,
-            p_node_array[i],
-            random_point(maxx, maxy, maxz));
+        graph_data_free(p_ret);
+        return NULL;
     }
 
+    /* Drawing an existing arc again adds nothing. */
     while (edges > 0)
     {
-        p_tail = choose(p_node_array, nodes);
-        p_head = choose(p_node_array, nodes);
+        p_tail = choose(p_ret->p_node_array, nodes);
+        p_head = choose(p_ret->p_node_array, nodes);
 
-        p_a = unordered_map_get(p_point_map, p_tail);
-        p_b = unordered_map_get(p_point_map, p_head);
-
-        directed_graph_node_add_arc(p_tail, p_head);
-
-        directed_graph_weight_function_put(
-            p_weight_function,
-            p_tail,
-            p_head,
-            1.2 * point_3d_distance(p_a, p_b));
+        if (!directed_graph_node_add_arc(p_tail, p_head) &&
+            !directed_graph_node_has_child(p_tail, p_head))
+        {
+            graph_data_free(p_ret);
+            return NULL;
+        }
 
         --edges;
     }
 
-    p_ret->p_node_array = p_node_array;
-    p_ret->p_weight_function = p_weight_function;
-    p_ret->p_point_map = p_point_map;
-
     return p_ret;
 }
 
-list* traceback_path(directed_graph_node* p_target,
-    unordered_map* p_parent_map)
+void graph_data_free(graph_data* p_data)
+{
+    size_t i;
+
+    if (!p_data) return;
+
+    directed_graph_weight_function_free(p_data->p_weight_function);
+    unordered_map_free(p_data->p_point_map);
+    free(p_data->p_points);
+
+    /* Nodes allocated in the arena go away with it. */
+    if (!p_data->p_arena)
+    {
+        for (i = 0; i < p_data->node_count; ++i)
+        {
+            directed_graph_node_free(p_data->p_node_array[i]);
+        }
+    }
+
+    free(p_data->p_node_array);
+    string_pool_free(p_data->p_name_pool);
+    arena_free(p_data->p_arena);
+    free(p_data);
+}
+
+graph_memory_summary graph_data_memory_summary(graph_data* p_data,
+                                               arena* p_search_scratch)
 {
-    list* p_ret;
-    directed_graph_node* p_current;
+    graph_memory_summary summary;
+    memory_usage         node_usage;
+    size_t               i;
 
-    if (!p_target)     return NULL;
-    if (!p_parent_map) return NULL;
+    memset(&summary, 0, sizeof(summary));
 
-    p_ret = list_alloc(10);
+    if (p_search_scratch)
+    {
+        summary.search_scratch.allocated =
+            arena_reserved_bytes(p_search_scratch);
+        summary.search_scratch.live = arena_bytes(p_search_scratch);
+    }
 
-    if (!p_ret)        return NULL;
+    if (!p_data) return summary;
 
-    p_current = p_target;
+    summary.adjacency.allocated =
+        sizeof(*p_data) + sizeof(directed_graph_node*) * p_data->node_count;
 
-    while (p_current)
+    for (i = 0; i < p_data->node_count; ++i)
     {
-        list_push_front(p_ret, p_current);
-        p_current = unordered_map_get(p_parent_map, p_current);
+        node_usage = directed_graph_node_memory_usage(p_data->p_node_array[i]);
+        summary.adjacency.live += node_usage.live;
+
+        if (!p_data->p_arena)
+        {
+            summary.adjacency.allocated += node_usage.allocated;
+        }
     }
 
-    return p_ret;
+    if (p_data->p_arena)
+    {
+        summary.adjacency.allocated += arena_reserved_bytes(p_data->p_arena);
+    }
+
+    summary.weights =
+        directed_graph_weight_function_memory_usage(p_data->p_weight_function);
+    summary.names = string_pool_memory_usage(p_data->p_name_pool);
+
+    if (p_data->p_point_map)
+    {
+        summary.coordinates = unordered_map_memory_usage(p_data->p_point_map);
+    }
+
+    if (p_data->p_points)
+    {
+        summary.coordinates.allocated +=
+            sizeof(point_3d) * p_data->node_count;
+        summary.coordinates.live +=
+            sizeof(point_3d) * unordered_map_size(p_data->p_point_map);
+    }
+
+    return summary;
 }
 
-bool is_valid_path(list* p_path)
+bool is_valid_path(path* p_path)
 {
     size_t i;
     size_t sz;
@@ -153,12 +234,12 @@ bool is_valid_path(list* p_path)
     if (!p_path) return false;
 
     /* A empty path is defined to be valid. */
-    if ((sz = list_size(p_path)) == 0) return true;
+    if ((sz = path_size(p_path)) == 0) return true;
 
     for (i = 0; i < sz - 1; ++i)
     {
-        if (!directed_graph_node_has_child(list_get(p_path, i),
-            list_get(p_path, i + 1)))
+        if (!directed_graph_node_has_child(path_get(p_path, i),
+            path_get(p_path, i + 1)))
         {
             return false;
         }
@@ -167,23 +248,30 @@ bool is_valid_path(list* p_path)
     return true;
 }
 
-double compute_path_cost(list* p_path,
+double compute_path_cost(path* p_path,
     directed_graph_weight_function* p_weight_function)
 {
     size_t i;
     size_t sz;
+    double weight;
     double cost = 0.0;
 
     if (!p_path) return 0.0;
 
     /* A empty path is defined to be valid. */
-    if ((sz = list_size(p_path)) == 0) return 0.0;
+    if ((sz = path_size(p_path)) == 0) return 0.0;
 
     for (i = 0; i < sz - 1; ++i)
     {
-        cost += *directed_graph_weight_function_get(p_weight_function,
-            list_get(p_path, i),
-            list_get(p_path, i + 1));
+        if (!directed_graph_weight_function_get_value(p_weight_function,
+                                                      path_get(p_path, i),
+                                                      path_get(p_path, i + 1),
+                                                      &weight))
+        {
+            return INFINITY;
+        }
+
+        cost += weight;
     }
 
     return cost;
@@ -4,7 +4,10 @@
 #include "directed_graph_node.h"
 #include "unordered_map.h"
 #include "weight_function.h"
-#include "list.h"
+#include "path.h"
+#include "string_pool.h"
+#include "arena.h"
+#include "memory_usage.h"
 
 #ifdef  __cplusplus
 extern "C" {
@@ -16,10 +19,20 @@ extern "C" {
         double z;
     } point_3d;
 
+    /***************************************************************************
+    * A graph with everything it owns: the nodes, their weights, the points    *
+    * of the point map, which live in the one array 'p_points' of              *
+    * 'node_count' entries, or NULL without coordinates, the names of the      *
+    * nodes and the arena the nodes are allocated in, if any.                  *
+    ***************************************************************************/
     typedef struct graph_data {
         directed_graph_node**           p_node_array;
+        size_t                          node_count;
         directed_graph_weight_function* p_weight_function;
         unordered_map*                  p_point_map;
+        point_3d*                       p_points;
+        string_pool*                    p_name_pool;
+        arena*                          p_arena;
     } graph_data;
 
     point_3d* random_point(double maxx, double maxy, double maxz);
@@ -35,13 +48,26 @@ extern "C" {
         const double maxy,
         const double maxz);
 
-    list* traceback_path(directed_graph_node* p_target,
-        unordered_map* p_parent_map);
+    /***************************************************************************
+    * Deallocates the graph and everything it owns, whichever loader created   *
+    * it. Does nothing if 'p_data' is NULL.                                    *
+    ***************************************************************************/
+    void graph_data_free(graph_data* p_data);
 
-    bool is_valid_path(list* p_path);
+    /***************************************************************************
+    * Returns the memory taken by the graph: its nodes and the node array as   *
+    * adjacency, the weight function, the name pool, the point map and its     *
+    * points, and the blocks kept by the arena 'p_search_scratch' of a search, *
+    * which may be NULL. Nodes in the arena of the graph are counted by the    *
+    * blocks of the arena.                                                     *
+    ***************************************************************************/
+    graph_memory_summary graph_data_memory_summary(graph_data* p_data,
+                                                   arena* p_search_scratch);
+
+    bool is_valid_path(path* p_path);
 
     double compute_path_cost(
-        list* p_path, directed_graph_weight_function* p_weight_function);
+        path* p_path, directed_graph_weight_function* p_weight_function);
 
 #ifdef  __cplusplus
 }
@@ -1,14 +1,547 @@
 #include "weight_function.h"
 #include "unordered_map.h"
+#include "unordered_set.h"
+#include "concurrent_map.h"
+#include <stdint.h>
+#include <string.h>
+
+/*******************************************************************************
+* The structures the arc weights are stored in.                                *
+*******************************************************************************/
+typedef enum weight_storage {
+    HASH_MAP_STORAGE,
+    CONCURRENT_MAP_STORAGE,
+    FLAT_STORAGE,
+    COMPUTED_STORAGE
+} weight_storage;
+
+/*******************************************************************************
+* In the flat storage, all the arcs leaving a tail node are kept in a single   *
+* block: the head nodes sorted by address, followed by the weights in the      *
+* same order and in the format of the weight function. An arc costs 16 bytes   *
+* with double weights and 12 bytes with the 32-bit formats, instead of an      *
+* inner map bucket, a map entry and a separately allocated weight.             *
+*******************************************************************************/
+typedef struct arc_block {
+    size_t               size;
+    size_t               capacity;
+    directed_graph_node* p_heads[];
+} arc_block;
 
 typedef struct directed_graph_weight_function_state {
-    unordered_map* p_first_level_map;
+    weight_storage  storage;
+    unordered_map*  p_first_level_map;
+    concurrent_map* p_first_level_concurrent_map;
     size_t(*p_hash_function)(void*);
     bool(*p_equals_function)(void*, void*);
+    weight_format   format;
+    double          fixed_point_scale;
+    double(*p_compute_function)(void*, void*, void*);
+    unordered_map*  p_node_data_map;
+    void*           p_compute_arg;
+    unordered_set*  p_dirty_tails;
 } directed_graph_weight_function_state;
 
+/*******************************************************************************
+* The slot of the calling thread into which the pointer-returning lookup       *
+* widens or computes the weights not stored as doubles. Being per thread,      *
+* concurrent readers never write the same slot.                                *
+*******************************************************************************/
+#if defined(_MSC_VER)
+static __declspec(thread) double decoded_weight;
+#else
+static __thread double decoded_weight;
+#endif
+
 static size_t INITIAL_CAPACITY = 16;
 static size_t LOAD_FACTOR = 1.0f;
+static size_t INITIAL_BLOCK_CAPACITY = 4;
+
+/*******************************************************************************
+* Returns the capacity of a new inner map of 'p_tail'. The arcs of a node are  *
+* usually added before their weights, so the map is sized for all of them at   *
+* once instead of doubling its way up from the initial capacity.               *
+*******************************************************************************/
+static size_t inner_map_capacity(directed_graph_node* p_tail)
+{
+    size_t arc_count = directed_graph_node_child_count(p_tail);
+
+    return arc_count > INITIAL_CAPACITY ? arc_count : INITIAL_CAPACITY;
+}
+
+/*******************************************************************************
+* Records that a weight of an arc leaving 'p_tail' changed, if the function    *
+* tracks its changes.                                                          *
+*******************************************************************************/
+static bool mark_dirty(directed_graph_weight_function_state* p_state,
+                       directed_graph_node* p_tail)
+{
+    if (!p_state->p_dirty_tails) return true;
+
+    unordered_set_add(p_state->p_dirty_tails, p_tail);
+    return unordered_set_contains(p_state->p_dirty_tails, p_tail);
+}
+
+/*******************************************************************************
+* Maps the arc to a newly allocated weight in the concurrent storage. The old  *
+* weight is retired since query threads may still be reading it.               *
+*******************************************************************************/
+static bool concurrent_put(directed_graph_weight_function_state* p_state,
+                           directed_graph_node* p_tail,
+                           directed_graph_node* p_head,
+                           double weight)
+{
+    concurrent_map* p_map;
+    concurrent_map* p_new_map;
+    double*         p_weight;
+    void*           p_old_weight;
+
+    if (!(p_map = concurrent_map_get(p_state->p_first_level_concurrent_map,
+                                     p_tail)))
+    {
+        p_new_map = concurrent_map_alloc(inner_map_capacity(p_tail),
+                                         LOAD_FACTOR,
+                                         p_state->p_hash_function,
+                                         p_state->p_equals_function);
+
+        if (!p_new_map) return false;
+
+        /* Another updater may have created the map for 'p_tail' already. */
+        p_map = concurrent_map_put_if_absent(
+                    p_state->p_first_level_concurrent_map,
+                    p_tail,
+                    p_new_map);
+
+        if (p_map != p_new_map)
+        {
+            concurrent_map_free(p_new_map);
+        }
+
+        if (!p_map) return false;
+    }
+
+    if (!(p_weight = malloc(sizeof(double)))) return false;
+
+    *p_weight = weight;
+
+    if (!concurrent_map_try_put(p_map, p_head, p_weight, &p_old_weight))
+    {
+        free(p_weight);
+        return false;
+    }
+
+    if (p_old_weight)
+    {
+        concurrent_map_retire(p_map, p_old_weight);
+    }
+
+    return true;
+}
+
+static double* concurrent_get(directed_graph_weight_function_state* p_state,
+                              directed_graph_node* p_tail,
+                              directed_graph_node* p_head)
+{
+    concurrent_map* p_map;
+
+    if (!(p_map = concurrent_map_get(p_state->p_first_level_concurrent_map,
+                                     p_tail)))
+    {
+        return NULL;
+    }
+
+    return concurrent_map_get(p_map, p_head);
+}
+
+static void free_weight(void* p_key, void* p_weight, void* p_arg)
+{
+    (void) p_key;
+    (void) p_arg;
+    free(p_weight);
+}
+
+static void free_second_level_map(void* p_key, void* p_map, void* p_arg)
+{
+    (void) p_key;
+    (void) p_arg;
+    concurrent_map_for_each(p_map, free_weight, NULL);
+    concurrent_map_free(p_map);
+}
+
+static void reclaim_second_level_map(void* p_key, void* p_map, void* p_arg)
+{
+    (void) p_key;
+    (void) p_arg;
+    concurrent_map_reclaim(p_map);
+}
+
+static void* flat_weights(arc_block* p_block)
+{
+    return p_block->p_heads + p_block->capacity;
+}
+
+/*******************************************************************************
+* Returns the index of the first arc in the block whose head is not located    *
+* below 'p_head'.                                                              *
+*******************************************************************************/
+static size_t flat_lower_bound(arc_block* p_block, directed_graph_node* p_head)
+{
+    size_t low;
+    size_t high;
+    size_t middle;
+
+    low = 0;
+    high = p_block->size;
+
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+
+        if ((uintptr_t) p_block->p_heads[middle] < (uintptr_t) p_head)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/*******************************************************************************
+* Returns the index of the arc leading to 'p_head', or the size of the block   *
+* if there is no such arc. The lookup by address hits whenever the client      *
+* passes the same node object it put the arc with; otherwise the block is      *
+* scanned with the equality function.                                          *
+*******************************************************************************/
+static size_t flat_find(directed_graph_weight_function_state* p_state,
+                        arc_block* p_block,
+                        directed_graph_node* p_head)
+{
+    size_t index;
+
+    index = flat_lower_bound(p_block, p_head);
+
+    if (index < p_block->size && p_block->p_heads[index] == p_head)
+    {
+        return index;
+    }
+
+    for (index = 0; index < p_block->size; ++index)
+    {
+        if (p_state->p_equals_function(p_block->p_heads[index], p_head))
+        {
+            return index;
+        }
+    }
+
+    return p_block->size;
+}
+
+/*******************************************************************************
+* Grows the block of 'p_tail' to hold 'new_capacity' arcs, moving the weights  *
+* behind the enlarged head array.                                              *
+*******************************************************************************/
+static arc_block* flat_grow(directed_graph_weight_function_state* p_state,
+                            directed_graph_node* p_tail,
+                            arc_block* p_block,
+                            size_t new_capacity)
+{
+    arc_block* p_new_block;
+    size_t     width;
+
+    width = weight_format_size(p_state->format);
+
+    p_new_block = realloc(p_block,
+                          sizeof(arc_block) +
+                          new_capacity * (sizeof(directed_graph_node*) +
+                                          width));
+
+    if (!p_new_block) return NULL;
+
+    if (p_block)
+    {
+        memmove(p_new_block->p_heads + new_capacity,
+                p_new_block->p_heads + p_new_block->capacity,
+                p_new_block->size * width);
+    }
+    else
+    {
+        p_new_block->size = 0;
+    }
+
+    p_new_block->capacity = new_capacity;
+    unordered_map_put(p_state->p_first_level_map, p_tail, p_new_block);
+
+    if (!unordered_map_contains_key(p_state->p_first_level_map, p_tail))
+    {
+        free(p_new_block);
+        return NULL;
+    }
+
+    return p_new_block;
+}
+
+static bool flat_put(directed_graph_weight_function_state* p_state,
+                     directed_graph_node* p_tail,
+                     directed_graph_node* p_head,
+                     double weight)
+{
+    arc_block* p_block;
+    char*      p_weights;
+    double     old_weight;
+    size_t     width;
+    size_t     index;
+
+    p_block = unordered_map_get(p_state->p_first_level_map, p_tail);
+
+    if (p_block)
+    {
+        index = flat_find(p_state, p_block, p_head);
+
+        if (index < p_block->size)
+        {
+            old_weight = weight_format_read(p_state->format,
+                                            p_state->fixed_point_scale,
+                                            flat_weights(p_block),
+                                            index);
+
+            if (!weight_format_write(p_state->format,
+                                     p_state->fixed_point_scale,
+                                     flat_weights(p_block),
+                                     index,
+                                     weight))
+            {
+                return false;
+            }
+
+            if (weight_format_read(p_state->format,
+                                   p_state->fixed_point_scale,
+                                   flat_weights(p_block),
+                                   index) != old_weight)
+            {
+                return mark_dirty(p_state, p_tail);
+            }
+
+            return true;
+        }
+    }
+
+    if (!p_block || p_block->size == p_block->capacity)
+    {
+        if (!(p_block = flat_grow(p_state,
+                                  p_tail,
+                                  p_block,
+                                  p_block ? 2 * p_block->capacity
+                                          : INITIAL_BLOCK_CAPACITY)))
+        {
+            return false;
+        }
+    }
+
+    index = flat_lower_bound(p_block, p_head);
+    width = weight_format_size(p_state->format);
+    p_weights = flat_weights(p_block);
+
+    memmove(&p_block->p_heads[index + 1],
+            &p_block->p_heads[index],
+            (p_block->size - index) * sizeof(directed_graph_node*));
+
+    memmove(p_weights + (index + 1) * width,
+            p_weights + index * width,
+            (p_block->size - index) * width);
+
+    p_block->p_heads[index] = p_head;
+    p_block->size++;
+
+    if (!weight_format_write(p_state->format,
+                             p_state->fixed_point_scale,
+                             p_weights,
+                             index,
+                             weight))
+    {
+        /* Not representable, so take the arc out again. */
+        p_block->size--;
+
+        memmove(&p_block->p_heads[index],
+                &p_block->p_heads[index + 1],
+                (p_block->size - index) * sizeof(directed_graph_node*));
+
+        memmove(p_weights + index * width,
+                p_weights + (index + 1) * width,
+                (p_block->size - index) * width);
+
+        return false;
+    }
+
+    return mark_dirty(p_state, p_tail);
+}
+
+/*******************************************************************************
+* Returns the block of 'p_tail' and sets '*p_index' to the index of the arc to *
+* 'p_head' in it, or returns NULL if there is no such arc.                     *
+*******************************************************************************/
+static arc_block* flat_locate(directed_graph_weight_function_state* p_state,
+                              directed_graph_node* p_tail,
+                              directed_graph_node* p_head,
+                              size_t* p_index)
+{
+    arc_block* p_block;
+
+    if (!(p_block = unordered_map_get(p_state->p_first_level_map, p_tail)))
+    {
+        return NULL;
+    }
+
+    if ((*p_index = flat_find(p_state, p_block, p_head)) == p_block->size)
+    {
+        return NULL;
+    }
+
+    return p_block;
+}
+
+static double* flat_get(directed_graph_weight_function_state* p_state,
+                        directed_graph_node* p_tail,
+                        directed_graph_node* p_head)
+{
+    arc_block* p_block;
+    size_t     index;
+
+    if (!(p_block = flat_locate(p_state, p_tail, p_head, &index)))
+    {
+        return NULL;
+    }
+
+    if (p_state->format == WEIGHT_FORMAT_DOUBLE)
+    {
+        return &((double*) flat_weights(p_block))[index];
+    }
+
+    /* The narrow formats are widened into the slot of the calling thread. */
+    decoded_weight = weight_format_read(p_state->format,
+                                        p_state->fixed_point_scale,
+                                        flat_weights(p_block),
+                                        index);
+    return &decoded_weight;
+}
+
+static bool flat_get_value(directed_graph_weight_function_state* p_state,
+                           directed_graph_node* p_tail,
+                           directed_graph_node* p_head,
+                           double* p_weight)
+{
+    arc_block* p_block;
+    size_t     index;
+
+    if (!(p_block = flat_locate(p_state, p_tail, p_head, &index)))
+    {
+        return false;
+    }
+
+    *p_weight = weight_format_read(p_state->format,
+                                   p_state->fixed_point_scale,
+                                   flat_weights(p_block),
+                                   index);
+    return true;
+}
+
+/*******************************************************************************
+* Computes the weight of the arc from the data of its end nodes into           *
+* '*p_weight'. Returns false if either node has no data.                       *
+*******************************************************************************/
+static bool computed_get_value(directed_graph_weight_function_state* p_state,
+                               directed_graph_node* p_tail,
+                               directed_graph_node* p_head,
+                               double* p_weight)
+{
+    void* p_tail_data;
+    void* p_head_data;
+
+    if (!(p_tail_data = unordered_map_get(p_state->p_node_data_map, p_tail)))
+    {
+        return false;
+    }
+
+    if (!(p_head_data = unordered_map_get(p_state->p_node_data_map, p_head)))
+    {
+        return false;
+    }
+
+    *p_weight = p_state->p_compute_function(p_tail_data,
+                                            p_head_data,
+                                            p_state->p_compute_arg);
+    return true;
+}
+
+/*******************************************************************************
+* Computes the weight of the arc into the slot of the calling thread.          *
+*******************************************************************************/
+static double* computed_get(directed_graph_weight_function_state* p_state,
+                            directed_graph_node* p_tail,
+                            directed_graph_node* p_head)
+{
+    if (!computed_get_value(p_state, p_tail, p_head, &decoded_weight))
+    {
+        return NULL;
+    }
+
+    return &decoded_weight;
+}
+
+size_t weight_format_size(weight_format format)
+{
+    return format == WEIGHT_FORMAT_DOUBLE ? sizeof(double) : sizeof(uint32_t);
+}
+
+double weight_format_read(weight_format format,
+                          double fixed_point_scale,
+                          const void* p_weights,
+                          size_t index)
+{
+    switch (format)
+    {
+        case WEIGHT_FORMAT_FLOAT:
+            return ((const float*) p_weights)[index];
+
+        case WEIGHT_FORMAT_FIXED_POINT:
+            return ((const uint32_t*) p_weights)[index] / fixed_point_scale;
+
+        default:
+            return ((const double*) p_weights)[index];
+    }
+}
+
+bool weight_format_write(weight_format format,
+                         double fixed_point_scale,
+                         void* p_weights,
+                         size_t index,
+                         double weight)
+{
+    double units;
+
+    switch (format)
+    {
+        case WEIGHT_FORMAT_FLOAT:
+            ((float*) p_weights)[index] = (float) weight;
+            return true;
+
+        case WEIGHT_FORMAT_FIXED_POINT:
+            /* Round to the nearest unit. */
+            units = weight * fixed_point_scale + 0.5;
+
+            if (!(units >= 0.0 && units < 4294967296.0)) return false;
+
+            ((uint32_t*) p_weights)[index] = (uint32_t) units;
+            return true;
+
+        default:
+            ((double*) p_weights)[index] = weight;
+            return true;
+    }
+}
 
 directed_graph_weight_function* directed_graph_weight_function_alloc
 (size_t(*p_hash_function)(void*),
@@ -29,11 +562,191 @@ directed_graph_weight_function* directed_graph_weight_function_alloc
         LOAD_FACTOR,
         p_hash_function,
         p_equals_function);
+    p_ret->state->storage = HASH_MAP_STORAGE;
+    p_ret->state->p_compute_function = NULL;
+    p_ret->state->p_node_data_map = NULL;
+    p_ret->state->p_compute_arg = NULL;
+    p_ret->state->p_dirty_tails = NULL;
+    p_ret->state->p_first_level_concurrent_map = NULL;
     p_ret->state->p_hash_function = p_hash_function;
     p_ret->state->p_equals_function = p_equals_function;
+    p_ret->state->format = WEIGHT_FORMAT_DOUBLE;
+    p_ret->state->fixed_point_scale = 1.0;
     return p_ret;
 }
 
+directed_graph_weight_function* directed_graph_weight_function_alloc_concurrent
+(size_t(*p_hash_function)(void*),
+    bool(*p_equals_function)(void*, void*))
+{
+    directed_graph_weight_function* p_ret;
+
+    if (!p_hash_function)   return NULL;
+    if (!p_equals_function) return NULL;
+
+    if (!(p_ret = malloc(sizeof(*p_ret)))) return NULL;
+
+    if (!(p_ret->state = malloc(sizeof(*p_ret->state))))
+    {
+        free(p_ret);
+        return NULL;
+    }
+
+    p_ret->state->p_first_level_concurrent_map =
+        concurrent_map_alloc(INITIAL_CAPACITY,
+                             LOAD_FACTOR,
+                             p_hash_function,
+                             p_equals_function);
+
+    if (!p_ret->state->p_first_level_concurrent_map)
+    {
+        free(p_ret->state);
+        free(p_ret);
+        return NULL;
+    }
+
+    p_ret->state->storage = CONCURRENT_MAP_STORAGE;
+    p_ret->state->p_compute_function = NULL;
+    p_ret->state->p_node_data_map = NULL;
+    p_ret->state->p_compute_arg = NULL;
+    p_ret->state->p_dirty_tails = NULL;
+    p_ret->state->p_first_level_map = NULL;
+    p_ret->state->p_hash_function = p_hash_function;
+    p_ret->state->p_equals_function = p_equals_function;
+    p_ret->state->format = WEIGHT_FORMAT_DOUBLE;
+    p_ret->state->fixed_point_scale = 1.0;
+    return p_ret;
+}
+
+directed_graph_weight_function* directed_graph_weight_function_alloc_flat
+(size_t(*p_hash_function)(void*),
+    bool(*p_equals_function)(void*, void*))
+{
+    return directed_graph_weight_function_alloc_flat_format(
+               p_hash_function,
+               p_equals_function,
+               WEIGHT_FORMAT_DOUBLE,
+               1.0);
+}
+
+directed_graph_weight_function*
+directed_graph_weight_function_alloc_flat_format
+(size_t(*p_hash_function)(void*),
+    bool(*p_equals_function)(void*, void*),
+    weight_format format,
+    double fixed_point_scale)
+{
+    directed_graph_weight_function* p_ret;
+
+    if (!p_hash_function)   return NULL;
+    if (!p_equals_function) return NULL;
+
+    if (format == WEIGHT_FORMAT_FIXED_POINT && !(fixed_point_scale > 0.0))
+    {
+        return NULL;
+    }
+
+    if (!(p_ret = malloc(sizeof(*p_ret)))) return NULL;
+
+    if (!(p_ret->state = malloc(sizeof(*p_ret->state))))
+    {
+        free(p_ret);
+        return NULL;
+    }
+
+    p_ret->state->p_first_level_map = unordered_map_alloc(INITIAL_CAPACITY,
+                                                          LOAD_FACTOR,
+                                                          p_hash_function,
+                                                          p_equals_function);
+
+    if (!p_ret->state->p_first_level_map)
+    {
+        free(p_ret->state);
+        free(p_ret);
+        return NULL;
+    }
+
+    p_ret->state->storage = FLAT_STORAGE;
+    p_ret->state->p_compute_function = NULL;
+    p_ret->state->p_node_data_map = NULL;
+    p_ret->state->p_compute_arg = NULL;
+    p_ret->state->p_dirty_tails = NULL;
+    p_ret->state->p_first_level_concurrent_map = NULL;
+    p_ret->state->p_hash_function = p_hash_function;
+    p_ret->state->p_equals_function = p_equals_function;
+    p_ret->state->format = format;
+    p_ret->state->fixed_point_scale =
+        format == WEIGHT_FORMAT_FIXED_POINT ? fixed_point_scale : 1.0;
+    return p_ret;
+}
+
+directed_graph_weight_function* directed_graph_weight_function_alloc_computed
+(double(*p_compute_function)(void* p_tail_data,
+                             void* p_head_data,
+                             void* p_arg),
+    unordered_map* p_node_data_map,
+    void* p_arg)
+{
+    directed_graph_weight_function* p_ret;
+
+    if (!p_compute_function) return NULL;
+    if (!p_node_data_map)    return NULL;
+
+    if (!(p_ret = malloc(sizeof(*p_ret)))) return NULL;
+
+    if (!(p_ret->state = malloc(sizeof(*p_ret->state))))
+    {
+        free(p_ret);
+        return NULL;
+    }
+
+    p_ret->state->storage = COMPUTED_STORAGE;
+    p_ret->state->p_first_level_map = NULL;
+    p_ret->state->p_first_level_concurrent_map = NULL;
+    p_ret->state->p_hash_function = NULL;
+    p_ret->state->p_equals_function = NULL;
+    p_ret->state->format = WEIGHT_FORMAT_DOUBLE;
+    p_ret->state->fixed_point_scale = 1.0;
+    p_ret->state->p_compute_function = p_compute_function;
+    p_ret->state->p_node_data_map = p_node_data_map;
+    p_ret->state->p_compute_arg = p_arg;
+    p_ret->state->p_dirty_tails = NULL;
+    return p_ret;
+}
+
+weight_format directed_graph_weight_function_format
+(directed_graph_weight_function* p_function)
+{
+    return p_function ? p_function->state->format : WEIGHT_FORMAT_DOUBLE;
+}
+
+double directed_graph_weight_function_fixed_point_scale
+(directed_graph_weight_function* p_function)
+{
+    return p_function ? p_function->state->fixed_point_scale : 1.0;
+}
+
+bool directed_graph_weight_function_reserve
+(directed_graph_weight_function* p_function, size_t tail_count)
+{
+    if (!p_function) return false;
+
+    if (p_function->state->storage == CONCURRENT_MAP_STORAGE)
+    {
+        /* The concurrent map grows without blocking the readers anyway. */
+        return true;
+    }
+
+    if (p_function->state->storage == COMPUTED_STORAGE)
+    {
+        /* Nothing is stored. */
+        return true;
+    }
+
+    return unordered_map_reserve(p_function->state->p_first_level_map,
+                                 tail_count);
+}
+
 bool directed_graph_weight_function_put
 (directed_graph_weight_function* p_weight_function,
     directed_graph_node* p_tail,
@@ -47,18 +760,57 @@ bool directed_graph_weight_function_put
     if (!p_tail)            return false;
     if (!p_head)            return false;
 
+    if (p_weight_function->state->storage == CONCURRENT_MAP_STORAGE)
+    {
+        return concurrent_put(p_weight_function->state,
+                              p_tail,
+                              p_head,
+                              weight);
+    }
+
+    if (p_weight_function->state->storage == COMPUTED_STORAGE)
+    {
+        /* The weights are defined by the node data alone. */
+        return false;
+    }
+
+    if (p_weight_function->state->storage == FLAT_STORAGE)
+    {
+        return flat_put(p_weight_function->state, p_tail, p_head, weight);
+    }
+
     p_tmp_map = unordered_map_get(p_weight_function->state->p_first_level_map,
         p_tail);
 
+    if (p_tmp_map && (p_weight = unordered_map_get(p_tmp_map, p_head)))
+    {
+        /* Update in place; replacing the value would leak the old one. */
+        if (*p_weight != weight)
+        {
+            *p_weight = weight;
+            return mark_dirty(p_weight_function->state, p_tail);
+        }
+
+        return true;
+    }
+
     if (p_tmp_map)
     {
-        p_weight = malloc(sizeof(double));
+        if (!(p_weight = malloc(sizeof(double)))) return false;
+
         *p_weight = weight;
         unordered_map_put(p_tmp_map, p_head, p_weight);
-        return unordered_map_contains_key(p_tmp_map, p_head);
+
+        if (!unordered_map_contains_key(p_tmp_map, p_head))
+        {
+            free(p_weight);
+            return false;
+        }
+
+        return mark_dirty(p_weight_function->state, p_tail);
     }
 
-    p_tmp_map = unordered_map_alloc(INITIAL_CAPACITY,
+    p_tmp_map = unordered_map_alloc(inner_map_capacity(p_tail),
         LOAD_FACTOR,
         p_weight_function->state->p_hash_function,
         p_weight_function->state->p_equals_function);
@@ -72,7 +824,8 @@ bool directed_graph_weight_function_put
     if (!unordered_map_contains_key(p_weight_function->state->p_first_level_map,
         p_tail)) return false;
 
-    p_weight = malloc(sizeof(double));
+    if (!(p_weight = malloc(sizeof(double)))) return false;
+
     *p_weight = weight;
 
     unordered_map_put(p_tmp_map, p_head, p_weight);
@@ -83,7 +836,70 @@ bool directed_graph_weight_function_put
         return false;
     }
 
-    return true;
+    return mark_dirty(p_weight_function->state, p_tail);
+}
+
+size_t directed_graph_weight_function_put_batch
+(directed_graph_weight_function* p_function,
+    const weight_update* p_updates,
+    size_t count)
+{
+    size_t applied;
+    size_t i;
+
+    if (!p_function) return 0;
+    if (!p_updates)  return 0;
+
+    applied = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (directed_graph_weight_function_put(p_function,
+                                               p_updates[i].p_tail,
+                                               p_updates[i].p_head,
+                                               p_updates[i].weight))
+        {
+            ++applied;
+        }
+    }
+
+    return applied;
+}
+
+bool directed_graph_weight_function_track_changes
+(directed_graph_weight_function* p_function)
+{
+    if (!p_function) return false;
+
+    if (p_function->state->storage != HASH_MAP_STORAGE &&
+        p_function->state->storage != FLAT_STORAGE)
+    {
+        return false;
+    }
+
+    if (p_function->state->p_dirty_tails) return true;
+
+    p_function->state->p_dirty_tails =
+        unordered_set_alloc(INITIAL_CAPACITY,
+                            LOAD_FACTOR,
+                            p_function->state->p_hash_function,
+                            p_function->state->p_equals_function);
+
+    return p_function->state->p_dirty_tails != NULL;
+}
+
+unordered_set* directed_graph_weight_function_dirty_tails
+(directed_graph_weight_function* p_function)
+{
+    return p_function ? p_function->state->p_dirty_tails : NULL;
+}
+
+void directed_graph_weight_function_clear_dirty
+(directed_graph_weight_function* p_function)
+{
+    if (!p_function || !p_function->state->p_dirty_tails) return;
+
+    unordered_set_clear(p_function->state->p_dirty_tails);
 }
 
 double* directed_graph_weight_function_get(
@@ -97,6 +913,21 @@ double* directed_graph_weight_function_get(
     if (!p_tail)     return NULL;
     if (!p_head)     return NULL;
 
+    if (p_function->state->storage == CONCURRENT_MAP_STORAGE)
+    {
+        return concurrent_get(p_function->state, p_tail, p_head);
+    }
+
+    if (p_function->state->storage == FLAT_STORAGE)
+    {
+        return flat_get(p_function->state, p_tail, p_head);
+    }
+
+    if (p_function->state->storage == COMPUTED_STORAGE)
+    {
+        return computed_get(p_function->state, p_tail, p_head);
+    }
+
     if (!(p_second_level_map = unordered_map_get(
         p_function->state->p_first_level_map, p_tail)))
     {
@@ -106,33 +937,217 @@ double* directed_graph_weight_function_get(
     return unordered_map_get(p_second_level_map, p_head);
 }
 
+bool directed_graph_weight_function_get_value(
+    directed_graph_weight_function* p_function,
+    directed_graph_node* p_tail,
+    directed_graph_node* p_head,
+    double* p_weight)
+{
+    double* p_stored_weight;
+
+    if (!p_function) return false;
+    if (!p_tail)     return false;
+    if (!p_head)     return false;
+    if (!p_weight)   return false;
+
+    if (p_function->state->storage == FLAT_STORAGE)
+    {
+        return flat_get_value(p_function->state, p_tail, p_head, p_weight);
+    }
+
+    if (p_function->state->storage == COMPUTED_STORAGE)
+    {
+        return computed_get_value(p_function->state,
+                                  p_tail,
+                                  p_head,
+                                  p_weight);
+    }
+
+    if (!(p_stored_weight = directed_graph_weight_function_get(p_function,
+                                                               p_tail,
+                                                               p_head)))
+    {
+        return false;
+    }
+
+    *p_weight = *p_stored_weight;
+    return true;
+}
+
+void directed_graph_weight_function_reclaim
+(directed_graph_weight_function* p_function)
+{
+    if (!p_function) return;
+
+    if (p_function->state->storage != CONCURRENT_MAP_STORAGE) return;
+
+    concurrent_map_for_each(p_function->state->p_first_level_concurrent_map,
+                            reclaim_second_level_map,
+                            NULL);
+    concurrent_map_reclaim(p_function->state->p_first_level_concurrent_map);
+}
+
+/*******************************************************************************
+* Adds the memory taken by a second level concurrent map and its weights to    *
+* the usage at 'p_usage'.                                                      *
+*******************************************************************************/
+static void add_second_level_usage(void* p_key, void* p_map, void* p_usage)
+{
+    memory_usage usage;
+
+    (void) p_key;
+
+    usage = concurrent_map_memory_usage(p_map);
+    usage.allocated += sizeof(double) * concurrent_map_size(p_map);
+    usage.live += sizeof(double) * concurrent_map_size(p_map);
+    memory_usage_add(p_usage, usage);
+}
+
+memory_usage directed_graph_weight_function_memory_usage
+(directed_graph_weight_function* p_function)
+{
+    directed_graph_weight_function_state* p_state;
+    unordered_map_iterator*               p_iterator;
+    void*                                 p_key;
+    void*                                 p_value;
+    unordered_map*                        p_map;
+    arc_block*                            p_block;
+    memory_usage                          usage = { 0, 0 };
+    size_t                                arc_size;
+
+    if (!p_function) return usage;
+
+    p_state = p_function->state;
+    usage.allocated = sizeof(*p_function) + sizeof(*p_state);
+
+    if (p_state->p_dirty_tails)
+    {
+        memory_usage_add(&usage,
+                         unordered_set_memory_usage(p_state->p_dirty_tails));
+    }
+
+    switch (p_state->storage)
+    {
+        case CONCURRENT_MAP_STORAGE:
+            memory_usage_add(&usage,
+                             concurrent_map_memory_usage(
+                                 p_state->p_first_level_concurrent_map));
+            concurrent_map_for_each(p_state->p_first_level_concurrent_map,
+                                    add_second_level_usage,
+                                    &usage);
+            return usage;
+
+        case COMPUTED_STORAGE:
+            /* The node data belongs to the client. */
+            return usage;
+
+        default:
+            break;
+    }
+
+    memory_usage_add(&usage,
+                     unordered_map_memory_usage(p_state->p_first_level_map));
+    arc_size = sizeof(directed_graph_node*) +
+               weight_format_size(p_state->format);
+    p_iterator = unordered_map_iterator_alloc(p_state->p_first_level_map);
+
+    while (unordered_map_iterator_has_next(p_iterator))
+    {
+        unordered_map_iterator_next(p_iterator, &p_key, &p_value);
+
+        if (p_state->storage == FLAT_STORAGE)
+        {
+            p_block = p_value;
+            usage.allocated += sizeof(arc_block) +
+                               arc_size * p_block->capacity;
+            usage.live += arc_size * p_block->size;
+        }
+        else
+        {
+            p_map = p_value;
+            memory_usage_add(&usage, unordered_map_memory_usage(p_map));
+            usage.allocated += sizeof(double) * unordered_map_size(p_map);
+            usage.live += sizeof(double) * unordered_map_size(p_map);
+        }
+    }
+
+    unordered_map_iterator_free(p_iterator);
+    return usage;
+}
+
 void directed_graph_weight_function_free
 (directed_graph_weight_function* p_function)
 {
     unordered_map_iterator* p_iterator;
     unordered_map_iterator* p_iterator_2;
     unordered_map*          p_map;
-    directed_graph_node*    p_node;
-    directed_graph_node*    p_node_2;
-    double*                   p_weight;
+    void*                   p_key;
+    void*                   p_value;
 
     if (!p_function) return;
 
+    if (p_function->state->p_dirty_tails)
+    {
+        unordered_set_free(p_function->state->p_dirty_tails);
+    }
+
+    if (p_function->state->storage == CONCURRENT_MAP_STORAGE)
+    {
+        concurrent_map_for_each(p_function->state->p_first_level_concurrent_map,
+                                free_second_level_map,
+                                NULL);
+        concurrent_map_free(p_function->state->p_first_level_concurrent_map);
+        free(p_function->state);
+        free(p_function);
+        return;
+    }
+
+    if (p_function->state->storage == COMPUTED_STORAGE)
+    {
+        /* The node data belongs to the client. */
+        free(p_function->state);
+        free(p_function);
+        return;
+    }
+
+    if (p_function->state->storage == FLAT_STORAGE)
+    {
+        p_iterator =
+            unordered_map_iterator_alloc(p_function->state->p_first_level_map);
+
+        while (unordered_map_iterator_has_next(p_iterator))
+        {
+            unordered_map_iterator_next(p_iterator, &p_key, &p_value);
+            free(p_value);
+        }
+
+        unordered_map_iterator_free(p_iterator);
+        unordered_map_free(p_function->state->p_first_level_map);
+        free(p_function->state);
+        free(p_function);
+        return;
+    }
+
     p_iterator = unordered_map_iterator_alloc(p_function->state->p_first_level_map);
 
     while (unordered_map_iterator_has_next(p_iterator))
     {
-        unordered_map_iterator_next(p_iterator, &p_node, &p_map);
+        unordered_map_iterator_next(p_iterator, &p_key, &p_value);
+        p_map = p_value;
         p_iterator_2 = unordered_map_iterator_alloc(p_map);
 
         while (unordered_map_iterator_has_next(p_iterator_2))
         {
-            unordered_map_iterator_next(p_iterator_2, &p_node_2, &p_weight);
-            free(p_weight);
+            unordered_map_iterator_next(p_iterator_2, &p_key, &p_value);
+            free(p_value);
         }
 
+        unordered_map_iterator_free(p_iterator_2);
         unordered_map_free(p_map);
     }
 
+    unordered_map_iterator_free(p_iterator);
     unordered_map_free(p_function->state->p_first_level_map);
+    free(p_function->state);
+    free(p_function);
 }
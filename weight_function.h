@@ -2,16 +2,64 @@
 #define WEIGHT_FUNCTION_H
 
 #include "directed_graph_node.h"
+#include "unordered_map.h"
+#include "unordered_set.h"
 #include <stdbool.h>
 
 #ifdef  __cplusplus
 extern "C" {
 #endif
 
+    /***************************************************************************
+    * The formats the arc weights can be stored in. Single-precision and       *
+    * 32-bit fixed-point weights halve the weight bandwidth of the searches; a *
+    * fixed-point weight is the number of units of size 1 /                    *
+    * 'fixed_point_scale', for example centiseconds with the scale of 100.     *
+    ***************************************************************************/
+    typedef enum weight_format {
+        WEIGHT_FORMAT_DOUBLE,
+        WEIGHT_FORMAT_FLOAT,
+        WEIGHT_FORMAT_FIXED_POINT
+    } weight_format;
+
+    /***************************************************************************
+    * Returns the amount of bytes a weight takes in format 'format'.           *
+    ***************************************************************************/
+    size_t weight_format_size(weight_format format);
+
+    /***************************************************************************
+    * Reads the index'th weight of the array 'p_weights' stored in format      *
+    * 'format'.                                                                *
+    ***************************************************************************/
+    double weight_format_read(weight_format format,
+                              double fixed_point_scale,
+                              const void* p_weights,
+                              size_t index);
+
+    /***************************************************************************
+    * Stores 'weight' as the index'th weight of the array 'p_weights' in       *
+    * format 'format'. Fixed-point weights are rounded to the nearest unit.    *
+    * Returns false if the weight is not representable in the format.          *
+    ***************************************************************************/
+    bool weight_format_write(weight_format format,
+                             double fixed_point_scale,
+                             void* p_weights,
+                             size_t index,
+                             double weight);
+
     typedef struct directed_graph_weight_function {
         struct directed_graph_weight_function_state* state;
     } directed_graph_weight_function;
 
+    /***************************************************************************
+    * A new weight for the arc ('p_tail', 'p_head').                           *
+    ***************************************************************************/
+    typedef struct weight_update {
+        directed_graph_node* p_tail;
+        directed_graph_node* p_head;
+        double               weight;
+    } weight_update;
+
     /***************************************************************************
     * Allocates a new, empty weight function.                                  *
     ***************************************************************************/
@@ -20,7 +68,92 @@ extern "C" {
                                              bool(*p_equals_function)(void*, void*));
 
     /***************************************************************************
-    * Associates the weight 'weight' with the arc ('p_tail', 'p_head').        *
+    * Allocates a new, empty weight function that can be read by any number of *
+    * threads while other threads update it. Reads never block. A weight       *
+    * pointer returned by 'directed_graph_weight_function_get' stays valid     *
+    * until the next 'directed_graph_weight_function_reclaim' even if the arc  *
+    * is updated meanwhile.                                                    *
+    ***************************************************************************/
+    directed_graph_weight_function*
+        directed_graph_weight_function_alloc_concurrent(
+            size_t(*p_hash_function)(void*),
+            bool(*p_equals_function)(void*, void*));
+
+    /***************************************************************************
+    * Allocates a new, empty weight function that keeps the arcs leaving each  *
+    * tail node in one array sorted by head node, about 16 bytes per arc. A    *
+    * weight pointer returned by 'directed_graph_weight_function_get' stays    *
+    * valid only until the next 'directed_graph_weight_function_put' with the  *
+    * same tail node.                                                          *
+    ***************************************************************************/
+    directed_graph_weight_function*
+        directed_graph_weight_function_alloc_flat(
+            size_t(*p_hash_function)(void*),
+            bool(*p_equals_function)(void*, void*));
+
+    /***************************************************************************
+    * Allocates a new, empty flat weight function storing the weights in       *
+    * format 'format'. Returns NULL if the format is fixed-point and           *
+    * 'fixed_point_scale' is not positive.                                     *
+    * 'directed_graph_weight_function_put' fails for weights that are not      *
+    * representable in the format. For the 32-bit formats, a pointer returned  *
+    * by 'directed_graph_weight_function_get' points to the weight widened     *
+    * into a slot of the calling thread and stays valid only until the next    *
+    * call to it by that thread; 'directed_graph_weight_function_get_value'    *
+    * returns the weight by value instead.                                     *
+    ***************************************************************************/
+    directed_graph_weight_function*
+        directed_graph_weight_function_alloc_flat_format(
+            size_t(*p_hash_function)(void*),
+            bool(*p_equals_function)(void*, void*),
+            weight_format format,
+            double fixed_point_scale);
+
+    /***************************************************************************
+    * Allocates a weight function that stores no weights but computes the      *
+    * weight of an arc on demand as 'p_compute_function(p_tail_data,           *
+    * p_head_data, p_arg)', where the node data is looked up in                *
+    * 'p_node_data_map', such as a map from nodes to their coordinates.        *
+    * 'directed_graph_weight_function_get' returns NULL if either node has no  *
+    * data; the returned pointer points to a slot of the calling thread and    *
+    * stays valid only until the next call to it by that thread.               *
+    * 'directed_graph_weight_function_put' always fails. The client keeps      *
+    * owning the map and must not free it before the weight function.          *
+    ***************************************************************************/
+    directed_graph_weight_function*
+        directed_graph_weight_function_alloc_computed(
+            double(*p_compute_function)(void* p_tail_data,
+                                        void* p_head_data,
+                                        void* p_arg),
+            unordered_map* p_node_data_map,
+            void* p_arg);
+
+    /***************************************************************************
+    * Returns the storage format of the weights.                               *
+    ***************************************************************************/
+    weight_format directed_graph_weight_function_format(
+        directed_graph_weight_function* p_function);
+
+    /***************************************************************************
+    * Returns the amount of fixed-point units per unit of weight, or 1 for the *
+    * other formats.                                                           *
+    ***************************************************************************/
+    double directed_graph_weight_function_fixed_point_scale(
+        directed_graph_weight_function* p_function);
+
+    /***************************************************************************
+    * Sizes the weight function for arcs leaving 'tail_count' distinct nodes   *
+    * so that loading them causes no rehashing of the tail table. The table of *
+    * the heads of a tail is sized by the amount of arcs the tail has when its *
+    * first weight is put, so adding the arcs first avoids rehashing it too.   *
+    ***************************************************************************/
+    bool directed_graph_weight_function_reserve(
+        directed_graph_weight_function* p_function,
+        size_t tail_count);
+
+    /***************************************************************************
+    * Associates the weight 'weight' with the arc ('p_tail', 'p_head'). An     *
+    * existing weight is overwritten in place.                                 *
     ***************************************************************************/
     bool directed_graph_weight_function_put(
         directed_graph_weight_function* p_function,
@@ -28,6 +161,39 @@ extern "C" {
         directed_graph_node* p_head,
         double weight);
 
+    /***************************************************************************
+    * Applies the 'count' updates in 'p_updates' in order and returns the      *
+    * amount of them that succeeded. Existing weights are overwritten in       *
+    * place.                                                                   *
+    ***************************************************************************/
+    size_t directed_graph_weight_function_put_batch(
+        directed_graph_weight_function* p_function,
+        const weight_update* p_updates,
+        size_t count);
+
+    /***************************************************************************
+    * Makes the weight function record every tail node one of whose arc        *
+    * weights is added or changed, so that caches derived from the weights can *
+    * refresh only those nodes. Supported by the hash map and the flat weight  *
+    * functions; returns false for the others.                                 *
+    ***************************************************************************/
+    bool directed_graph_weight_function_track_changes(
+        directed_graph_weight_function* p_function);
+
+    /***************************************************************************
+    * Returns the set of the tail nodes changed since the tracking started or  *
+    * the dirty set was last cleared, or NULL if the changes are not tracked.  *
+    * The set belongs to the weight function.                                  *
+    ***************************************************************************/
+    unordered_set* directed_graph_weight_function_dirty_tails(
+        directed_graph_weight_function* p_function);
+
+    /***************************************************************************
+    * Empties the dirty set, typically after the changes have been consumed.   *
+    ***************************************************************************/
+    void directed_graph_weight_function_clear_dirty(
+        directed_graph_weight_function* p_function);
+
     /***************************************************************************
     * Reads the weight for the arc ('p_tail', 'p_head').                       *
     ***************************************************************************/
@@ -36,6 +202,37 @@ extern "C" {
         directed_graph_node* p_tail,
         directed_graph_node* p_head);
 
+    /***************************************************************************
+    * Stores the weight of the arc ('p_tail', 'p_head') in '*p_weight'.        *
+    * Returns false if the arc has no weight. Unlike a pointer returned by     *
+    * 'directed_graph_weight_function_get', the weight read stays valid        *
+    * whatever happens to the function, which suits the searches.              *
+    ***************************************************************************/
+    bool directed_graph_weight_function_get_value(
+        directed_graph_weight_function* p_function,
+        directed_graph_node* p_tail,
+        directed_graph_node* p_head,
+        double* p_weight);
+
+    /***************************************************************************
+    * Deallocates the weights replaced since the last call. For a concurrent   *
+    * weight function, it must be called only while no thread reads the        *
+    * function, such as between two query batches. Does nothing for the other  *
+    * weight functions.                                                        *
+    ***************************************************************************/
+    void directed_graph_weight_function_reclaim
+    (directed_graph_weight_function* p_function);
+
+    /***************************************************************************
+    * Returns the memory taken by the weight function: its maps, blocks and    *
+    * weights, and its dirty set. Of a computed weight function only the       *
+    * function itself is counted, as the node data belongs to the client. For  *
+    * a concurrent weight function, it must be called only while no thread     *
+    * writes the function.                                                     *
+    ***************************************************************************/
+    memory_usage directed_graph_weight_function_memory_usage
+    (directed_graph_weight_function* p_function);
+
     /***************************************************************************
     * Deallocate the weight function.                                          *
     ***************************************************************************/
@@ -0,0 +1,115 @@
+#include "weight_profile.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct weight_profile_state {
+    size_t  metric_count;
+    size_t  arc_count;
+    double* p_weights;
+} weight_profile_state;
+
+weight_profile* weight_profile_alloc(compact_graph* p_graph,
+                                     size_t metric_count)
+{
+    weight_profile* p_profile;
+    size_t          arc_count;
+
+    if (!p_graph)      return NULL;
+    if (!metric_count) return NULL;
+
+    arc_count = compact_graph_arc_count(p_graph);
+
+    /* The columns, plus one spare entry, must fit in one block. */
+    if (arc_count && metric_count > (SIZE_MAX - 1) / arc_count) return NULL;
+
+    if (!(p_profile = malloc(sizeof(*p_profile)))) return NULL;
+
+    if (!(p_profile->state = malloc(sizeof(weight_profile_state))))
+    {
+        free(p_profile);
+        return NULL;
+    }
+
+    /* All the columns go in one block, one after another. */
+    if (!(p_profile->state->p_weights =
+          calloc(metric_count * arc_count + 1, sizeof(double))))
+    {
+        free(p_profile->state);
+        free(p_profile);
+        return NULL;
+    }
+
+    p_profile->state->metric_count = metric_count;
+    p_profile->state->arc_count = arc_count;
+    return p_profile;
+}
+
+size_t weight_profile_metric_count(weight_profile* p_profile)
+{
+    return p_profile ? p_profile->state->metric_count : 0;
+}
+
+size_t weight_profile_arc_count(weight_profile* p_profile)
+{
+    return p_profile ? p_profile->state->arc_count : 0;
+}
+
+double* weight_profile_column(weight_profile* p_profile, size_t metric)
+{
+    if (!p_profile || metric >= p_profile->state->metric_count) return NULL;
+
+    return p_profile->state->p_weights + metric * p_profile->state->arc_count;
+}
+
+bool weight_profile_load(weight_profile* p_profile,
+                         size_t metric,
+                         compact_graph* p_graph,
+                         directed_graph_weight_function* p_weight_function)
+{
+    compact_arc_iterator arcs;
+    double*              p_column;
+    double               weight;
+    uint32_t             id;
+    uint32_t             head;
+    size_t               arc;
+
+    if (!p_graph)           return false;
+    if (!p_weight_function) return false;
+
+    if (!(p_column = weight_profile_column(p_profile, metric))) return false;
+
+    if (compact_graph_arc_count(p_graph) != p_profile->state->arc_count)
+    {
+        return false;
+    }
+
+    for (id = 0; id < compact_graph_node_count(p_graph); ++id)
+    {
+        compact_graph_arcs(p_graph, id, &arcs);
+
+        while (compact_arc_iterator_next(&arcs, &arc, &head))
+        {
+            if (!directed_graph_weight_function_get_value(
+                     p_weight_function,
+                     compact_graph_node(p_graph, id),
+                     compact_graph_node(p_graph, head),
+                     &weight))
+            {
+                return false;
+            }
+
+            p_column[arc] = weight;
+        }
+    }
+
+    return true;
+}
+
+void weight_profile_free(weight_profile* p_profile)
+{
+    if (!p_profile) return;
+
+    free(p_profile->state->p_weights);
+    free(p_profile->state);
+    free(p_profile);
+}
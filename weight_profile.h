@@ -0,0 +1,68 @@
+#ifndef WEIGHT_PROFILE_H
+#define WEIGHT_PROFILE_H
+
+#include "compact_graph.h"
+#include "weight_function.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    /***************************************************************************
+    * Several metrics of the arcs of a compact graph, such as distance, travel *
+    * time and toll, stored column by column: the weight of arc 'a' under      *
+    * metric 'k' is the a'th element of column 'k'. All the columns share the  *
+    * arc index of the graph, so a metric costs 8 bytes per arc and nothing    *
+    * else.                                                                    *
+    ***************************************************************************/
+    typedef struct weight_profile {
+        struct weight_profile_state* state;
+    } weight_profile;
+
+    /***************************************************************************
+    * Allocates a profile of 'metric_count' metrics for the arcs of 'p_graph'. *
+    * All the weights are initially zero. Returns NULL if there are no         *
+    * metrics, the columns would not fit in memory, or memory runs out.        *
+    ***************************************************************************/
+    weight_profile* weight_profile_alloc(compact_graph* p_graph,
+                                         size_t metric_count);
+
+    /***************************************************************************
+    * Returns the amount of metrics in the profile.                            *
+    ***************************************************************************/
+    size_t weight_profile_metric_count(weight_profile* p_profile);
+
+    /***************************************************************************
+    * Returns the amount of arcs the profile has weights for.                  *
+    ***************************************************************************/
+    size_t weight_profile_arc_count(weight_profile* p_profile);
+
+    /***************************************************************************
+    * Returns the weight column of metric 'metric', or NULL if the metric is   *
+    * out of range. The column may be written directly.                        *
+    ***************************************************************************/
+    double* weight_profile_column(weight_profile* p_profile, size_t metric);
+
+    /***************************************************************************
+    * Fills the column of metric 'metric' with the weights 'p_weight_function' *
+    * assigns to the arcs of 'p_graph', the graph the profile was allocated    *
+    * for. Returns false if an arc has no weight.                              *
+    ***************************************************************************/
+    bool weight_profile_load(weight_profile* p_profile,
+                             size_t metric,
+                             compact_graph* p_graph,
+                             directed_graph_weight_function*
+                                 p_weight_function);
+
+    /***************************************************************************
+    * Deallocates the profile.                                                 *
+    ***************************************************************************/
+    void weight_profile_free(weight_profile* p_profile);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* WEIGHT_PROFILE_H */